@@ -0,0 +1,112 @@
+#version 460
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec4 clusterParameters;
+    uint lightCount;
+    float interpolationFactor;
+} ubo;
+
+struct GameObjectData {
+    uint transformIndex;
+    uint materialIndex;
+    uint meshIndex;
+    uint drawIndex;
+    uint objectId;
+};
+
+layout(std430, binding = 2) readonly buffer GameObjectBuffer {
+    GameObjectData gameObjectData[];
+} gameObjectBuffer;
+
+// Rows of the affine world matrix, the last row is (0, 0, 0, 1), and the translation before the last simulation step
+struct ObjectTransform {
+    vec4 worldMatrixRows[3];
+    vec4 previousPosition;
+};
+
+// Only the slots that changed are written by the CPU, so the translation is interpolated here
+layout(std430, binding = 7) readonly buffer TransformBuffer {
+    ObjectTransform transforms[];
+} transformBuffer;
+
+// Written by occlusionCulling.comp, gl_InstanceIndex already contains the firstInstance of the draw
+layout(std430, binding = 6) readonly buffer VisibleInstanceBuffer {
+    uint objectIndices[];
+} visibleInstanceBuffer;
+
+// Instancing mode of the pipeline variant, see PipelineSpecialization: the direct draws carry their object in the push
+// constants, the instanced draws read it from the object buffer
+layout(constant_id = 0) const bool pushConstantDraws = false;
+
+// Per draw data of the direct draws, see DrawPushConstants
+layout(push_constant) uniform DrawParameters {
+    vec4 worldMatrixRows[3];
+    uint objectIndex;
+    uint materialIndex;
+    uint meshIndex;
+    uint lod;
+} drawParameters;
+
+// Dequantization of the mesh positions, see VertexQuantization
+struct MeshData {
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+layout(std430, set = 1, binding = 3) readonly buffer MeshBuffer {
+    MeshData meshes[];
+} meshBuffer;
+
+// Only the snorm16x4 positions of the geometry buffer, 8 instead of 16 bytes per vertex.
+// They have the same indices as the vertices, so gl_VertexIndex addresses them directly.
+layout(std430, set = 1, binding = 5) readonly buffer PositionBuffer {
+    uvec2 positions[];
+} positionBuffer;
+
+// Must match shader.vert bit for bit, the color pass tests the depth with EQUAL
+invariant gl_Position;
+
+void main()
+{
+    vec4 worldMatrixRows[3];
+    uint materialIndex;
+    uint meshIndex;
+
+    // No buffer was written for the direct draws
+    if (pushConstantDraws)
+    {
+        worldMatrixRows = drawParameters.worldMatrixRows;
+        materialIndex = drawParameters.materialIndex;
+        meshIndex = drawParameters.meshIndex;
+    }
+    else
+    {
+        GameObjectData gameObject = gameObjectBuffer.gameObjectData[visibleInstanceBuffer.objectIndices[gl_InstanceIndex]];
+        ObjectTransform transform = transformBuffer.transforms[gameObject.transformIndex];
+
+        worldMatrixRows = transform.worldMatrixRows;
+        vec3 translation = vec3(worldMatrixRows[0].w, worldMatrixRows[1].w, worldMatrixRows[2].w);
+        translation = mix(transform.previousPosition.xyz, translation, ubo.interpolationFactor);
+        worldMatrixRows[0].w = translation.x;
+        worldMatrixRows[1].w = translation.y;
+        worldMatrixRows[2].w = translation.z;
+
+        materialIndex = gameObject.materialIndex;
+        meshIndex = gameObject.meshIndex;
+    }
+
+    MeshData mesh = meshBuffer.meshes[meshIndex];
+
+    uvec2 vertex = positionBuffer.positions[gl_VertexIndex];
+    vec3 inPosition = vec3(unpackSnorm2x16(vertex.x), unpackSnorm2x16(vertex.y).x);
+
+    vec3 position = mesh.positionOffset.xyz + inPosition * mesh.positionScale.xyz;
+
+    vec4 localPosition = vec4(position, 1.0);
+    vec3 globalPosition = vec3(dot(worldMatrixRows[0], localPosition), dot(worldMatrixRows[1], localPosition), dot(worldMatrixRows[2], localPosition));
+    vec4 viewPosition = ubo.view * ubo.model * vec4(globalPosition, 1.0);
+    gl_Position = ubo.proj * viewPosition;
+}
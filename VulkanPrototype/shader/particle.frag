@@ -0,0 +1,18 @@
+#version 450
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragCorner;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // Round soft sprite, blended additively, so the order of the particles does not matter
+    float distanceSquared = dot(fragCorner, fragCorner);
+
+    if (distanceSquared >= 1.0)
+        discard;
+
+    float alpha = (1.0 - distanceSquared) * fragColor.a;
+    outColor = vec4(fragColor.rgb * alpha, alpha);
+}
@@ -0,0 +1,64 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec4 clusterParameters;
+    uint lightCount;
+} ubo;
+
+layout(std430, binding = 1) readonly buffer ParticlePositionBuffer {
+    vec4 positionAge[];
+} positionBuffer;
+
+layout(std430, binding = 2) readonly buffer ParticleVelocityBuffer {
+    vec4 velocityLifetime[];
+} velocityBuffer;
+
+layout(std430, binding = 3) readonly buffer ParticleColorBuffer {
+    uint colors[];
+} colorBuffer;
+
+// The list particleSimulate.comp has written in this frame, one instance per entry
+layout(std430, binding = 5) readonly buffer ParticleAliveListBuffer {
+    uint indices[];
+} aliveList;
+
+layout(push_constant) uniform ParticleParameters {
+    vec4 emitterPositionRadius;
+    vec4 gravityTimeStep;
+    uint emitCount;
+    uint maxParticleCount;
+    uint aliveList;
+    uint stage;
+    uint seed;
+    float lifetime;
+    float speed;
+    float size;
+} parameters;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragCorner;
+
+// Two triangles of a quad, counter clockwise
+const vec2 corners[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main()
+{
+    uint particle = aliveList.indices[parameters.aliveList * parameters.maxParticleCount + gl_InstanceIndex];
+    vec4 positionAge = positionBuffer.positionAge[particle];
+    float lifetime = velocityBuffer.velocityLifetime[particle].w;
+
+    // Shrinks and fades out towards the end of its life
+    float life = 1.0 - clamp(positionAge.w / lifetime, 0.0, 1.0);
+    vec2 corner = corners[gl_VertexIndex];
+
+    // Billboard in view space, it always faces the camera
+    vec4 viewPosition = ubo.view * ubo.model * vec4(positionAge.xyz, 1.0);
+    viewPosition.xy += corner * parameters.size * (0.5 + 0.5 * life);
+    gl_Position = ubo.proj * viewPosition;
+
+    fragColor = vec4(unpackUnorm4x8(colorBuffer.colors[particle]).rgb, life);
+    fragCorner = corner;
+}
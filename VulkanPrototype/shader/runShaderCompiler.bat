@@ -1,5 +1,14 @@
 %VULKAN_SDK%\Bin\glslangValidator.exe -Od -g -V shader.vert || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V depthPrepass.vert -o depthPrepass.spv || EXIT /B
 %VULKAN_SDK%\Bin\glslangValidator.exe -g -V shader.frag || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V lightCulling.comp -o lightCulling.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V depthPyramid.comp -o depthPyramid.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V occlusionCulling.comp -o occlusionCulling.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V particle.vert -o particleVert.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V particle.frag -o particleFrag.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V particleEmit.comp -o particleEmit.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V particleSimulate.comp -o particleSimulate.spv || EXIT /B
+%VULKAN_SDK%\Bin\glslangValidator.exe -g -V particleArguments.comp -o particleArguments.spv || EXIT /B
 
 XCOPY *.spv ..\..\out\bin\Debug\VulkanPrototype\shader\ /C /S /D /Y /I
 XCOPY *.spv ..\..\out\bin\Release\VulkanPrototype\shader\ /C /S /D /Y /I
\ No newline at end of file
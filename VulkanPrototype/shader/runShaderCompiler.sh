@@ -1,2 +1,11 @@
 glslc -c shader.frag -o frag.spv
 glslc -c shader.vert -o vert.spv
+glslc -c depthPrepass.vert -o depthPrepass.spv
+glslc -c lightCulling.comp -o lightCulling.spv
+glslc -c depthPyramid.comp -o depthPyramid.spv
+glslc -c occlusionCulling.comp -o occlusionCulling.spv
+glslc -c particle.vert -o particleVert.spv
+glslc -c particle.frag -o particleFrag.spv
+glslc -c particleEmit.comp -o particleEmit.spv
+glslc -c particleSimulate.comp -o particleSimulate.spv
+glslc -c particleArguments.comp -o particleArguments.spv
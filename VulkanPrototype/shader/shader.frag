@@ -1,15 +1,125 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D textureSampler;
+// Has to match the cluster counts in Renderer.cpp and lightCulling.comp
+const uint clusterCountX = 16;
+const uint clusterCountY = 9;
+const uint clusterCountZ = 24;
+
+// Light of the unlit sides, the meshes have no normals of their own
+const float ambientLight = 0.3;
+
+// Features of the pipeline variant, see PipelineSpecialization. Disabled features are removed when the pipeline is created.
+layout(constant_id = 1) const bool texturing = true;
+
+// 0 shades normally, 1 shows the normals, 2 the light count of the cluster and 3 the material
+layout(constant_id = 2) const uint debugVisualization = 0;
+
+// Lights per cluster at which the light count view is fully red
+const float debugMaxClusterLights = 32.0;
+
+struct MaterialData {
+    vec4 baseColor;
+    uint textureIndex;
+};
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec4 clusterParameters;
+    uint lightCount;
+} ubo;
+
+// View space position and radius, color
+struct LightData {
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(std430, binding = 3) readonly buffer LightBuffer {
+    LightData lights[];
+} lightBuffer;
+
+// Offset into the light indices and light count per cluster, written by lightCulling.comp
+layout(std430, binding = 4) readonly buffer ClusterBuffer {
+    uvec2 clusters[];
+} clusterBuffer;
+
+layout(std430, binding = 5) readonly buffer LightIndexBuffer {
+    uint count;
+    uint indices[];
+} lightIndexBuffer;
+
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 1) uniform sampler textureSampler;
+
+layout(std430, set = 1, binding = 2) readonly buffer MaterialBuffer {
+    MaterialData materials[];
+} materialBuffer;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTextureCoordinate;
+layout(location = 2) flat in uint fragMaterialIndex;
+layout(location = 3) in vec3 fragViewPosition;
 
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
-    // outColor = texture(textureSampler, fragTextureCoordinate) * vec4(fragColor, 1.0);
-    outColor = vec4(fragColor, 1.0);
-}   
\ No newline at end of file
+    MaterialData material = materialBuffer.materials[fragMaterialIndex];
+
+    vec4 textureColor = vec4(1.0);
+
+    if (texturing)
+        textureColor = texture(sampler2D(textures[nonuniformEXT(material.textureIndex)], textureSampler), fragTextureCoordinate);
+
+    // Flat normal from the screen space derivatives, turned towards the camera
+    vec3 normal = normalize(cross(dFdx(fragViewPosition), dFdy(fragViewPosition)));
+    normal = faceforward(normal, fragViewPosition, normal);
+
+    if (debugVisualization == 1)
+    {
+        outColor = vec4(normal * 0.5 + 0.5, 1.0);
+        return;
+    }
+
+    if (debugVisualization == 3)
+    {
+        // Neighbouring indices get clearly different hues
+        outColor = vec4(fract(vec3(fragMaterialIndex) * vec3(0.618, 0.381, 0.273) + vec3(0.1, 0.5, 0.8)), 1.0);
+        return;
+    }
+
+    // The same tiles and exponential depth slices as in lightCulling.comp
+    float near = ubo.clusterParameters.z;
+    float far = ubo.clusterParameters.w;
+    float slice = log(-fragViewPosition.z / near) / log(far / near) * float(clusterCountZ);
+
+    uvec3 cluster = uvec3(min(uvec2(gl_FragCoord.xy / ubo.clusterParameters.xy * vec2(clusterCountX, clusterCountY)), uvec2(clusterCountX - 1, clusterCountY - 1)),
+        min(uint(max(slice, 0.0)), clusterCountZ - 1));
+    uvec2 clusterLights = clusterBuffer.clusters[cluster.x + cluster.y * clusterCountX + cluster.z * clusterCountX * clusterCountY];
+
+    if (debugVisualization == 2)
+    {
+        float heat = min(float(clusterLights.y) / debugMaxClusterLights, 1.0);
+        outColor = vec4(mix(vec3(0.0, 0.0, 0.5), vec3(1.0, 0.0, 0.0), heat), 1.0);
+        return;
+    }
+
+    vec3 lighting = vec3(ambientLight);
+
+    for (uint i = 0; i < clusterLights.y; i++)
+    {
+        LightData light = lightBuffer.lights[lightIndexBuffer.indices[clusterLights.x + i]];
+
+        vec3 toLight = light.positionRadius.xyz - fragViewPosition;
+        float distanceSquared = dot(toLight, toLight);
+        float falloff = clamp(1.0 - distanceSquared / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+
+        lighting += light.color.rgb * max(dot(normal, toLight * inversesqrt(distanceSquared)), 0.0) * falloff * falloff;
+    }
+
+    outColor = textureColor * material.baseColor * vec4(fragColor * lighting, 1.0);
+}
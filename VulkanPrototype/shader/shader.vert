@@ -4,29 +4,122 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 proj;
+    vec4 clusterParameters;
+    uint lightCount;
+    float interpolationFactor;
 } ubo;
 
 struct GameObjectData {
-    vec3 position;
+    uint transformIndex;
+    uint materialIndex;
+    uint meshIndex;
+    uint drawIndex;
+    uint objectId;
 };
 
-layout(std140, binding = 2) readonly buffer GameObjectBuffer {
+layout(std430, binding = 2) readonly buffer GameObjectBuffer {
     GameObjectData gameObjectData[];
 } gameObjectBuffer;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTextureCoordinate;
+// Rows of the affine world matrix, the last row is (0, 0, 0, 1), and the translation before the last simulation step
+struct ObjectTransform {
+    vec4 worldMatrixRows[3];
+    vec4 previousPosition;
+};
+
+// Only the slots that changed are written by the CPU, so the translation is interpolated here
+layout(std430, binding = 7) readonly buffer TransformBuffer {
+    ObjectTransform transforms[];
+} transformBuffer;
+
+// Written by occlusionCulling.comp, gl_InstanceIndex already contains the firstInstance of the draw
+layout(std430, binding = 6) readonly buffer VisibleInstanceBuffer {
+    uint objectIndices[];
+} visibleInstanceBuffer;
+
+// Instancing mode of the pipeline variant, see PipelineSpecialization: the direct draws carry their object in the push
+// constants, the instanced draws read it from the object buffer
+layout(constant_id = 0) const bool pushConstantDraws = false;
+
+// Per draw data of the direct draws, see DrawPushConstants
+layout(push_constant) uniform DrawParameters {
+    vec4 worldMatrixRows[3];
+    uint objectIndex;
+    uint materialIndex;
+    uint meshIndex;
+    uint lod;
+} drawParameters;
+
+// Dequantization of the mesh positions, see VertexQuantization
+struct MeshData {
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+layout(std430, set = 1, binding = 3) readonly buffer MeshBuffer {
+    MeshData meshes[];
+} meshBuffer;
+
+// QuantizedVertex, 16 bytes: snorm16x4 position, unorm8x4 color and half2 texture coordinate.
+// gl_VertexIndex already contains the vertexOffset of the draw, so it addresses the whole geometry buffer.
+layout(std430, set = 1, binding = 4) readonly buffer GeometryBuffer {
+    uvec4 vertices[];
+} geometryBuffer;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTextureCoordinate;
+layout(location = 2) flat out uint fragMaterialIndex;
+layout(location = 3) out vec3 fragViewPosition;
+
+// depthPrepass.vert computes the same positions, the color pass tests them with EQUAL
+invariant gl_Position;
 
 void main()
 {
-    vec3 globalPosition = inPosition + gameObjectBuffer.gameObjectData[gl_BaseInstance].position;
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(globalPosition, 1.0);
+    vec4 worldMatrixRows[3];
+    uint materialIndex;
+    uint meshIndex;
+
+    // No buffer was written for the direct draws
+    if (pushConstantDraws)
+    {
+        worldMatrixRows = drawParameters.worldMatrixRows;
+        materialIndex = drawParameters.materialIndex;
+        meshIndex = drawParameters.meshIndex;
+    }
+    else
+    {
+        GameObjectData gameObject = gameObjectBuffer.gameObjectData[visibleInstanceBuffer.objectIndices[gl_InstanceIndex]];
+        ObjectTransform transform = transformBuffer.transforms[gameObject.transformIndex];
+
+        worldMatrixRows = transform.worldMatrixRows;
+        vec3 translation = vec3(worldMatrixRows[0].w, worldMatrixRows[1].w, worldMatrixRows[2].w);
+        translation = mix(transform.previousPosition.xyz, translation, ubo.interpolationFactor);
+        worldMatrixRows[0].w = translation.x;
+        worldMatrixRows[1].w = translation.y;
+        worldMatrixRows[2].w = translation.z;
+
+        materialIndex = gameObject.materialIndex;
+        meshIndex = gameObject.meshIndex;
+    }
+
+    MeshData mesh = meshBuffer.meshes[meshIndex];
+
+    uvec4 vertex = geometryBuffer.vertices[gl_VertexIndex];
+    vec3 inPosition = vec3(unpackSnorm2x16(vertex.x), unpackSnorm2x16(vertex.y).x);
+    vec4 inColor = unpackUnorm4x8(vertex.z);
+    vec2 inTextureCoordinate = unpackHalf2x16(vertex.w);
+
+    vec3 position = mesh.positionOffset.xyz + inPosition * mesh.positionScale.xyz;
+
+    vec4 localPosition = vec4(position, 1.0);
+    vec3 globalPosition = vec3(dot(worldMatrixRows[0], localPosition), dot(worldMatrixRows[1], localPosition), dot(worldMatrixRows[2], localPosition));
+    vec4 viewPosition = ubo.view * ubo.model * vec4(globalPosition, 1.0);
+    gl_Position = ubo.proj * viewPosition;
     
     // gl_Position = vec4(inPosition, 1.0);
-    fragColor = inColor;
+    fragColor = inColor.rgb;
     fragTextureCoordinate = inTextureCoordinate;
+    fragMaterialIndex = materialIndex;
+    fragViewPosition = viewPosition.xyz;
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "AssetLoader.h"
+
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "../Jobs/JobSystem.h"
+
+namespace VulkanPrototype::Assets
+{
+    /*
+    * Module Global Variables
+    */
+
+    // Decodes that are queued on the job system or currently running
+    static Jobs::Counter pendingJobs;
+
+    // Blocking reads have their own thread, so neither a worker nor a frame waiting in Jobs::Wait ever waits for the disk
+    static std::thread readThread;
+    static std::deque<std::function<void()>> queuedReads;
+    static std::mutex readMutex;
+    static std::condition_variable readCondition;
+    static std::atomic<uint32_t> pendingReads = 0;
+    static bool stopReadThread = false;
+
+    static std::vector<std::coroutine_handle<>> mainThreadContinuations;
+    static std::mutex mainThreadMutex;
+
+    /*
+     * Private Functions
+     */
+
+    static std::vector<char> readFile(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht geoeffnet werden!");
+        }
+
+        std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(buffer.data(), buffer.size());
+
+        return buffer;
+    }
+
+    static void readLoop()
+    {
+        // The decodes started from here go into an own deque, where they are only stolen by idle threads
+        Jobs::RegisterThread();
+
+        while (true)
+        {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(readMutex);
+                readCondition.wait(lock, [] { return stopReadThread || !queuedReads.empty(); });
+
+                if (queuedReads.empty())
+                    break;
+
+                job = std::move(queuedReads.front());
+                queuedReads.pop_front();
+            }
+
+            try
+            {
+                job();
+            }
+            catch (std::exception& ex)
+            {
+                std::cerr << "Asset: " << ex.what() << std::endl;
+            }
+
+            pendingReads--;
+        }
+
+        Jobs::UnregisterThread();
+    }
+
+    static bool hasMainThreadContinuations()
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        return !mainThreadContinuations.empty();
+    }
+
+    /*
+     * Member Functions
+     */
+
+    void Task::promise_type::unhandled_exception()
+    {
+        // A failed load keeps its placeholder, the exception only gets reported
+        try
+        {
+            throw;
+        }
+        catch (std::exception& ex)
+        {
+            std::cerr << "Asset: " << ex.what() << std::endl;
+        }
+    }
+
+    void ReadThreadAwaiter::await_suspend(std::coroutine_handle<> continuation) const
+    {
+        ScheduleRead([continuation] { continuation.resume(); });
+    }
+
+    void WorkerAwaiter::await_suspend(std::coroutine_handle<> continuation) const
+    {
+        Schedule([continuation] { continuation.resume(); });
+    }
+
+    void MainThreadAwaiter::await_suspend(std::coroutine_handle<> continuation) const
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        mainThreadContinuations.push_back(continuation);
+    }
+
+    /*
+     * Global Functions
+     */
+
+    void Initialize()
+    {
+        stopReadThread = false;
+        readThread = std::thread(readLoop);
+    }
+
+    void Cleanup()
+    {
+        // Finish outstanding loads so no coroutine is left suspended
+        while (pendingReads > 0 || !pendingJobs.isDone() || hasMainThreadContinuations())
+        {
+            Update();
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(readMutex);
+            stopReadThread = true;
+        }
+
+        readCondition.notify_all();
+        readThread.join();
+    }
+
+    void Update()
+    {
+        std::vector<std::coroutine_handle<>> continuations;
+
+        {
+            std::lock_guard<std::mutex> lock(mainThreadMutex);
+            continuations.swap(mainThreadContinuations);
+        }
+
+        for (std::coroutine_handle<> continuation : continuations)
+            continuation.resume();
+    }
+
+    void Schedule(std::function<void()> job)
+    {
+        Jobs::Run(std::move(job), &pendingJobs);
+    }
+
+    void ScheduleRead(std::function<void()> job)
+    {
+        pendingReads++;
+
+        {
+            std::lock_guard<std::mutex> lock(readMutex);
+            queuedReads.push_back(std::move(job));
+        }
+
+        readCondition.notify_one();
+    }
+
+    AssetHandle<std::vector<char>> LoadFile(const std::string& filename)
+    {
+        return Async([filename] { return readFile(filename); }, ScheduleRead);
+    }
+}
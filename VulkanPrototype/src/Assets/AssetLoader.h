@@ -0,0 +1,215 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace VulkanPrototype::Assets
+{
+    /*
+    * Helper Structs for the Asset Loader
+    */
+
+    template<typename T>
+    struct AssetState
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::optional<T> value;
+        std::exception_ptr exception;
+        bool ready = false;
+        std::vector<std::coroutine_handle<>> waiters;
+
+        void complete(std::optional<T>&& result, std::exception_ptr error)
+        {
+            std::vector<std::coroutine_handle<>> continuations;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                value = std::move(result);
+                exception = error;
+                ready = true;
+                continuations.swap(waiters);
+            }
+
+            condition.notify_all();
+
+            // Awaiting coroutines continue on the thread that finished the asset
+            for (std::coroutine_handle<> continuation : continuations)
+                continuation.resume();
+        }
+    };
+
+    /// <summary>
+    /// Handle auf ein Asset, das im Hintergrund geladen wird. Kann mit co_await erwartet oder mit get() blockierend abgefragt werden.
+    /// </summary>
+    template<typename T>
+    class AssetHandle
+    {
+    public:
+        AssetHandle() = default;
+        explicit AssetHandle(std::shared_ptr<AssetState<T>> state) : state(std::move(state)) {}
+
+        bool isValid() const
+        {
+            return state != nullptr;
+        }
+
+        bool isReady() const
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            return state->ready;
+        }
+
+        const T& get() const
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->condition.wait(lock, [this] { return state->ready; });
+
+            if (state->exception)
+                std::rethrow_exception(state->exception);
+
+            return *state->value;
+        }
+
+        bool await_ready() const
+        {
+            return isReady();
+        }
+
+        bool await_suspend(std::coroutine_handle<> continuation) const
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            if (state->ready)
+                return false;
+
+            state->waiters.push_back(continuation);
+            return true;
+        }
+
+        const T& await_resume() const
+        {
+            return get();
+        }
+
+    private:
+        std::shared_ptr<AssetState<T>> state;
+    };
+
+    /// <summary>
+    /// Coroutine ohne Rueckgabewert fuer Ladeketten, die mit ResumeOnReadThread/ResumeOnWorker/ResumeOnMainThread zwischen den Threads wechseln.
+    /// </summary>
+    struct Task
+    {
+        struct promise_type
+        {
+            Task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception();
+        };
+    };
+
+    struct ReadThreadAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> continuation) const;
+        void await_resume() const noexcept {}
+    };
+
+    struct WorkerAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> continuation) const;
+        void await_resume() const noexcept {}
+    };
+
+    struct MainThreadAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> continuation) const;
+        void await_resume() const noexcept {}
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Startet den Lese Thread. Dekodiert wird auf dem Job System, Jobs::Initialize muss vorher gerufen werden.
+    /// </summary>
+    void Initialize();
+
+    /// <summary>
+    /// Wartet auf alle ausstehenden Ladevorgaenge und beendet danach den Lese Thread. Muss vor Jobs::Cleanup gerufen werden.
+    /// </summary>
+    void Cleanup();
+
+    /// <summary>
+    /// Fuehrt alle Coroutines aus, die mit ResumeOnMainThread auf den Hauptthread warten. Wird einmal pro Frame gerufen.
+    /// </summary>
+    void Update();
+
+    /// <summary>
+    /// Dekodieren und Kopieren laufen als Jobs auf dem Job System und verteilen sich mit der Arbeit der Frames auf die Worker.
+    /// </summary>
+    void Schedule(std::function<void()> job);
+
+    /// <summary>
+    /// Blockierendes Lesen von der Platte. Die Jobs laufen nacheinander auf dem Lese Thread und belegen nie einen Worker.
+    /// </summary>
+    void ScheduleRead(std::function<void()> job);
+
+    AssetHandle<std::vector<char>> LoadFile(const std::string& filename);
+
+    inline ReadThreadAwaiter ResumeOnReadThread()
+    {
+        return {};
+    }
+
+    inline WorkerAwaiter ResumeOnWorker()
+    {
+        return {};
+    }
+
+    inline MainThreadAwaiter ResumeOnMainThread()
+    {
+        return {};
+    }
+
+    template<typename F>
+    AssetHandle<std::invoke_result_t<F>> Async(F function, void (*schedule)(std::function<void()>) = Schedule)
+    {
+        using T = std::invoke_result_t<F>;
+
+        auto state = std::make_shared<AssetState<T>>();
+
+        schedule([state, function]() mutable
+        {
+            try
+            {
+                state->complete(function(), nullptr);
+            }
+            catch (...)
+            {
+                state->complete(std::nullopt, std::current_exception());
+            }
+        });
+
+        return AssetHandle<T>(state);
+    }
+}
+
+#endif // ASSETLOADER_H
@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VulkanPrototype::Assets
+{
+    /*
+     * Global Functions
+     */
+
+#ifdef _WIN32
+    MappedFile MapFile(const std::string& filename)
+    {
+        MappedFile file;
+
+        // Sequential scan lets the cache manager read ahead aggressively
+        HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht geoeffnet werden!");
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Datei \"" + filename + "\" ist leer!");
+        }
+
+        HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr)
+        {
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht abgebildet werden!");
+        }
+
+        const void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr)
+        {
+            CloseHandle(mappingHandle);
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht abgebildet werden!");
+        }
+
+        file.data = static_cast<const uint8_t*>(data);
+        file.size = static_cast<uint64_t>(fileSize.QuadPart);
+        file.fileHandle = fileHandle;
+        file.mappingHandle = mappingHandle;
+
+        return file;
+    }
+
+    void UnmapFile(MappedFile& file)
+    {
+        if (file.data == nullptr)
+            return;
+
+        UnmapViewOfFile(file.data);
+        CloseHandle(file.mappingHandle);
+        CloseHandle(file.fileHandle);
+
+        file = {};
+    }
+#else
+    MappedFile MapFile(const std::string& filename)
+    {
+        MappedFile file;
+
+        int fileDescriptor = open(filename.c_str(), O_RDONLY);
+        if (fileDescriptor < 0)
+            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht geoeffnet werden!");
+
+        struct stat fileStatus;
+        if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error("Datei \"" + filename + "\" ist leer!");
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+        // The mapping keeps its own reference to the file
+        close(fileDescriptor);
+
+        if (data == MAP_FAILED)
+            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht abgebildet werden!");
+
+        // The file is consumed front to back exactly once, so read ahead and drop pages behind
+        madvise(data, static_cast<size_t>(fileStatus.st_size), MADV_SEQUENTIAL);
+
+        file.data = static_cast<const uint8_t*>(data);
+        file.size = static_cast<uint64_t>(fileStatus.st_size);
+
+        return file;
+    }
+
+    void UnmapFile(MappedFile& file)
+    {
+        if (file.data == nullptr)
+            return;
+
+        munmap(const_cast<uint8_t*>(file.data), static_cast<size_t>(file.size));
+
+        file = {};
+    }
+#endif
+
+    void PrefetchFile(const MappedFile& file)
+    {
+        // The smallest page size of both platforms, one volatile read per page that the compiler can not drop
+        const uint64_t pageSize = 4096;
+        const volatile uint8_t* data = file.data;
+
+        for (uint64_t offset = 0; offset < file.size; offset += pageSize)
+            (void)data[offset];
+    }
+}
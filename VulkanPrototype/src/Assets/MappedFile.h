@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+
+namespace VulkanPrototype::Assets
+{
+    /*
+    * Helper Structs for memory mapped Files
+    */
+
+    struct MappedFile
+    {
+        const uint8_t* data = nullptr;
+        uint64_t size = 0;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Bildet eine Datei schreibgeschuetzt in den Speicher ab. Die Seiten werden erst beim Zugriff vom Betriebssystem gelesen,
+    /// ein memcpy aus data kopiert also direkt aus dem Page Cache.
+    /// </summary>
+    MappedFile MapFile(const std::string& filename);
+    void UnmapFile(MappedFile& file);
+
+    /// <summary>
+    /// Liest jede Seite der Datei einmal, danach kopieren Zugriffe auf data nur noch aus dem Page Cache und warten nicht auf die Platte.
+    /// </summary>
+    void PrefetchFile(const MappedFile& file);
+}
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,298 @@
+#include "JobSystem.h"
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace VulkanPrototype::Jobs
+{
+    /*
+    * Helper Structs for the Job System
+    */
+
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    /*
+    * Module Global Variables
+    */
+
+    // One queue per thread, index 0 belongs to the main thread, then the workers, then the slots for registered threads
+    static std::vector<std::unique_ptr<JobQueue>> queues;
+    static std::vector<std::thread> workers;
+
+    // The queues are created up front, so the workers never see the vector change while they steal
+    static const uint32_t maxRegisteredThreads = 4;
+    static std::atomic<uint32_t> registeredThreadMask = 0;
+
+    // Jobs that sit in any of the queues, workers only go to sleep while it is 0
+    static std::atomic<uint32_t> queuedJobs = 0;
+    static std::atomic<uint32_t> sleepingWorkers = 0;
+    static std::mutex sleepMutex;
+    static std::condition_variable sleepCondition;
+    static std::atomic<bool> stopWorkers = false;
+
+    // Threads that are not part of the job system and did not call RegisterThread share the queue of the main thread
+    static thread_local uint32_t threadIndex = 0;
+
+    /*
+     * Private Functions
+     */
+
+    static void pushJob(Job&& job)
+    {
+        // Counted before it becomes visible, so a thief never decrements below 0
+        queuedJobs++;
+
+        {
+            JobQueue& queue = *queues[threadIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+
+        // A worker increments sleepingWorkers before it checks queuedJobs, so one of both sees the other
+        if (sleepingWorkers > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+            }
+
+            sleepCondition.notify_one();
+        }
+    }
+
+    static bool tryGetJob(Job& job)
+    {
+        uint32_t queueCount = static_cast<uint32_t>(queues.size());
+
+        // The own queue is used as a stack, the newest job still has its data in the cache
+        {
+            JobQueue& queue = *queues[threadIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                queuedJobs--;
+                return true;
+            }
+        }
+
+        // Other queues are stolen from the front, where the oldest and usually biggest jobs are
+        for (uint32_t i = 1; i < queueCount; i++)
+        {
+            JobQueue& queue = *queues[(threadIndex + i) % queueCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                queuedJobs--;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static void finishJob(Counter* counter)
+    {
+        if (counter == nullptr)
+            return;
+
+        std::vector<Job> continuations;
+
+        {
+            std::lock_guard<std::mutex> lock(counter->mutex);
+
+            if (--counter->value == 0)
+                continuations.swap(counter->continuations);
+        }
+
+        // The counter may already be destroyed by a waiting thread, only the local copy is used from here on
+        for (Job& continuation : continuations)
+            pushJob(std::move(continuation));
+    }
+
+    static void executeJob(Job& job)
+    {
+        // A throwing job must still finish its counter, otherwise every Wait on it would hang
+        try
+        {
+            job.function();
+        }
+        catch (std::exception& ex)
+        {
+            std::cerr << "Job: " << ex.what() << std::endl;
+        }
+
+        finishJob(job.counter);
+    }
+
+    static void workerLoop(uint32_t index)
+    {
+        threadIndex = index;
+
+        while (true)
+        {
+            Job job;
+
+            if (tryGetJob(job))
+            {
+                executeJob(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+
+            sleepingWorkers++;
+            sleepCondition.wait(lock, [] { return stopWorkers || queuedJobs > 0; });
+            sleepingWorkers--;
+
+            if (stopWorkers && queuedJobs == 0)
+                return;
+        }
+    }
+
+    /*
+     * Member Functions
+     */
+
+    bool Counter::isDone()
+    {
+        // Only 0 needs the lock, finishJob might still be taking the continuations
+        if (value != 0)
+            return false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return value == 0;
+    }
+
+    /*
+     * Global Functions
+     */
+
+    void Initialize(uint32_t threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+        stopWorkers = false;
+        threadIndex = 0;
+        registeredThreadMask = 0;
+
+        for (uint32_t i = 0; i <= threadCount + maxRegisteredThreads; i++)
+            queues.push_back(std::make_unique<JobQueue>());
+
+        for (uint32_t i = 0; i < threadCount; i++)
+            workers.emplace_back(workerLoop, i + 1);
+    }
+
+    void Cleanup()
+    {
+        // Jobs that are still queued run before the workers stop
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopWorkers = true;
+        }
+
+        sleepCondition.notify_all();
+
+        for (std::thread& worker : workers)
+            worker.join();
+
+        workers.clear();
+        queues.clear();
+    }
+
+    void RegisterThread()
+    {
+        uint32_t mask = registeredThreadMask;
+        uint32_t slot;
+
+        do
+        {
+            slot = 0;
+            while (slot < maxRegisteredThreads && (mask & (1u << slot)) != 0)
+                slot++;
+
+            if (slot == maxRegisteredThreads)
+                throw std::runtime_error("Es koennen maximal " + std::to_string(maxRegisteredThreads) + " Threads beim Job System registriert werden!");
+        }
+        while (!registeredThreadMask.compare_exchange_weak(mask, mask | (1u << slot)));
+
+        threadIndex = static_cast<uint32_t>(workers.size()) + 1 + slot;
+    }
+
+    void UnregisterThread()
+    {
+        // The main thread, the workers and threads that never registered have no slot to give back
+        uint32_t firstSlotIndex = static_cast<uint32_t>(workers.size()) + 1;
+        if (threadIndex < firstSlotIndex || threadIndex >= firstSlotIndex + maxRegisteredThreads)
+            return;
+
+        // Jobs left in the queue are stolen by the workers, nothing gets lost
+        uint32_t slot = threadIndex - firstSlotIndex;
+        registeredThreadMask &= ~(1u << slot);
+
+        threadIndex = 0;
+    }
+
+    uint32_t GetThreadCount()
+    {
+        return static_cast<uint32_t>(queues.size());
+    }
+
+    uint32_t GetThreadIndex()
+    {
+        return threadIndex;
+    }
+
+    void Run(std::function<void()> function, Counter* counter)
+    {
+        if (counter != nullptr)
+            counter->value++;
+
+        pushJob({ std::move(function), counter });
+    }
+
+    void RunAfter(Counter& dependency, std::function<void()> function, Counter* counter)
+    {
+        if (counter != nullptr)
+            counter->value++;
+
+        {
+            std::lock_guard<std::mutex> lock(dependency.mutex);
+
+            if (dependency.value != 0)
+            {
+                dependency.continuations.push_back({ std::move(function), counter });
+                return;
+            }
+        }
+
+        pushJob({ std::move(function), counter });
+    }
+
+    void Wait(Counter& counter)
+    {
+        while (!counter.isDone())
+        {
+            Job job;
+
+            if (tryGetJob(job))
+                executeJob(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace VulkanPrototype::Jobs
+{
+    struct Counter;
+
+    /*
+    * Helper Structs for the Job System
+    */
+
+    struct Job
+    {
+        std::function<void()> function;
+
+        // Decremented once the function has returned, may be null
+        Counter* counter = nullptr;
+    };
+
+    /// <summary>
+    /// Zaehlt die Jobs, die noch nicht fertig sind. Jeder Run mit diesem Counter erhoeht ihn, jeder fertige Job verringert ihn.
+    /// Jobs, die mit RunAfter auf den Counter warten, werden gestartet, sobald er 0 erreicht.
+    /// Ein Counter darf erst zerstoert oder neu verwendet werden, wenn Wait zurueckgekehrt ist.
+    /// </summary>
+    struct Counter
+    {
+        // Only changed while the mutex is held, so isDone can not see 0 before the continuations were taken
+        std::atomic<uint32_t> value = 0;
+        std::mutex mutex;
+        std::vector<Job> continuations;
+
+        Counter() = default;
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+        bool isDone();
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Startet threadCount Worker, jeder mit einer eigenen Deque. Ohne Angabe ein Worker pro Kern neben dem Hauptthread.
+    /// Freie Worker stehlen Jobs vom anderen Ende der Deques der uebrigen Threads.
+    /// </summary>
+    void Initialize(uint32_t threadCount = 0);
+    void Cleanup();
+
+    /// <summary>
+    /// Gibt einem Thread ausserhalb des Job Systems (z.B. dem Render Thread) einen eigenen Index und eine eigene Deque,
+    /// damit er Run und Wait nutzen kann, ohne sich Index 0 mit dem Hauptthread zu teilen. Vor dem Ende des Threads
+    /// muss UnregisterThread gerufen werden.
+    /// </summary>
+    void RegisterThread();
+    void UnregisterThread();
+
+    /// <summary>
+    /// Anzahl der Indices, die GetThreadIndex liefern kann. GetThreadIndex liefert 0 fuer den Hauptthread, danach folgen
+    /// die Worker und die registrierten Threads, damit lassen sich Daten pro Thread ohne Locks anlegen.
+    /// </summary>
+    uint32_t GetThreadCount();
+    uint32_t GetThreadIndex();
+
+    void Run(std::function<void()> function, Counter* counter = nullptr);
+
+    /// <summary>
+    /// Startet den Job erst, wenn dependency 0 erreicht hat. counter zaehlt den Job schon ab diesem Aufruf.
+    /// </summary>
+    void RunAfter(Counter& dependency, std::function<void()> function, Counter* counter = nullptr);
+
+    /// <summary>
+    /// Wartet, bis counter 0 erreicht. Solange fuehrt der Thread selbst Jobs aus, statt zu blockieren,
+    /// deshalb darf Wait auch innerhalb eines Jobs gerufen werden.
+    /// </summary>
+    void Wait(Counter& counter);
+
+    /// <summary>
+    /// Teilt [0, count) in Bloecke von batchSize auf und ruft function(begin, end) fuer jeden Block als eigenen Job.
+    /// Passt alles in einen Block, wird function direkt auf dem aufrufenden Thread ausgefuehrt.
+    /// </summary>
+    template<typename F>
+    void ParallelFor(uint32_t count, uint32_t batchSize, F function, Counter& counter)
+    {
+        if (count <= batchSize)
+        {
+            if (count > 0)
+                function(0u, count);
+
+            return;
+        }
+
+        for (uint32_t begin = 0; begin < count; begin += batchSize)
+        {
+            uint32_t end = std::min(begin + batchSize, count);
+            Run([function, begin, end]() { function(begin, end); }, &counter);
+        }
+    }
+}
+
+#endif // JOBSYSTEM_H
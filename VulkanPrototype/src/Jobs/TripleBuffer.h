@@ -0,0 +1,56 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace VulkanPrototype::Jobs
+{
+    /// <summary>
+    /// Lock-freier Dreifachpuffer fuer genau einen schreibenden und einen lesenden Thread.
+    /// Der Schreiber fuellt getWriteBuffer() und gibt ihn mit publish() frei, der Leser holt sich mit consume() den zuletzt
+    /// freigegebenen Puffer. Keiner der beiden wartet auf den anderen, nicht gelesene Puffer werden vom naechsten publish() ersetzt.
+    /// </summary>
+    template<typename T>
+    class TripleBuffer
+    {
+    public:
+        T& getWriteBuffer()
+        {
+            return buffers[writeIndex];
+        }
+
+        void publish()
+        {
+            // The written buffer becomes the middle one, the old middle one is written next
+            writeIndex = middle.exchange(static_cast<uint8_t>(writeIndex | publishedBit), std::memory_order_acq_rel) & indexMask;
+        }
+
+        bool consume()
+        {
+            if ((middle.load(std::memory_order_relaxed) & publishedBit) == 0)
+                return false;
+
+            readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+            return true;
+        }
+
+        T& getReadBuffer()
+        {
+            return buffers[readIndex];
+        }
+
+    private:
+        static constexpr uint8_t indexMask = 0x3;
+        static constexpr uint8_t publishedBit = 0x4;
+
+        T buffers[3];
+
+        // Each index is only touched by its own thread, the middle one is handed over through the atomic
+        uint8_t writeIndex = 0;
+        uint8_t readIndex = 1;
+        std::atomic<uint8_t> middle = 2;
+    };
+}
+
+#endif // TRIPLEBUFFER_H
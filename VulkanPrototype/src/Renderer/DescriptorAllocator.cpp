@@ -0,0 +1,179 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Module Global Variables
+    */
+
+    static const uint32_t maxSetsPerPool = 4096;
+
+    /*
+     * Member Functions
+     */
+
+    void DescriptorAllocator::initialize(VkDevice device, const VkAllocationCallbacks* pAllocator, uint32_t initialSets, const std::vector<DescriptorPoolSizeRatio>& poolSizeRatios, VkDescriptorPoolCreateFlags poolFlags)
+    {
+        this->device = device;
+        this->pAllocator = pAllocator;
+        this->poolSizeRatios = poolSizeRatios;
+        this->poolFlags = poolFlags;
+
+        readyPools.push_back(createPool(initialSets));
+
+        // The next pool in the chain is bigger, so a steady workload ends up in few pools
+        setsPerPool = std::min(initialSets + initialSets / 2, maxSetsPerPool);
+    }
+
+    void DescriptorAllocator::cleanup()
+    {
+        for (VkDescriptorPool pool : readyPools)
+            vkDestroyDescriptorPool(device, pool, pAllocator);
+
+        for (VkDescriptorPool pool : fullPools)
+            vkDestroyDescriptorPool(device, pool, pAllocator);
+
+        readyPools.clear();
+        fullPools.clear();
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, const void* pNext)
+    {
+        VkResult result;
+
+        VkDescriptorPool pool = getPool();
+
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = pNext,
+            .descriptorPool = pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &layout
+        };
+
+        VkDescriptorSet descriptorSet;
+        result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet);
+
+        // The pool is exhausted, retire it and try once more with the next one in the chain
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+        {
+            fullPools.push_back(pool);
+
+            pool = getPool();
+            descriptorSetAllocateInfo.descriptorPool = pool;
+
+            result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet);
+        }
+
+        readyPools.push_back(pool);
+
+        if (result != VK_SUCCESS)
+            throw std::runtime_error("Descriptor Set konnte nicht allokiert werden!");
+
+        return descriptorSet;
+    }
+
+    void DescriptorAllocator::reset()
+    {
+        for (VkDescriptorPool pool : readyPools)
+            vkResetDescriptorPool(device, pool, 0);
+
+        for (VkDescriptorPool pool : fullPools)
+        {
+            vkResetDescriptorPool(device, pool, 0);
+            readyPools.push_back(pool);
+        }
+
+        fullPools.clear();
+    }
+
+    uint32_t DescriptorAllocator::getPoolCount() const
+    {
+        return static_cast<uint32_t>(readyPools.size() + fullPools.size());
+    }
+
+    VkDescriptorPool DescriptorAllocator::createPool(uint32_t setCount)
+    {
+        VkResult result;
+
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const DescriptorPoolSizeRatio& poolSizeRatio : poolSizeRatios)
+        {
+            poolSizes.push_back(
+            {
+                .type = poolSizeRatio.type,
+                .descriptorCount = std::max(static_cast<uint32_t>(poolSizeRatio.ratio * setCount), 1u)
+            });
+        }
+
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = poolFlags,
+            .maxSets = setCount,
+            .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+            .pPoolSizes = poolSizes.data()
+        };
+
+        VkDescriptorPool pool;
+        result = vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, pAllocator, &pool);
+
+        if (result != VK_SUCCESS)
+            throw std::runtime_error("Descriptor Pool konnte nicht erstellt werden!");
+
+        return pool;
+    }
+
+    VkDescriptorPool DescriptorAllocator::getPool()
+    {
+        if (!readyPools.empty())
+        {
+            VkDescriptorPool pool = readyPools.back();
+            readyPools.pop_back();
+
+            return pool;
+        }
+
+        VkDescriptorPool pool = createPool(setsPerPool);
+        setsPerPool = std::min(setsPerPool + setsPerPool / 2, maxSetsPerPool);
+
+        return pool;
+    }
+
+    /*
+     * Global Functions
+     */
+
+    VkDescriptorUpdateTemplate createDescriptorUpdateTemplate(VkDevice device, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry>& entries, VkPipelineLayout pipelineLayout, uint32_t set, bool pushDescriptors,
+        VkPipelineBindPoint pipelineBindPoint)
+    {
+        VkResult result;
+
+        VkDescriptorUpdateTemplateCreateInfo descriptorUpdateTemplateCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size()),
+            .pDescriptorUpdateEntries = entries.data(),
+            .templateType = pushDescriptors ? VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR : VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+            .descriptorSetLayout = layout,
+            .pipelineBindPoint = pipelineBindPoint,
+            .pipelineLayout = pipelineLayout,
+            .set = set
+        };
+
+        VkDescriptorUpdateTemplate descriptorUpdateTemplate;
+        result = vkCreateDescriptorUpdateTemplate(device, &descriptorUpdateTemplateCreateInfo, pAllocator, &descriptorUpdateTemplate);
+
+        if (result != VK_SUCCESS)
+            throw std::runtime_error("Descriptor Update Template konnte nicht erstellt werden!");
+
+        return descriptorUpdateTemplate;
+    }
+}
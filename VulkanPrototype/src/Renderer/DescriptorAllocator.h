@@ -0,0 +1,64 @@
+#ifndef DESCRIPTORALLOCATOR_H
+#define DESCRIPTORALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Helper Structs for the Descriptor Allocator
+    */
+
+    struct DescriptorPoolSizeRatio
+    {
+        VkDescriptorType type;
+        float ratio;
+    };
+
+    /// <summary>
+    /// Verteilt Descriptor Sets aus einer Kette von Pools. Ist ein Pool voll, wird ein neuer, groesserer Pool angehaengt.
+    /// reset() setzt alle Pools auf einmal zurueck, damit lassen sich Sets verwalten, die nur einen Frame lang leben.
+    /// </summary>
+    struct DescriptorAllocator
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        const VkAllocationCallbacks* pAllocator = nullptr;
+
+        std::vector<DescriptorPoolSizeRatio> poolSizeRatios;
+        VkDescriptorPoolCreateFlags poolFlags = 0;
+        uint32_t setsPerPool = 0;
+
+        // Pools that ran out of memory and pools that can still hand out sets
+        std::vector<VkDescriptorPool> fullPools;
+        std::vector<VkDescriptorPool> readyPools;
+
+        void initialize(VkDevice device, const VkAllocationCallbacks* pAllocator, uint32_t initialSets, const std::vector<DescriptorPoolSizeRatio>& poolSizeRatios, VkDescriptorPoolCreateFlags poolFlags = 0);
+        void cleanup();
+
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout, const void* pNext = nullptr);
+        void reset();
+
+        uint32_t getPoolCount() const;
+
+    private:
+        VkDescriptorPool createPool(uint32_t setCount);
+        VkDescriptorPool getPool();
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Erstellt ein Update Template fuer das Set mit der Nummer set. Mit pushDescriptors wird das Template fuer
+    /// vkCmdPushDescriptorSetWithTemplateKHR erstellt, sonst fuer vkUpdateDescriptorSetWithTemplate.
+    /// pipelineBindPoint wird nur fuer Push Descriptors gebraucht.
+    /// </summary>
+    VkDescriptorUpdateTemplate createDescriptorUpdateTemplate(VkDevice device, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry>& entries, VkPipelineLayout pipelineLayout, uint32_t set, bool pushDescriptors,
+        VkPipelineBindPoint pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+}
+
+#endif // DESCRIPTORALLOCATOR_H
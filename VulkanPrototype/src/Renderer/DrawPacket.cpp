@@ -0,0 +1,115 @@
+#include "DrawPacket.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+     * Global Functions
+     */
+
+    uint64_t makeDrawKey(uint32_t pass, uint32_t pipeline, uint32_t draw, float depth)
+    {
+        // The bits of positive floats are ordered like their values, the upper half keeps the exponent and 7 mantissa bits
+        uint32_t depthBits;
+        depth = std::max(depth, 0.0f);
+        std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+        return ((pass & drawKeyFieldMask) << drawKeyPassShift) | ((pipeline & drawKeyFieldMask) << drawKeyPipelineShift) |
+            ((draw & drawKeyDrawMask) << drawKeyDrawShift) | (depthBits >> 16);
+    }
+
+    uint32_t getDrawKeyPass(uint64_t key)
+    {
+        return static_cast<uint32_t>((key >> drawKeyPassShift) & drawKeyFieldMask);
+    }
+
+    uint32_t getDrawKeyPipeline(uint64_t key)
+    {
+        return static_cast<uint32_t>((key >> drawKeyPipelineShift) & drawKeyFieldMask);
+    }
+
+    uint32_t getDrawKeyDraw(uint64_t key)
+    {
+        return static_cast<uint32_t>((key >> drawKeyDrawShift) & drawKeyDrawMask);
+    }
+
+    uint32_t getDrawKeyDepth(uint64_t key)
+    {
+        return static_cast<uint32_t>(key & drawKeyDepthMask);
+    }
+
+    void sortDrawPackets(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+    {
+        size_t count = packets.size();
+
+        if (count < 2)
+            return;
+
+        scratch.resize(count);
+
+        // The histograms of all eight bytes in one pass over the keys
+        uint32_t histograms[8][256] = {};
+
+        for (const DrawPacket& packet : packets)
+        {
+            for (uint32_t byte = 0; byte < 8; byte++)
+                histograms[byte][(packet.key >> (byte * 8)) & 0xFF]++;
+        }
+
+        DrawPacket* source = packets.data();
+        DrawPacket* destination = scratch.data();
+
+        for (uint32_t byte = 0; byte < 8; byte++)
+        {
+            uint32_t* histogram = histograms[byte];
+
+            // All keys share this byte, like the pass and pipeline of most frames
+            if (histogram[(source[0].key >> (byte * 8)) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+
+            for (uint32_t digit = 0; digit < 256; digit++)
+            {
+                uint32_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+
+            for (size_t i = 0; i < count; i++)
+                destination[histogram[(source[i].key >> (byte * 8)) & 0xFF]++] = source[i];
+
+            std::swap(source, destination);
+        }
+
+        if (source != packets.data())
+            packets.swap(scratch);
+    }
+
+    void buildDrawRanges(const std::vector<DrawPacket>& packets, std::vector<DrawRange>& ranges)
+    {
+        ranges.clear();
+
+        for (uint32_t i = 0; i < packets.size(); i++)
+        {
+            if (i == 0 || (packets[i].key >> drawKeyDrawShift) != (packets[i - 1].key >> drawKeyDrawShift))
+                ranges.push_back({ packets[i].key, i, 0 });
+
+            ranges.back().packetCount++;
+        }
+
+        // Only the draws inside a pass and pipeline are reordered, so the batches and their binds stay the same
+        auto begin = ranges.begin();
+
+        while (begin != ranges.end())
+        {
+            uint64_t batchKey = begin->key >> drawKeyPipelineShift;
+            auto end = std::find_if(begin, ranges.end(), [batchKey](const DrawRange& range) { return (range.key >> drawKeyPipelineShift) != batchKey; });
+
+            std::stable_sort(begin, end, [](const DrawRange& a, const DrawRange& b) { return getDrawKeyDepth(a.key) < getDrawKeyDepth(b.key); });
+            begin = end;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef DRAWPACKET_H
+#define DRAWPACKET_H
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Helper Structs for Draw Packets
+    */
+
+    // Bits of the sort key from the most to the least significant field: pass, pipeline, mesh and LOD, depth.
+    // The culling shader appends the instances of a draw in any order, so the depth does not order the instances but the draws:
+    // after the sort the first packet of a draw holds its nearest depth. Bits 16 to 31 stay free,
+    // bytes that are equal in all keys cost the radix sort nothing.
+    static const uint32_t drawKeyPassShift = 60;
+    static const uint32_t drawKeyPipelineShift = 56;
+    static const uint32_t drawKeyDrawShift = 32;
+    static const uint64_t drawKeyFieldMask = 0xF;
+    static const uint64_t drawKeyDrawMask = 0xFFFFFF;
+    static const uint64_t drawKeyDepthMask = 0xFFFF;
+
+    // Sorts behind every valid key, for objects that are not drawn
+    static const uint64_t noDrawKey = UINT64_MAX;
+
+    struct DrawPacket
+    {
+        uint64_t key;
+
+        // Index of the object in the frame packet
+        uint32_t object;
+    };
+
+    // Sorted packets of one mesh and LOD, drawn by one indirect command
+    struct DrawRange
+    {
+        // Key of the first packet, which has the nearest depth of the range
+        uint64_t key;
+        uint32_t firstPacket;
+        uint32_t packetCount;
+    };
+
+    // Consecutive draws with the same pass and pipeline, recorded with one indirect draw
+    struct DrawBatch
+    {
+        uint32_t pass;
+        uint32_t pipeline;
+        uint32_t firstDraw;
+        uint32_t drawCount;
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// depth ist die Entfernung in View Richtung, negative Werte werden wie 0 sortiert. Sie wird auf 16 Bit gekuerzt,
+    /// etwa ein Prozent der Entfernung reicht fuer die Reihenfolge von vorne nach hinten.
+    /// </summary>
+    uint64_t makeDrawKey(uint32_t pass, uint32_t pipeline, uint32_t draw, float depth);
+
+    uint32_t getDrawKeyPass(uint64_t key);
+    uint32_t getDrawKeyPipeline(uint64_t key);
+    uint32_t getDrawKeyDraw(uint64_t key);
+    uint32_t getDrawKeyDepth(uint64_t key);
+
+    /// <summary>
+    /// Stabiler LSD Radix Sort nach dem Schluessel, acht Bit pro Durchgang. Bytes, die in allen Schluesseln gleich sind,
+    /// werden uebersprungen. scratch wird als Zwischenpuffer benutzt, das Ergebnis steht danach in packets.
+    /// </summary>
+    void sortDrawPackets(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+
+    /// <summary>
+    /// Fasst die sortierten Pakete pro Mesh und LOD zu Bereichen zusammen. Innerhalb von Pass und Pipeline werden die Bereiche
+    /// nach ihrer naechsten Tiefe von vorne nach hinten geordnet, damit der fruehe Tiefentest auch zwischen den Draws greift.
+    /// </summary>
+    void buildDrawRanges(const std::vector<DrawPacket>& packets, std::vector<DrawRange>& ranges);
+}
+
+#endif // DRAWPACKET_H
@@ -0,0 +1,103 @@
+#include "GeometryAllocator.h"
+
+#include <algorithm>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+     * Member Functions
+     */
+
+    void GeometryAllocator::initialize(uint64_t capacity)
+    {
+        this->capacity = capacity;
+
+        freeRanges.clear();
+        freeRanges.push_back({ 0, capacity });
+    }
+
+    bool GeometryAllocator::allocate(uint64_t size, uint64_t alignment, GeometryAllocation& allocation)
+    {
+        if (size == 0 || alignment == 0)
+            return false;
+
+        for (auto range = freeRanges.begin(); range != freeRanges.end(); range++)
+        {
+            uint64_t alignedOffset = (range->offset + alignment - 1) / alignment * alignment;
+            uint64_t rangeEnd = range->offset + range->size;
+
+            if (alignedOffset + size > rangeEnd)
+                continue;
+
+            // The padding in front stays free, so freeing the allocation later needs only its aligned offset
+            GeometryAllocation front = { range->offset, alignedOffset - range->offset };
+            GeometryAllocation back = { alignedOffset + size, rangeEnd - alignedOffset - size };
+
+            if (front.size > 0 && back.size > 0)
+            {
+                *range = front;
+                freeRanges.insert(range + 1, back);
+            }
+            else if (front.size > 0)
+            {
+                *range = front;
+            }
+            else if (back.size > 0)
+            {
+                *range = back;
+            }
+            else
+            {
+                freeRanges.erase(range);
+            }
+
+            allocation = { alignedOffset, size };
+            return true;
+        }
+
+        return false;
+    }
+
+    void GeometryAllocator::free(const GeometryAllocation& allocation)
+    {
+        if (allocation.size == 0)
+            return;
+
+        auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), allocation.offset, [](const GeometryAllocation& range, uint64_t offset)
+        {
+            return range.offset < offset;
+        });
+
+        bool mergePrevious = next != freeRanges.begin() && (next - 1)->offset + (next - 1)->size == allocation.offset;
+        bool mergeNext = next != freeRanges.end() && allocation.offset + allocation.size == next->offset;
+
+        if (mergePrevious && mergeNext)
+        {
+            (next - 1)->size += allocation.size + next->size;
+            freeRanges.erase(next);
+        }
+        else if (mergePrevious)
+        {
+            (next - 1)->size += allocation.size;
+        }
+        else if (mergeNext)
+        {
+            next->offset = allocation.offset;
+            next->size += allocation.size;
+        }
+        else
+        {
+            freeRanges.insert(next, allocation);
+        }
+    }
+
+    uint64_t GeometryAllocator::getFreeSize() const
+    {
+        uint64_t freeSize = 0;
+
+        for (const GeometryAllocation& range : freeRanges)
+            freeSize += range.size;
+
+        return freeSize;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef GEOMETRYALLOCATOR_H
+#define GEOMETRYALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Helper Structs for the Geometry Allocator
+    */
+
+    struct GeometryAllocation
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    /// <summary>
+    /// Verteilt Bereiche eines grossen Buffers, aus dem alle Meshes ihre Vertices und Indices beziehen.
+    /// Die freien Bereiche werden nach Offset sortiert gehalten, vergeben wird der erste passende (First Fit).
+    /// Freigegebene Bereiche werden mit angrenzenden freien Bereichen zusammengefasst.
+    /// </summary>
+    struct GeometryAllocator
+    {
+        uint64_t capacity = 0;
+
+        // Sorted by offset, two ranges never touch each other
+        std::vector<GeometryAllocation> freeRanges;
+
+        void initialize(uint64_t capacity);
+
+        bool allocate(uint64_t size, uint64_t alignment, GeometryAllocation& allocation);
+        void free(const GeometryAllocation& allocation);
+
+        uint64_t getFreeSize() const;
+    };
+}
+
+#endif // GEOMETRYALLOCATOR_H
@@ -0,0 +1,76 @@
+#ifndef MESHFORMAT_H
+#define MESHFORMAT_H
+
+#include <cstdint>
+
+#include "VertexLayout.h"
+
+// Shared with tools/MeshImporter, so this header must not depend on Vulkan or GLM.
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Binary Mesh Format (.vpmesh)
+    *
+    * MeshFileHeader | MeshFileStream[streamCount] | MeshFileLod[lodCount] | vertex streams | indices
+    * Every block starts at a multiple of meshFileAlignment, all values are little endian.
+    * All LODs share the vertex streams, their index ranges lie one after another in the index block.
+    */
+
+    static const uint32_t meshFileMagic = 0x48534D56; // "VMSH"
+    static const uint32_t meshFileVersion = 2;
+    static const uint32_t meshFileAlignment = 16;
+    static const uint32_t meshMaxLodCount = 5;
+
+    enum MeshVertexFormat : uint32_t
+    {
+        MESH_VERTEX_FORMAT_FLOAT = 0,       // MeshVertex
+        MESH_VERTEX_FORMAT_QUANTIZED = 1    // QuantizedVertex, the bounds define the position range
+    };
+
+    struct MeshFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexFormat;
+        uint32_t streamCount;
+
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t indexSize;             // 2 or 4 bytes
+        uint32_t lodCount;              // 1 to meshMaxLodCount, LOD 0 is the full mesh
+
+        float boundsMin[3];
+        float boundsMax[3];
+
+        uint64_t indexOffset;
+    };
+
+    struct MeshFileStream
+    {
+        uint32_t stride;
+        uint32_t reserved;
+        uint64_t offset;
+    };
+
+    struct MeshFileLod
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;                    // Maximum object space deviation from LOD 0
+        uint32_t reserved;
+    };
+
+    struct MeshVertex
+    {
+        float position[3];
+        float color[3];
+        float textureCoordinate[2];
+    };
+
+    static_assert(sizeof(MeshFileHeader) == 64);
+    static_assert(sizeof(MeshFileStream) == 16);
+    static_assert(sizeof(MeshFileLod) == 16);
+    static_assert(sizeof(MeshVertex) == 32);
+}
+
+#endif // MESHFORMAT_H
@@ -0,0 +1,102 @@
+#include "MeshLoader.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+     * Private Functions
+     */
+
+    static bool isRangeInFile(const MeshFile& meshFile, uint64_t offset, uint64_t size)
+    {
+        return offset <= meshFile.mappedFile.size && size <= meshFile.mappedFile.size - offset;
+    }
+
+    template<typename T>
+    static bool areIndicesInRange(const uint8_t* indices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        const T* typedIndices = reinterpret_cast<const T*>(indices);
+        uint32_t maxIndex = 0;
+
+        for (uint32_t i = 0; i < indexCount; i++)
+            maxIndex = std::max<uint32_t>(maxIndex, typedIndices[i]);
+
+        return indexCount == 0 || maxIndex < vertexCount;
+    }
+
+    /*
+     * Global Functions
+     */
+
+    void openMeshFile(const std::string& filename, MeshFile& meshFile)
+    {
+        meshFile.mappedFile = Assets::MapFile(filename);
+
+        const uint8_t* data = meshFile.mappedFile.data;
+
+        if (!isRangeInFile(meshFile, 0, sizeof(MeshFileHeader)))
+        {
+            closeMeshFile(meshFile);
+            throw std::runtime_error("Datei \"" + filename + "\" ist keine gueltige Mesh Datei!");
+        }
+
+        meshFile.header = reinterpret_cast<const MeshFileHeader*>(data);
+        meshFile.streams = reinterpret_cast<const MeshFileStream*>(data + sizeof(MeshFileHeader));
+
+        const MeshFileHeader& header = *meshFile.header;
+        uint64_t lodOffset = sizeof(MeshFileHeader) + sizeof(MeshFileStream) * static_cast<uint64_t>(header.streamCount);
+
+        meshFile.lods = reinterpret_cast<const MeshFileLod*>(data + lodOffset);
+
+        bool valid = header.magic == meshFileMagic &&
+            header.version == meshFileVersion &&
+            (header.indexSize == 2 || header.indexSize == 4) &&
+            header.indexOffset % meshFileAlignment == 0 &&
+            header.lodCount >= 1 && header.lodCount <= meshMaxLodCount &&
+            isRangeInFile(meshFile, sizeof(MeshFileHeader), sizeof(MeshFileStream) * static_cast<uint64_t>(header.streamCount)) &&
+            isRangeInFile(meshFile, lodOffset, sizeof(MeshFileLod) * static_cast<uint64_t>(header.lodCount)) &&
+            isRangeInFile(meshFile, header.indexOffset, getMeshIndexSize(meshFile));
+
+        for (uint32_t i = 0; valid && i < header.streamCount; i++)
+            valid = isRangeInFile(meshFile, meshFile.streams[i].offset, getMeshStreamSize(meshFile, i));
+
+        for (uint32_t i = 0; valid && i < header.lodCount; i++)
+            valid = meshFile.lods[i].firstIndex <= header.indexCount && meshFile.lods[i].indexCount <= header.indexCount - meshFile.lods[i].firstIndex;
+
+        // An index past the vertex streams would make the GPU read outside of the vertex buffer
+        if (valid)
+        {
+            const uint8_t* indices = data + header.indexOffset;
+            valid = header.indexSize == 2 ?
+                areIndicesInRange<uint16_t>(indices, header.indexCount, header.vertexCount) :
+                areIndicesInRange<uint32_t>(indices, header.indexCount, header.vertexCount);
+        }
+
+        if (!valid)
+        {
+            closeMeshFile(meshFile);
+            throw std::runtime_error("Datei \"" + filename + "\" ist keine gueltige Mesh Datei!");
+        }
+    }
+
+    void closeMeshFile(MeshFile& meshFile)
+    {
+        Assets::UnmapFile(meshFile.mappedFile);
+
+        meshFile.header = nullptr;
+        meshFile.streams = nullptr;
+        meshFile.lods = nullptr;
+    }
+
+    uint64_t getMeshStreamSize(const MeshFile& meshFile, uint32_t stream)
+    {
+        return static_cast<uint64_t>(meshFile.streams[stream].stride) * meshFile.header->vertexCount;
+    }
+
+    uint64_t getMeshIndexSize(const MeshFile& meshFile)
+    {
+        return static_cast<uint64_t>(meshFile.header->indexSize) * meshFile.header->indexCount;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <string>
+
+#include "../Assets/MappedFile.h"
+#include "MeshFormat.h"
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Helper Structs for binary Meshes
+    */
+
+    struct MeshFile
+    {
+        Assets::MappedFile mappedFile;
+
+        // Point into mappedFile, valid until closeMeshFile
+        const MeshFileHeader* header;
+        const MeshFileStream* streams;
+        const MeshFileLod* lods;
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Bildet eine .vpmesh Datei in den Speicher ab und prueft Header, Streams, LODs und Indices gegen die Dateigroesse,
+    /// ausserdem darf kein Index ueber vertexCount hinauszeigen.
+    /// Es werden keine Daten kopiert, die Streams koennen direkt aus dem Mapping in einen Staging Buffer kopiert werden.
+    /// </summary>
+    void openMeshFile(const std::string& filename, MeshFile& meshFile);
+    void closeMeshFile(MeshFile& meshFile);
+
+    uint64_t getMeshStreamSize(const MeshFile& meshFile, uint32_t stream);
+    uint64_t getMeshIndexSize(const MeshFile& meshFile);
+}
+
+#endif // MESHLOADER_H
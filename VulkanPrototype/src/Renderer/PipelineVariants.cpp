@@ -0,0 +1,213 @@
+#include "PipelineVariants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+     * Member Functions
+     */
+
+    void PipelineVariantCache::initialize(VkDevice device, const VkAllocationCallbacks* pAllocator, CreateFunction createPipeline, uint32_t compileThreadCount)
+    {
+        this->device = device;
+        this->pAllocator = pAllocator;
+        this->createPipeline = std::move(createPipeline);
+
+        if (compileThreadCount == 0)
+            compileThreadCount = std::max(std::thread::hardware_concurrency() / 4, 1u);
+
+        stopCompiling = false;
+
+        for (uint32_t i = 0; i < compileThreadCount; i++)
+            compileThreads.emplace_back(&PipelineVariantCache::compileLoop, this);
+    }
+
+    void PipelineVariantCache::cleanup()
+    {
+        clear();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopCompiling = true;
+        }
+
+        compileCondition.notify_all();
+
+        for (std::thread& compileThread : compileThreads)
+            compileThread.join();
+
+        compileThreads.clear();
+    }
+
+    void PipelineVariantCache::clear()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Pipelines that are already being compiled are still destroyed below
+        compileQueue.clear();
+        idleCondition.wait(lock, [this] { return compilingCount == 0; });
+
+        for (auto& [key, variant] : variants)
+            vkDestroyPipeline(device, variant->pipeline, pAllocator);
+
+        variants.clear();
+    }
+
+    void PipelineVariantCache::compileFallbacks()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        std::vector<Variant*> fallbacks;
+
+        for (uint32_t state = 0; state <= PIPELINE_VARIANT_STATE_MASK; state++)
+        {
+            fallbacks.push_back(&findOrRequest(state));
+            fallbacks.push_back(&findOrRequest(state | PIPELINE_VARIANT_PUSH_CONSTANT_DRAWS));
+        }
+
+        // A fallback that failed to compile would never be published
+        idleCondition.wait(lock, [this, &fallbacks]
+        {
+            if (compileQueue.empty() && compilingCount == 0)
+                return true;
+
+            for (Variant* fallback : fallbacks)
+            {
+                if (fallback->pipeline == VK_NULL_HANDLE)
+                    return false;
+            }
+
+            return true;
+        });
+    }
+
+    void PipelineVariantCache::request(uint32_t key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        findOrRequest(normalizeKey(key));
+    }
+
+    VkPipeline PipelineVariantCache::get(uint32_t key)
+    {
+        key = normalizeKey(key);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        VkPipeline pipeline = findOrRequest(key).pipeline.load(std::memory_order_acquire);
+
+        if (pipeline != VK_NULL_HANDLE)
+            return pipeline;
+
+        return findOrRequest(getFallbackKey(key)).pipeline.load(std::memory_order_acquire);
+    }
+
+    uint32_t PipelineVariantCache::getVariantCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<uint32_t>(variants.size());
+    }
+
+    uint32_t PipelineVariantCache::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<uint32_t>(compileQueue.size()) + compilingCount;
+    }
+
+    uint32_t PipelineVariantCache::normalizeKey(uint32_t key)
+    {
+        // The depth prepass has no fragment shader, texturing and the debug views would only duplicate it
+        if ((key & PIPELINE_VARIANT_STATE_MASK) == PIPELINE_VARIANT_STATE_DEPTH_PREPASS)
+            key &= ~(PIPELINE_VARIANT_TEXTURING | PIPELINE_VARIANT_DEBUG_VISUALIZATION_MASK);
+
+        // The debug views replace the material color
+        if ((key & PIPELINE_VARIANT_DEBUG_VISUALIZATION_MASK) != 0)
+            key &= ~PIPELINE_VARIANT_TEXTURING;
+
+        return key;
+    }
+
+    uint32_t PipelineVariantCache::getFallbackKey(uint32_t key)
+    {
+        // The push constant bit changes where the vertex shader reads the objects from, so it can not be dropped
+        return key & (PIPELINE_VARIANT_STATE_MASK | PIPELINE_VARIANT_PUSH_CONSTANT_DRAWS);
+    }
+
+    PipelineSpecialization PipelineVariantCache::getSpecialization(uint32_t key)
+    {
+        return
+        {
+            .pushConstantDraws = (key & PIPELINE_VARIANT_PUSH_CONSTANT_DRAWS) != 0 ? VK_TRUE : VK_FALSE,
+            .texturing = (key & PIPELINE_VARIANT_TEXTURING) != 0 ? VK_TRUE : VK_FALSE,
+            .debugVisualization = (key & PIPELINE_VARIANT_DEBUG_VISUALIZATION_MASK) >> PIPELINE_VARIANT_DEBUG_VISUALIZATION_SHIFT
+        };
+    }
+
+    PipelineVariantCache::Variant& PipelineVariantCache::findOrRequest(uint32_t key)
+    {
+        std::unique_ptr<Variant>& variant = variants[key];
+
+        if (!variant)
+        {
+            variant = std::make_unique<Variant>();
+            compileQueue.push_back(key);
+            compileCondition.notify_one();
+        }
+
+        return *variant;
+    }
+
+    void PipelineVariantCache::compileLoop()
+    {
+        while (true)
+        {
+            uint32_t key;
+            Variant* variant;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                compileCondition.wait(lock, [this] { return stopCompiling || !compileQueue.empty(); });
+
+                if (stopCompiling)
+                    return;
+
+                key = compileQueue.front();
+                compileQueue.pop_front();
+                variant = variants[key].get();
+                compilingCount++;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            VkPipeline pipeline = createPipeline(key);
+            float compileTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // The handle is published in one store, a frame sees either the fallback or the complete pipeline
+            variant->pipeline.store(pipeline, std::memory_order_release);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                compilingCount--;
+            }
+
+            idleCondition.notify_all();
+
+            // Assembled first, so the lines of several compile threads do not interleave. A failed variant keeps using its fallback.
+            std::ostringstream message;
+            message << "Pipeline variant 0x" << std::hex << key << std::dec;
+
+            if (pipeline != VK_NULL_HANDLE)
+            {
+                message << " compiled in " << compileTime << " ms\n";
+                std::cout << message.str();
+            }
+            else
+            {
+                message << " failed to compile, the fallback is used instead\n";
+                std::cerr << message.str();
+            }
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef PIPELINEVARIANTS_H
+#define PIPELINEVARIANTS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Helper Structs for the Pipeline Variants
+    */
+
+    // Bits of a variant key. The lowest two select the fixed function state, the others are specialization constants of
+    // shader.vert, depthPrepass.vert and shader.frag, see PipelineSpecialization.
+    enum PipelineVariantBits : uint32_t
+    {
+        PIPELINE_VARIANT_STATE_MASK = 0x3,
+        PIPELINE_VARIANT_TEXTURING = 1 << 2,                // Samples the texture of the material, otherwise only its base color
+        PIPELINE_VARIANT_PUSH_CONSTANT_DRAWS = 1 << 3,      // Instancing mode: objects from the push constants instead of the object buffer
+        PIPELINE_VARIANT_DEBUG_VISUALIZATION_SHIFT = 4,     // Two bits, see DebugVisualization
+        PIPELINE_VARIANT_DEBUG_VISUALIZATION_MASK = 0x3 << PIPELINE_VARIANT_DEBUG_VISUALIZATION_SHIFT
+    };
+
+    enum PipelineVariantState : uint32_t
+    {
+        PIPELINE_VARIANT_STATE_FILL = 0,
+        PIPELINE_VARIANT_STATE_WIREFRAME = 1,
+        PIPELINE_VARIANT_STATE_DEPTH_EQUAL = 2,             // Color pass behind the depth prepass
+        PIPELINE_VARIANT_STATE_DEPTH_PREPASS = 3            // No fragment shader, so no fragment features
+    };
+
+    enum DebugVisualization : uint32_t
+    {
+        DEBUG_VISUALIZATION_NONE = 0,
+        DEBUG_VISUALIZATION_NORMALS = 1,
+        DEBUG_VISUALIZATION_LIGHT_COUNT = 2,
+        DEBUG_VISUALIZATION_MATERIAL = 3
+    };
+
+    // Data of the specialization constants, has to match the constant_id declarations in the shaders
+    struct PipelineSpecialization
+    {
+        VkBool32 pushConstantDraws;     // constant_id = 0
+        VkBool32 texturing;             // constant_id = 1
+        uint32_t debugVisualization;    // constant_id = 2
+    };
+
+    /// <summary>
+    /// Graphics Pipelines pro Variante, erstellt bei der ersten Anfrage. Schluessel, die sich nur in Features unterscheiden,
+    /// die eine Pipeline nicht benutzt, werden auf denselben Schluessel abgebildet und teilen sich die Pipeline.
+    /// Die Pipelines werden auf eigenen Compile Threads erstellt und erst veroeffentlicht, wenn sie fertig sind.
+    /// Bis dahin liefert get() die Fallback Pipeline mit demselben Zustand ohne Features, der Aufrufer wartet nie.
+    /// </summary>
+    class PipelineVariantCache
+    {
+    public:
+        // Called on the compile threads with a normalized key, must be thread safe. Returns VK_NULL_HANDLE on failure.
+        using CreateFunction = std::function<VkPipeline(uint32_t key)>;
+
+        /// <summary>
+        /// Startet compileThreadCount Compile Threads, ohne Angabe einen pro vier Kerne.
+        /// Sie laufen neben den Workern des Job Systems, damit ein Wait im Frame nie eine Pipeline erstellen muss.
+        /// </summary>
+        void initialize(VkDevice device, const VkAllocationCallbacks* pAllocator, CreateFunction createPipeline, uint32_t compileThreadCount = 0);
+        void cleanup();
+
+        /// <summary>
+        /// Verwirft die wartenden Anfragen, wartet auf die laufenden und zerstoert alle Pipelines,
+        /// z.B. wenn sich die Groesse des Swapchains aendert. Danach muss compileFallbacks() erneut gerufen werden.
+        /// </summary>
+        void clear();
+
+        /// <summary>
+        /// Erstellt die Fallback Pipelines aller Zustaende und wartet darauf. Nur beim Start und nach clear() noetig.
+        /// </summary>
+        void compileFallbacks();
+
+        /// <summary>
+        /// Reiht die Variante zum Erstellen ein, falls es sie noch nicht gibt, und kehrt sofort zurueck.
+        /// </summary>
+        void request(uint32_t key);
+
+        /// <summary>
+        /// Gibt die Pipeline der Variante zurueck, solange sie noch erstellt wird die Fallback Pipeline.
+        /// VK_NULL_HANDLE nur, wenn auch die Fallback Pipeline fehlt.
+        /// </summary>
+        VkPipeline get(uint32_t key);
+
+        uint32_t getVariantCount() const;
+
+        // Variants that are queued or being compiled
+        uint32_t getPendingCount() const;
+
+        /// <summary>
+        /// Setzt die Bits zurueck, die die Pipeline des Schluessels nicht auswertet.
+        /// </summary>
+        static uint32_t normalizeKey(uint32_t key);
+
+        /// <summary>
+        /// Derselbe Zustand und Draw Pfad ohne Texturen und Debug Ansicht, zeichnet also dieselben Pixel in der Grundfarbe.
+        /// </summary>
+        static uint32_t getFallbackKey(uint32_t key);
+
+        static PipelineSpecialization getSpecialization(uint32_t key);
+
+    private:
+        struct Variant
+        {
+            // Stored once by a compile thread when the pipeline is complete, the frame loop reads it without the mutex
+            std::atomic<VkPipeline> pipeline = VK_NULL_HANDLE;
+        };
+
+        VkDevice device = VK_NULL_HANDLE;
+        const VkAllocationCallbacks* pAllocator = nullptr;
+        CreateFunction createPipeline;
+
+        // Variants never move, the compile threads write into them while other keys are added
+        mutable std::mutex mutex;
+        std::unordered_map<uint32_t, std::unique_ptr<Variant>> variants;
+
+        // compileCondition wakes the compile threads for new keys, idleCondition signals every finished pipeline
+        std::deque<uint32_t> compileQueue;
+        uint32_t compilingCount = 0;
+        bool stopCompiling = false;
+        std::condition_variable compileCondition;
+        std::condition_variable idleCondition;
+        std::vector<std::thread> compileThreads;
+
+        // Expects the mutex to be held
+        Variant& findOrRequest(uint32_t key);
+
+        void compileLoop();
+    };
+}
+
+#endif // PIPELINEVARIANTS_H
@@ -1,5 +1,8 @@
 ﻿#include "Renderer.h"
 
+#include <algorithm>
+#include <deque>
+#include <mutex>
 #include<vector>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -11,7 +14,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../Assets/AssetLoader.h"
 #include "../Backend/Backend.h"
+#include "../Jobs/JobSystem.h"
+#include "DrawPacket.h"
+#include "MeshLoader.h"
+#include "PipelineVariants.h"
+#include "TextureLoader.h"
 
 namespace VulkanPrototype::Renderer
 {
@@ -35,6 +44,23 @@ namespace VulkanPrototype::Renderer
 
     VkPolygonMode g_polygonMode = VK_POLYGON_MODE_FILL;
 
+    float g_lodPixelError = 1.0f;
+    bool g_occlusionCulling = true;
+    std::atomic<uint32_t> g_drawnTriangleCount = 0;
+    std::atomic<uint32_t> g_stateBindCount = 0;
+    std::atomic<uint32_t> g_skippedStateBindCount = 0;
+    bool g_depthPrepass = false;
+    std::atomic<float> g_gpuFrameTime = 0.0f;
+    bool g_pushConstantDraws = true;
+    std::atomic<float> g_cpuFrameTime = 0.0f;
+    std::atomic<uint64_t> g_renderedFrameCount = 0;
+    bool g_texturing = true;
+    uint32_t g_debugVisualization = DEBUG_VISUALIZATION_NONE;
+    std::atomic<uint32_t> g_pipelineVariantCount = 0;
+    std::atomic<uint32_t> g_pendingPipelineVariantCount = 0;
+    std::atomic<uint32_t> g_particleCount = 0;
+    std::atomic<uint32_t> g_pendingStreamedMeshCount = 0;
+
     /*
     * Module Global Variables
     */
@@ -47,19 +73,148 @@ namespace VulkanPrototype::Renderer
     static std::vector<FrameData> frames;
 
     //Buffers
-    //static VkBuffer indexBuffer;
-    //static VkDeviceMemory indexBufferMemory;
-    static AllocatedBuffer indexBuffer;
-    //static VkBuffer vertexBuffer;
-    //static VkDeviceMemory vertexBufferMemory;
-    static AllocatedBuffer vertexBuffer;
+    //Vertices and indices of all meshes are sub-allocated from one device local buffer
+    static AllocatedBuffer geometryBuffer;
+    static GeometryAllocator geometryAllocator;
+    static const uint64_t geometryBufferSize = 64ull * 1024 * 1024;
+
+    // Position only stream for the depth prepass, half the size of the geometry buffer. The snorm16x4 position of the
+    // vertex at byte 16 * i of the geometry buffer lies at byte 8 * i, so both streams share the vertex offsets.
+    static AllocatedBuffer positionBuffer;
+
+    static std::vector<Mesh> meshes;
+    static AllocatedBuffer meshBuffer;
+    static const uint32_t maxMeshCount = 256;
+
+    // Loaded meshes and textures whose staging buffers are filled. Queued by the coroutines resumed in Assets::Update, which runs
+    // on the thread of RenderFrame, and copied by the command buffer of the next frame instead of waiting for the queue.
+    static std::vector<MeshUpload> queuedMeshUploads;
+    static std::vector<TextureUpload> queuedTextureUploads;
+
+    // The streaming slots follow the loaded meshes in the mesh buffer. StreamMesh queues the meshes on any thread, RenderFrame
+    // copies them through the staging buffer of its frame, so an upload never waits for the queue to be idle.
+    static std::mutex streamedMeshMutex;
+    static std::deque<StreamedMesh> streamedMeshQueue;
+    static std::vector<StreamedMesh> streamedMeshUploads;
+    static std::vector<Mesh> streamedMeshes;
+    static const uint64_t streamingBufferSize = 16ull * 1024 * 1024;
+
+    // Rendered objects per frame and slots of the transform buffer, which is 32 MiB per frame
+    static const uint32_t maxGameObjectCount = 1 << 19;
+
+    // The transforms of the hierarchy slots as the frame packets sent them. The slots from persistentTransformCount on
+    // belong to the objects of the current frame packet that are not in the hierarchy.
+    static std::vector<ObjectTransform> objectTransforms;
+    static uint32_t persistentTransformCount = 0;
+
+    // Scratch arrays of updateUniformBuffer, kept so a million objects do not reallocate every frame
+    static std::vector<uint32_t> objectTransformIndices;
+    static std::vector<DrawPacket> drawPackets;
+    static std::vector<DrawPacket> drawPacketScratch;
+    static std::vector<DrawRange> drawRanges;
+
+    // One command per mesh and LOD with objects in the current frame in the order of the sort keys, the object buffer is sorted the same way
+    static std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+    static std::vector<DrawBatch> drawBatches;
+    static const uint32_t maxDrawCount = maxMeshCount * meshMaxLodCount + maxStreamedMeshCount;
+
+    // Pass and pipeline fields of the sort keys
+    static const uint32_t mainPassKey = 0;
+    static const uint32_t fillPipelineKey = 0;
+    static const uint32_t wireframePipelineKey = 1;
+    static bool multiDrawIndirectSupported = false;
+
+    // The dynamic objects of the frame packet, drawn after the batches of phase 0 without culling
+    static std::vector<DirectDraw> directDraws;
+    static const uint32_t maxDirectDrawCount = 256;
+
+    // Two phase occlusion culling: the objects visible in the last frame are drawn first, their depth is reduced into
+    // the depth pyramid and every object is tested against it. The newly visible ones are drawn in a second render pass.
+    static VkPipeline occlusionCullingPipeline;
+    static VkPipelineLayout occlusionCullingPipelineLayout;
+    static VkDescriptorSetLayout descriptorSetLayoutOcclusionCulling;
+    static VkDescriptorUpdateTemplate occlusionCullingDescriptorTemplate;
+
+    // One bit per object id, objects with larger ids are always drawn
+    static AllocatedBuffer visibilityBuffer;
+
+    // Same size as the depth image, always in VK_IMAGE_LAYOUT_GENERAL. Every level has its own view for the reduction.
+    static VkImage depthPyramidImage;
+    static VkDeviceMemory depthPyramidImageMemory;
+    static VkImageView depthPyramidImageView;
+    static std::vector<VkImageView> depthPyramidLevelViews;
+    static VkSampler depthPyramidSampler;
+
+    static VkPipeline depthPyramidPipeline;
+    static VkPipelineLayout depthPyramidPipelineLayout;
+    static VkDescriptorSetLayout descriptorSetLayoutDepthPyramid;
+    static VkDescriptorUpdateTemplate depthPyramidDescriptorTemplate;
+
+    // Clustered lighting: view space tiles times exponential depth slices, the counts have to match lightCulling.comp and shader.frag
+    static const uint32_t clusterCountX = 16;
+    static const uint32_t clusterCountY = 9;
+    static const uint32_t clusterCountZ = 24;
+    static const uint32_t clusterCount = clusterCountX * clusterCountY * clusterCountZ;
+    static const uint32_t maxLightCount = 16384;
+
+    // Light indices of all clusters together, 64 per cluster on average. Clusters beyond a full list get no lights.
+    static const uint32_t maxLightIndexCount = clusterCount * 64;
+
+    static VkPipeline lightCullingPipeline;
+    static VkPipelineLayout lightCullingPipelineLayout;
+    static VkDescriptorSetLayout descriptorSetLayoutLightCulling;
+    static VkDescriptorUpdateTemplate lightCullingDescriptorTemplate;
+
+    // GPU particles, shared by all frames like the visibility buffer. Every buffer is only written by the particle shaders,
+    // the CPU pushes the emitter and the time step and never touches a particle.
+    static AllocatedBuffer particlePositionBuffer;
+    static AllocatedBuffer particleVelocityBuffer;
+    static AllocatedBuffer particleColorBuffer;
+    static AllocatedBuffer particleDeadListBuffer;
+    static AllocatedBuffer particleAliveListBuffer;
+    static AllocatedBuffer particleCounterBuffer;
+    static const uint32_t maxParticleCount = 1 << 21;
+
+    // The alive list with the current particles, every simulation writes the other one. Particles that are due but not
+    // yet emitted carry over to the next frame.
+    static uint32_t particleAliveList = 0;
+    static uint32_t particleSeed = 0;
+    static float particleEmitAccumulator = 0.0f;
+    static std::chrono::steady_clock::time_point particleUpdateTime;
+
+    static VkPipeline particleArgumentsPipeline;
+    static VkPipeline particleEmitPipeline;
+    static VkPipeline particleSimulatePipeline;
+    static VkPipeline particlePipeline;
+    static VkPipelineLayout particlePipelineLayout;
+    static VkDescriptorSetLayout descriptorSetLayoutParticles;
+    static VkDescriptorUpdateTemplate particleComputeDescriptorTemplate;
+    static VkDescriptorUpdateTemplate particleDrawDescriptorTemplate;
     //static std::vector<VkBuffer> uniformBuffers;
     //static std::vector<VkDeviceMemory> uniformBuffersMemory;
 
-    static VkImage textureImage;
-    static VkImageView textureImageView;
-    static VkDeviceMemory textureImageMemory;
+    //Bindless Textures and Materials, index 0 is the placeholder texture
+    static std::vector<Texture> textures;
     static VkSampler textureSampler;
+    static uint32_t maxTextureCount = 4096;
+
+    static std::vector<MaterialData> materials;
+    static AllocatedBuffer materialBuffer;
+    static const uint32_t maxMaterialCount = 1024;
+
+    //Assets that are read on the worker threads during initialization
+    static Assets::AssetHandle<std::vector<char>> shaderFileVert;
+    static Assets::AssetHandle<std::vector<char>> shaderFileFrag;
+    static Assets::AssetHandle<std::vector<char>> shaderFileDepthPrepass;
+    static Assets::AssetHandle<std::vector<char>> shaderFileLightCulling;
+    static Assets::AssetHandle<std::vector<char>> shaderFileOcclusionCulling;
+    static Assets::AssetHandle<std::vector<char>> shaderFileDepthPyramid;
+    static Assets::AssetHandle<std::vector<char>> shaderFileParticleArguments;
+    static Assets::AssetHandle<std::vector<char>> shaderFileParticleEmit;
+    static Assets::AssetHandle<std::vector<char>> shaderFileParticleSimulate;
+    static Assets::AssetHandle<std::vector<char>> shaderFileParticleVert;
+    static Assets::AssetHandle<std::vector<char>> shaderFileParticleFrag;
+    static Assets::AssetHandle<std::vector<char>> fontFile;
 
     static VkImage depthImage;
     static VkImageView depthImageView;
@@ -69,9 +224,16 @@ namespace VulkanPrototype::Renderer
     static std::vector<VkImageView> imageViews;
 
     //Descriptors
-    static VkDescriptorPool descriptorPool;
     static VkDescriptorPool descriptorPoolImGui;
     static VkDescriptorSetLayout descriptorSetLayout;
+    static VkDescriptorPool descriptorPoolBindless;
+    static VkDescriptorSetLayout descriptorSetLayoutBindless;
+    static VkDescriptorSet descriptorSetBindless;
+    static VkDescriptorUpdateTemplate frameDescriptorTemplate;
+
+    //Set 0 is pushed directly into the command buffer if VK_KHR_push_descriptor is available
+    static bool pushDescriptorsSupported = false;
+    static PFN_vkCmdPushDescriptorSetWithTemplateKHR cmdPushDescriptorSetWithTemplate = nullptr;
     // static std::vector<VkDescriptorSet> descriptorSets;
 
     //Platformspecific
@@ -83,64 +245,65 @@ namespace VulkanPrototype::Renderer
     static VkDevice device;
     static VkInstance instance;
     static VkRenderPass renderPass;
+
+    // Continues the frame after the occlusion culling, compatible with renderPass so both use the same framebuffers
+    static VkRenderPass renderPassLoad;
     static VkPhysicalDevice physicalDevice;
-    static VkPipeline pipeline;
-    static VkPipeline wireframePipeline;
+
+    // Every combination of fixed function state and shader features is its own pipeline, compiled in the background when it
+    // is first needed. pipelineVariantFeatures holds the feature bits of the frame packet that is recorded.
+    static PipelineVariantCache pipelineVariants;
+    static uint32_t pipelineVariantFeatures = 0;
+    static VkShaderModule shaderModuleVert;
+    static VkShaderModule shaderModuleFrag;
+    static VkShaderModule shaderModuleDepthPrepass;
+
+    // With the depth prepass the first subpass writes the depth of the objects, the second one shades them with depth
+    // compare EQUAL and without depth writes, so every pixel is shaded once
+    static const uint32_t depthPrepassSubpass = 0;
+    static const uint32_t colorSubpass = 1;
+
+    // Nanoseconds per timestamp tick, 0 if the queue does not support timestamps
+    static float timestampPeriod = 0.0f;
+
     static VkPipelineLayout pipelineLayout;
 
     static VkQueue queue;
 
     static QueueFamily queueFamily;
 
-    //Vertex Buffer
-    static const std::vector<Vertex> vertices =
-    {
-        {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-        {{0.5f, -0.5f, 0.0f}, {1.0f, .0f, 0.0f}, {0.0f, 0.0f}},
-        {{0.5f, 0.5f, 0.0f}, {1.0f, 0.0f, .0f}, {0.0f, 1.0f}},
-        {{-0.5f, 0.5f, 0.0f}, {1.0f, .0f, .0f}, {1.0f, 1.0f}},
-
-        {{-0.5f, -0.5f, 1.0f}, {.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-        {{0.5f, -0.5f, 1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-        {{0.5f, 0.5f, 1.0f}, {0.0f, 1.0f, .0f}, {0.0f, 1.0f}},
-        {{-0.5f, 0.5f, 1.0f}, {.0f, 1.0f, .0f}, {1.0f, 1.0f}}
-    };
-
-    static const std::vector<uint16_t> indices =
-    {
-        0, 2, 1, 0, 3, 2,
-        0, 7, 3, 0, 4, 7,
-        1, 4, 0, 1, 5, 4,
-        2, 5, 1, 2, 6, 5,
-        3, 6, 2, 3, 7, 6,
-        4, 6, 7, 4, 5, 6
-    };
+    // Packet of the frame that is currently recorded, only valid during RenderFrame
+    static const FramePacket* currentFramePacket = nullptr;
+    static VkExtent2D framebufferSize;
 
-    glm::vec3 cubePositions[] =
-    {
-        glm::vec3(0.0f, 0.0f, 0.0f),
-        glm::vec3(2.0f, 5.0f, 15.0f),
-        glm::vec3(-1.5f, -2.2f, 2.5f),
-        glm::vec3(-3.8f, -2.0f, 12.3f),
-        glm::vec3(2.4f, -0.4f, 3.5f),
-        glm::vec3(-1.7f, 3.0f, 7.5f),
-        glm::vec3(1.3f, -2.0f, 2.5f),
-        glm::vec3(1.5f, 2.0f, 2.5f),
-        glm::vec3(1.5f, 0.2f, 1.5f),
-        glm::vec3(-1.3f, 1.0f, 1.5f)
-    };
+    // Camera position between the last two simulation steps
+    static glm::vec3 cameraPosition;
 
     /*
      * Forward Declarations
      */
 
+    VkPipeline createGraphicsPipelineVariant(uint32_t key);
     void createImage(const VkImageCreateInfo& imageCreateInfo, VkImage& image, VkDeviceMemory& imageMemory);
-    VkImageView createImageView(const VkImage image, const VkFormat format, const VkImageAspectFlags aspectFlags);
+    VkImageView createImageView(const VkImage image, const VkFormat format, const VkImageAspectFlags aspectFlags, const uint32_t mipLevels = 1, const uint32_t baseMipLevel = 0);
     void createShaderModule(const std::vector<char>& shaderCode, VkShaderModule* shaderModule);
+    void createTextureImage(VkCommandBuffer commandBuffer, const TextureUpload& textureUpload, Texture& texture);
+    FrameDescriptors getFrameDescriptors(const FrameData& frame);
+    ParticleDescriptors getParticleDescriptors(const FrameData& frame);
     uint32_t pickMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     VkPhysicalDevice pickPhysicalDevice();
     QueueFamily pickQueueFamily(VkPhysicalDevice physicalDevice);
+    VkFormat pickTextureFormat(VkFormat fileFormat);
+    void prepareMeshUpload(const std::string& filename, MeshFile& meshFile, MeshUpload& meshUpload);
+    void prepareTextureUpload(TextureFile& textureFile, Assets::MappedFile& encodedFile, TextureUpload& textureUpload);
+    void publishAssetUploads(FrameData& frame);
     SurfaceDetails querySurfaceCapabilities(VkPhysicalDevice physicalDevice);
+    void readTextureUpload(const std::string& filename, TextureFile& textureFile, Assets::MappedFile& encodedFile, TextureUpload& textureUpload);
+    VkPipeline selectGraphicsPipeline(uint32_t pipelineKey, bool depthOnly, bool pushConstantDraws);
+    uint32_t selectMeshLod(const Mesh& mesh, const glm::mat4& worldMatrix);
+    void updateTextureDescriptor(uint32_t textureIndex);
+    Assets::Task uploadTexture(std::string filename, uint32_t textureIndex);
+    void uploadTransforms(FrameData& frame);
 
     /*
      * Debug Utils
@@ -160,6 +323,7 @@ namespace VulkanPrototype::Renderer
 
         return VK_FALSE;
     }
+
 #endif
 
     /*
@@ -230,29 +394,8 @@ namespace VulkanPrototype::Renderer
         vkFreeCommandBuffers(device, frames[0].commandPool, 1, &commandBuffer);
     }
 
-    void readFile(const std::string& filename, std::vector<char>& buffer)
-    {
-        std::ifstream file(filename, std::ios::binary | std::ios::ate);
-
-        if (file.is_open())
-        {
-            size_t fileSize = static_cast<size_t>(file.tellg());
-            file.seekg(0);
-            buffer.resize(fileSize);
-            file.read(buffer.data(), fileSize);
-            file.close();
-        }
-        else
-        {
-            throw std::runtime_error("Datei \"" + filename + "\" konnte nicht geoeffnet werden!");
-        }
-    }
-
-    void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+    void recordImageLayoutTransition(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1)
     {
-        VkCommandBuffer commandBuffer;
-        beginCommandBuffer(&commandBuffer);
-
         VkImageMemoryBarrier imageMemoryBarrier =
         {
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
@@ -268,7 +411,7 @@ namespace VulkanPrototype::Renderer
             {
                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = mipLevels,
                 .baseArrayLayer = 0,
                 .layerCount = 1
             }
@@ -293,6 +436,14 @@ namespace VulkanPrototype::Renderer
             sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
         }
+        else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_GENERAL)
+        {
+            imageMemoryBarrier.srcAccessMask = 0;
+            imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        }
         else
         {   //TODO: uncaracteristic throw
             throw std::invalid_argument("unsupported layout transition!");
@@ -310,7 +461,13 @@ namespace VulkanPrototype::Renderer
             1,
             &imageMemoryBarrier
         );
+    }
 
+    void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1)
+    {
+        VkCommandBuffer commandBuffer;
+        beginCommandBuffer(&commandBuffer);
+        recordImageLayoutTransition(commandBuffer, image, oldLayout, newLayout, mipLevels);
         endCommandBuffer(commandBuffer);
     }
 
@@ -318,6 +475,144 @@ namespace VulkanPrototype::Renderer
      * Private Functions
      */
 
+    void bindComputeDescriptors(FrameData& frame, VkDescriptorUpdateTemplate descriptorTemplate, VkPipelineLayout layout, VkDescriptorSetLayout setLayout, const void* descriptors)
+    {
+        if (pushDescriptorsSupported)
+        {
+            cmdPushDescriptorSetWithTemplate(frame.mainCommandBuffer, descriptorTemplate, layout, 0, descriptors);
+        }
+        else
+        {
+            VkDescriptorSet descriptorSet = frame.descriptorAllocator.allocate(setLayout);
+            vkUpdateDescriptorSetWithTemplate(device, descriptorSet, descriptorTemplate, descriptors);
+            vkCmdBindDescriptorSets(frame.mainCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &descriptorSet, 0, nullptr);
+        }
+    }
+
+    void bindFrameDescriptors(FrameData& frame)
+    {
+        // Set 0 and the bindless set, they stay bound for the whole frame
+        if (frame.boundGraphicsState.frameDescriptors)
+        {
+            frame.boundGraphicsState.skippedBindCount += 2;
+            return;
+        }
+
+        frame.boundGraphicsState.frameDescriptors = true;
+        frame.boundGraphicsState.bindCount += 2;
+
+        FrameDescriptors frameDescriptors = getFrameDescriptors(frame);
+
+        if (pushDescriptorsSupported)
+        {
+            cmdPushDescriptorSetWithTemplate(frame.mainCommandBuffer, frameDescriptorTemplate, pipelineLayout, 0, &frameDescriptors);
+        }
+        else
+        {
+            VkDescriptorSet descriptorSet = frame.descriptorAllocator.allocate(descriptorSetLayout);
+            vkUpdateDescriptorSetWithTemplate(device, descriptorSet, frameDescriptorTemplate, &frameDescriptors);
+            vkCmdBindDescriptorSets(frame.mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        }
+
+        vkCmdBindDescriptorSets(frame.mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &descriptorSetBindless, 0, nullptr);
+    }
+
+    void bindGraphicsPipeline(FrameData& frame, VkPipeline graphicsPipeline)
+    {
+        if (frame.boundGraphicsState.pipeline == graphicsPipeline)
+        {
+            frame.boundGraphicsState.skippedBindCount++;
+            return;
+        }
+
+        frame.boundGraphicsState.pipeline = graphicsPipeline;
+        frame.boundGraphicsState.bindCount++;
+
+        vkCmdBindPipeline(frame.mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    }
+
+    void bindIndexBuffer(FrameData& frame, VkBuffer indexBuffer)
+    {
+        if (frame.boundGraphicsState.indexBuffer == indexBuffer)
+        {
+            frame.boundGraphicsState.skippedBindCount++;
+            return;
+        }
+
+        frame.boundGraphicsState.indexBuffer = indexBuffer;
+        frame.boundGraphicsState.bindCount++;
+
+        vkCmdBindIndexBuffer(frame.mainCommandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void buildDepthPyramid(FrameData& frame)
+    {
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        // The occlusion culling of the last frame may still read the pyramid
+        VkMemoryBarrier readBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readBarrier, 0, nullptr, 0, nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipeline);
+
+        DepthPyramidParameters parameters =
+        {
+            .sourceSize = { g_windowSize.width, g_windowSize.height },
+            .destinationSize = { g_windowSize.width, g_windowSize.height }
+        };
+
+        for (uint32_t level = 0; level < depthPyramidLevelViews.size(); level++)
+        {
+            // Level 0 copies the depth image, every further level reduces the one above it
+            DepthPyramidDescriptors descriptors =
+            {
+                .source =
+                {
+                    .sampler = depthPyramidSampler,
+                    .imageView = level == 0 ? depthImageView : depthPyramidLevelViews[level - 1],
+                    .imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL
+                },
+                .destination =
+                {
+                    .sampler = VK_NULL_HANDLE,
+                    .imageView = depthPyramidLevelViews[level],
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+                }
+            };
+
+            if (level > 0)
+            {
+                parameters.sourceSize[0] = parameters.destinationSize[0];
+                parameters.sourceSize[1] = parameters.destinationSize[1];
+                parameters.destinationSize[0] = std::max(g_windowSize.width >> level, 1u);
+                parameters.destinationSize[1] = std::max(g_windowSize.height >> level, 1u);
+            }
+
+            bindComputeDescriptors(frame, depthPyramidDescriptorTemplate, depthPyramidPipelineLayout, descriptorSetLayoutDepthPyramid, &descriptors);
+            vkCmdPushConstants(commandBuffer, depthPyramidPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(parameters), &parameters);
+
+            vkCmdDispatch(commandBuffer, (parameters.destinationSize[0] + 15) / 16, (parameters.destinationSize[1] + 15) / 16, 1);
+
+            // The next level and the occlusion culling read this one
+            VkMemoryBarrier levelBarrier =
+            {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+            };
+
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+        }
+    }
+
     bool checkInstanceExtensionSupport(std::vector<const char*> instanceExtensions)
     {
         uint32_t amountOfExtensions = 0;
@@ -387,14 +682,8 @@ namespace VulkanPrototype::Renderer
         }
         else
         {
-            int width, height;
-            glfwGetFramebufferSize(Backend::g_window, &width, &height);
-
-            VkExtent2D actualExtent =
-            {
-                .width = static_cast<uint32_t>(width),
-                .height = static_cast<uint32_t>(height)
-            };
+            // Comes from the last frame packet, the swapchain may be recreated on the render thread
+            VkExtent2D actualExtent = framebufferSize;
 
             actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
             actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
@@ -450,6 +739,13 @@ namespace VulkanPrototype::Renderer
         vkDestroyImage(device, depthImage, pAllocator);
         vkFreeMemory(device, depthImageMemory, pAllocator);
 
+        for (VkImageView levelView : depthPyramidLevelViews)
+            vkDestroyImageView(device, levelView, pAllocator);
+
+        vkDestroyImageView(device, depthPyramidImageView, pAllocator);
+        vkDestroyImage(device, depthPyramidImage, pAllocator);
+        vkFreeMemory(device, depthPyramidImageMemory, pAllocator);
+
         vkDestroySwapchainKHR(device, swapchain, pAllocator);
     }
 
@@ -457,38 +753,123 @@ namespace VulkanPrototype::Renderer
     {
         vkDeviceWaitIdle(device);
 
+        // Uploads that were never recorded only own their staging buffers, the recorded ones are finished and get published
+        for (MeshUpload& meshUpload : queuedMeshUploads)
+        {
+            vkDestroyBuffer(device, meshUpload.stagingBuffer.buffer, pAllocator);
+            vkFreeMemory(device, meshUpload.stagingBuffer.bufferMemory, pAllocator);
+        }
+
+        for (TextureUpload& textureUpload : queuedTextureUploads)
+        {
+            vkDestroyBuffer(device, textureUpload.stagingBuffer.buffer, pAllocator);
+            vkFreeMemory(device, textureUpload.stagingBuffer.bufferMemory, pAllocator);
+        }
+
+        queuedMeshUploads.clear();
+        queuedTextureUploads.clear();
+
         for (FrameData& frame : frames)
         {
+            publishAssetUploads(frame);
+
             vkDestroySemaphore(device, frame.semaphoreRenderingDone, pAllocator);
             vkDestroySemaphore(device, frame.semaphoreImageAvailable, pAllocator);
             vkDestroyFence(device, frame.fenceCommandBufferDone, pAllocator);
             vkDestroyCommandPool(device, frame.commandPool, pAllocator);
+            vkDestroyQueryPool(device, frame.timestampQueryPool, pAllocator);
             vkDestroyBuffer(device, frame.uniformBuffer.buffer, pAllocator);
             vkFreeMemory(device, frame.uniformBuffer.bufferMemory, pAllocator);
             vkDestroyBuffer(device, frame.objectBuffer.buffer, pAllocator);
             vkFreeMemory(device, frame.objectBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.transformBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.transformBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.indirectBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.indirectBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.drawCommandBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.drawCommandBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.visibleInstanceBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.visibleInstanceBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.lightBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.lightBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.clusterBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.clusterBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.lightIndexBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.lightIndexBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.particleCounterReadbackBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.particleCounterReadbackBuffer.bufferMemory, pAllocator);
+            vkDestroyBuffer(device, frame.streamingBuffer.buffer, pAllocator);
+            vkFreeMemory(device, frame.streamingBuffer.bufferMemory, pAllocator);
+            frame.descriptorAllocator.cleanup();
         }
 
         cleanupSwapchain();
 
         vkDestroySampler(device, textureSampler, pAllocator);
-        vkDestroyImageView(device, textureImageView, pAllocator);
-        vkDestroyImage(device, textureImage, pAllocator);
-        vkFreeMemory(device, textureImageMemory, pAllocator);
+        vkDestroySampler(device, depthPyramidSampler, pAllocator);
+
+        for (Texture& texture : textures)
+        {
+            // Slots of textures that failed to load never got an image
+            if (texture.image == VK_NULL_HANDLE)
+                continue;
+
+            vkDestroyImageView(device, texture.imageView, pAllocator);
+            vkDestroyImage(device, texture.image, pAllocator);
+            vkFreeMemory(device, texture.imageMemory, pAllocator);
+        }
+
+        vkDestroyBuffer(device, materialBuffer.buffer, pAllocator);
+        vkFreeMemory(device, materialBuffer.bufferMemory, pAllocator);
 
         vkDestroyPipelineLayout(device, pipelineLayout, pAllocator);
         vkDestroyRenderPass(device, renderPass, pAllocator);
-        vkDestroyPipeline(device, pipeline, pAllocator);
-        vkDestroyPipeline(device, wireframePipeline, pAllocator);
-
-        vkDestroyDescriptorPool(device, descriptorPool, pAllocator);
+        vkDestroyRenderPass(device, renderPassLoad, pAllocator);
+        pipelineVariants.cleanup();
+        vkDestroyShaderModule(device, shaderModuleVert, pAllocator);
+        vkDestroyShaderModule(device, shaderModuleFrag, pAllocator);
+        vkDestroyShaderModule(device, shaderModuleDepthPrepass, pAllocator);
+        vkDestroyPipeline(device, lightCullingPipeline, pAllocator);
+        vkDestroyPipelineLayout(device, lightCullingPipelineLayout, pAllocator);
+        vkDestroyPipeline(device, occlusionCullingPipeline, pAllocator);
+        vkDestroyPipelineLayout(device, occlusionCullingPipelineLayout, pAllocator);
+        vkDestroyPipeline(device, depthPyramidPipeline, pAllocator);
+        vkDestroyPipelineLayout(device, depthPyramidPipelineLayout, pAllocator);
+        vkDestroyPipeline(device, particleArgumentsPipeline, pAllocator);
+        vkDestroyPipeline(device, particleEmitPipeline, pAllocator);
+        vkDestroyPipeline(device, particleSimulatePipeline, pAllocator);
+        vkDestroyPipeline(device, particlePipeline, pAllocator);
+        vkDestroyPipelineLayout(device, particlePipelineLayout, pAllocator);
+
+        vkDestroyDescriptorUpdateTemplate(device, frameDescriptorTemplate, pAllocator);
+        vkDestroyDescriptorUpdateTemplate(device, lightCullingDescriptorTemplate, pAllocator);
+        vkDestroyDescriptorUpdateTemplate(device, occlusionCullingDescriptorTemplate, pAllocator);
+        vkDestroyDescriptorUpdateTemplate(device, depthPyramidDescriptorTemplate, pAllocator);
+        vkDestroyDescriptorUpdateTemplate(device, particleComputeDescriptorTemplate, pAllocator);
+        vkDestroyDescriptorUpdateTemplate(device, particleDrawDescriptorTemplate, pAllocator);
         vkDestroyDescriptorPool(device, descriptorPoolImGui, pAllocator);
         vkDestroyDescriptorSetLayout(device, descriptorSetLayout, pAllocator);
-
-        vkDestroyBuffer(device, indexBuffer.buffer, pAllocator);
-        vkFreeMemory(device, indexBuffer.bufferMemory, pAllocator);
-        vkDestroyBuffer(device, vertexBuffer.buffer, pAllocator);
-        vkFreeMemory(device, vertexBuffer.bufferMemory, pAllocator);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayoutLightCulling, pAllocator);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayoutOcclusionCulling, pAllocator);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayoutDepthPyramid, pAllocator);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayoutParticles, pAllocator);
+        vkDestroyDescriptorPool(device, descriptorPoolBindless, pAllocator);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayoutBindless, pAllocator);
+
+        vkDestroyBuffer(device, geometryBuffer.buffer, pAllocator);
+        vkFreeMemory(device, geometryBuffer.bufferMemory, pAllocator);
+        vkDestroyBuffer(device, positionBuffer.buffer, pAllocator);
+        vkFreeMemory(device, positionBuffer.bufferMemory, pAllocator);
+        vkDestroyBuffer(device, meshBuffer.buffer, pAllocator);
+        vkFreeMemory(device, meshBuffer.bufferMemory, pAllocator);
+        vkDestroyBuffer(device, visibilityBuffer.buffer, pAllocator);
+        vkFreeMemory(device, visibilityBuffer.bufferMemory, pAllocator);
+
+        for (AllocatedBuffer* buffer : { &particlePositionBuffer, &particleVelocityBuffer, &particleColorBuffer, &particleDeadListBuffer, &particleAliveListBuffer, &particleCounterBuffer })
+        {
+            vkDestroyBuffer(device, buffer->buffer, pAllocator);
+            vkFreeMemory(device, buffer->bufferMemory, pAllocator);
+        }
 
         vkDestroyDevice(device, pAllocator);
         vkDestroySurfaceKHR(instance, surface, pAllocator);
@@ -505,15 +886,15 @@ namespace VulkanPrototype::Renderer
         return 0;
     }
 
-    void copyBuffer(uint64_t size, VkBuffer srcBuffer, VkBuffer dstBuffer)
+    void copyBuffer(uint64_t size, VkBuffer srcBuffer, VkBuffer dstBuffer, uint64_t srcOffset = 0, uint64_t dstOffset = 0)
     {
         VkCommandBuffer commandBuffer;
         beginCommandBuffer(&commandBuffer);
 
         VkBufferCopy copyRegion =
         {
-            .srcOffset = 0,
-            .dstOffset = 0,
+            .srcOffset = srcOffset,
+            .dstOffset = dstOffset,
             .size = size
         };
 
@@ -555,6 +936,41 @@ namespace VulkanPrototype::Renderer
         endCommandBuffer(commandBuffer);
     }
 
+    void copyDrawCommandsToHost(FrameData& frame)
+    {
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        VkMemoryBarrier cullingBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &cullingBarrier, 0, nullptr, 0, nullptr);
+
+        // Behind the commands of the CPU, they are read once the fence of the frame was waited on
+        VkBufferCopy copyRegion =
+        {
+            .srcOffset = 0,
+            .dstOffset = sizeof(VkDrawIndexedIndirectCommand) * 2 * maxDrawCount,
+            .size = sizeof(VkDrawIndexedIndirectCommand) * 2 * frame.drawCount
+        };
+
+        vkCmdCopyBuffer(commandBuffer, frame.drawCommandBuffer.buffer, frame.indirectBuffer.buffer, 1, &copyRegion);
+
+        VkMemoryBarrier hostBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+    }
+
     void createBuffer(uint64_t size, VkBufferUsageFlags usage, VkSharingMode sharingMode, VkMemoryPropertyFlags properties, AllocatedBuffer& allocatedBuffer)
     {
         VkResult result;
@@ -592,6 +1008,89 @@ namespace VulkanPrototype::Renderer
         evaluteVulkanResult(result);
     }
 
+    VkPipeline createComputePipeline(const Assets::AssetHandle<std::vector<char>>& shaderFile, VkPipelineLayout layout)
+    {
+        VkResult result;
+
+        std::vector<char> shaderCode;
+
+        try
+        {
+            shaderCode = shaderFile.get();
+        }
+        catch (std::exception& ex)
+        {
+            std::cout << ex.what() << std::endl;
+            evaluteVulkanResult(VK_ERROR_INITIALIZATION_FAILED);
+        }
+
+        VkShaderModule shaderModule;
+        createShaderModule(shaderCode, &shaderModule);
+
+        VkComputePipelineCreateInfo pipelineCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage =
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = shaderModule,
+                .pName = "main",
+                .pSpecializationInfo = nullptr
+            },
+            .layout = layout,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        VkPipeline pipeline;
+        result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, pAllocator, &pipeline);
+        evaluteVulkanResult(result);
+
+        vkDestroyShaderModule(device, shaderModule, pAllocator);
+
+        return pipeline;
+    }
+
+    void createComputePipelines()
+    {
+        lightCullingPipeline = createComputePipeline(shaderFileLightCulling, lightCullingPipelineLayout);
+        occlusionCullingPipeline = createComputePipeline(shaderFileOcclusionCulling, occlusionCullingPipelineLayout);
+        depthPyramidPipeline = createComputePipeline(shaderFileDepthPyramid, depthPyramidPipelineLayout);
+        particleArgumentsPipeline = createComputePipeline(shaderFileParticleArguments, particlePipelineLayout);
+        particleEmitPipeline = createComputePipeline(shaderFileParticleEmit, particlePipelineLayout);
+        particleSimulatePipeline = createComputePipeline(shaderFileParticleSimulate, particlePipelineLayout);
+    }
+
+    void createCullingBuffers()
+    {
+        // The commands of both phases, the second phase starts behind the commands of the first one
+        uint64_t drawCommandBufferSize = sizeof(VkDrawIndexedIndirectCommand) * 2 * maxDrawCount;
+
+        // Every object can be drawn once per phase, the second phase uses the upper half
+        uint64_t visibleInstanceBufferSize = sizeof(uint32_t) * 2 * maxGameObjectCount;
+
+        for (FrameData& frameData : frames)
+        {
+            createBuffer(drawCommandBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frameData.drawCommandBuffer);
+            createBuffer(visibleInstanceBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frameData.visibleInstanceBuffer);
+        }
+
+        // Shared by all frames, the frames run one after another on the queue. Nothing was visible before the first frame.
+        uint64_t visibilityBufferSize = maxVisibilityObjectCount / 8;
+
+        createBuffer(visibilityBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, visibilityBuffer);
+
+        VkCommandBuffer commandBuffer;
+        beginCommandBuffer(&commandBuffer);
+        vkCmdFillBuffer(commandBuffer, visibilityBuffer.buffer, 0, visibilityBufferSize, 0);
+        endCommandBuffer(commandBuffer);
+    }
+
     void createDepthResources()
     {
         VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
@@ -608,7 +1107,7 @@ namespace VulkanPrototype::Renderer
             .arrayLayers = 1,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
             .queueFamilyIndexCount = 0,
             .pQueueFamilyIndices = nullptr,
@@ -618,55 +1117,68 @@ namespace VulkanPrototype::Renderer
         createImage(imageCreateInfo, depthImage, depthImageMemory);
 
         depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+        // Depth pyramid, level 0 has the size of the depth image and every level halves it down to 1x1
+        uint32_t levelCount = 1;
+        while ((std::max(g_windowSize.width, g_windowSize.height) >> levelCount) > 0)
+            levelCount++;
+
+        VkImageCreateInfo pyramidCreateInfo = imageCreateInfo;
+        pyramidCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+        pyramidCreateInfo.mipLevels = levelCount;
+        pyramidCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+        createImage(pyramidCreateInfo, depthPyramidImage, depthPyramidImageMemory);
+
+        depthPyramidImageView = createImageView(depthPyramidImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+
+        depthPyramidLevelViews.resize(levelCount);
+        for (uint32_t i = 0; i < levelCount; i++)
+            depthPyramidLevelViews[i] = createImageView(depthPyramidImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 1, i);
+
+        // Written and read by the compute shaders only, so it never leaves the general layout
+        transitionImageLayout(depthPyramidImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, levelCount);
     }
 
     void createDescriptorPool()
     {
         VkResult result;
 
-        VkDescriptorPoolSize descriptorPoolSize[] =
+        // One bindless set shared by all frames
+        VkDescriptorPoolSize descriptorPoolSizeBindless[] =
         {
             {
-                .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                .descriptorCount = imageCount
+                .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                .descriptorCount = maxTextureCount
             },
             {
                 .type = VK_DESCRIPTOR_TYPE_SAMPLER,
-                .descriptorCount = imageCount
+                .descriptorCount = 1
             },
             {
                 .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                .descriptorCount = imageCount
+                .descriptorCount = 4
             }
         };
 
-        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo =
+        VkDescriptorPoolCreateInfo descriptorPoolBindlessCreateInfo =
         {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
             .pNext = nullptr,
-            .flags = 0,
-            .maxSets = imageCount * IM_ARRAYSIZE(descriptorPoolSize),
-            .poolSizeCount = (uint32_t)IM_ARRAYSIZE(descriptorPoolSize),
-            .pPoolSizes = descriptorPoolSize
+            .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+            .maxSets = 1,
+            .poolSizeCount = (uint32_t)IM_ARRAYSIZE(descriptorPoolSizeBindless),
+            .pPoolSizes = descriptorPoolSizeBindless
         };
 
-        result = vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, pAllocator, &descriptorPool);
+        result = vkCreateDescriptorPool(device, &descriptorPoolBindlessCreateInfo, pAllocator, &descriptorPoolBindless);
         evaluteVulkanResult(result);
 
         //For ImGui only Dont Touch
+        //The Vulkan backend only allocates a combined image sampler for the font atlas and for each user texture
         VkDescriptorPoolSize pool_sizes[] =
         {
-            { VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
-            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
-            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000 },
-            { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000 },
-            { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000 },
-            { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000 },
-            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000 },
-            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000 },
-            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000 },
-            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000 },
-            { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000 }
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 16 }
         };
 
         VkDescriptorPoolCreateInfo pool_info =
@@ -674,7 +1186,7 @@ namespace VulkanPrototype::Renderer
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
             .pNext = nullptr,
             .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
-            .maxSets = 1000 * IM_ARRAYSIZE(pool_sizes),
+            .maxSets = 16,
             .poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes),
             .pPoolSizes = pool_sizes
         };
@@ -693,18 +1205,46 @@ namespace VulkanPrototype::Renderer
                 .binding = 0,
                 .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                 .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 2,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
                 .pImmutableSamplers = nullptr
             },
             {
-                .binding = 1,
-                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .binding = 3,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
                 .pImmutableSamplers = nullptr
             },
             {
-                .binding = 2,
+                .binding = 4,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 5,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 6,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 7,
                 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
@@ -716,1219 +1256,3570 @@ namespace VulkanPrototype::Renderer
         {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
             .pNext = nullptr,
-            .flags = 0,
+            .flags = pushDescriptorsSupported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
             .bindingCount = IM_ARRAYSIZE(descriptorSetLayoutBinding),
             .pBindings = descriptorSetLayoutBinding
         };
 
         result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutInfo, pAllocator, &descriptorSetLayout);
         evaluteVulkanResult(result);
-    }
-
-    void createDescriptorSets()
-    {
-        VkResult result;
-
-        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo =
-        {
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-            .pNext = nullptr,
-            .descriptorPool = descriptorPool,
-            .descriptorSetCount = 1,
-            .pSetLayouts = &descriptorSetLayout
-        };
 
-        for (FrameData& frameData : frames)
+        // Light culling, the bindings are numbered like in set 0 of the graphics pipeline
+        VkDescriptorSetLayoutBinding descriptorSetLayoutBindingLightCulling[] =
         {
-            result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &frameData.descriptorSet);
-            evaluteVulkanResult(result);
-
-            VkDescriptorBufferInfo descriptorBufferInfo =
             {
-                .buffer = frameData.uniformBuffer.buffer,
-                .offset = 0,
-                .range = sizeof(UniformBufferObject)
-            };
-
-            VkDescriptorImageInfo descriptorImageInfo =
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
+            },
             {
-                .sampler = textureSampler,
-                .imageView = textureImageView,
-                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-            };
-
-            VkDescriptorBufferInfo descriptorStorageBufferInfo =
+                .binding = 3,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
+            },
             {
-                .buffer = frameData.objectBuffer.buffer,
-                .offset = 0,
-                .range = sizeof(GameObjectData) * 1000
-            };
-
-            VkWriteDescriptorSet writeDescriptorSet[] =
+                .binding = 4,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
+            },
             {
-                {
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .pNext = nullptr,
-                    .dstSet = frameData.descriptorSet,
-                    .dstBinding = 0,
-                    .dstArrayElement = 0,
-                    .descriptorCount = 1,
-                    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                    .pImageInfo = nullptr,
-                    .pBufferInfo = &descriptorBufferInfo,
-                    .pTexelBufferView = nullptr
-                },
-                {
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .pNext = nullptr,
-                    .dstSet = frameData.descriptorSet,
-                    .dstBinding = 1,
-                    .dstArrayElement = 0,
-                    .descriptorCount = 1,
-                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    .pImageInfo = &descriptorImageInfo,
-                    .pBufferInfo = nullptr,
-                    .pTexelBufferView = nullptr
-                },
-                {
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .pNext = nullptr,
-                    .dstSet = frameData.descriptorSet,
-                    .dstBinding = 2,
-                    .dstArrayElement = 0,
-                    .descriptorCount = 1,
-                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                    .pImageInfo = nullptr,
-                    .pBufferInfo = &descriptorStorageBufferInfo,
-                    .pTexelBufferView = nullptr
-                }
-            };
+                .binding = 5,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
+            }
+        };
 
-            vkUpdateDescriptorSets(device, 3, writeDescriptorSet, 0, nullptr);
-        }
-    }
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutLightCullingInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = pushDescriptorsSupported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
+            .bindingCount = IM_ARRAYSIZE(descriptorSetLayoutBindingLightCulling),
+            .pBindings = descriptorSetLayoutBindingLightCulling
+        };
 
-    void createFramebuffers()
-    {
-        VkResult result;
+        result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutLightCullingInfo, pAllocator, &descriptorSetLayoutLightCulling);
+        evaluteVulkanResult(result);
 
-        framebuffers.resize(imageCount);
-        for (uint32_t i = 0; i < imageCount; i++)
-        {
-            std::array<VkImageView, 2> attachments =
-            {
-                imageViews[i],
-                depthImageView
-            };
+        // Occlusion culling, in the order of CullingDescriptors
+        VkDescriptorSetLayoutBinding descriptorSetLayoutBindingOcclusionCulling[8];
 
-            VkFramebufferCreateInfo framebufferCreateInfo =
+        for (uint32_t i = 0; i < IM_ARRAYSIZE(descriptorSetLayoutBindingOcclusionCulling); i++)
+        {
+            descriptorSetLayoutBindingOcclusionCulling[i] =
             {
-                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = 0,
-                .renderPass = renderPass,
-                .attachmentCount = static_cast<uint32_t>(attachments.size()),
-                .pAttachments = attachments.data(),
-                .width = g_windowSize.width,
-                .height = g_windowSize.height,
-                .layers = 1
+                .binding = i,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
             };
-
-            result = vkCreateFramebuffer(device, &framebufferCreateInfo, nullptr, &(framebuffers[i]));
-            evaluteVulkanResult(result);
         }
-    }
 
-    void createFrameData()
-    {
-        VkResult result;
+        descriptorSetLayoutBindingOcclusionCulling[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorSetLayoutBindingOcclusionCulling[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
-        VkSemaphoreCreateInfo semaphoreCreateInfo =
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutOcclusionCullingInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
             .pNext = nullptr,
-            .flags = 0
+            .flags = pushDescriptorsSupported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
+            .bindingCount = IM_ARRAYSIZE(descriptorSetLayoutBindingOcclusionCulling),
+            .pBindings = descriptorSetLayoutBindingOcclusionCulling
         };
 
-        VkFenceCreateInfo fenceCreateInfo =
+        result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutOcclusionCullingInfo, pAllocator, &descriptorSetLayoutOcclusionCulling);
+        evaluteVulkanResult(result);
+
+        // Depth pyramid, one set per level
+        VkDescriptorSetLayoutBinding descriptorSetLayoutBindingDepthPyramid[] =
         {
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = VK_FENCE_CREATE_SIGNALED_BIT
+            {
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = nullptr
+            }
         };
 
-        //TODO: Check flags according to Vulkan Tutorial
-        VkCommandPoolCreateInfo commandPoolCreateInfo =
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutDepthPyramidInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
             .pNext = nullptr,
-            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-            .queueFamilyIndex = queueFamily.index.value()
+            .flags = pushDescriptorsSupported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
+            .bindingCount = IM_ARRAYSIZE(descriptorSetLayoutBindingDepthPyramid),
+            .pBindings = descriptorSetLayoutBindingDepthPyramid
         };
 
-        frames.resize(imageCount);
-        for (int i = 0; i < imageCount; i++)
-        {
-            frames[i] = { };
-            // Semaphores
-            result = vkCreateSemaphore(device, &semaphoreCreateInfo, pAllocator, &frames[i].semaphoreImageAvailable);
-            evaluteVulkanResult(result);
-            result = vkCreateSemaphore(device, &semaphoreCreateInfo, pAllocator, &frames[i].semaphoreRenderingDone);
-            evaluteVulkanResult(result);
+        result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutDepthPyramidInfo, pAllocator, &descriptorSetLayoutDepthPyramid);
+        evaluteVulkanResult(result);
 
-            // Fence
-            result = vkCreateFence(device, &fenceCreateInfo, pAllocator, &frames[i].fenceCommandBufferDone);
-            evaluteVulkanResult(result);
+        // Particles, in the order of ParticleDescriptors. The same set is used by the compute passes and particle.vert.
+        VkDescriptorSetLayoutBinding descriptorSetLayoutBindingParticles[7];
 
-            // CommandPool
-            result = vkCreateCommandPool(device, &commandPoolCreateInfo, pAllocator, &frames[i].commandPool);
-            evaluteVulkanResult(result);
+        for (uint32_t i = 0; i < IM_ARRAYSIZE(descriptorSetLayoutBindingParticles); i++)
+        {
+            descriptorSetLayoutBindingParticles[i] =
+            {
+                .binding = i,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
+                .pImmutableSamplers = nullptr
+            };
+        }
 
-            { // CommandBuffer
-                VkCommandBufferAllocateInfo commandBufferAllocateInfo =
-                {
-                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                    .pNext = nullptr,
-                    .commandPool = frames[i].commandPool,
-                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                    .commandBufferCount = 1
-                };
+        descriptorSetLayoutBindingParticles[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorSetLayoutBindingParticles[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-                result = vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &frames[i].mainCommandBuffer);
-                evaluteVulkanResult(result);
-            }
-        }
-    }
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutParticlesInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = pushDescriptorsSupported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
+            .bindingCount = IM_ARRAYSIZE(descriptorSetLayoutBindingParticles),
+            .pBindings = descriptorSetLayoutBindingParticles
+        };
 
-    void createGraphicsPipeline()
-    {
-        VkResult result;
+        result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutParticlesInfo, pAllocator, &descriptorSetLayoutParticles);
+        evaluteVulkanResult(result);
 
-        std::vector<char> shaderCodeVert, shaderCodeFrag;
+        // Bindless set: every texture lives in one array that is indexed through the materials
+        VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties =
+        {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+            .pNext = nullptr
+        };
 
-        try
+        VkPhysicalDeviceProperties2 physicalDeviceProperties =
         {
-            readFile("shader/vert.spv", shaderCodeVert);
-            readFile("shader/frag.spv", shaderCodeFrag);
-        }
-        catch (std::exception& ex)
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &descriptorIndexingProperties
+        };
+
+        vkGetPhysicalDeviceProperties2(physicalDevice, &physicalDeviceProperties);
+
+        maxTextureCount = std::min({ maxTextureCount, descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+        VkDescriptorSetLayoutBinding descriptorSetLayoutBindingBindless[] =
         {
-            std::cout << ex.what() << std::endl;
-            evaluteVulkanResult(VK_ERROR_INITIALIZATION_FAILED);
-        }
+            {
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                .descriptorCount = maxTextureCount,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 2,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 3,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 4,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = 5,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .pImmutableSamplers = nullptr
+            }
+        };
 
-        VkShaderModule shaderModuleVert, shaderModuleFrag;
-        createShaderModule(shaderCodeVert, &shaderModuleVert);
-        createShaderModule(shaderCodeFrag, &shaderModuleFrag);
+        // Texture slots can be written while frames using other slots are in flight
+        VkDescriptorBindingFlags descriptorBindingFlags[] =
+        {
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+            0,
+            0,
+            0,
+            0,
+            0
+        };
 
-        VkPipelineShaderStageCreateInfo shaderStageCreateInfoVert =
+        VkDescriptorSetLayoutBindingFlagsCreateInfo descriptorSetLayoutBindingFlagsInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
             .pNext = nullptr,
-            .flags = 0,
-            .stage = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = shaderModuleVert,
-            .pName = "main",
-            .pSpecializationInfo = nullptr
-        },
-            shaderStageCreateInfoFrag =
+            .bindingCount = IM_ARRAYSIZE(descriptorBindingFlags),
+            .pBindingFlags = descriptorBindingFlags
+        };
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutBindlessInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = shaderModuleFrag,
-            .pName = "main",
-            .pSpecializationInfo = nullptr
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = &descriptorSetLayoutBindingFlagsInfo,
+            .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+            .bindingCount = IM_ARRAYSIZE(descriptorSetLayoutBindingBindless),
+            .pBindings = descriptorSetLayoutBindingBindless
         };
 
-        std::vector<VkPipelineShaderStageCreateInfo> shaderStages = { shaderStageCreateInfoVert, shaderStageCreateInfoFrag };
+        result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutBindlessInfo, pAllocator, &descriptorSetLayoutBindless);
+        evaluteVulkanResult(result);
+    }
 
-        auto bindingDescription = Vertex::getBindingDescription();
-        auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    void createDescriptorSets()
+    {
+        VkResult result;
 
-        VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo =
+        // Set 0 is written every frame through frameDescriptorTemplate, only the bindless set is persistent
+        VkDescriptorSetAllocateInfo descriptorSetBindlessAllocateInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
             .pNext = nullptr,
-            .flags = 0,
-            .vertexBindingDescriptionCount = 1,
-            .pVertexBindingDescriptions = &bindingDescription,
-            .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
-            .pVertexAttributeDescriptions = attributeDescriptions.data()
+            .descriptorPool = descriptorPoolBindless,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &descriptorSetLayoutBindless
         };
 
-        VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo =
+        result = vkAllocateDescriptorSets(device, &descriptorSetBindlessAllocateInfo, &descriptorSetBindless);
+        evaluteVulkanResult(result);
+
+        VkDescriptorImageInfo descriptorSamplerInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-            .primitiveRestartEnable = VK_FALSE
+            .sampler = textureSampler,
+            .imageView = VK_NULL_HANDLE,
+            .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED
         };
 
-        //TODO: Eventuell windowData als parameter �bergeben (konsistenz)
-        //TODO: Viewport is never changed on resize, needs to maybe be recreated.
-        VkViewport viewport =
+        VkDescriptorBufferInfo descriptorMaterialBufferInfo =
         {
-            .x = 0.0f,
-            .y = 0.0f,
-            .width = static_cast<float>(g_windowSize.width),
-            .height = static_cast<float>(g_windowSize.height),
-            .minDepth = 0.0f,
-            .maxDepth = 1.0f
+            .buffer = materialBuffer.buffer,
+            .offset = 0,
+            .range = sizeof(MaterialData) * maxMaterialCount
         };
 
-        VkRect2D scissor =
+        VkDescriptorBufferInfo descriptorMeshBufferInfo =
         {
-            .offset = { 0, 0 },
-            .extent = g_windowSize
+            .buffer = meshBuffer.buffer,
+            .offset = 0,
+            .range = sizeof(MeshData) * (maxMeshCount + maxStreamedMeshCount)
         };
 
-        VkPipelineViewportStateCreateInfo viewportStateCreateInfo =
+        // The vertices are pulled from the whole geometry buffer, the index buffer binding uses the same memory
+        VkDescriptorBufferInfo descriptorGeometryBufferInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .viewportCount = 1,
-            .pViewports = &viewport,
-            .scissorCount = 1,
-            .pScissors = &scissor
+            .buffer = geometryBuffer.buffer,
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
         };
 
-        // TODO: Very important for Triangle face
-        VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo =
+        VkDescriptorBufferInfo descriptorPositionBufferInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .depthClampEnable = VK_FALSE,
-            .rasterizerDiscardEnable = VK_FALSE,
-            .polygonMode = VK_POLYGON_MODE_FILL,
-            .cullMode = VK_CULL_MODE_BACK_BIT,
-            .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-            .depthBiasEnable = VK_FALSE,
-            .depthBiasConstantFactor = 0.0f,
-            .depthBiasClamp = 0.0f,
-            .depthBiasSlopeFactor = 0.0f,
-            .lineWidth = 1.0f
+            .buffer = positionBuffer.buffer,
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
         };
 
-        VkPipelineMultisampleStateCreateInfo multisampleCreateInfo =
+        VkWriteDescriptorSet writeDescriptorSetBindless[] =
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-            .sampleShadingEnable = VK_FALSE,
-            .minSampleShading = 1.0f,
-            .pSampleMask = nullptr,
-            .alphaToCoverageEnable = VK_FALSE,
-            .alphaToOneEnable = VK_FALSE
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = nullptr,
+                .dstSet = descriptorSetBindless,
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                .pImageInfo = &descriptorSamplerInfo,
+                .pBufferInfo = nullptr,
+                .pTexelBufferView = nullptr
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = nullptr,
+                .dstSet = descriptorSetBindless,
+                .dstBinding = 2,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pImageInfo = nullptr,
+                .pBufferInfo = &descriptorMaterialBufferInfo,
+                .pTexelBufferView = nullptr
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = nullptr,
+                .dstSet = descriptorSetBindless,
+                .dstBinding = 3,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pImageInfo = nullptr,
+                .pBufferInfo = &descriptorMeshBufferInfo,
+                .pTexelBufferView = nullptr
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = nullptr,
+                .dstSet = descriptorSetBindless,
+                .dstBinding = 4,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pImageInfo = nullptr,
+                .pBufferInfo = &descriptorGeometryBufferInfo,
+                .pTexelBufferView = nullptr
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = nullptr,
+                .dstSet = descriptorSetBindless,
+                .dstBinding = 5,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pImageInfo = nullptr,
+                .pBufferInfo = &descriptorPositionBufferInfo,
+                .pTexelBufferView = nullptr
+            }
         };
 
-        VkPipelineColorBlendAttachmentState colorBlendAttachmentState =
+        vkUpdateDescriptorSets(device, IM_ARRAYSIZE(writeDescriptorSetBindless), writeDescriptorSetBindless, 0, nullptr);
+
+        // Unused slots stay unwritten, the array is partially bound
+        for (uint32_t i = 0; i < textures.size(); i++)
+            updateTextureDescriptor(i);
+    }
+
+    void createDescriptorUpdateTemplates()
+    {
+        std::vector<VkDescriptorUpdateTemplateEntry> entries =
         {
-            .blendEnable = VK_TRUE,
-            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-            .colorBlendOp = VK_BLEND_OP_ADD,
-            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-            .alphaBlendOp = VK_BLEND_OP_ADD,
-            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+            {
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .offset = offsetof(FrameDescriptors, uniformBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            },
+            {
+                .dstBinding = 2,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(FrameDescriptors, objectBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            },
+            {
+                .dstBinding = 3,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(FrameDescriptors, lightBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            },
+            {
+                .dstBinding = 4,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(FrameDescriptors, clusterBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            },
+            {
+                .dstBinding = 5,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(FrameDescriptors, lightIndexBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            },
+            {
+                .dstBinding = 6,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(FrameDescriptors, visibleInstanceBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            },
+            {
+                .dstBinding = 7,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(FrameDescriptors, transformBuffer),
+                .stride = sizeof(VkDescriptorBufferInfo)
+            }
         };
 
-        VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo =
+        frameDescriptorTemplate = createDescriptorUpdateTemplate(device, pAllocator, descriptorSetLayout, entries, pipelineLayout, 0, pushDescriptorsSupported);
+
+        // The light culling set has the uniform buffer and the light bindings of set 0
+        std::vector<VkDescriptorUpdateTemplateEntry> lightCullingEntries;
+
+        for (const VkDescriptorUpdateTemplateEntry& entry : entries)
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .logicOpEnable = VK_FALSE,
-            .logicOp = VK_LOGIC_OP_NO_OP,
-            .attachmentCount = 1,
-            .pAttachments = &colorBlendAttachmentState,
-            .blendConstants = { 0.0f, 0.0f, 0.0f, 0.0f }
-        };
+            if (entry.dstBinding == 0 || (entry.dstBinding >= 3 && entry.dstBinding <= 5))
+                lightCullingEntries.push_back(entry);
+        }
 
-        VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo =
+        lightCullingDescriptorTemplate = createDescriptorUpdateTemplate(device, pAllocator, descriptorSetLayoutLightCulling, lightCullingEntries, lightCullingPipelineLayout, 0, pushDescriptorsSupported, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+        // Occlusion culling, the bindings follow the members of CullingDescriptors
+        std::vector<VkDescriptorUpdateTemplateEntry> occlusionCullingEntries;
+
+        for (uint32_t i = 0; i < 6; i++)
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .depthTestEnable = VK_TRUE,
-            .depthWriteEnable = VK_TRUE,
-            .depthCompareOp = VK_COMPARE_OP_LESS,
-            .depthBoundsTestEnable = VK_FALSE,
-            .stencilTestEnable = VK_FALSE,
-            .front = {},
-            .back = {},
-            .minDepthBounds = 0.0f,
-            .maxDepthBounds = 1.0f
-        };
+            occlusionCullingEntries.push_back(
+            {
+                .dstBinding = i,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(CullingDescriptors, uniformBuffer) + sizeof(VkDescriptorBufferInfo) * i,
+                .stride = sizeof(VkDescriptorBufferInfo)
+            });
+        }
 
-        VkPipelineLayoutCreateInfo layoutCreateInfo =
+        occlusionCullingEntries.push_back(
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .setLayoutCount = 1,
-            .pSetLayouts = &descriptorSetLayout,
-            .pushConstantRangeCount = 0,
-            .pPushConstantRanges = nullptr
-        };
+            .dstBinding = 6,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .offset = offsetof(CullingDescriptors, depthPyramid),
+            .stride = sizeof(VkDescriptorImageInfo)
+        });
+
+        occlusionCullingEntries.push_back(
+        {
+            .dstBinding = 7,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .offset = offsetof(CullingDescriptors, transformBuffer),
+            .stride = sizeof(VkDescriptorBufferInfo)
+        });
 
-        result = vkCreatePipelineLayout(device, &layoutCreateInfo, pAllocator, &pipelineLayout);
-        evaluteVulkanResult(result);
+        occlusionCullingDescriptorTemplate = createDescriptorUpdateTemplate(device, pAllocator, descriptorSetLayoutOcclusionCulling, occlusionCullingEntries, occlusionCullingPipelineLayout, 0, pushDescriptorsSupported, VK_PIPELINE_BIND_POINT_COMPUTE);
 
-        VkGraphicsPipelineCreateInfo pipelineCreateInfo =
+        std::vector<VkDescriptorUpdateTemplateEntry> depthPyramidEntries =
         {
-            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .stageCount = 2,
-            .pStages = shaderStages.data(),
-            .pVertexInputState = &vertexInputCreateInfo,
-            .pInputAssemblyState = &inputAssemblyCreateInfo,
-            .pTessellationState = nullptr,
-            .pViewportState = &viewportStateCreateInfo,
-            .pRasterizationState = &rasterizationCreateInfo,
-            .pMultisampleState = &multisampleCreateInfo,
-            .pDepthStencilState = &depthStencilStateCreateInfo,
-            .pColorBlendState = &colorBlendCreateInfo,
-            .pDynamicState = nullptr,
-            .layout = pipelineLayout,
-            .renderPass = renderPass,
-            .subpass = 0,
-            .basePipelineHandle = VK_NULL_HANDLE,
-            .basePipelineIndex = -1
+            {
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .offset = offsetof(DepthPyramidDescriptors, source),
+                .stride = sizeof(VkDescriptorImageInfo)
+            },
+            {
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .offset = offsetof(DepthPyramidDescriptors, destination),
+                .stride = sizeof(VkDescriptorImageInfo)
+            }
         };
 
-        result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, pAllocator, &pipeline);
-        evaluteVulkanResult(result);
+        depthPyramidDescriptorTemplate = createDescriptorUpdateTemplate(device, pAllocator, descriptorSetLayoutDepthPyramid, depthPyramidEntries, depthPyramidPipelineLayout, 0, pushDescriptorsSupported, VK_PIPELINE_BIND_POINT_COMPUTE);
 
-        // Wireframe Pipeline
-        rasterizationCreateInfo.polygonMode = VK_POLYGON_MODE_LINE;
-        result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, pAllocator, &wireframePipeline);
+        // Particles, the bindings follow the members of ParticleDescriptors. Push descriptors need one template per bind point.
+        std::vector<VkDescriptorUpdateTemplateEntry> particleEntries;
 
-        vkDestroyShaderModule(device, shaderModuleVert, nullptr);
-        vkDestroyShaderModule(device, shaderModuleFrag, nullptr);
+        for (uint32_t i = 0; i < 7; i++)
+        {
+            particleEntries.push_back(
+            {
+                .dstBinding = i,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .offset = offsetof(ParticleDescriptors, uniformBuffer) + sizeof(VkDescriptorBufferInfo) * i,
+                .stride = sizeof(VkDescriptorBufferInfo)
+            });
+        }
+
+        particleComputeDescriptorTemplate = createDescriptorUpdateTemplate(device, pAllocator, descriptorSetLayoutParticles, particleEntries, particlePipelineLayout, 0, pushDescriptorsSupported, VK_PIPELINE_BIND_POINT_COMPUTE);
+        particleDrawDescriptorTemplate = createDescriptorUpdateTemplate(device, pAllocator, descriptorSetLayoutParticles, particleEntries, particlePipelineLayout, 0, pushDescriptorsSupported);
     }
 
-    void createImage(const VkImageCreateInfo& imageCreateInfo, VkImage& image, VkDeviceMemory& imageMemory)
+    void createFramebuffers()
     {
         VkResult result;
 
-        result = vkCreateImage(device, &imageCreateInfo, pAllocator, &image);
-        evaluteVulkanResult(result);
+        framebuffers.resize(imageCount);
+        for (uint32_t i = 0; i < imageCount; i++)
+        {
+            std::array<VkImageView, 2> attachments =
+            {
+                imageViews[i],
+                depthImageView
+            };
 
-        VkMemoryRequirements memoryRequirements;
-        vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+            VkFramebufferCreateInfo framebufferCreateInfo =
+            {
+                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .renderPass = renderPass,
+                .attachmentCount = static_cast<uint32_t>(attachments.size()),
+                .pAttachments = attachments.data(),
+                .width = g_windowSize.width,
+                .height = g_windowSize.height,
+                .layers = 1
+            };
 
-        VkMemoryAllocateInfo memoryAllocateInfo =
+            result = vkCreateFramebuffer(device, &framebufferCreateInfo, nullptr, &(framebuffers[i]));
+            evaluteVulkanResult(result);
+        }
+    }
+
+    void createFrameData()
+    {
+        VkResult result;
+
+        VkSemaphoreCreateInfo semaphoreCreateInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
             .pNext = nullptr,
-            .allocationSize = memoryRequirements.size,
-            .memoryTypeIndex = pickMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            .flags = 0
         };
 
-        result = vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &imageMemory);
-        evaluteVulkanResult(result);
+        VkFenceCreateInfo fenceCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = VK_FENCE_CREATE_SIGNALED_BIT
+        };
 
-        vkBindImageMemory(device, image, imageMemory, 0);
-    }
+        //TODO: Check flags according to Vulkan Tutorial
+        VkCommandPoolCreateInfo commandPoolCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = queueFamily.index.value()
+        };
 
-    VkImageView createImageView(const VkImage image, const VkFormat format, const VkImageAspectFlags aspectFlags)
-    {
-        VkResult result;
+        // The GPU time of a frame is only measured if every queue can write timestamps
+        VkPhysicalDeviceProperties physicalDeviceProperties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
 
-        VkImageViewCreateInfo imageViewCreateInfo =
+        if (physicalDeviceProperties.limits.timestampComputeAndGraphics)
+            timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
+
+        VkQueryPoolCreateInfo queryPoolCreateInfo =
         {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
-            .image = image,
-            .viewType = VK_IMAGE_VIEW_TYPE_2D,
-            .format = format,
-            .components =
-            {
-                .r = VK_COMPONENT_SWIZZLE_IDENTITY,
-                .g = VK_COMPONENT_SWIZZLE_IDENTITY,
-                .b = VK_COMPONENT_SWIZZLE_IDENTITY,
-                .a = VK_COMPONENT_SWIZZLE_IDENTITY
-            },
-            .subresourceRange =
-            {
-                .aspectMask = aspectFlags,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-            },
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2,
+            .pipelineStatistics = 0
         };
 
-        VkImageView imageView;
-        result = vkCreateImageView(device, &imageViewCreateInfo, pAllocator, &imageView);
-        evaluteVulkanResult(result);
+        frames.resize(imageCount);
+        for (int i = 0; i < imageCount; i++)
+        {
+            frames[i] = { };
+            // Semaphores
+            result = vkCreateSemaphore(device, &semaphoreCreateInfo, pAllocator, &frames[i].semaphoreImageAvailable);
+            evaluteVulkanResult(result);
+            result = vkCreateSemaphore(device, &semaphoreCreateInfo, pAllocator, &frames[i].semaphoreRenderingDone);
+            evaluteVulkanResult(result);
+
+            // Fence
+            result = vkCreateFence(device, &fenceCreateInfo, pAllocator, &frames[i].fenceCommandBufferDone);
+            evaluteVulkanResult(result);
+
+            // CommandPool
+            result = vkCreateCommandPool(device, &commandPoolCreateInfo, pAllocator, &frames[i].commandPool);
+            evaluteVulkanResult(result);
+
+            // Timestamps
+            if (timestampPeriod > 0.0f)
+            {
+                result = vkCreateQueryPool(device, &queryPoolCreateInfo, pAllocator, &frames[i].timestampQueryPool);
+                evaluteVulkanResult(result);
+            }
+
+            { // CommandBuffer
+                VkCommandBufferAllocateInfo commandBufferAllocateInfo =
+                {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .pNext = nullptr,
+                    .commandPool = frames[i].commandPool,
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1
+                };
+
+                result = vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &frames[i].mainCommandBuffer);
+                evaluteVulkanResult(result);
+            }
+
+            // DescriptorAllocator, the ratios are descriptors per set
+            frames[i].descriptorAllocator.initialize(device, pAllocator, 16,
+            {
+                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.0f },
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f }
+            });
+        }
+    }
+
+    void createGeometryBuffer()
+    {
+        // Storage buffer for the vertex pulling in shader.vert, index buffer for the draws
+        createBuffer(geometryBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geometryBuffer);
+        createBuffer(geometryBufferSize / 2, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, positionBuffer);
+
+        geometryAllocator.initialize(geometryBufferSize);
+
+        for (FrameData& frameData : frames)
+        {
+            createBuffer(streamingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.streamingBuffer);
+
+            void* data;
+            vkMapMemory(device, frameData.streamingBuffer.bufferMemory, 0, streamingBufferSize, 0, &data);
+            frameData.mappedStreamingBuffer = static_cast<uint8_t*>(data);
+        }
+    }
+
+    void createGraphicsPipeline()
+    {
+        std::vector<char> shaderCodeVert, shaderCodeFrag, shaderCodeDepthPrepass;
+
+        try
+        {
+            shaderCodeVert = shaderFileVert.get();
+            shaderCodeFrag = shaderFileFrag.get();
+            shaderCodeDepthPrepass = shaderFileDepthPrepass.get();
+        }
+        catch (std::exception& ex)
+        {
+            std::cout << ex.what() << std::endl;
+            evaluteVulkanResult(VK_ERROR_INITIALIZATION_FAILED);
+        }
+
+        // The modules live as long as the renderer, the variants are created from them on the compile threads
+        createShaderModule(shaderCodeVert, &shaderModuleVert);
+        createShaderModule(shaderCodeFrag, &shaderModuleFrag);
+        createShaderModule(shaderCodeDepthPrepass, &shaderModuleDepthPrepass);
+
+        // Only the fallbacks are waited for, every other variant is drawn with them until it is ready
+        pipelineVariants.initialize(device, pAllocator, createGraphicsPipelineVariant);
+        pipelineVariants.compileFallbacks();
+    }
+
+    VkPipeline createGraphicsPipelineVariant(uint32_t key)
+    {
+        VkResult result;
+
+        uint32_t state = key & PIPELINE_VARIANT_STATE_MASK;
+        bool depthPrepass = state == PIPELINE_VARIANT_STATE_DEPTH_PREPASS;
+
+        // The features are constants of the variant, the driver removes the code of the disabled ones
+        PipelineSpecialization specialization = PipelineVariantCache::getSpecialization(key);
+
+        VkSpecializationMapEntry specializationMapEntries[] =
+        {
+            { 0, offsetof(PipelineSpecialization, pushConstantDraws), sizeof(VkBool32) },
+            { 1, offsetof(PipelineSpecialization, texturing), sizeof(VkBool32) },
+            { 2, offsetof(PipelineSpecialization, debugVisualization), sizeof(uint32_t) }
+        };
+
+        VkSpecializationInfo specializationInfo =
+        {
+            .mapEntryCount = IM_ARRAYSIZE(specializationMapEntries),
+            .pMapEntries = specializationMapEntries,
+            .dataSize = sizeof(specialization),
+            .pData = &specialization
+        };
+
+        VkPipelineShaderStageCreateInfo shaderStageCreateInfoVert =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = depthPrepass ? shaderModuleDepthPrepass : shaderModuleVert,
+            .pName = "main",
+            .pSpecializationInfo = &specializationInfo
+        },
+            shaderStageCreateInfoFrag =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = shaderModuleFrag,
+            .pName = "main",
+            .pSpecializationInfo = &specializationInfo
+        };
+
+        // The depth prepass has positions only and no fragment shader
+        std::vector<VkPipelineShaderStageCreateInfo> shaderStages = { shaderStageCreateInfoVert };
+
+        if (!depthPrepass)
+            shaderStages.push_back(shaderStageCreateInfoFrag);
+
+        // shader.vert pulls its vertices from the geometry buffer with gl_VertexIndex, so there is no fixed function vertex input
+        VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .vertexBindingDescriptionCount = 0,
+            .pVertexBindingDescriptions = nullptr,
+            .vertexAttributeDescriptionCount = 0,
+            .pVertexAttributeDescriptions = nullptr
+        };
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+            .primitiveRestartEnable = VK_FALSE
+        };
+
+        //TODO: Eventuell windowData als parameter �bergeben (konsistenz)
+        //TODO: Viewport is never changed on resize, needs to maybe be recreated.
+        VkViewport viewport =
+        {
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = static_cast<float>(g_windowSize.width),
+            .height = static_cast<float>(g_windowSize.height),
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f
+        };
+
+        VkRect2D scissor =
+        {
+            .offset = { 0, 0 },
+            .extent = g_windowSize
+        };
+
+        VkPipelineViewportStateCreateInfo viewportStateCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .viewportCount = 1,
+            .pViewports = &viewport,
+            .scissorCount = 1,
+            .pScissors = &scissor
+        };
+
+        // TODO: Very important for Triangle face
+        VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .depthClampEnable = VK_FALSE,
+            .rasterizerDiscardEnable = VK_FALSE,
+            .polygonMode = state == PIPELINE_VARIANT_STATE_WIREFRAME ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL,
+            .cullMode = VK_CULL_MODE_BACK_BIT,
+            .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            .depthBiasEnable = VK_FALSE,
+            .depthBiasConstantFactor = 0.0f,
+            .depthBiasClamp = 0.0f,
+            .depthBiasSlopeFactor = 0.0f,
+            .lineWidth = 1.0f
+        };
+
+        VkPipelineMultisampleStateCreateInfo multisampleCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+            .sampleShadingEnable = VK_FALSE,
+            .minSampleShading = 1.0f,
+            .pSampleMask = nullptr,
+            .alphaToCoverageEnable = VK_FALSE,
+            .alphaToOneEnable = VK_FALSE
+        };
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachmentState =
+        {
+            .blendEnable = VK_TRUE,
+            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        };
+
+        VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .logicOpEnable = VK_FALSE,
+            .logicOp = VK_LOGIC_OP_NO_OP,
+            .attachmentCount = depthPrepass ? 0u : 1u,
+            .pAttachments = depthPrepass ? nullptr : &colorBlendAttachmentState,
+            .blendConstants = { 0.0f, 0.0f, 0.0f, 0.0f }
+        };
+
+        VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .depthTestEnable = VK_TRUE,
+            .depthWriteEnable = VK_TRUE,
+            .depthCompareOp = VK_COMPARE_OP_LESS,
+            .depthBoundsTestEnable = VK_FALSE,
+            .stencilTestEnable = VK_FALSE,
+            .front = {},
+            .back = {},
+            .minDepthBounds = 0.0f,
+            .maxDepthBounds = 1.0f
+        };
+
+        // Color pass behind the depth prepass, only the nearest fragment of every pixel passes and is shaded exactly once
+        if (state == PIPELINE_VARIANT_STATE_DEPTH_EQUAL)
+        {
+            depthStencilStateCreateInfo.depthWriteEnable = VK_FALSE;
+            depthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        }
+
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stageCount = static_cast<uint32_t>(shaderStages.size()),
+            .pStages = shaderStages.data(),
+            .pVertexInputState = &vertexInputCreateInfo,
+            .pInputAssemblyState = &inputAssemblyCreateInfo,
+            .pTessellationState = nullptr,
+            .pViewportState = &viewportStateCreateInfo,
+            .pRasterizationState = &rasterizationCreateInfo,
+            .pMultisampleState = &multisampleCreateInfo,
+            .pDepthStencilState = &depthStencilStateCreateInfo,
+            .pColorBlendState = &colorBlendCreateInfo,
+            .pDynamicState = nullptr,
+            .layout = pipelineLayout,
+            .renderPass = renderPass,
+            .subpass = depthPrepass ? depthPrepassSubpass : colorSubpass,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        // The variant cache logs the key and keeps the fallback if this returns VK_NULL_HANDLE
+        VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+        result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, pAllocator, &graphicsPipeline);
+        evaluteVulkanResult(result);
+
+        return result == VK_SUCCESS ? graphicsPipeline : VK_NULL_HANDLE;
+    }
+
+    void createImage(const VkImageCreateInfo& imageCreateInfo, VkImage& image, VkDeviceMemory& imageMemory)
+    {
+        VkResult result;
+
+        result = vkCreateImage(device, &imageCreateInfo, pAllocator, &image);
+        evaluteVulkanResult(result);
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+
+        VkMemoryAllocateInfo memoryAllocateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .allocationSize = memoryRequirements.size,
+            .memoryTypeIndex = pickMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+        };
+
+        result = vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &imageMemory);
+        evaluteVulkanResult(result);
+
+        vkBindImageMemory(device, image, imageMemory, 0);
+    }
+
+    VkImageView createImageView(const VkImage image, const VkFormat format, const VkImageAspectFlags aspectFlags, const uint32_t mipLevels, const uint32_t baseMipLevel)
+    {
+        VkResult result;
+
+        VkImageViewCreateInfo imageViewCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = format,
+            .components =
+            {
+                .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .a = VK_COMPONENT_SWIZZLE_IDENTITY
+            },
+            .subresourceRange =
+            {
+                .aspectMask = aspectFlags,
+                .baseMipLevel = baseMipLevel,
+                .levelCount = mipLevels,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+        };
+
+        VkImageView imageView;
+        result = vkCreateImageView(device, &imageViewCreateInfo, pAllocator, &imageView);
+        evaluteVulkanResult(result);
+
+        return imageView;
+    }
+
+    void createImageViews()
+    {
+        VkResult result;
+
+        result = vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
+        evaluteVulkanResult(result);
+        std::vector<VkImage> swapchainImages(imageCount);
+        result = vkGetSwapchainImagesKHR(device, swapchain, &imageCount, swapchainImages.data());
+        evaluteVulkanResult(result);
+
+        imageViews.resize(imageCount);
+
+        for (uint32_t i = 0; i < imageCount; i++)
+        {
+            imageViews[i] = createImageView(swapchainImages[i], surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT);
+        }
+    }
+
+    void createIndirectBuffers()
+    {
+        // At most one draw per mesh and LOD and phase, once as written by the CPU and once as read back from the GPU
+        uint64_t bufferSize = sizeof(VkDrawIndexedIndirectCommand) * 4 * maxDrawCount;
+
+        for (FrameData& frameData : frames)
+        {
+            createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.indirectBuffer);
+
+            void* data;
+            vkMapMemory(device, frameData.indirectBuffer.bufferMemory, 0, bufferSize, 0, &data);
+            frameData.mappedDrawCommands = static_cast<VkDrawIndexedIndirectCommand*>(data);
+        }
+    }
+
+    int createInstance()
+    {
+        VkResult result;
+
+        VkApplicationInfo applicationInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            .pNext = nullptr,
+            .pApplicationName = "VulkanPrototype",
+            .applicationVersion = VULKANPROTOTYPE_VERSION,
+            .pEngineName = nullptr,
+            .engineVersion = 0,
+            .apiVersion = VK_API_VERSION_1_3
+        };
+
+        uint32_t amountOfGlfwExtensions = 0;
+        const char** requiredGlfwExtensions = glfwGetRequiredInstanceExtensions(&amountOfGlfwExtensions);
+        std::vector<const char*> instanceExtensions(requiredGlfwExtensions, requiredGlfwExtensions + amountOfGlfwExtensions);
+
+        if (!checkInstanceExtensionSupport(instanceExtensions))
+        {
+            std::cout << "Extension not Supported!\n";
+            return -1;
+        }
+
+#ifdef DEBUG
+
+        std::vector<const char*> instanceLayers = { "VK_LAYER_KHRONOS_validation" };
+
+        if (!checkInstanceLayerSupport(instanceLayers))
+        {
+            std::cout << "Validation Layer not Supported!\n";
+            return -1;
+        }
+
+        instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
+        if (!checkInstanceExtensionSupport(instanceExtensions))
+        {
+            std::cout << "Extension not Supported!\n";
+            return -1;
+        }
+
+        VkInstanceCreateInfo instanceCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .pApplicationInfo = &applicationInfo,
+            .enabledLayerCount = static_cast<uint32_t>(instanceLayers.size()),
+            .ppEnabledLayerNames = instanceLayers.data(),
+            .enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size()),
+            .ppEnabledExtensionNames = instanceExtensions.data()
+        };
+
+        result = vkCreateInstance(&instanceCreateInfo, nullptr, &instance);
+        evaluteVulkanResult(result);
+
+        VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+            .pNext = nullptr,
+            .flags = 0,
+            .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+            .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+            .pfnUserCallback = debugCallback,
+            .pUserData = nullptr
+        };
+
+        auto vkCreateDebugUtilsMessengerEXT = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+
+        if (vkCreateDebugUtilsMessengerEXT == nullptr)
+            return -1;
+
+        result = vkCreateDebugUtilsMessengerEXT(instance, &debugMessengerCreateInfo, nullptr, &debugMessenger);
+        evaluteVulkanResult(result);
+
+#else
+
+        VkInstanceCreateInfo instanceCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .pApplicationInfo = &applicationInfo,
+            .enabledLayerCount = 0,
+            .ppEnabledLayerNames = nullptr,
+            .enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size()),
+            .ppEnabledExtensionNames = instanceExtensions.data()
+        };
+
+        result = vkCreateInstance(&instanceCreateInfo, nullptr, &instance);
+        evaluteVulkanResult(result);
+
+#endif
+
+        return 0;
+    }
+
+    void createLightBuffers()
+    {
+        uint64_t lightBufferSize = sizeof(LightData) * maxLightCount;
+
+        // Offset and count per cluster
+        uint64_t clusterBufferSize = sizeof(uint32_t) * 2 * clusterCount;
+
+        // The counter of the used indices comes first
+        uint64_t lightIndexBufferSize = sizeof(uint32_t) * (1 + maxLightIndexCount);
+
+        for (FrameData& frameData : frames)
+        {
+            createBuffer(lightBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.lightBuffer);
+            createBuffer(clusterBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frameData.clusterBuffer);
+            createBuffer(lightIndexBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frameData.lightIndexBuffer);
+
+            void* data;
+            vkMapMemory(device, frameData.lightBuffer.bufferMemory, 0, lightBufferSize, 0, &data);
+            frameData.mappedLights = static_cast<LightData*>(data);
+        }
+    }
+
+    void createLogicalDevice(VkPhysicalDevice physicalDevice)
+    {
+        VkResult result;
+
+        queueFamily = pickQueueFamily(physicalDevice);
+
+        std::vector<float> queuePriorities(queueFamily.queueCount);
+        for (uint32_t i = 0; i < queueFamily.queueCount; i++)
+            queuePriorities[i] = 1.0f;
+
+        VkDeviceQueueCreateInfo deviceQueueCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .queueFamilyIndex = queueFamily.index.value(),
+            .queueCount = queueFamily.queueCount,
+            .pQueuePriorities = queuePriorities.data()
+        };
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+        //TODO: Add a check if the features are available.
+        VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
+        physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
+        physicalDeviceFeatures.fillModeNonSolid = VK_TRUE;
+        physicalDeviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+        // Without multi draw indirect the draw commands are recorded one by one. The instance counts come from the occlusion
+        // culling on the GPU, so the commands are always indirect and need their firstInstance.
+        physicalDeviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        physicalDeviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        multiDrawIndirectSupported = supportedFeatures.multiDrawIndirect;
+
+        if (!supportedFeatures.drawIndirectFirstInstance)
+        {
+            std::cout << "Draw Indirect First Instance not Supported";
+            evaluteVulkanResult(VK_ERROR_FEATURE_NOT_PRESENT);
+        }
+
+        //TODO: Add a check if the Extensions are available.
+        std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+        uint32_t amountOfExtensionProperties = 0;
+        result = vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &amountOfExtensionProperties, nullptr);
+        evaluteVulkanResult(result);
+
+        std::vector<VkExtensionProperties> extensionProperties(amountOfExtensionProperties);
+        result = vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &amountOfExtensionProperties, extensionProperties.data());
+        evaluteVulkanResult(result);
+
+        for (const VkExtensionProperties& extension : extensionProperties)
+        {
+            if (strcmp(extension.extensionName, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) == 0)
+            {
+                deviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+                pushDescriptorsSupported = true;
+            }
+        }
+
+        // Descriptor indexing is required for the bindless texture array
+        VkPhysicalDeviceDescriptorIndexingFeatures supportedDescriptorIndexingFeatures =
+        {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+            .pNext = nullptr
+        };
+
+        VkPhysicalDeviceFeatures2 supportedFeatures2 =
+        {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &supportedDescriptorIndexingFeatures
+        };
+
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+        if (!supportedDescriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing ||
+            !supportedDescriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind ||
+            !supportedDescriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending ||
+            !supportedDescriptorIndexingFeatures.descriptorBindingPartiallyBound ||
+            !supportedDescriptorIndexingFeatures.runtimeDescriptorArray)
+        {
+            std::cout << "Descriptor Indexing not Supported";
+            evaluteVulkanResult(VK_ERROR_FEATURE_NOT_PRESENT);
+        }
+
+        VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures =
+        {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+            .pNext = nullptr,
+            .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+            .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+            .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+            .descriptorBindingPartiallyBound = VK_TRUE,
+            .runtimeDescriptorArray = VK_TRUE
+        };
+
+        VkPhysicalDeviceShaderDrawParametersFeatures shaderDrawParametersFeatures =
+        {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES,
+            .pNext = &descriptorIndexingFeatures,
+            .shaderDrawParameters = VK_TRUE
+        };
+
+        VkDeviceCreateInfo deviceCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            .pNext = &shaderDrawParametersFeatures,
+            .flags = 0,
+            .queueCreateInfoCount = 1,
+            .pQueueCreateInfos = &deviceQueueCreateInfo,
+            .enabledLayerCount = 0,
+            .ppEnabledLayerNames = nullptr,
+            .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
+            .ppEnabledExtensionNames = deviceExtensions.data(),
+            .pEnabledFeatures = &physicalDeviceFeatures
+        };
+
+        result = vkCreateDevice(physicalDevice, &deviceCreateInfo, pAllocator, &device);
+        evaluteVulkanResult(result);
+
+        vkGetDeviceQueue(device, queueFamily.index.value(), 0, &queue);
+
+        if (pushDescriptorsSupported)
+            cmdPushDescriptorSetWithTemplate = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetWithTemplateKHR");
+    }
+
+    uint32_t createMaterial(uint32_t textureIndex, const glm::vec4& baseColor)
+    {
+        if (materials.size() >= maxMaterialCount)
+            throw std::runtime_error("Es koennen maximal " + std::to_string(maxMaterialCount) + " Materialien erstellt werden!");
+
+        uint32_t materialIndex = static_cast<uint32_t>(materials.size());
+
+        materials.push_back(
+        {
+            .baseColor = baseColor,
+            .textureIndex = textureIndex,
+            .padding = {}
+        });
+
+        // Only the new element is written, materials in use by frames in flight stay untouched
+        void* data;
+        vkMapMemory(device, materialBuffer.bufferMemory, sizeof(MaterialData) * materialIndex, sizeof(MaterialData), 0, &data);
+        memcpy(data, &materials[materialIndex], sizeof(MaterialData));
+        vkUnmapMemory(device, materialBuffer.bufferMemory);
+
+        return materialIndex;
+    }
+
+    void createMaterialBuffer()
+    {
+        uint64_t bufferSize = sizeof(MaterialData) * maxMaterialCount;
+
+        createBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, materialBuffer);
+    }
+
+    void createMesh(VkCommandBuffer commandBuffer, MeshUpload& meshUpload)
+    {
+        if (meshes.size() >= maxMeshCount)
+            throw std::runtime_error("Es koennen maximal " + std::to_string(maxMeshCount) + " Meshes geladen werden!");
+
+        Mesh& mesh = meshUpload.mesh;
+        mesh = {};
+
+        // Vertices are aligned to their size, so the draw commands can address them with a vertex offset
+        if (!geometryAllocator.allocate(meshUpload.vertexSize, sizeof(Vertex), mesh.vertexAllocation) ||
+            !geometryAllocator.allocate(meshUpload.indexSize, sizeof(uint32_t), mesh.indexAllocation))
+        {
+            geometryAllocator.free(mesh.vertexAllocation);
+            throw std::runtime_error("Im Geometrie Buffer ist kein Platz fuer " + std::to_string(meshUpload.vertexSize + meshUpload.indexSize) + " Bytes!");
+        }
+
+        VkBufferCopy geometryCopies[] =
+        {
+            { 0, mesh.vertexAllocation.offset, meshUpload.vertexSize },
+            { meshUpload.vertexSize, mesh.indexAllocation.offset, meshUpload.indexSize }
+        };
+
+        VkBufferCopy positionCopy = { meshUpload.vertexSize + meshUpload.indexSize, mesh.vertexAllocation.offset / 2, meshUpload.positionSize };
+
+        vkCmdCopyBuffer(commandBuffer, meshUpload.stagingBuffer.buffer, geometryBuffer.buffer, 2, geometryCopies);
+        vkCmdCopyBuffer(commandBuffer, meshUpload.stagingBuffer.buffer, positionBuffer.buffer, 1, &positionCopy);
+
+        mesh.vertexOffset = static_cast<int32_t>(mesh.vertexAllocation.offset / sizeof(Vertex));
+        mesh.firstIndex = static_cast<uint32_t>(mesh.indexAllocation.offset / sizeof(uint32_t));
+        mesh.lods = meshUpload.lods;
+
+        const VertexQuantization& quantization = meshUpload.quantization;
+
+        MeshData meshData =
+        {
+            .positionScale = glm::vec4(quantization.scale[0], quantization.scale[1], quantization.scale[2], 0.0f),
+            .positionOffset = glm::vec4(quantization.offset[0], quantization.offset[1], quantization.offset[2], 0.0f)
+        };
+
+        mesh.boundingSphere = glm::vec4(glm::vec3(meshData.positionOffset), glm::length(glm::vec3(meshData.positionScale)));
+
+        // The index is taken right away, findMesh skips the entry without LODs until publishAssetUploads moves the mesh in
+        meshUpload.meshIndex = static_cast<uint32_t>(meshes.size());
+        meshes.push_back({});
+
+        // Only the new element is written, meshes in use by frames in flight stay untouched
+        void* data;
+        vkMapMemory(device, meshBuffer.bufferMemory, sizeof(MeshData) * meshUpload.meshIndex, sizeof(MeshData), 0, &data);
+        memcpy(data, &meshData, sizeof(MeshData));
+        vkUnmapMemory(device, meshBuffer.bufferMemory);
+    }
+
+    void createMeshBuffer()
+    {
+        uint64_t bufferSize = sizeof(MeshData) * (maxMeshCount + maxStreamedMeshCount);
+
+        // Loaded meshes are mapped and written directly, the streaming slots are updated in the command buffer of the frame
+        createBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, meshBuffer);
+
+        streamedMeshes.resize(maxStreamedMeshCount);
+    }
+
+    void createParticleBuffers()
+    {
+        // 48 bytes per particle: position and age, velocity and lifetime, color, one dead and two alive list entries
+        createBuffer(sizeof(glm::vec4) * maxParticleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, particlePositionBuffer);
+        createBuffer(sizeof(glm::vec4) * maxParticleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, particleVelocityBuffer);
+        createBuffer(sizeof(uint32_t) * maxParticleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, particleColorBuffer);
+        createBuffer(sizeof(uint32_t) * maxParticleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, particleDeadListBuffer);
+        createBuffer(sizeof(uint32_t) * 2 * maxParticleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, particleAliveListBuffer);
+        createBuffer(sizeof(ParticleCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, particleCounterBuffer);
+
+        for (FrameData& frameData : frames)
+        {
+            createBuffer(sizeof(ParticleCounters), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.particleCounterReadbackBuffer);
+
+            void* data;
+            vkMapMemory(device, frameData.particleCounterReadbackBuffer.bufferMemory, 0, sizeof(ParticleCounters), 0, &data);
+            frameData.mappedParticleCounters = static_cast<ParticleCounters*>(data);
+        }
+
+        // Every particle starts dead, this is the only time the CPU writes the lists
+        uint64_t deadListSize = sizeof(uint32_t) * maxParticleCount;
+
+        AllocatedBuffer stagingBuffer;
+        createBuffer(sizeof(ParticleCounters) + deadListSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+
+        void* data;
+        vkMapMemory(device, stagingBuffer.bufferMemory, 0, sizeof(ParticleCounters) + deadListSize, 0, &data);
+
+        ParticleCounters counters = {};
+        counters.deadCount = maxParticleCount;
+        memcpy(data, &counters, sizeof(counters));
+
+        uint32_t* deadList = reinterpret_cast<uint32_t*>(static_cast<char*>(data) + sizeof(ParticleCounters));
+
+        for (uint32_t i = 0; i < maxParticleCount; i++)
+            deadList[i] = i;
+
+        vkUnmapMemory(device, stagingBuffer.bufferMemory);
+
+        copyBuffer(sizeof(ParticleCounters), stagingBuffer.buffer, particleCounterBuffer.buffer);
+        copyBuffer(deadListSize, stagingBuffer.buffer, particleDeadListBuffer.buffer, sizeof(ParticleCounters));
+
+        vkDestroyBuffer(device, stagingBuffer.buffer, pAllocator);
+        vkFreeMemory(device, stagingBuffer.bufferMemory, pAllocator);
+    }
+
+    void createParticlePipeline()
+    {
+        VkResult result;
+
+        std::vector<char> shaderCodeVert;
+        std::vector<char> shaderCodeFrag;
+
+        try
+        {
+            shaderCodeVert = shaderFileParticleVert.get();
+            shaderCodeFrag = shaderFileParticleFrag.get();
+        }
+        catch (std::exception& ex)
+        {
+            std::cout << ex.what() << std::endl;
+            evaluteVulkanResult(VK_ERROR_INITIALIZATION_FAILED);
+        }
+
+        VkShaderModule shaderModuleParticleVert;
+        VkShaderModule shaderModuleParticleFrag;
+        createShaderModule(shaderCodeVert, &shaderModuleParticleVert);
+        createShaderModule(shaderCodeFrag, &shaderModuleParticleFrag);
+
+        VkPipelineShaderStageCreateInfo shaderStages[] =
+        {
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                .module = shaderModuleParticleVert,
+                .pName = "main",
+                .pSpecializationInfo = nullptr
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .module = shaderModuleParticleFrag,
+                .pName = "main",
+                .pSpecializationInfo = nullptr
+            }
+        };
+
+        // particle.vert builds the quads from gl_VertexIndex and reads the particles of gl_InstanceIndex from the buffers
+        VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .vertexBindingDescriptionCount = 0,
+            .pVertexBindingDescriptions = nullptr,
+            .vertexAttributeDescriptionCount = 0,
+            .pVertexAttributeDescriptions = nullptr
+        };
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+            .primitiveRestartEnable = VK_FALSE
+        };
+
+        // Viewport and scissor are dynamic, unlike the variants this pipeline survives a resize of the swapchain
+        VkPipelineViewportStateCreateInfo viewportStateCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .viewportCount = 1,
+            .pViewports = nullptr,
+            .scissorCount = 1,
+            .pScissors = nullptr
+        };
+
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+        VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .dynamicStateCount = IM_ARRAYSIZE(dynamicStates),
+            .pDynamicStates = dynamicStates
+        };
+
+        // The billboards always face the camera
+        VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .depthClampEnable = VK_FALSE,
+            .rasterizerDiscardEnable = VK_FALSE,
+            .polygonMode = VK_POLYGON_MODE_FILL,
+            .cullMode = VK_CULL_MODE_NONE,
+            .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            .depthBiasEnable = VK_FALSE,
+            .depthBiasConstantFactor = 0.0f,
+            .depthBiasClamp = 0.0f,
+            .depthBiasSlopeFactor = 0.0f,
+            .lineWidth = 1.0f
+        };
+
+        VkPipelineMultisampleStateCreateInfo multisampleCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+            .sampleShadingEnable = VK_FALSE,
+            .minSampleShading = 1.0f,
+            .pSampleMask = nullptr,
+            .alphaToCoverageEnable = VK_FALSE,
+            .alphaToOneEnable = VK_FALSE
+        };
+
+        // Additive, so the particles need no sorting. particle.frag already multiplies the color with its alpha.
+        VkPipelineColorBlendAttachmentState colorBlendAttachmentState =
+        {
+            .blendEnable = VK_TRUE,
+            .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE,
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        };
+
+        VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .logicOpEnable = VK_FALSE,
+            .logicOp = VK_LOGIC_OP_NO_OP,
+            .attachmentCount = 1,
+            .pAttachments = &colorBlendAttachmentState,
+            .blendConstants = { 0.0f, 0.0f, 0.0f, 0.0f }
+        };
+
+        // Hidden behind the objects, but without writing depth
+        VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .depthTestEnable = VK_TRUE,
+            .depthWriteEnable = VK_FALSE,
+            .depthCompareOp = VK_COMPARE_OP_LESS,
+            .depthBoundsTestEnable = VK_FALSE,
+            .stencilTestEnable = VK_FALSE,
+            .front = {},
+            .back = {},
+            .minDepthBounds = 0.0f,
+            .maxDepthBounds = 1.0f
+        };
+
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stageCount = IM_ARRAYSIZE(shaderStages),
+            .pStages = shaderStages,
+            .pVertexInputState = &vertexInputCreateInfo,
+            .pInputAssemblyState = &inputAssemblyCreateInfo,
+            .pTessellationState = nullptr,
+            .pViewportState = &viewportStateCreateInfo,
+            .pRasterizationState = &rasterizationCreateInfo,
+            .pMultisampleState = &multisampleCreateInfo,
+            .pDepthStencilState = &depthStencilStateCreateInfo,
+            .pColorBlendState = &colorBlendCreateInfo,
+            .pDynamicState = &dynamicStateCreateInfo,
+            .layout = particlePipelineLayout,
+            .renderPass = renderPass,
+            .subpass = colorSubpass,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, pAllocator, &particlePipeline);
+        evaluteVulkanResult(result);
+
+        vkDestroyShaderModule(device, shaderModuleParticleVert, pAllocator);
+        vkDestroyShaderModule(device, shaderModuleParticleFrag, pAllocator);
+    }
+
+    void createPipelineLayout()
+    {
+        VkResult result;
+
+        VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout, descriptorSetLayoutBindless };
+
+        VkPushConstantRange drawPushConstantRange =
+        {
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .offset = 0,
+            .size = sizeof(DrawPushConstants)
+        };
+
+        VkPipelineLayoutCreateInfo layoutCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .setLayoutCount = IM_ARRAYSIZE(setLayouts),
+            .pSetLayouts = setLayouts,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &drawPushConstantRange
+        };
+
+        result = vkCreatePipelineLayout(device, &layoutCreateInfo, pAllocator, &pipelineLayout);
+        evaluteVulkanResult(result);
+
+        VkPipelineLayoutCreateInfo lightCullingLayoutCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .setLayoutCount = 1,
+            .pSetLayouts = &descriptorSetLayoutLightCulling,
+            .pushConstantRangeCount = 0,
+            .pPushConstantRanges = nullptr
+        };
+
+        result = vkCreatePipelineLayout(device, &lightCullingLayoutCreateInfo, pAllocator, &lightCullingPipelineLayout);
+        evaluteVulkanResult(result);
+
+        VkPushConstantRange occlusionCullingPushConstantRange =
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(CullingParameters)
+        };
+
+        VkPipelineLayoutCreateInfo occlusionCullingLayoutCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .setLayoutCount = 1,
+            .pSetLayouts = &descriptorSetLayoutOcclusionCulling,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &occlusionCullingPushConstantRange
+        };
+
+        result = vkCreatePipelineLayout(device, &occlusionCullingLayoutCreateInfo, pAllocator, &occlusionCullingPipelineLayout);
+        evaluteVulkanResult(result);
+
+        VkPushConstantRange depthPyramidPushConstantRange =
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(DepthPyramidParameters)
+        };
+
+        VkPipelineLayoutCreateInfo depthPyramidLayoutCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .setLayoutCount = 1,
+            .pSetLayouts = &descriptorSetLayoutDepthPyramid,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &depthPyramidPushConstantRange
+        };
+
+        result = vkCreatePipelineLayout(device, &depthPyramidLayoutCreateInfo, pAllocator, &depthPyramidPipelineLayout);
+        evaluteVulkanResult(result);
+
+        // Shared by the particle compute passes and the particle pipeline, so the push constants are visible to both stages
+        VkPushConstantRange particlePushConstantRange =
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
+            .offset = 0,
+            .size = sizeof(ParticleParameters)
+        };
+
+        VkPipelineLayoutCreateInfo particleLayoutCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .setLayoutCount = 1,
+            .pSetLayouts = &descriptorSetLayoutParticles,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &particlePushConstantRange
+        };
+
+        result = vkCreatePipelineLayout(device, &particleLayoutCreateInfo, pAllocator, &particlePipelineLayout);
+        evaluteVulkanResult(result);
+    }
+
+    void createPlaceholderTexture()
+    {
+        // Bound to every texture slot until its upload has finished on the worker threads
+        const uint8_t pixel[4] = { 255, 255, 255, 255 };
+
+        TextureUpload textureUpload =
+        {
+            .format = VK_FORMAT_R8G8B8A8_SRGB,
+            .width = 1,
+            .height = 1,
+            .regions =
+            {
+                {
+                    .bufferOffset = 0,
+                    .bufferRowLength = 0,
+                    .bufferImageHeight = 0,
+                    .imageSubresource =
+                    {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = 0,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1
+                    },
+                    .imageOffset = {0, 0, 0},
+                    .imageExtent = {1, 1, 1}
+                }
+            }
+        };
+
+        createBuffer(sizeof(pixel), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, textureUpload.stagingBuffer);
+
+        void* data;
+        vkMapMemory(device, textureUpload.stagingBuffer.bufferMemory, 0, sizeof(pixel), 0, &data);
+        memcpy(data, pixel, sizeof(pixel));
+        vkUnmapMemory(device, textureUpload.stagingBuffer.bufferMemory);
+
+        textures.push_back({});
+
+        VkCommandBuffer commandBuffer;
+        beginCommandBuffer(&commandBuffer);
+        createTextureImage(commandBuffer, textureUpload, textures[0]);
+        endCommandBuffer(commandBuffer);
+
+        vkDestroyBuffer(device, textureUpload.stagingBuffer.buffer, pAllocator);
+        vkFreeMemory(device, textureUpload.stagingBuffer.bufferMemory, pAllocator);
+    }
+
+    void createRenderPass()
+    {
+        VkResult result;
+
+        VkAttachmentDescription colorAttachmentDescription =
+        {
+            .flags = 0,
+            .format = surfaceFormat.format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        };
+
+        VkAttachmentReference colorAttachmentReference =
+        {
+            .attachment = 0,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        };
+
+        VkAttachmentDescription depthAttachmentDescription =
+        {
+            .flags = 0,
+            .format = VK_FORMAT_D32_SFLOAT,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+        };
+
+        VkAttachmentReference depthAttachmentReference =
+        {
+            .attachment = 1,
+            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+        };
+
+        // Subpass 0 is the optional depth prepass, without draws it only clears the depth. Subpass 1 shades the color.
+        VkSubpassDescription subpassDescriptions[] =
+        {
+            {
+                .flags = 0,
+                .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+                .inputAttachmentCount = 0,
+                .pInputAttachments = nullptr,
+                .colorAttachmentCount = 0,
+                .pColorAttachments = nullptr,
+                .pResolveAttachments = nullptr,
+                .pDepthStencilAttachment = &depthAttachmentReference,
+                .preserveAttachmentCount = 0,
+                .pPreserveAttachments = nullptr
+            },
+            {
+                .flags = 0,
+                .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+                .inputAttachmentCount = 0,
+                .pInputAttachments = nullptr,
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &colorAttachmentReference,
+                .pResolveAttachments = nullptr,
+                .pDepthStencilAttachment = &depthAttachmentReference,
+                .preserveAttachmentCount = 0,
+                .pPreserveAttachments = nullptr
+            }
+        };
+
+        //TODO: Check if rendering is not done properly without this struct
+        // The depth image of the last frame may still be read by its depth pyramid reduction
+        VkSubpassDependency subpassDependencies[] =
+        {
+            {
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = depthPrepassSubpass,
+                .srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dependencyFlags = 0
+            },
+            {
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = colorSubpass,
+                .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dependencyFlags = 0
+            },
+            {
+                // The color pass tests against the depth of the prepass
+                .srcSubpass = depthPrepassSubpass,
+                .dstSubpass = colorSubpass,
+                .srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
+            },
+            {
+                // The depth pyramid is built from the depth of the first render pass
+                .srcSubpass = colorSubpass,
+                .dstSubpass = VK_SUBPASS_EXTERNAL,
+                .srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                .dependencyFlags = 0
+            }
+        };
+
+        std::array<VkAttachmentDescription, 2> attachments = { colorAttachmentDescription, depthAttachmentDescription };
+        VkRenderPassCreateInfo renderPassCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .attachmentCount = static_cast<uint32_t>(attachments.size()),
+            .pAttachments = attachments.data(),
+            .subpassCount = IM_ARRAYSIZE(subpassDescriptions),
+            .pSubpasses = subpassDescriptions,
+            .dependencyCount = IM_ARRAYSIZE(subpassDependencies),
+            .pDependencies = subpassDependencies
+        };
+
+        result = vkCreateRenderPass(device, &renderPassCreateInfo, pAllocator, &renderPass);
+        evaluteVulkanResult(result);
+
+        // Second render pass of the frame, it keeps the color and depth of the first one and presents the image
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        // Waits for the first render pass and for the depth pyramid, which still reads the depth image
+        VkSubpassDependency subpassDependenciesLoad[] =
+        {
+            {
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = depthPrepassSubpass,
+                .srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dependencyFlags = 0
+            },
+            {
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = colorSubpass,
+                .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dependencyFlags = 0
+            },
+            subpassDependencies[2]
+        };
+
+        renderPassCreateInfo.dependencyCount = IM_ARRAYSIZE(subpassDependenciesLoad);
+        renderPassCreateInfo.pDependencies = subpassDependenciesLoad;
+
+        result = vkCreateRenderPass(device, &renderPassCreateInfo, pAllocator, &renderPassLoad);
+        evaluteVulkanResult(result);
+    }
+
+    void createShaderModule(const std::vector<char>& shaderCode, VkShaderModule* shaderModule)
+    {
+        VkShaderModuleCreateInfo shaderModuleCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .codeSize = shaderCode.size(),
+            .pCode = reinterpret_cast<const uint32_t*>(shaderCode.data())
+        };
+
+        VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, pAllocator, shaderModule);
+        evaluteVulkanResult(result);
+    }
+
+    void createStorageBuffers()
+    {
+        uint64_t bufferSize = sizeof(GameObjectData) * maxGameObjectCount;
+        uint64_t transformBufferSize = sizeof(ObjectTransform) * maxGameObjectCount;
+
+        for (FrameData& frameData : frames)
+        {
+            createBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.objectBuffer);
+
+            // Stays mapped, the objects are written straight into it every frame
+            void* data;
+            vkMapMemory(device, frameData.objectBuffer.bufferMemory, 0, bufferSize, 0, &data);
+            frameData.mappedObjects = static_cast<GameObjectData*>(data);
+
+            // Also stays mapped, but only the changed slots are written
+            createBuffer(transformBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.transformBuffer);
+
+            vkMapMemory(device, frameData.transformBuffer.bufferMemory, 0, transformBufferSize, 0, &data);
+            frameData.mappedTransforms = static_cast<ObjectTransform*>(data);
+        }
+    }
+
+    void createSwapchain(VkPhysicalDevice physicalDevice)
+    {
+        VkResult result;
+        SurfaceDetails surfaceDetails = querySurfaceCapabilities(physicalDevice);
+
+        surfaceFormat = chooseSurfaceFormat(surfaceDetails.formats);
+        VkPresentModeKHR presentMode = choosePresentMode(surfaceDetails.presentModes);
+        g_windowSize = chooseExtent2D(surfaceDetails.capabilities);
+
+        uint32_t imageCount = surfaceDetails.capabilities.minImageCount + 1;
+
+        if (surfaceDetails.capabilities.maxImageCount > 0 && imageCount > surfaceDetails.capabilities.maxImageCount)
+        {
+            imageCount = surfaceDetails.capabilities.maxImageCount;
+        }
+
+        //TODO: Parameter überprüfen
+        VkSwapchainCreateInfoKHR swapchainCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .flags = 0,
+            .surface = surface,
+            .minImageCount = imageCount,
+            .imageFormat = surfaceFormat.format,
+            .imageColorSpace = surfaceFormat.colorSpace,
+            .imageExtent = g_windowSize,
+            .imageArrayLayers = 1,
+            .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .preTransform = surfaceDetails.capabilities.currentTransform, //VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR
+            .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+            .presentMode = presentMode,
+            .clipped = VK_TRUE,
+            .oldSwapchain = VK_NULL_HANDLE
+        };
+
+        result = vkCreateSwapchainKHR(device, &swapchainCreateInfo, pAllocator, &swapchain);
+        evaluteVulkanResult(result);
+    }
+
+    void createTextureImage(VkCommandBuffer commandBuffer, const TextureUpload& textureUpload, Texture& texture)
+    {
+        uint32_t mipLevels = static_cast<uint32_t>(textureUpload.regions.size());
+
+        VkImageCreateInfo imageCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = textureUpload.format,
+            .extent = { textureUpload.width, textureUpload.height, 1},
+            .mipLevels = mipLevels,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        createImage(imageCreateInfo, texture.image, texture.imageMemory);
+
+        // Only recorded, the staging buffer has to live until commandBuffer has finished
+        recordImageLayoutTransition(commandBuffer, texture.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+        vkCmdCopyBufferToImage(commandBuffer, textureUpload.stagingBuffer.buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(textureUpload.regions.size()), textureUpload.regions.data());
+        recordImageLayoutTransition(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+
+        texture.imageView = createImageView(texture.image, textureUpload.format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+    }
+
+    void createTextureSampler()
+    {
+        VkResult result;
+
+        VkPhysicalDeviceProperties physicalDeviceProperties{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+        VkSamplerCreateInfo samplerCreateInfo =
+        {
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .magFilter = VK_FILTER_LINEAR,
+            .minFilter = VK_FILTER_LINEAR,
+            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .mipLodBias = 0.f,
+            .anisotropyEnable = VK_TRUE,
+            .maxAnisotropy = physicalDeviceProperties.limits.maxSamplerAnisotropy,
+            .compareEnable = VK_FALSE,
+            .compareOp = VK_COMPARE_OP_ALWAYS,
+            .minLod = 0.f,
+            .maxLod = VK_LOD_CLAMP_NONE,
+            .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+            .unnormalizedCoordinates = VK_FALSE
+        };
+
+        result = vkCreateSampler(device, &samplerCreateInfo, pAllocator, &textureSampler);
+        evaluteVulkanResult(result);
+
+        // The depth pyramid is only read with texelFetch
+        VkSamplerCreateInfo depthPyramidSamplerCreateInfo = samplerCreateInfo;
+        depthPyramidSamplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        depthPyramidSamplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        depthPyramidSamplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        depthPyramidSamplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        depthPyramidSamplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        depthPyramidSamplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        depthPyramidSamplerCreateInfo.anisotropyEnable = VK_FALSE;
+
+        result = vkCreateSampler(device, &depthPyramidSamplerCreateInfo, pAllocator, &depthPyramidSampler);
+        evaluteVulkanResult(result);
+    }
+
+    UniformBufferObject createUniformBufferObject(const UBOValues& uboValues, const glm::vec3& eye, float aspectRatio)
+    {
+        UniformBufferObject ubo =
+        {
+            .model = glm::translate(glm::mat4(1.0f), uboValues.axis),
+            .view = glm::lookAt(eye, uboValues.center + eye, uboValues.up),
+            .proj = glm::perspective(glm::radians(uboValues.fovy), aspectRatio, uboValues.near, uboValues.far)
+        };
+
+        ubo.proj[1][1] *= -1;
+
+        return ubo;
+    }
+
+    void createUniformBuffers()
+    {
+        uint64_t bufferSize = sizeof(UniformBufferObject);
+
+        for (uint64_t i = 0; i < imageCount; i++) {
+            createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frames[i].uniformBuffer);
+        }
+    }
+
+    void cullLights(FrameData& frame)
+    {
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        // The first value is the counter of the used light indices
+        vkCmdFillBuffer(commandBuffer, frame.lightIndexBuffer.buffer, 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier fillBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, lightCullingPipeline);
+
+        FrameDescriptors frameDescriptors = getFrameDescriptors(frame);
+        bindComputeDescriptors(frame, lightCullingDescriptorTemplate, lightCullingPipelineLayout, descriptorSetLayoutLightCulling, &frameDescriptors);
+
+        // One work group per depth slice, one invocation per tile
+        vkCmdDispatch(commandBuffer, 1, 1, clusterCountZ);
+
+        VkMemoryBarrier cullingBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &cullingBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    void cullObjects(FrameData& frame, uint32_t phase)
+    {
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        if (phase == 0)
+        {
+            // Both phases start from the commands of the CPU, which have no instances yet
+            VkBufferCopy copyRegion =
+            {
+                .srcOffset = 0,
+                .dstOffset = 0,
+                .size = sizeof(VkDrawIndexedIndirectCommand) * 2 * frame.drawCount
+            };
+
+            vkCmdCopyBuffer(commandBuffer, frame.indirectBuffer.buffer, frame.drawCommandBuffer.buffer, 1, &copyRegion);
+
+            // Also orders the visibility bits after the occlusion culling of the last frame
+            VkMemoryBarrier copyBarrier =
+            {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+            };
+
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &copyBarrier, 0, nullptr, 0, nullptr);
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionCullingPipeline);
+
+        // The pyramid is only read in phase 1, it is valid in phase 0 as well because it never leaves the general layout
+        CullingDescriptors cullingDescriptors =
+        {
+            .uniformBuffer = { frame.uniformBuffer.buffer, 0, sizeof(UniformBufferObject) },
+            .objectBuffer = { frame.objectBuffer.buffer, 0, sizeof(GameObjectData) * maxGameObjectCount },
+            .meshBuffer = { meshBuffer.buffer, 0, sizeof(MeshData) * (maxMeshCount + maxStreamedMeshCount) },
+            .drawCommandBuffer = { frame.drawCommandBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .visibleInstanceBuffer = { frame.visibleInstanceBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .visibilityBuffer = { visibilityBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .depthPyramid = { depthPyramidSampler, depthPyramidImageView, VK_IMAGE_LAYOUT_GENERAL },
+            .transformBuffer = { frame.transformBuffer.buffer, 0, sizeof(ObjectTransform) * maxGameObjectCount }
+        };
+
+        bindComputeDescriptors(frame, occlusionCullingDescriptorTemplate, occlusionCullingPipelineLayout, descriptorSetLayoutOcclusionCulling, &cullingDescriptors);
+
+        CullingParameters parameters =
+        {
+            .objectCount = frame.objectCount,
+            .drawCount = frame.drawCount,
+            .phase = phase,
+            .occlusionCulling = currentFramePacket->occlusionCulling ? 1u : 0u
+        };
+
+        vkCmdPushConstants(commandBuffer, occlusionCullingPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(parameters), &parameters);
+
+        // One invocation per object, the work groups have 64
+        vkCmdDispatch(commandBuffer, (frame.objectCount + 63) / 64, 1, 1);
+
+        VkMemoryBarrier cullingBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &cullingBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    void drawObjects(FrameData& frame, uint32_t firstDraw, bool depthOnly)
+    {
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        // The variants of the instanced draws read their objects from the object buffer, the push constants only have to be defined
+        if (!drawBatches.empty())
+        {
+            DrawPushConstants pushConstants = {};
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
+        }
+
+        // Bound state survives the end of a render pass, so the second phase usually binds nothing
+        for (const DrawBatch& batch : drawBatches)
+        {
+            VkPipeline graphicsPipeline = selectGraphicsPipeline(batch.pipeline, depthOnly, false);
+
+            if (graphicsPipeline == VK_NULL_HANDLE)
+                continue;
+
+            bindGraphicsPipeline(frame, graphicsPipeline);
+
+            // The vertices are pulled from the geometry buffer in shader.vert, only its indices go through the fixed function input
+            bindIndexBuffer(frame, geometryBuffer.buffer);
+            bindFrameDescriptors(frame);
+
+            // The instance counts were written by the occlusion culling
+            VkDeviceSize offset = sizeof(VkDrawIndexedIndirectCommand) * (firstDraw + batch.firstDraw);
+
+            if (multiDrawIndirectSupported)
+            {
+                vkCmdDrawIndexedIndirect(commandBuffer, frame.drawCommandBuffer.buffer, offset, batch.drawCount, sizeof(VkDrawIndexedIndirectCommand));
+            }
+            else
+            {
+                for (uint32_t i = 0; i < batch.drawCount; i++)
+                    vkCmdDrawIndexedIndirect(commandBuffer, frame.drawCommandBuffer.buffer, offset + sizeof(VkDrawIndexedIndirectCommand) * i, 1, sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
+
+        // The dynamic objects are not culled, so they are only drawn in phase 0
+        if (firstDraw > 0 || directDraws.empty())
+            return;
+
+        uint32_t pipelineKey = currentFramePacket->polygonMode == VK_POLYGON_MODE_FILL ? fillPipelineKey : wireframePipelineKey;
+        VkPipeline graphicsPipeline = selectGraphicsPipeline(pipelineKey, depthOnly, true);
+
+        if (graphicsPipeline == VK_NULL_HANDLE)
+            return;
+
+        bindGraphicsPipeline(frame, graphicsPipeline);
+        bindIndexBuffer(frame, geometryBuffer.buffer);
+        bindFrameDescriptors(frame);
+
+        for (const DirectDraw& directDraw : directDraws)
+        {
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants), &directDraw.pushConstants);
+            vkCmdDrawIndexed(commandBuffer, directDraw.indexCount, 1, directDraw.firstIndex, directDraw.vertexOffset, 0);
+        }
+    }
+
+    void drawParticles(FrameData& frame)
+    {
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        bindGraphicsPipeline(frame, particlePipeline);
+
+        VkViewport viewport =
+        {
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = static_cast<float>(g_windowSize.width),
+            .height = static_cast<float>(g_windowSize.height),
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f
+        };
+
+        VkRect2D scissor =
+        {
+            .offset = { 0, 0 },
+            .extent = g_windowSize
+        };
+
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        // Takes the place of set 0, objects drawn after the particles would have to bind their descriptors again
+        ParticleDescriptors particleDescriptors = getParticleDescriptors(frame);
+
+        if (pushDescriptorsSupported)
+        {
+            cmdPushDescriptorSetWithTemplate(commandBuffer, particleDrawDescriptorTemplate, particlePipelineLayout, 0, &particleDescriptors);
+        }
+        else
+        {
+            VkDescriptorSet descriptorSet = frame.descriptorAllocator.allocate(descriptorSetLayoutParticles);
+            vkUpdateDescriptorSetWithTemplate(device, descriptorSet, particleDrawDescriptorTemplate, &particleDescriptors);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particlePipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        }
+
+        frame.boundGraphicsState.frameDescriptors = false;
+        frame.boundGraphicsState.bindCount++;
+
+        ParticleParameters parameters =
+        {
+            .maxParticleCount = maxParticleCount,
+            .aliveList = particleAliveList,
+            .size = currentFramePacket->particleEmitter.size
+        };
+
+        vkCmdPushConstants(commandBuffer, particlePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(parameters), &parameters);
+
+        // The instance count is the number of alive particles, written by particleArguments.comp
+        vkCmdDrawIndirect(commandBuffer, particleCounterBuffer.buffer, offsetof(ParticleCounters, draw), 1, sizeof(VkDrawIndirectCommand));
+    }
+
+    // Loaded meshes below maxMeshCount, the streaming slots above. nullptr for meshes that are still loading and empty slots.
+    const Mesh* findMesh(uint32_t meshIndex)
+    {
+        if (meshIndex < meshes.size())
+            return meshes[meshIndex].lods.empty() ? nullptr : &meshes[meshIndex];
+
+        if (meshIndex < maxMeshCount || meshIndex - maxMeshCount >= streamedMeshes.size())
+            return nullptr;
+
+        const Mesh& mesh = streamedMeshes[meshIndex - maxMeshCount];
+
+        return mesh.lods.empty() ? nullptr : &mesh;
+    }
+
+    FrameDescriptors getFrameDescriptors(const FrameData& frame)
+    {
+        return
+        {
+            .uniformBuffer =
+            {
+                .buffer = frame.uniformBuffer.buffer,
+                .offset = 0,
+                .range = sizeof(UniformBufferObject)
+            },
+            .objectBuffer =
+            {
+                .buffer = frame.objectBuffer.buffer,
+                .offset = 0,
+                .range = sizeof(GameObjectData) * maxGameObjectCount
+            },
+            .lightBuffer =
+            {
+                .buffer = frame.lightBuffer.buffer,
+                .offset = 0,
+                .range = sizeof(LightData) * maxLightCount
+            },
+            .clusterBuffer =
+            {
+                .buffer = frame.clusterBuffer.buffer,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE
+            },
+            .lightIndexBuffer =
+            {
+                .buffer = frame.lightIndexBuffer.buffer,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE
+            },
+            .visibleInstanceBuffer =
+            {
+                .buffer = frame.visibleInstanceBuffer.buffer,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE
+            },
+            .transformBuffer =
+            {
+                .buffer = frame.transformBuffer.buffer,
+                .offset = 0,
+                .range = sizeof(ObjectTransform) * maxGameObjectCount
+            }
+        };
+    }
+
+    ParticleDescriptors getParticleDescriptors(const FrameData& frame)
+    {
+        return
+        {
+            .uniformBuffer = { frame.uniformBuffer.buffer, 0, sizeof(UniformBufferObject) },
+            .positionBuffer = { particlePositionBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .velocityBuffer = { particleVelocityBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .colorBuffer = { particleColorBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .deadListBuffer = { particleDeadListBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .aliveListBuffer = { particleAliveListBuffer.buffer, 0, VK_WHOLE_SIZE },
+            .counterBuffer = { particleCounterBuffer.buffer, 0, VK_WHOLE_SIZE }
+        };
+    }
+
+    int initializeImGui()
+    {
+        VkResult result;
+
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO(); (void)io;
+        io.IniFilename = nullptr;
+
+        // The font data stays owned by fontFile, it was read while the device got created
+        ImFontConfig fontConfig;
+        fontConfig.FontDataOwnedByAtlas = false;
+
+        try
+        {
+            const std::vector<char>& fontData = fontFile.get();
+            io.Fonts->AddFontFromMemoryTTF(const_cast<char*>(fontData.data()), static_cast<int>(fontData.size()), 16 * Backend::GetMonitorScale(), &fontConfig);
+        }
+        catch (std::exception& ex)
+        {
+            std::cout << ex.what() << std::endl;
+            io.Fonts->AddFontDefault();
+        }
+
+        ImGui::StyleColorsDark();
+
+        IM_ASSERT(io.BackendPlatformUserData == NULL && "Already initialized a platform backend!");
+
+        ImGui_ImplGlfw_InitForVulkan(Backend::g_window, true);
+        ImGui_ImplVulkan_InitInfo init_info = {};
+        init_info.Instance = instance;
+        init_info.PhysicalDevice = physicalDevice;
+        init_info.Device = device;
+        init_info.QueueFamily = queueFamily.index.value();
+        init_info.Queue = queue;
+        init_info.PipelineCache = nullptr;
+        init_info.DescriptorPool = descriptorPoolImGui;
+        init_info.Subpass = colorSubpass;
+        init_info.MinImageCount = imageCount;
+        init_info.ImageCount = imageCount;
+        init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+        init_info.Allocator = pAllocator;
+        init_info.CheckVkResultFn = evaluteVulkanResult;
+        ImGui_ImplVulkan_Init(&init_info, renderPass);
+
+        //Upload Fonts
+        {
+            // Use any command queue
+            VkCommandPool command_pool = frames[0].commandPool;
+            VkCommandBuffer command_buffer = frames[0].mainCommandBuffer;
+
+            result = vkResetCommandPool(device, command_pool, 0);
+            evaluteVulkanResult(result);
+            VkCommandBufferBeginInfo begin_info = {};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            result = vkBeginCommandBuffer(command_buffer, &begin_info);
+            evaluteVulkanResult(result);
+
+            ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
+
+            VkSubmitInfo end_info = {};
+            end_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            end_info.commandBufferCount = 1;
+            end_info.pCommandBuffers = &command_buffer;
+            result = vkEndCommandBuffer(command_buffer);
+            evaluteVulkanResult(result);
+            result = vkQueueSubmit(queue, 1, &end_info, VK_NULL_HANDLE);
+            evaluteVulkanResult(result);
+
+            result = vkDeviceWaitIdle(device);
+            evaluteVulkanResult(result);
+            ImGui_ImplVulkan_DestroyFontUploadObjects();
+        }
+
+        return 0;
+    }
+
+    int initializeVulkan()
+    {
+        VkResult result;
+
+        if (createInstance() != 0)
+            return -1;
+
+        result = glfwCreateWindowSurface(instance, Backend::g_window, pAllocator, &surface);
+        evaluteVulkanResult(result);
+
+        physicalDevice = pickPhysicalDevice();
+
+        createLogicalDevice(physicalDevice);
+
+        VkBool32 surfaceSupport = false;
+        result = vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamily.index.value(), surface, &surfaceSupport);
+        evaluteVulkanResult(result);
+
+        if (!surfaceSupport)
+        {
+            std::cout << "Surface not Supported";
+            evaluteVulkanResult(VK_ERROR_INITIALIZATION_FAILED);
+            return -1;
+        }
+
+        createSwapchain(physicalDevice);
+        createImageViews();
+        createRenderPass();
+        
+        createDescriptorSetLayout();
+        createPipelineLayout();
+        createDescriptorUpdateTemplates();
+        createGraphicsPipeline();
+        createComputePipelines();
+        createParticlePipeline();
+
+        // The depth pyramid gets its layout through a command buffer of the frames
+        createFrameData();
+        createDepthResources();
+        createFramebuffers();
+
+        createPlaceholderTexture();
+        createTextureSampler();
+
+        createUniformBuffers();
+        createStorageBuffers();
+        createIndirectBuffers();
+        createCullingBuffers();
+        createLightBuffers();
+        createMaterialBuffer();
+        createMeshBuffer();
+        createGeometryBuffer();
+        createParticleBuffers();
+
+        createDescriptorPool();
+        createDescriptorSets();
+
+        return 0;
+    }
+
+    Assets::Task loadMesh(std::string filename)
+    {
+        MeshFile meshFile;
+        MeshUpload meshUpload;
+
+        // Checking the indices and the prefetch read the file, the copies on the worker then only hit the page cache
+        co_await Assets::ResumeOnReadThread();
+
+        openMeshFile(filename, meshFile);
+        Assets::PrefetchFile(meshFile.mappedFile);
+
+        co_await Assets::ResumeOnWorker();
+
+        prepareMeshUpload(filename, meshFile, meshUpload);
+
+        co_await Assets::ResumeOnMainThread();
+
+        // Copied by the command buffer of the next frame, drawn once its fence has signalled
+        queuedMeshUploads.push_back(std::move(meshUpload));
+    }
+
+    uint32_t loadTexture(const std::string& filename)
+    {
+        if (textures.size() >= maxTextureCount)
+            throw std::runtime_error("Es koennen maximal " + std::to_string(maxTextureCount) + " Texturen geladen werden!");
+
+        // The slot shows the placeholder until uploadTexture has finished
+        uint32_t textureIndex = static_cast<uint32_t>(textures.size());
+        textures.push_back({});
+        updateTextureDescriptor(textureIndex);
+
+        uploadTexture(filename, textureIndex);
+
+        return textureIndex;
+    }
+
+    uint32_t pickMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+    {
+        VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceMemoryProperties);
+
+        for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeFilter & (1 << i)) && (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    VkPhysicalDevice pickPhysicalDevice()
+    {
+        uint32_t amountOfPhysicalDevices = 0;
+        VkResult result = vkEnumeratePhysicalDevices(instance, &amountOfPhysicalDevices, nullptr);
+        evaluteVulkanResult(result);
+
+        std::vector<VkPhysicalDevice> physicalDevices(amountOfPhysicalDevices);
+        result = vkEnumeratePhysicalDevices(instance, &amountOfPhysicalDevices, physicalDevices.data());
+        evaluteVulkanResult(result);
+
+        for (uint32_t i = 0; i < amountOfPhysicalDevices; i++)
+        {
+            VkPhysicalDeviceProperties physicalDeviceProperties;
+            vkGetPhysicalDeviceProperties(physicalDevices[i], &physicalDeviceProperties);
+
+            if (physicalDeviceProperties.deviceType & VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+            {
+                return physicalDevices[i];
+            }
+        }
+
+        return physicalDevices[0];
+    }
+
+    QueueFamily pickQueueFamily(VkPhysicalDevice physicalDevice)
+    {
+        QueueFamily queueFamily;
+
+        uint32_t amountOfQueueFamilyProperties = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &amountOfQueueFamilyProperties, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilyProperties(amountOfQueueFamilyProperties);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &amountOfQueueFamilyProperties, queueFamilyProperties.data());
+
+        for (uint32_t i = 0; i < amountOfQueueFamilyProperties; i++)
+        {
+            if (queueFamilyProperties[i].queueFlags == (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT))
+            {
+                queueFamily.index = i;
+                queueFamily.queueCount = 1;
+
+                break;
+            }
+        }
 
-        return imageView;
+        if (!queueFamily.index.has_value())
+            throw std::logic_error("No fitting QueueFamily was found."); //TODO: Inconsisten throw
+
+        return queueFamily;
     }
 
-    void createImageViews()
+    VkFormat pickTextureFormat(VkFormat fileFormat)
     {
-        VkResult result;
+        VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
 
-        result = vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
-        evaluteVulkanResult(result);
-        std::vector<VkImage> swapchainImages(imageCount);
-        result = vkGetSwapchainImagesKHR(device, swapchain, &imageCount, swapchainImages.data());
-        evaluteVulkanResult(result);
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, fileFormat, &formatProperties);
 
-        imageViews.resize(imageCount);
+        if ((formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures)
+            return fileFormat;
 
-        for (uint32_t i = 0; i < imageCount; i++)
-        {
-            imageViews[i] = createImageView(swapchainImages[i], surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT);
-        }
+        // No BC support on this device, transcode on the CPU
+        return getDecompressedFormat(fileFormat);
     }
 
-    void createIndexBuffer()
+    void prepareMeshUpload(const std::string& filename, MeshFile& meshFile, MeshUpload& meshUpload)
     {
-        uint64_t bufferSize = sizeof(indices[0]) * indices.size();
-
-        AllocatedBuffer stagingBuffer;
+        const MeshFileHeader& header = *meshFile.header;
 
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+        bool quantized = header.vertexFormat == MESH_VERTEX_FORMAT_QUANTIZED && header.streamCount == 1 && meshFile.streams[0].stride == sizeof(Vertex);
+        bool unquantized = header.vertexFormat == MESH_VERTEX_FORMAT_FLOAT && header.streamCount == 1 && meshFile.streams[0].stride == sizeof(MeshVertex);
 
-        void* data;
-        vkMapMemory(device, stagingBuffer.bufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, indices.data(), bufferSize);
-        vkUnmapMemory(device, stagingBuffer.bufferMemory);
+        if (!quantized && !unquantized)
+        {
+            closeMeshFile(meshFile);
+            throw std::runtime_error("Das Vertex Format von \"" + filename + "\" wird nicht unterstuetzt!");
+        }
 
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer);
+        meshUpload.vertexSize = static_cast<uint64_t>(header.vertexCount) * sizeof(Vertex);
+        meshUpload.indexSize = static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t);
+        meshUpload.positionSize = static_cast<uint64_t>(header.vertexCount) * sizeof(uint64_t);
+        meshUpload.indexCount = header.indexCount;
+        meshUpload.quantization = getVertexQuantization(header.boundsMin, header.boundsMax);
 
-        copyBuffer(bufferSize, stagingBuffer.buffer, indexBuffer.buffer);
+        for (uint32_t i = 0; i < header.lodCount; i++)
+            meshUpload.lods.push_back({ meshFile.lods[i].firstIndex, meshFile.lods[i].indexCount, meshFile.lods[i].error });
 
-        vkDestroyBuffer(device, stagingBuffer.buffer, pAllocator);
-        vkFreeMemory(device, stagingBuffer.bufferMemory, pAllocator);
-    }
+        uint64_t stagingSize = meshUpload.vertexSize + meshUpload.indexSize + meshUpload.positionSize;
+        createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, meshUpload.stagingBuffer);
 
-    int createInstance()
-    {
-        VkResult result;
+        // Straight from the page cache into the staging memory, the file is never copied into an intermediate buffer
+        void* data;
+        vkMapMemory(device, meshUpload.stagingBuffer.bufferMemory, 0, stagingSize, 0, &data);
 
-        VkApplicationInfo applicationInfo =
+        if (quantized)
         {
-            .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
-            .pNext = nullptr,
-            .pApplicationName = "VulkanPrototype",
-            .applicationVersion = VULKANPROTOTYPE_VERSION,
-            .pEngineName = nullptr,
-            .engineVersion = 0,
-            .apiVersion = VK_API_VERSION_1_3
-        };
-
-        uint32_t amountOfGlfwExtensions = 0;
-        const char** requiredGlfwExtensions = glfwGetRequiredInstanceExtensions(&amountOfGlfwExtensions);
-        std::vector<const char*> instanceExtensions(requiredGlfwExtensions, requiredGlfwExtensions + amountOfGlfwExtensions);
-
-        if (!checkInstanceExtensionSupport(instanceExtensions))
+            memcpy(data, meshFile.mappedFile.data + meshFile.streams[0].offset, meshUpload.vertexSize);
+        }
+        else
         {
-            std::cout << "Extension not Supported!\n";
-            return -1;
+            // Older float meshes are quantized while they are copied, re-importing them skips this step
+            const MeshVertex* source = reinterpret_cast<const MeshVertex*>(meshFile.mappedFile.data + meshFile.streams[0].offset);
+            Vertex* destination = static_cast<Vertex*>(data);
+
+            for (uint32_t i = 0; i < header.vertexCount; i++)
+                destination[i] = quantizeVertex(meshUpload.quantization, source[i].position, source[i].color, source[i].textureCoordinate);
         }
 
-#ifdef DEBUG
+        // All meshes share one index buffer binding, so 16 bit indices are widened while they are copied
+        uint32_t* indices = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(data) + meshUpload.vertexSize);
 
-        std::vector<const char*> instanceLayers = { "VK_LAYER_KHRONOS_validation" };
+        if (header.indexSize == 2)
+        {
+            const uint16_t* source = reinterpret_cast<const uint16_t*>(meshFile.mappedFile.data + header.indexOffset);
 
-        if (!checkInstanceLayerSupport(instanceLayers))
+            for (uint32_t i = 0; i < header.indexCount; i++)
+                indices[i] = source[i];
+        }
+        else
         {
-            std::cout << "Validation Layer not Supported!\n";
-            return -1;
+            memcpy(indices, meshFile.mappedFile.data + header.indexOffset, meshUpload.indexSize);
         }
 
-        instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        // The snorm16x4 position is the first attribute of every vertex, the depth prepass reads only these 8 bytes
+        const uint8_t* vertices = static_cast<const uint8_t*>(data);
+        uint8_t* positions = static_cast<uint8_t*>(data) + meshUpload.vertexSize + meshUpload.indexSize;
 
-        if (!checkInstanceExtensionSupport(instanceExtensions))
-        {
-            std::cout << "Extension not Supported!\n";
-            return -1;
-        }
+        for (uint32_t i = 0; i < header.vertexCount; i++)
+            memcpy(positions + sizeof(uint64_t) * i, vertices + sizeof(Vertex) * i, sizeof(uint64_t));
 
-        VkInstanceCreateInfo instanceCreateInfo =
-        {
-            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .pApplicationInfo = &applicationInfo,
-            .enabledLayerCount = static_cast<uint32_t>(instanceLayers.size()),
-            .ppEnabledLayerNames = instanceLayers.data(),
-            .enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size()),
-            .ppEnabledExtensionNames = instanceExtensions.data()
-        };
+        vkUnmapMemory(device, meshUpload.stagingBuffer.bufferMemory);
 
-        result = vkCreateInstance(&instanceCreateInfo, nullptr, &instance);
-        evaluteVulkanResult(result);
+        closeMeshFile(meshFile);
+    }
 
-        VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo =
+    void prepareTextureUpload(TextureFile& textureFile, Assets::MappedFile& encodedFile, TextureUpload& textureUpload)
+    {
+        // Blocks the GPU can sample were read straight into the staging buffer by readTextureUpload, only the rest is decoded here
+        if (textureUpload.format == VK_FORMAT_UNDEFINED)
         {
-            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
-            .pNext = nullptr,
-            .flags = 0,
-            .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
-            .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
-            .pfnUserCallback = debugCallback,
-            .pUserData = nullptr
-        };
+            int textureWidth, textureHeight, textureChannels;
+            stbi_uc* pixels = stbi_load_from_memory(encodedFile.data, static_cast<int>(encodedFile.size), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
 
-        auto vkCreateDebugUtilsMessengerEXT = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+            Assets::UnmapFile(encodedFile);
 
-        if (vkCreateDebugUtilsMessengerEXT == nullptr)
-            return -1;
+            if (!pixels) //TODO: Uncaracteristic Throw
+            {
+                throw std::runtime_error("failed to load texture image!");
+            }
 
-        result = vkCreateDebugUtilsMessengerEXT(instance, &debugMessengerCreateInfo, nullptr, &debugMessenger);
-        evaluteVulkanResult(result);
+            VkDeviceSize imageSize = textureWidth * textureHeight * 4;
 
-#else
+            createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, textureUpload.stagingBuffer);
 
-        VkInstanceCreateInfo instanceCreateInfo =
+            void* data;
+            vkMapMemory(device, textureUpload.stagingBuffer.bufferMemory, 0, imageSize, 0, &data);
+            memcpy(data, pixels, static_cast<size_t>(imageSize));
+            vkUnmapMemory(device, textureUpload.stagingBuffer.bufferMemory);
+
+            stbi_image_free(pixels);
+
+            textureFile.levels = { { .fileOffset = 0, .size = imageSize, .width = static_cast<uint32_t>(textureWidth), .height = static_cast<uint32_t>(textureHeight) } };
+
+            textureUpload.format = VK_FORMAT_R8G8B8A8_SRGB;
+            textureUpload.width = static_cast<uint32_t>(textureWidth);
+            textureUpload.height = static_cast<uint32_t>(textureHeight);
+        }
+        else if (encodedFile.data != nullptr)
         {
-            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .pApplicationInfo = &applicationInfo,
-            .enabledLayerCount = 0,
-            .ppEnabledLayerNames = nullptr,
-            .enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size()),
-            .ppEnabledExtensionNames = instanceExtensions.data()
-        };
+            // Blocks the GPU can not sample are decompressed from the mapping, readTextureUpload already read its pages
+            VkDeviceSize imageSize = getTextureSize(textureFile, textureUpload.format);
 
-        result = vkCreateInstance(&instanceCreateInfo, nullptr, &instance);
-        evaluteVulkanResult(result);
+            createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, textureUpload.stagingBuffer);
 
-#endif
+            void* data;
+            vkMapMemory(device, textureUpload.stagingBuffer.bufferMemory, 0, imageSize, 0, &data);
 
-        return 0;
-    }
+            uint8_t* destination = static_cast<uint8_t*>(data);
 
-    void createLogicalDevice(VkPhysicalDevice physicalDevice)
-    {
-        VkResult result;
+            for (const TextureLevel& level : textureFile.levels)
+            {
+                decompressBlocks(textureFile.format, encodedFile.data + level.fileOffset, level.width, level.height, destination);
+                destination += getTextureLevelSize(textureUpload.format, level.width, level.height);
+            }
 
-        queueFamily = pickQueueFamily(physicalDevice);
+            vkUnmapMemory(device, textureUpload.stagingBuffer.bufferMemory);
 
-        std::vector<float> queuePriorities(queueFamily.queueCount);
-        for (uint32_t i = 0; i < queueFamily.queueCount; i++)
-            queuePriorities[i] = 1.0f;
+            Assets::UnmapFile(encodedFile);
+        }
 
-        VkDeviceQueueCreateInfo deviceQueueCreateInfo =
+        VkDeviceSize bufferOffset = 0;
+
+        for (uint32_t i = 0; i < textureFile.levels.size(); i++)
         {
-            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .queueFamilyIndex = queueFamily.index.value(),
-            .queueCount = queueFamily.queueCount,
-            .pQueuePriorities = queuePriorities.data()
-        };
+            const TextureLevel& level = textureFile.levels[i];
 
-        //TODO: Add a check if the features are available.
-        VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
-        physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
-        physicalDeviceFeatures.fillModeNonSolid = VK_TRUE;
+            textureUpload.regions.push_back(
+            {
+                .bufferOffset = bufferOffset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = i,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .imageOffset = {0, 0, 0},
+                .imageExtent = { level.width, level.height, 1}
+            });
 
-        //TODO: Add a check if the Extensions are available.
-        const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+            bufferOffset += getTextureLevelSize(textureUpload.format, level.width, level.height);
+        }
+    }
 
-        VkPhysicalDeviceShaderDrawParametersFeatures shaderDrawParametersFeatures =
+    void publishAssetUploads(FrameData& frame)
+    {
+        for (MeshUpload& meshUpload : frame.meshUploads)
         {
-            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES,
-            .pNext = nullptr,
-            .shaderDrawParameters = VK_TRUE
-        };
+            meshes[meshUpload.meshIndex] = std::move(meshUpload.mesh);
 
-        VkDeviceCreateInfo deviceCreateInfo =
+            vkDestroyBuffer(device, meshUpload.stagingBuffer.buffer, pAllocator);
+            vkFreeMemory(device, meshUpload.stagingBuffer.bufferMemory, pAllocator);
+        }
+
+        // The bindless set is updated after bind, frames in flight keep sampling the placeholder or see the finished image
+        for (TextureUpload& textureUpload : frame.textureUploads)
         {
-            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-            .pNext = &shaderDrawParametersFeatures,
-            .flags = 0,
-            .queueCreateInfoCount = 1,
-            .pQueueCreateInfos = &deviceQueueCreateInfo,
-            .enabledLayerCount = 0,
-            .ppEnabledLayerNames = nullptr,
-            .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
-            .ppEnabledExtensionNames = deviceExtensions.data(),
-            .pEnabledFeatures = &physicalDeviceFeatures
-        };
+            textures[textureUpload.textureIndex] = textureUpload.texture;
+            updateTextureDescriptor(textureUpload.textureIndex);
 
-        result = vkCreateDevice(physicalDevice, &deviceCreateInfo, pAllocator, &device);
-        evaluteVulkanResult(result);
+            vkDestroyBuffer(device, textureUpload.stagingBuffer.buffer, pAllocator);
+            vkFreeMemory(device, textureUpload.stagingBuffer.bufferMemory, pAllocator);
+        }
 
-        vkGetDeviceQueue(device, queueFamily.index.value(), 0, &queue);
+        frame.meshUploads.clear();
+        frame.textureUploads.clear();
     }
 
-    void createRenderPass()
+    SurfaceDetails querySurfaceCapabilities(VkPhysicalDevice physicalDevice)
     {
-        VkResult result;
+        SurfaceDetails surfaceDetails;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceDetails.capabilities);
 
-        VkAttachmentDescription colorAttachmentDescription =
-        {
-            .flags = 0,
-            .format = surfaceFormat.format,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-        };
+        uint32_t amountOfSurfaceFormats = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &amountOfSurfaceFormats, nullptr);
+        surfaceDetails.formats.resize(amountOfSurfaceFormats);
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &amountOfSurfaceFormats, surfaceDetails.formats.data());
 
-        VkAttachmentReference colorAttachmentReference =
-        {
-            .attachment = 0,
-            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        };
+        uint32_t amountOFPresentModes = 0;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &amountOFPresentModes, nullptr);
+        surfaceDetails.presentModes.resize(amountOFPresentModes);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &amountOFPresentModes, surfaceDetails.presentModes.data());
 
-        VkAttachmentDescription depthAttachmentDescription =
+        return surfaceDetails;
+    }
+
+    void readTextureUpload(const std::string& filename, TextureFile& textureFile, Assets::MappedFile& encodedFile, TextureUpload& textureUpload)
+    {
+        textureUpload.format = VK_FORMAT_UNDEFINED;
+
+        // Precompressed textures are streamed straight into the staging buffer, the jpeg is only a fallback
+        if (readTextureFileHeader(filename + ".ktx2", textureFile) || readTextureFileHeader(filename + ".dds", textureFile))
         {
-            .flags = 0,
-            .format = VK_FORMAT_D32_SFLOAT,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-        };
+            textureUpload.format = pickTextureFormat(textureFile.format);
 
-        VkAttachmentReference depthAttachmentReference =
+            if (textureUpload.format == VK_FORMAT_UNDEFINED)
+                std::cout << "Texture format " << textureFile.format << " of \"" << textureFile.filename << "\" is not supported, falling back to jpeg.\n";
+        }
+
+        if (textureUpload.format == VK_FORMAT_UNDEFINED)
         {
-            .attachment = 1,
-            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-        };
+            // Decoded by prepareTextureUpload on a worker
+            encodedFile = Assets::MapFile(filename + ".jpg");
+            Assets::PrefetchFile(encodedFile);
+            return;
+        }
+
+        textureUpload.width = textureFile.width;
+        textureUpload.height = textureFile.height;
 
-        VkSubpassDescription subpassDescription =
+        if (textureUpload.format != textureFile.format)
         {
-            .flags = 0,
-            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-            .inputAttachmentCount = 0,
-            .pInputAttachments = nullptr,
-            .colorAttachmentCount = 1,
-            .pColorAttachments = &colorAttachmentReference,
-            .pResolveAttachments = nullptr,
-            .pDepthStencilAttachment = &depthAttachmentReference,
-            .preserveAttachmentCount = 0,
-            .pPreserveAttachments = nullptr
-        };
+            // Decompressed by prepareTextureUpload on a worker
+            encodedFile = Assets::MapFile(textureFile.filename);
+            Assets::PrefetchFile(encodedFile);
+            return;
+        }
+
+        VkDeviceSize imageSize = getTextureSize(textureFile, textureUpload.format);
+
+        createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, textureUpload.stagingBuffer);
+
+        void* data;
+        vkMapMemory(device, textureUpload.stagingBuffer.bufferMemory, 0, imageSize, 0, &data);
+        readTextureFileLevels(textureFile, static_cast<uint8_t*>(data));
+        vkUnmapMemory(device, textureUpload.stagingBuffer.bufferMemory);
+    }
+
+    void recreateGraphicsPipelineAndSwapchain()
+    {
+        vkDeviceWaitIdle(device);
+
+        cleanupSwapchain();
+
+        // The viewport is part of the pipelines, RenderFrame requests the variants again
+        pipelineVariants.clear();
+
+        // RenderFrame skips packets of a minimized window, so the framebuffer size is never 0 here
+        createSwapchain(physicalDevice);
+        createImageViews();
+
+        // Only now g_windowSize has the extent of the new swapchain
+        pipelineVariants.compileFallbacks();
+
+        createDepthResources();
+        createFramebuffers();
+    }
+
+    VkPipeline selectGraphicsPipeline(uint32_t pipelineKey, bool depthOnly, bool pushConstantDraws)
+    {
+        uint32_t state;
 
-        //TODO: Check if rendering is not done properly without this struct
-        VkSubpassDependency subpassDependency =
+        // Wireframes are not part of the depth prepass, they would hide the faces behind their lines
+        if (depthOnly)
         {
-            .srcSubpass = VK_SUBPASS_EXTERNAL,
-            .dstSubpass = 0,
-            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-            .srcAccessMask = 0,
-            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-            .dependencyFlags = 0
-        };
+            if (pipelineKey != fillPipelineKey)
+                return VK_NULL_HANDLE;
 
-        std::array<VkAttachmentDescription, 2> attachments = { colorAttachmentDescription, depthAttachmentDescription };
-        VkRenderPassCreateInfo renderPassCreateInfo =
+            state = PIPELINE_VARIANT_STATE_DEPTH_PREPASS;
+        }
+        else if (pipelineKey == wireframePipelineKey)
         {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .attachmentCount = static_cast<uint32_t>(attachments.size()),
-            .pAttachments = attachments.data(),
-            .subpassCount = 1,
-            .pSubpasses = &subpassDescription,
-            .dependencyCount = 1,
-            .pDependencies = &subpassDependency
-        };
+            state = PIPELINE_VARIANT_STATE_WIREFRAME;
+        }
+        else
+        {
+            state = currentFramePacket->depthPrepass ? PIPELINE_VARIANT_STATE_DEPTH_EQUAL : PIPELINE_VARIANT_STATE_FILL;
+        }
 
-        result = vkCreateRenderPass(device, &renderPassCreateInfo, pAllocator, &renderPass);
-        evaluteVulkanResult(result);
+        return pipelineVariants.get(state | pipelineVariantFeatures | (pushConstantDraws ? PIPELINE_VARIANT_PUSH_CONSTANT_DRAWS : 0));
     }
 
-    void createShaderModule(const std::vector<char>& shaderCode, VkShaderModule* shaderModule)
+    uint32_t selectMeshLod(const Mesh& mesh, const glm::mat4& worldMatrix)
     {
-        VkShaderModuleCreateInfo shaderModuleCreateInfo =
+        // Pixels covered by one object space unit at a distance of one unit
+        const UBOValues& uboValues = currentFramePacket->uboValues;
+
+        float projectionScale = static_cast<float>(g_windowSize.height) / (2.0f * std::tan(glm::radians(uboValues.fovy) * 0.5f));
+
+        // The sphere follows the rotation of the object, non uniform scaling is covered by the largest axis
+        glm::vec3 center = glm::vec3(worldMatrix * glm::vec4(glm::vec3(mesh.boundingSphere), 1.0f));
+        float scale = std::max({ glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2])) });
+
+        // The closest point of the bounding sphere decides, so a large object never gets coarse while its front is close
+        float distance = glm::distance(center, cameraPosition) - mesh.boundingSphere.w * scale;
+        distance = std::max(distance, uboValues.near);
+
+        // The errors grow with the LOD, so the last one below the threshold is the coarsest acceptable one
+        uint32_t lod = 0;
+        for (uint32_t i = 1; i < mesh.lods.size(); i++)
         {
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .codeSize = shaderCode.size(),
-            .pCode = reinterpret_cast<const uint32_t*>(shaderCode.data())
-        };
+            if (mesh.lods[i].error * projectionScale / distance <= currentFramePacket->lodPixelError)
+                lod = i;
+        }
 
-        VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, pAllocator, shaderModule);
-        evaluteVulkanResult(result);
+        return lod;
     }
 
-    void createStorageBuffers()
+    void storeTransformRanges(const FramePacket& framePacket)
     {
-        uint64_t bufferSize = sizeof(GameObjectData) * 1000;
+        // The hierarchy only grows or shrinks with a rebuild, which sends all of its slots
+        persistentTransformCount = std::min(framePacket.transformCount, maxGameObjectCount);
+        objectTransforms.resize(persistentTransformCount);
 
-        for (FrameData& frameData : frames)
+        const ObjectTransform* transforms = framePacket.transforms.data();
+
+        for (const TransformRange& range : framePacket.transformRanges)
         {
-            createBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameData.objectBuffer);
+            uint32_t firstTransform = std::min(range.firstTransform, persistentTransformCount);
+            uint32_t transformCount = std::min(range.transformCount, persistentTransformCount - firstTransform);
+
+            std::copy(transforms, transforms + transformCount, objectTransforms.begin() + firstTransform);
+            transforms += range.transformCount;
+
+            // Every frame in flight copies the range into its own transform buffer the next time it is recorded
+            if (transformCount > 0)
+            {
+                for (FrameData& frame : frames)
+                    frame.pendingTransformRanges.push_back({ firstTransform, transformCount });
+            }
         }
     }
 
-    void createSwapchain(VkPhysicalDevice physicalDevice)
+    void streamMeshes(FrameData& frame)
     {
-        VkResult result;
-        SurfaceDetails surfaceDetails = querySurfaceCapabilities(physicalDevice);
+        // Frames submitted before this one are done as well, none of them draws the replaced geometry anymore
+        for (const GeometryAllocation& allocation : frame.retiredGeometry)
+            geometryAllocator.free(allocation);
 
-        surfaceFormat = chooseSurfaceFormat(surfaceDetails.formats);
-        VkPresentModeKHR presentMode = choosePresentMode(surfaceDetails.presentModes);
-        g_windowSize = chooseExtent2D(surfaceDetails.capabilities);
+        frame.retiredGeometry.clear();
 
-        uint32_t imageCount = surfaceDetails.capabilities.minImageCount + 1;
+        auto getStagingSize = [](const StreamedMesh& streamedMesh)
+        {
+            return streamedMesh.vertices.size() * (sizeof(Vertex) + sizeof(uint64_t)) + streamedMesh.indices.size() * sizeof(uint32_t);
+        };
 
-        if (surfaceDetails.capabilities.maxImageCount > 0 && imageCount > surfaceDetails.capabilities.maxImageCount)
         {
-            imageCount = surfaceDetails.capabilities.maxImageCount;
+            std::lock_guard<std::mutex> lock(streamedMeshMutex);
+            uint64_t stagingSize = 0;
+
+            // In the order of StreamMesh, the rest waits for the next frames
+            while (!streamedMeshQueue.empty())
+            {
+                uint64_t size = getStagingSize(streamedMeshQueue.front());
+
+                if (size > streamingBufferSize)
+                {
+                    std::cerr << "Das Mesh fuer Slot " << streamedMeshQueue.front().slot << " ist groesser als der Staging Buffer!" << std::endl;
+                    streamedMeshQueue.pop_front();
+                    continue;
+                }
+
+                if (stagingSize + size > streamingBufferSize)
+                    break;
+
+                stagingSize += size;
+                streamedMeshUploads.push_back(std::move(streamedMeshQueue.front()));
+                streamedMeshQueue.pop_front();
+            }
+
+            g_pendingStreamedMeshCount = static_cast<uint32_t>(streamedMeshQueue.size());
         }
 
-        //TODO: Parameter überprüfen
-        VkSwapchainCreateInfoKHR swapchainCreateInfo =
+        if (streamedMeshUploads.empty())
+            return;
+
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+
+        // The frames in flight may still read the mesh data of the slots that get overwritten
+        VkMemoryBarrier readBarrier =
         {
-            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
             .pNext = nullptr,
-            .flags = 0,
-            .surface = surface,
-            .minImageCount = imageCount,
-            .imageFormat = surfaceFormat.format,
-            .imageColorSpace = surfaceFormat.colorSpace,
-            .imageExtent = g_windowSize,
-            .imageArrayLayers = 1,
-            .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            .queueFamilyIndexCount = 0,
-            .pQueueFamilyIndices = nullptr,
-            .preTransform = surfaceDetails.capabilities.currentTransform, //VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR
-            .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-            .presentMode = presentMode,
-            .clipped = VK_TRUE,
-            .oldSwapchain = VK_NULL_HANDLE
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
         };
 
-        result = vkCreateSwapchainKHR(device, &swapchainCreateInfo, pAllocator, &swapchain);
-        evaluteVulkanResult(result);
-    }
-
-    void createTextureImage()
-    {
-        int textureWidth, textureHeight, textureChannels;
-        stbi_uc* pixels = stbi_load("assets/textures/texture.jpg", &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &readBarrier, 0, nullptr, 0, nullptr);
 
-        VkDeviceSize imageSize = textureWidth * textureHeight * 4;
+        uint64_t stagingOffset = 0;
 
-        if (!pixels) //TODO: Uncaracteristic Throw
+        for (const StreamedMesh& streamedMesh : streamedMeshUploads)
         {
-            throw std::runtime_error("failed to load texture image!");
-        }
+            Mesh& mesh = streamedMeshes[streamedMesh.slot];
 
-        AllocatedBuffer stagingBuffer;
+            if (!mesh.lods.empty())
+            {
+                frame.retiredGeometry.push_back(mesh.vertexAllocation);
+                frame.retiredGeometry.push_back(mesh.indexAllocation);
+                mesh.lods.clear();
+            }
 
-        createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+            if (streamedMesh.vertices.empty())
+                continue;
 
-        void* data;
-        vkMapMemory(device, stagingBuffer.bufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(device, stagingBuffer.bufferMemory);
+            uint64_t vertexSize = streamedMesh.vertices.size() * sizeof(Vertex);
+            uint64_t indexSize = streamedMesh.indices.size() * sizeof(uint32_t);
+            uint64_t positionSize = streamedMesh.vertices.size() * sizeof(uint64_t);
 
-        stbi_image_free(pixels);
+            GeometryAllocation vertexAllocation, indexAllocation;
 
-        VkImageCreateInfo imageCreateInfo =
+            // A full geometry buffer drops the mesh, the slot stays empty until the next mesh for it
+            if (!geometryAllocator.allocate(vertexSize, sizeof(Vertex), vertexAllocation) ||
+                !geometryAllocator.allocate(indexSize, sizeof(uint32_t), indexAllocation))
+            {
+                geometryAllocator.free(vertexAllocation);
+                std::cerr << "Im Geometrie Buffer ist kein Platz fuer " << vertexSize + indexSize << " Bytes von Slot " << streamedMesh.slot << "!" << std::endl;
+                continue;
+            }
+
+            // Same layout as a MeshUpload: vertices, indices and the positions of the depth prepass
+            uint8_t* staging = frame.mappedStreamingBuffer + stagingOffset;
+            memcpy(staging, streamedMesh.vertices.data(), vertexSize);
+            memcpy(staging + vertexSize, streamedMesh.indices.data(), indexSize);
+
+            uint8_t* positions = staging + vertexSize + indexSize;
+
+            for (size_t i = 0; i < streamedMesh.vertices.size(); i++)
+                memcpy(positions + sizeof(uint64_t) * i, &streamedMesh.vertices[i], sizeof(uint64_t));
+
+            VkBufferCopy geometryCopies[] =
+            {
+                { stagingOffset, vertexAllocation.offset, vertexSize },
+                { stagingOffset + vertexSize, indexAllocation.offset, indexSize }
+            };
+
+            VkBufferCopy positionCopy = { stagingOffset + vertexSize + indexSize, vertexAllocation.offset / 2, positionSize };
+
+            vkCmdCopyBuffer(commandBuffer, frame.streamingBuffer.buffer, geometryBuffer.buffer, 2, geometryCopies);
+            vkCmdCopyBuffer(commandBuffer, frame.streamingBuffer.buffer, positionBuffer.buffer, 1, &positionCopy);
+
+            stagingOffset += vertexSize + indexSize + positionSize;
+
+            const VertexQuantization& quantization = streamedMesh.quantization;
+
+            MeshData meshData =
+            {
+                .positionScale = glm::vec4(quantization.scale[0], quantization.scale[1], quantization.scale[2], 0.0f),
+                .positionOffset = glm::vec4(quantization.offset[0], quantization.offset[1], quantization.offset[2], 0.0f)
+            };
+
+            vkCmdUpdateBuffer(commandBuffer, meshBuffer.buffer, sizeof(MeshData) * (maxMeshCount + streamedMesh.slot), sizeof(MeshData), &meshData);
+
+            mesh.vertexAllocation = vertexAllocation;
+            mesh.indexAllocation = indexAllocation;
+            mesh.vertexOffset = static_cast<int32_t>(vertexAllocation.offset / sizeof(Vertex));
+            mesh.firstIndex = static_cast<uint32_t>(indexAllocation.offset / sizeof(uint32_t));
+            mesh.lods = { { 0, static_cast<uint32_t>(streamedMesh.indices.size()), 0.0f } };
+            mesh.boundingSphere = glm::vec4(glm::vec3(meshData.positionOffset), glm::length(glm::vec3(meshData.positionScale)));
+        }
+
+        streamedMeshUploads.clear();
+
+        // The culling and the draws of this frame already use the new meshes
+        VkMemoryBarrier uploadBarrier =
         {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
             .pNext = nullptr,
-            .flags = 0,
-            .imageType = VK_IMAGE_TYPE_2D,
-            .format = VK_FORMAT_R8G8B8A8_SRGB,
-            .extent = { static_cast<uint32_t>(textureWidth), static_cast<uint32_t>(textureHeight), 1},
-            .mipLevels = 1,
-            .arrayLayers = 1,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            .queueFamilyIndexCount = 0,
-            .pQueueFamilyIndices = nullptr,
-            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDEX_READ_BIT
         };
 
-        createImage(imageCreateInfo, textureImage, textureImageMemory);
-        transitionImageLayout(textureImage,  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        copyBufferToImage(stagingBuffer.buffer, textureImage, static_cast<uint32_t>(textureWidth), static_cast<uint32_t>(textureHeight));
-        transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-        vkDestroyBuffer(device, stagingBuffer.buffer, pAllocator);
-        vkFreeMemory(device, stagingBuffer.bufferMemory, pAllocator);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &uploadBarrier, 0, nullptr, 0, nullptr);
     }
 
-    void createTextureImageView()
+    void updateParticles(FrameData& frame)
     {
-        textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
-    }
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
+        const ParticleEmitter& emitter = currentFramePacket->particleEmitter;
 
-    void createTextureSampler()
-    {
-        VkResult result;
+        // In real time, RenderFrame does not run once per fixed simulation step. Long stalls are cut off.
+        auto updateTime = std::chrono::steady_clock::now();
+        float timeStep = std::min(std::chrono::duration<float>(updateTime - particleUpdateTime).count(), 0.1f);
+        particleUpdateTime = updateTime;
 
-        VkPhysicalDeviceProperties physicalDeviceProperties{};
-        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+        particleEmitAccumulator += emitter.rate * timeStep;
+        uint32_t emitCount = static_cast<uint32_t>(std::min(particleEmitAccumulator, static_cast<float>(maxParticleCount)));
+        particleEmitAccumulator = std::min(particleEmitAccumulator - static_cast<float>(emitCount), 1.0f);
 
-        VkSamplerCreateInfo samplerCreateInfo =
+        // Up is negative y
+        ParticleParameters parameters =
         {
-            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .emitterPositionRadius = glm::vec4(emitter.position, emitter.radius),
+            .gravityTimeStep = glm::vec4(0.0f, 9.81f, 0.0f, timeStep),
+            .emitCount = emitCount,
+            .maxParticleCount = maxParticleCount,
+            .aliveList = particleAliveList,
+            .stage = 0,
+            .seed = particleSeed++,
+            .lifetime = emitter.lifetime,
+            .speed = emitter.speed,
+            .size = emitter.size
+        };
+
+        // The draw, the indirect arguments and the readback of the last frame still use the buffers
+        VkMemoryBarrier frameBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
             .pNext = nullptr,
-            .flags = 0,
-            .magFilter = VK_FILTER_LINEAR,
-            .minFilter = VK_FILTER_LINEAR,
-            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-            .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-            .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-            .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-            .mipLodBias = 0.f,
-            .anisotropyEnable = VK_TRUE,
-            .maxAnisotropy = physicalDeviceProperties.limits.maxSamplerAnisotropy,
-            .compareEnable = VK_FALSE,
-            .compareOp = VK_COMPARE_OP_ALWAYS,
-            .minLod = 0.f,
-            .maxLod = 0.f,
-            .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-            .unnormalizedCoordinates = VK_FALSE
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
         };
 
-        result = vkCreateSampler(device, &samplerCreateInfo, pAllocator, &textureSampler);
-        evaluteVulkanResult(result);
-    }
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &frameBarrier, 0, nullptr, 0, nullptr);
 
-    void createUniformBuffers()
-    {
-        uint64_t bufferSize = sizeof(UniformBufferObject);
+        // The pipelines share one layout, so the set and the push constants stay bound between the passes
+        ParticleDescriptors particleDescriptors = getParticleDescriptors(frame);
+        bindComputeDescriptors(frame, particleComputeDescriptorTemplate, particlePipelineLayout, descriptorSetLayoutParticles, &particleDescriptors);
 
-        for (uint64_t i = 0; i < imageCount; i++) {
-            createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frames[i].uniformBuffer);
-        }
-    }
+        // Every pass reads the counters of the one before it, in the shader or as indirect arguments
+        VkMemoryBarrier passBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT
+        };
 
-    void createVertexBuffer()
-    {
-        VkResult result;
+        auto dispatchArguments = [&](uint32_t stage)
+        {
+            parameters.stage = stage;
 
-        uint64_t bufferSize = sizeof(vertices[0]) * vertices.size();
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleArgumentsPipeline);
+            vkCmdPushConstants(commandBuffer, particlePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(parameters), &parameters);
+            vkCmdDispatch(commandBuffer, 1, 1, 1);
 
-        AllocatedBuffer stagingBuffer;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+        };
 
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+        // Emission: new particles from the end of the dead list into the current alive list
+        dispatchArguments(0);
 
-        void* data;
-        result = vkMapMemory(device, stagingBuffer.bufferMemory, 0, bufferSize, 0, &data);
-        evaluteVulkanResult(result);
-        memcpy(data, vertices.data(), bufferSize);
-        vkUnmapMemory(device, stagingBuffer.bufferMemory);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleEmitPipeline);
+        vkCmdDispatchIndirect(commandBuffer, particleCounterBuffer.buffer, offsetof(ParticleCounters, emitDispatch));
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
 
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer);
+        // Simulation: the survivors are compacted into the other alive list, the dead ones go back to the dead list
+        dispatchArguments(1);
 
-        copyBuffer(bufferSize, stagingBuffer.buffer, vertexBuffer.buffer);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleSimulatePipeline);
+        vkCmdDispatchIndirect(commandBuffer, particleCounterBuffer.buffer, offsetof(ParticleCounters, simulateDispatch));
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
 
-        vkDestroyBuffer(device, stagingBuffer.buffer, pAllocator);
-        vkFreeMemory(device, stagingBuffer.bufferMemory, pAllocator);
+        particleAliveList ^= 1;
+        parameters.aliveList = particleAliveList;
+
+        // Draw arguments, the barrier behind it also covers the particles for particle.vert
+        dispatchArguments(2);
+
+        // Read once the fence of the frame was waited on, only for the count in the UI
+        VkBufferCopy copyRegion =
+        {
+            .srcOffset = 0,
+            .dstOffset = 0,
+            .size = sizeof(ParticleCounters)
+        };
+
+        vkCmdCopyBuffer(commandBuffer, particleCounterBuffer.buffer, frame.particleCounterReadbackBuffer.buffer, 1, &copyRegion);
+
+        VkMemoryBarrier hostBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+        frame.particleCountersWritten = true;
     }
 
-    int initializeImGui()
+    void updateTextureDescriptor(uint32_t textureIndex)
     {
-        VkResult result;
+        const Texture& texture = textures[textureIndex].imageView != VK_NULL_HANDLE ? textures[textureIndex] : textures[0];
 
-        IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
-        ImGuiIO& io = ImGui::GetIO(); (void)io;
-        io.IniFilename = nullptr;
+        VkDescriptorImageInfo descriptorImageInfo =
+        {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = texture.imageView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
 
-        io.Fonts->AddFontFromFileTTF("assets/font/DroidSans.ttf", 16 * Backend::GetMonitorScale());
+        VkWriteDescriptorSet writeDescriptorSet =
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSetBindless,
+            .dstBinding = 0,
+            .dstArrayElement = textureIndex,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .pImageInfo = &descriptorImageInfo,
+            .pBufferInfo = nullptr,
+            .pTexelBufferView = nullptr
+        };
 
-        ImGui::StyleColorsDark();
+        vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+    }
 
-        IM_ASSERT(io.BackendPlatformUserData == NULL && "Already initialized a platform backend!");
+    void updateUniformBuffer(uint32_t frameNumber)
+    {
+        const UBOValues& uboValues = currentFramePacket->uboValues;
 
-        ImGui_ImplGlfw_InitForVulkan(Backend::g_window, true);
-        ImGui_ImplVulkan_InitInfo init_info = {};
-        init_info.Instance = instance;
-        init_info.PhysicalDevice = physicalDevice;
-        init_info.Device = device;
-        init_info.QueueFamily = queueFamily.index.value();
-        init_info.Queue = queue;
-        init_info.PipelineCache = nullptr;
-        init_info.DescriptorPool = descriptorPoolImGui;
-        init_info.Subpass = 0;
-        init_info.MinImageCount = imageCount;
-        init_info.ImageCount = imageCount;
-        init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-        init_info.Allocator = pAllocator;
-        init_info.CheckVkResultFn = evaluteVulkanResult;
-        ImGui_ImplVulkan_Init(&init_info, renderPass);
+        UniformBufferObject ubo = createUniformBufferObject(uboValues, cameraPosition, static_cast<float>(g_windowSize.width) / static_cast<float>(g_windowSize.height));
+        ubo.interpolationFactor = currentFramePacket->interpolationFactor;
 
-        //Upload Fonts
         {
-            // Use any command queue
-            VkCommandPool command_pool = frames[0].commandPool;
-            VkCommandBuffer command_buffer = frames[0].mainCommandBuffer;
+            // The clusters are built in view space, so the lights are transformed once here instead of per cluster and fragment
+            const std::vector<RenderLight>& lights = currentFramePacket->lights;
+            uint32_t lightCount = std::min(static_cast<uint32_t>(lights.size()), maxLightCount);
+            glm::mat4 modelView = ubo.view * ubo.model;
 
-            result = vkResetCommandPool(device, command_pool, 0);
-            evaluteVulkanResult(result);
-            VkCommandBufferBeginInfo begin_info = {};
-            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-            result = vkBeginCommandBuffer(command_buffer, &begin_info);
-            evaluteVulkanResult(result);
+            for (uint32_t i = 0; i < lightCount; i++)
+            {
+                glm::vec3 viewPosition = glm::vec3(modelView * glm::vec4(lights[i].position, 1.0f));
+                frames[frameNumber].mappedLights[i] = { glm::vec4(viewPosition, lights[i].radius), glm::vec4(lights[i].color, 1.0f) };
+            }
+
+            ubo.clusterParameters = glm::vec4(static_cast<float>(g_windowSize.width), static_cast<float>(g_windowSize.height), uboValues.near, uboValues.far);
+            ubo.lightCount = lightCount;
+        }
+
+        {
+            void* data;
+            vkMapMemory(device, frames[frameNumber].uniformBuffer.bufferMemory, 0, sizeof(ubo), 0, &data);
+            memcpy(data, &ubo, sizeof(ubo));
+            vkUnmapMemory(device, frames[frameNumber].uniformBuffer.bufferMemory);
+        }
+
+        drawCommands.clear();
+        drawBatches.clear();
+        directDraws.clear();
+        frames[frameNumber].drawCount = 0;
+        frames[frameNumber].objectCount = 0;
+
+        const std::vector<RenderObject>& objects = currentFramePacket->objects;
+        const std::vector<RenderObject>& dynamicObjects = currentFramePacket->dynamicObjects;
+        float interpolationFactor = currentFramePacket->interpolationFactor;
+
+        // Only the slots the frame packets changed since this frame was last recorded, a static scene copies nothing
+        uploadTransforms(frames[frameNumber]);
+
+        if (objects.empty() && dynamicObjects.empty())
+            return;
+
+        if (currentFramePacket->pushConstantDraws)
+        {
+            // The whole per draw data goes into the push constants, neither the object buffer nor a descriptor is touched
+            uint32_t directDrawCount = std::min(static_cast<uint32_t>(dynamicObjects.size()), maxDirectDrawCount);
+
+            for (uint32_t i = 0; i < directDrawCount; i++)
+            {
+                const RenderObject& object = dynamicObjects[i];
+                const Mesh* mesh = findMesh(object.meshIndex);
+
+                if (mesh == nullptr)
+                    continue;
 
-            ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
+                glm::vec3 position = glm::mix(object.previousPosition, glm::vec3(object.worldMatrix[3]), interpolationFactor);
 
-            VkSubmitInfo end_info = {};
-            end_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            end_info.commandBufferCount = 1;
-            end_info.pCommandBuffers = &command_buffer;
-            result = vkEndCommandBuffer(command_buffer);
-            evaluteVulkanResult(result);
-            result = vkQueueSubmit(queue, 1, &end_info, VK_NULL_HANDLE);
-            evaluteVulkanResult(result);
+                glm::mat4 worldMatrix = object.worldMatrix;
+                worldMatrix[3] = glm::vec4(position, 1.0f);
 
-            result = vkDeviceWaitIdle(device);
-            evaluteVulkanResult(result);
-            ImGui_ImplVulkan_DestroyFontUploadObjects();
+                uint32_t lod = selectMeshLod(*mesh, ubo.model * worldMatrix);
+
+                worldMatrix = glm::transpose(worldMatrix);
+
+                DirectDraw& directDraw = directDraws.emplace_back();
+                directDraw.pushConstants.worldMatrixRows[0] = worldMatrix[0];
+                directDraw.pushConstants.worldMatrixRows[1] = worldMatrix[1];
+                directDraw.pushConstants.worldMatrixRows[2] = worldMatrix[2];
+                directDraw.pushConstants.objectIndex = object.objectId;
+                directDraw.pushConstants.materialIndex = object.materialIndex;
+                directDraw.pushConstants.meshIndex = object.meshIndex;
+                directDraw.pushConstants.lod = lod;
+                directDraw.indexCount = mesh->lods[lod].indexCount;
+                directDraw.firstIndex = mesh->firstIndex + mesh->lods[lod].firstIndex;
+                directDraw.vertexOffset = mesh->vertexOffset;
+            }
         }
 
-        return 0;
-    }
+        {
+            // Every object becomes a draw packet, sorted by its key the objects of one mesh and LOD lie next to each other
+            // and every pair is drawn as one instanced draw over its range of the object buffer.
+            // Without push constant draws the dynamic objects follow the others through the object buffer.
+            uint32_t staticObjectCount = static_cast<uint32_t>(objects.size());
+            uint32_t dynamicObjectCount = currentFramePacket->pushConstantDraws ? 0 : static_cast<uint32_t>(dynamicObjects.size());
+            auto getObject = [&](uint32_t i) -> const RenderObject&
+            {
+                return i < staticObjectCount ? objects[i] : dynamicObjects[i - staticObjectCount];
+            };
 
-    int initializeVulkan()
-    {
-        VkResult result;
+            uint32_t objectCount = std::min(staticObjectCount + dynamicObjectCount, maxGameObjectCount);
+            uint32_t pipelineKey = currentFramePacket->polygonMode == VK_POLYGON_MODE_FILL ? fillPipelineKey : wireframePipelineKey;
 
-        if (createInstance() != 0)
-            return -1;
+            objectTransformIndices.resize(objectCount);
+            drawPackets.resize(objectCount);
 
-        result = glfwCreateWindowSurface(instance, Backend::g_window, pAllocator, &surface);
-        evaluteVulkanResult(result);
+            ObjectTransform* mappedTransforms = frames[frameNumber].mappedTransforms;
+            std::atomic<uint32_t> transientTransformCount = 0;
 
-        physicalDevice = pickPhysicalDevice();
+            // Interpolation, LOD selection and the keys are independent per object, small scenes stay on this thread
+            Jobs::Counter lodCounter;
+            Jobs::ParallelFor(objectCount, 256, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    const RenderObject& object = getObject(i);
+                    const Mesh* mesh = findMesh(object.meshIndex);
 
-        createLogicalDevice(physicalDevice);
+                    // Objects whose mesh is not loaded yet or whose streaming slot is empty are not drawn
+                    if (mesh == nullptr)
+                    {
+                        drawPackets[i] = { noDrawKey, i };
+                        continue;
+                    }
 
-        VkBool32 surfaceSupport = false;
-        result = vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamily.index.value(), surface, &surfaceSupport);
-        evaluteVulkanResult(result);
+                    uint32_t transformIndex = object.transformIndex;
 
-        if (!surfaceSupport)
-        {
-            std::cout << "Surface not Supported";
-            evaluteVulkanResult(VK_ERROR_INITIALIZATION_FAILED);
-            return -1;
-        }
+                    // The voxel chunks and the dynamic objects are not in the hierarchy, their slots are written for this frame only
+                    if (transformIndex >= persistentTransformCount)
+                    {
+                        transformIndex = persistentTransformCount + transientTransformCount.fetch_add(1, std::memory_order_relaxed);
 
-        createSwapchain(physicalDevice);
-        createImageViews();
-        createRenderPass();
-        
-        createDescriptorSetLayout();
-        createGraphicsPipeline();
+                        if (transformIndex >= maxGameObjectCount)
+                        {
+                            drawPackets[i] = { noDrawKey, i };
+                            continue;
+                        }
 
-        createDepthResources();
+                        glm::mat4 transposedMatrix = glm::transpose(object.worldMatrix);
 
-        createFramebuffers();
-        createFrameData();
+                        ObjectTransform& transform = mappedTransforms[transformIndex];
+                        transform.worldMatrixRows[0] = transposedMatrix[0];
+                        transform.worldMatrixRows[1] = transposedMatrix[1];
+                        transform.worldMatrixRows[2] = transposedMatrix[2];
+                        transform.previousPosition = glm::vec4(object.previousPosition, 1.0f);
+                    }
 
-        createTextureImage();
-        createTextureImageView();
-        createTextureSampler();
+                    objectTransformIndices[i] = transformIndex;
 
-        createVertexBuffer();
-        createIndexBuffer();
-        createUniformBuffers();
-        createStorageBuffers();
+                    // The shaders interpolate the same way from the transform buffer
+                    glm::mat4 worldMatrix = object.worldMatrix;
+                    worldMatrix[3] = glm::vec4(glm::mix(object.previousPosition, glm::vec3(object.worldMatrix[3]), interpolationFactor), 1.0f);
 
-        createDescriptorPool();
-        createDescriptorSets();
+                    uint32_t lod = selectMeshLod(*mesh, ubo.model * worldMatrix);
 
-        return 0;
-    }
+                    // The view direction is -z, the nearest object of a mesh and LOD decides where its draw goes
+                    float viewDepth = -(ubo.view * ubo.model * worldMatrix[3]).z;
 
-    uint32_t pickMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
-    {
-        VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceMemoryProperties);
+                    drawPackets[i] = { makeDrawKey(mainPassKey, pipelineKey, object.meshIndex * meshMaxLodCount + lod, viewDepth), i };
+                }
+            }, lodCounter);
+            Jobs::Wait(lodCounter);
 
-        for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; i++)
-        {
-            if ((typeFilter & (1 << i)) && (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            sortDrawPackets(drawPackets, drawPacketScratch);
+
+            while (!drawPackets.empty() && drawPackets.back().key == noDrawKey)
+                drawPackets.pop_back();
+
+            // Every mesh and LOD becomes one draw command, front to back by its nearest object inside its pass and pipeline
+            buildDrawRanges(drawPackets, drawRanges);
+
+            // Both buffers are persistently mapped, the objects land in their sorted slot without a staging copy
+            GameObjectData* gameObjectData = frames[frameNumber].mappedObjects;
+            uint32_t packetCount = 0;
+
+            for (uint32_t rangeIndex = 0; rangeIndex < drawRanges.size(); rangeIndex++)
             {
-                return i;
-            }
-        }
+                const DrawRange& range = drawRanges[rangeIndex];
+                uint64_t key = range.key;
 
-        throw std::runtime_error("failed to find suitable memory type!");
-    }
+                uint32_t draw = getDrawKeyDraw(key);
+                const Mesh& mesh = *findMesh(draw / meshMaxLodCount);
+                const MeshLod& lod = mesh.lods[draw % meshMaxLodCount];
 
-    VkPhysicalDevice pickPhysicalDevice()
-    {
-        uint32_t amountOfPhysicalDevices = 0;
-        VkResult result = vkEnumeratePhysicalDevices(instance, &amountOfPhysicalDevices, nullptr);
-        evaluteVulkanResult(result);
+                // A new pass or pipeline starts a batch. The instance ranges are filled from the front by the occlusion culling,
+                // which also counts the instances.
+                if (rangeIndex == 0 || (key >> drawKeyPipelineShift) != (drawRanges[rangeIndex - 1].key >> drawKeyPipelineShift))
+                    drawBatches.push_back({ getDrawKeyPass(key), getDrawKeyPipeline(key), static_cast<uint32_t>(drawCommands.size()), 0 });
 
-        std::vector<VkPhysicalDevice> physicalDevices(amountOfPhysicalDevices);
-        result = vkEnumeratePhysicalDevices(instance, &amountOfPhysicalDevices, physicalDevices.data());
-        evaluteVulkanResult(result);
+                drawBatches.back().drawCount++;
 
-        for (uint32_t i = 0; i < amountOfPhysicalDevices; i++)
-        {
-            VkPhysicalDeviceProperties physicalDeviceProperties;
-            vkGetPhysicalDeviceProperties(physicalDevices[i], &physicalDeviceProperties);
+                drawCommands.push_back(
+                {
+                    .indexCount = lod.indexCount,
+                    .instanceCount = range.packetCount,
+                    .firstIndex = mesh.firstIndex + lod.firstIndex,
+                    .vertexOffset = mesh.vertexOffset,
+                    .firstInstance = packetCount
+                });
+
+                for (uint32_t packet = range.firstPacket; packet < range.firstPacket + range.packetCount; packet++)
+                {
+                    const RenderObject& renderObject = getObject(drawPackets[packet].object);
+
+                    GameObjectData& object = gameObjectData[packetCount++];
+                    object.transformIndex = objectTransformIndices[drawPackets[packet].object];
+                    object.materialIndex = renderObject.materialIndex;
+                    object.meshIndex = renderObject.meshIndex;
+                    object.drawIndex = static_cast<uint32_t>(drawCommands.size()) - 1;
+                    object.objectId = renderObject.objectId;
+                }
+            }
 
-            if (physicalDeviceProperties.deviceType & VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+            // The commands of the second phase follow the first ones and use the upper half of the visible instance buffer
+            VkDrawIndexedIndirectCommand* mappedDrawCommands = frames[frameNumber].mappedDrawCommands;
+            uint32_t drawCount = static_cast<uint32_t>(drawCommands.size());
+
+            for (uint32_t i = 0; i < drawCount; i++)
             {
-                return physicalDevices[i];
+                mappedDrawCommands[i] = drawCommands[i];
+                mappedDrawCommands[i].instanceCount = 0;
+
+                mappedDrawCommands[drawCount + i] = mappedDrawCommands[i];
+                mappedDrawCommands[drawCount + i].firstInstance += maxGameObjectCount;
             }
-        }
 
-        return physicalDevices[0];
+            frames[frameNumber].drawCount = drawCount;
+            frames[frameNumber].objectCount = packetCount;
+        }
     }
 
-    QueueFamily pickQueueFamily(VkPhysicalDevice physicalDevice)
+    void uploadAssets(FrameData& frame)
     {
-        QueueFamily queueFamily;
+        // The copies of the last submission of this frame are done
+        publishAssetUploads(frame);
 
-        uint32_t amountOfQueueFamilyProperties = 0;
-        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &amountOfQueueFamilyProperties, nullptr);
+        if (queuedMeshUploads.empty() && queuedTextureUploads.empty())
+            return;
 
-        std::vector<VkQueueFamilyProperties> queueFamilyProperties(amountOfQueueFamilyProperties);
-        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &amountOfQueueFamilyProperties, queueFamilyProperties.data());
+        VkCommandBuffer commandBuffer = frame.mainCommandBuffer;
 
-        for (uint32_t i = 0; i < amountOfQueueFamilyProperties; i++)
+        for (MeshUpload& meshUpload : queuedMeshUploads)
         {
-            if (queueFamilyProperties[i].queueFlags == (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT))
+            try
             {
-                queueFamily.index = i;
-                queueFamily.queueCount = 1;
+                createMesh(commandBuffer, meshUpload);
+                frame.meshUploads.push_back(std::move(meshUpload));
+            }
+            catch (std::exception& ex)
+            {
+                std::cerr << ex.what() << std::endl;
 
-                break;
+                vkDestroyBuffer(device, meshUpload.stagingBuffer.buffer, pAllocator);
+                vkFreeMemory(device, meshUpload.stagingBuffer.bufferMemory, pAllocator);
             }
         }
 
-        if (!queueFamily.index.has_value())
-            throw std::logic_error("No fitting QueueFamily was found."); //TODO: Inconsisten throw
-
-        return queueFamily;
-    }
-
-    SurfaceDetails querySurfaceCapabilities(VkPhysicalDevice physicalDevice)
-    {
-        SurfaceDetails surfaceDetails;
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceDetails.capabilities);
+        for (TextureUpload& textureUpload : queuedTextureUploads)
+        {
+            createTextureImage(commandBuffer, textureUpload, textureUpload.texture);
+            frame.textureUploads.push_back(std::move(textureUpload));
+        }
 
-        uint32_t amountOfSurfaceFormats = 0;
-        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &amountOfSurfaceFormats, nullptr);
-        surfaceDetails.formats.resize(amountOfSurfaceFormats);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &amountOfSurfaceFormats, surfaceDetails.formats.data());
+        queuedMeshUploads.clear();
+        queuedTextureUploads.clear();
 
-        uint32_t amountOFPresentModes = 0;
-        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &amountOFPresentModes, nullptr);
-        surfaceDetails.presentModes.resize(amountOFPresentModes);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &amountOFPresentModes, surfaceDetails.presentModes.data());
+        // The meshes are only drawn after the fence, the barrier makes the copies visible to the later submissions
+        VkMemoryBarrier uploadBarrier =
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+        };
 
-        return surfaceDetails;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &uploadBarrier, 0, nullptr, 0, nullptr);
     }
 
-    void recreateGraphicsPipelineAndSwapchain()
+    Assets::Task uploadTexture(std::string filename, uint32_t textureIndex)
     {
-        vkDeviceWaitIdle(device);
+        TextureFile textureFile;
+        Assets::MappedFile encodedFile;
+        TextureUpload textureUpload;
 
-        cleanupSwapchain();
+        co_await Assets::ResumeOnReadThread();
 
-        vkDestroyPipelineLayout(device, pipelineLayout, pAllocator);
-        vkDestroyPipeline(device, pipeline, pAllocator);
-        vkDestroyPipeline(device, wireframePipeline, pAllocator);
+        readTextureUpload(filename, textureFile, encodedFile, textureUpload);
 
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(Backend::g_window, &width, &height);
-        while (width == 0 || height == 0) {
-            glfwGetFramebufferSize(Backend::g_window, &width, &height);
-            glfwWaitEvents();
-        }
+        co_await Assets::ResumeOnWorker();
 
-        createSwapchain(physicalDevice);
-        createImageViews();
+        prepareTextureUpload(textureFile, encodedFile, textureUpload);
 
-        createGraphicsPipeline();
-        
-        createDepthResources();
-        createFramebuffers();
+        co_await Assets::ResumeOnMainThread();
+
+        // Copied by the command buffer of the next frame, the slot shows the placeholder until its fence has signalled
+        textureUpload.textureIndex = textureIndex;
+        queuedTextureUploads.push_back(std::move(textureUpload));
     }
 
-    void updateUniformBuffer(uint32_t imageIndex)
+    void uploadTransforms(FrameData& frame)
     {
-        // static auto startTime = std::chrono::high_resolution_clock::now();
-
-        // auto currentTime = std::chrono::high_resolution_clock::now();
-        // float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        std::vector<TransformRange>& ranges = frame.pendingTransformRanges;
 
-        auto x = g_uboValues.center + g_uboValues.eye;
-
-        UniformBufferObject ubo =
-        {
-            .model = glm::translate(glm::mat4(1.0f), g_uboValues.axis),
-            .view = glm::lookAt(g_uboValues.eye, g_uboValues.center + g_uboValues.eye, g_uboValues.up),
-            .proj = glm::perspective(glm::radians(g_uboValues.fovy), static_cast<float>(g_windowSize.width) / static_cast<float>(g_windowSize.height), g_uboValues.near, g_uboValues.far)
-        };
+        if (ranges.empty())
+            return;
 
-        /*UniformBufferObject ubo =
+        auto copyTransforms = [&frame](uint32_t firstTransform, uint32_t endTransform)
         {
-            .model = glm::rotate(glm::mat4(1.0f), glm::radians(g_uboValues.angle), glm::vec3(1.0f, 0.0f, 0.0f)),
-            .view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.5f)),
-            .proj = glm::perspective(glm::radians(60.0f), static_cast<float>(g_windowSize.width) / static_cast<float>(g_windowSize.height), 0.1f, 10.0f)
-        };*/
+            // Ranges of packets before a rebuild may reach beyond the slots of the smaller hierarchy
+            endTransform = std::min(endTransform, persistentTransformCount);
 
-        //UniformBufferObject ubo =
-        //{
-        //    .model = glm::rotate(glm::mat4(1.0f), time * glm::radians(60.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-        //    .view = glm::lookAt(glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-        //    .proj = glm::perspective(glm::radians(60.0f), static_cast<float>(windowSize.width) / static_cast<float>(windowSize.height), 0.1f, 10.0f)
-        //};
+            if (endTransform > firstTransform)
+                memcpy(frame.mappedTransforms + firstTransform, objectTransforms.data() + firstTransform, sizeof(ObjectTransform) * (endTransform - firstTransform));
+        };
 
-        ubo.proj[1][1] *= -1;
+        // The ranges of several packets overlap, merged every slot is copied once
+        std::sort(ranges.begin(), ranges.end(), [](const TransformRange& a, const TransformRange& b) { return a.firstTransform < b.firstTransform; });
 
-        {
-            void* data;
-            vkMapMemory(device, frames[imageIndex].uniformBuffer.bufferMemory, 0, sizeof(ubo), 0, &data);
-            memcpy(data, &ubo, sizeof(ubo));
-            vkUnmapMemory(device, frames[imageIndex].uniformBuffer.bufferMemory);
-        }
+        uint32_t firstTransform = ranges[0].firstTransform;
+        uint32_t endTransform = firstTransform;
 
+        for (const TransformRange& range : ranges)
         {
-            void* data;
-            vkMapMemory(device, frames[imageIndex].objectBuffer.bufferMemory, 0, sizeof(ubo), 0, &data);
-
-            GameObjectData* gameObjectData = (GameObjectData*)data;
-
-            gameObjectData[0].globalPosition = glm::vec3(-1, 1, -1);
-            gameObjectData[1].globalPosition = glm::vec3(0, 1, 0);
-            gameObjectData[2].globalPosition = glm::vec3(1, 1, 1);
-            gameObjectData[3].globalPosition = glm::vec3(-1, 0, -1);
-            gameObjectData[4].globalPosition = glm::vec3(0, 0, 0);
-            gameObjectData[5].globalPosition = glm::vec3(1, 0, 1);
-            gameObjectData[6].globalPosition = glm::vec3(-1, -1, -1);
-            gameObjectData[7].globalPosition = glm::vec3(0, -1, 0);
-            gameObjectData[8].globalPosition = glm::vec3(1, -1, 1);
+            if (range.firstTransform > endTransform)
+            {
+                copyTransforms(firstTransform, endTransform);
+                firstTransform = range.firstTransform;
+            }
 
-            vkUnmapMemory(device, frames[imageIndex].objectBuffer.bufferMemory);
+            endTransform = std::max(endTransform, range.firstTransform + range.transformCount);
         }
+
+        copyTransforms(firstTransform, endTransform);
+        ranges.clear();
     }
 
     /*
@@ -1941,19 +4832,127 @@ namespace VulkanPrototype::Renderer
         cleanupVulkan();
     }
 
+    void CopyDrawData(const ImDrawData* drawData, FramePacket& framePacket)
+    {
+        for (ImDrawList* drawList : framePacket.drawLists)
+            IM_DELETE(drawList);
+
+        framePacket.drawLists.clear();
+        framePacket.drawData = *drawData;
+
+        for (int i = 0; i < drawData->CmdListsCount; i++)
+            framePacket.drawLists.push_back(drawData->CmdLists[i]->CloneOutput());
+
+        // The copied ImDrawData still points to the lists of ImGui
+#if IMGUI_VERSION_NUM >= 18980
+        framePacket.drawData.CmdLists.resize(0);
+        for (ImDrawList* drawList : framePacket.drawLists)
+            framePacket.drawData.CmdLists.push_back(drawList);
+#else
+        framePacket.drawData.CmdLists = framePacket.drawLists.data();
+#endif
+    }
+
+    uint32_t GetStreamedMeshIndex(uint32_t slot)
+    {
+        return maxMeshCount + slot;
+    }
+
+    glm::mat4 GetViewProjectionMatrix(const UBOValues& uboValues, const glm::vec3& eye, float aspectRatio)
+    {
+        UniformBufferObject ubo = createUniformBufferObject(uboValues, eye, aspectRatio);
+
+        return ubo.proj * ubo.view * ubo.model;
+    }
+
     int Initialize()
     {
+        // Shaders and font are read on the worker threads while the device gets created
+        shaderFileVert = Assets::LoadFile("shader/vert.spv");
+        shaderFileFrag = Assets::LoadFile("shader/frag.spv");
+        shaderFileDepthPrepass = Assets::LoadFile("shader/depthPrepass.spv");
+        shaderFileLightCulling = Assets::LoadFile("shader/lightCulling.spv");
+        shaderFileOcclusionCulling = Assets::LoadFile("shader/occlusionCulling.spv");
+        shaderFileDepthPyramid = Assets::LoadFile("shader/depthPyramid.spv");
+        shaderFileParticleArguments = Assets::LoadFile("shader/particleArguments.spv");
+        shaderFileParticleEmit = Assets::LoadFile("shader/particleEmit.spv");
+        shaderFileParticleSimulate = Assets::LoadFile("shader/particleSimulate.spv");
+        shaderFileParticleVert = Assets::LoadFile("shader/particleVert.spv");
+        shaderFileParticleFrag = Assets::LoadFile("shader/particleFrag.spv");
+        fontFile = Assets::LoadFile("assets/font/DroidSans.ttf");
+
+        int width, height;
+        glfwGetFramebufferSize(Backend::g_window, &width, &height);
+        framebufferSize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+
         initializeVulkan();
         initializeImGui();
 
+        loadMesh("assets/meshes/cube.vpmesh");
+
+        uint32_t textureIndex = loadTexture("assets/textures/texture");
+
+        createMaterial(textureIndex, glm::vec4(1.0f));
+        createMaterial(textureIndex, glm::vec4(0.4f, 0.6f, 1.0f, 1.0f));
+        createMaterial(0, glm::vec4(1.0f, 0.8f, 0.2f, 1.0f));
+
         return 0;
     }
 
-    void RenderFrame(ImDrawData* draw_data)
+    void RenderFrame(const FramePacket& framePacket)
     {
         static uint32_t imageIndex = 0;
         static uint32_t frameNumber = 0;
-        VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frames[frameNumber].semaphoreImageAvailable, nullptr, &imageIndex);
+
+        // Even a packet that is not rendered changes the transforms, later frames must not miss them
+        storeTransformRanges(framePacket);
+
+        // A minimized window has no framebuffer to render into
+        if (framePacket.framebufferSize.width == 0 || framePacket.framebufferSize.height == 0)
+            return;
+
+        currentFramePacket = &framePacket;
+        framebufferSize = framePacket.framebufferSize;
+        cameraPosition = glm::mix(framePacket.previousEye, framePacket.uboValues.eye, framePacket.interpolationFactor);
+
+        pipelineVariantFeatures = (framePacket.texturing ? PIPELINE_VARIANT_TEXTURING : 0) |
+            ((framePacket.debugVisualization << PIPELINE_VARIANT_DEBUG_VISUALIZATION_SHIFT) & PIPELINE_VARIANT_DEBUG_VISUALIZATION_MASK);
+
+        // All variants this frame may use are queued for the compile threads. A new combination of features is drawn with the
+        // fallbacks until its pipelines are published, the frame never waits for them.
+        for (uint32_t state = 0; state <= PIPELINE_VARIANT_STATE_MASK; state++)
+        {
+            pipelineVariants.request(state | pipelineVariantFeatures);
+            pipelineVariants.request(state | pipelineVariantFeatures | PIPELINE_VARIANT_PUSH_CONSTANT_DRAWS);
+        }
+
+        // wait indefinitely instead of periodically checking
+        // Everything indexed by frameNumber (semaphores, buffers, descriptors) is free again after this
+        VkResult result = vkWaitForFences(device, 1, &frames[frameNumber].fenceCommandBufferDone, VK_TRUE, UINT64_MAX);
+        evaluteVulkanResult(result);
+
+        {
+            // The culled commands of the last submission of this frame were copied behind the commands of the CPU
+            const FrameData& frame = frames[frameNumber];
+            const VkDrawIndexedIndirectCommand* culledDrawCommands = frame.mappedDrawCommands + 2 * maxDrawCount;
+            uint32_t drawnTriangleCount = 0;
+
+            for (uint32_t i = 0; i < 2 * frame.drawCount; i++)
+                drawnTriangleCount += culledDrawCommands[i].indexCount / 3 * culledDrawCommands[i].instanceCount;
+
+            g_drawnTriangleCount = drawnTriangleCount;
+
+            // Both timestamps are available after the fence, the query does not wait
+            uint64_t timestamps[2];
+
+            if (frame.timestampsWritten && vkGetQueryPoolResults(device, frame.timestampQueryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+                g_gpuFrameTime = static_cast<float>(timestamps[1] - timestamps[0]) * timestampPeriod / 1000000.0f;
+
+            // The particles drawn by this frame, the simulation stands still while they are disabled
+            g_particleCount = frame.particleCountersWritten ? frame.mappedParticleCounters->draw.instanceCount : 0;
+        }
+
+        result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frames[frameNumber].semaphoreImageAvailable, nullptr, &imageIndex);
         evaluteVulkanResult(result);
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -1962,13 +4961,14 @@ namespace VulkanPrototype::Renderer
             return;
         }
 
-        // wait indefinitely instead of periodically checking
-        result = vkWaitForFences(device, 1, &frames[frameNumber].fenceCommandBufferDone, VK_TRUE, UINT64_MAX);
-        evaluteVulkanResult(result);
+        // Filling the buffers and recording the commands, without the waits for the fence and the swapchain
+        auto recordStartTime = std::chrono::steady_clock::now();
 
         result = vkResetFences(device, 1, &frames[frameNumber].fenceCommandBufferDone);
         evaluteVulkanResult(result);
 
+        frames[frameNumber].descriptorAllocator.reset();
+
         /*result = vkResetCommandPool(device, commandPool, 0);
         evaluteVulkanResult(result);*/
 
@@ -1986,9 +4986,44 @@ namespace VulkanPrototype::Renderer
 
             result = vkBeginCommandBuffer(frames[frameNumber].mainCommandBuffer, &info);
             evaluteVulkanResult(result);
+
+            frames[frameNumber].boundGraphicsState = {};
+
+            if (frames[frameNumber].timestampQueryPool != VK_NULL_HANDLE)
+            {
+                vkCmdResetQueryPool(frames[frameNumber].mainCommandBuffer, frames[frameNumber].timestampQueryPool, 0, 2);
+                vkCmdWriteTimestamp(frames[frameNumber].mainCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frames[frameNumber].timestampQueryPool, 0);
+            }
         }
 
-        { 
+        // Loaded assets become visible a few frames later, the streamed meshes already in this frame
+        uploadAssets(frames[frameNumber]);
+
+        // Before the objects are built, they may already use the meshes uploaded by this frame
+        streamMeshes(frames[frameNumber]);
+
+        updateUniformBuffer(frameNumber);
+
+        // Outside of the render pass, the fragment shader waits for the light lists
+        cullLights(frames[frameNumber]);
+
+        // Emission and simulation only need the particles of the last frame, they are drawn after the objects
+        bool particlesEnabled = framePacket.particles;
+        frames[frameNumber].particleCountersWritten = false;
+
+        if (particlesEnabled)
+            updateParticles(frames[frameNumber]);
+
+        // The meshes are still loading on the worker threads
+        bool drawObjectsEnabled = frames[frameNumber].drawCount > 0;
+        bool occlusionCullingEnabled = drawObjectsEnabled && framePacket.occlusionCulling;
+        bool phase0Enabled = drawObjectsEnabled || !directDraws.empty();
+
+        // Phase 0 selects the objects that were visible in the last frame, or all of them without occlusion culling
+        if (drawObjectsEnabled)
+            cullObjects(frames[frameNumber], 0);
+
+        {
             std::array<VkClearValue, 2> clearValues{};
             clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
             clearValues[1].depthStencil = { 1.0f, 0 };
@@ -2007,33 +5042,74 @@ namespace VulkanPrototype::Renderer
             vkCmdBeginRenderPass(frames[frameNumber].mainCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
         }
 
-        updateUniformBuffer(imageIndex);
+        // Subpass 0 only writes the depth, with the prepass disabled it is empty
+        bool depthPrepassEnabled = phase0Enabled && framePacket.depthPrepass;
+
+        if (depthPrepassEnabled)
+            drawObjects(frames[frameNumber], 0, true);
+
+        vkCmdNextSubpass(frames[frameNumber].mainCommandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+
+        if (phase0Enabled)
+            drawObjects(frames[frameNumber], 0, false);
+
+        vkCmdEndRenderPass(frames[frameNumber].mainCommandBuffer);
+
+        // Phase 1 tests every object against the depth of phase 0 and selects the ones that became visible
+        if (occlusionCullingEnabled)
+        {
+            buildDepthPyramid(frames[frameNumber]);
+            cullObjects(frames[frameNumber], 1);
+        }
+
+        {
+            VkRenderPassBeginInfo renderPassBeginInfo =
+            {
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .pNext = nullptr,
+                .renderPass = renderPassLoad,
+                .framebuffer = framebuffers[imageIndex],
+                .renderArea = {{0, 0}, g_windowSize},
+                .clearValueCount = 0,
+                .pClearValues = nullptr
+            };
+
+            vkCmdBeginRenderPass(frames[frameNumber].mainCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        if (occlusionCullingEnabled && depthPrepassEnabled)
+            drawObjects(frames[frameNumber], frames[frameNumber].drawCount, true);
 
-        VkPipeline graphicsPipeline = g_polygonMode == VK_POLYGON_MODE_FILL ? pipeline : wireframePipeline;
-        vkCmdBindPipeline(frames[frameNumber].mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        vkCmdNextSubpass(frames[frameNumber].mainCommandBuffer, VK_SUBPASS_CONTENTS_INLINE);
 
-        VkBuffer vertexBuffers[] = { vertexBuffer.buffer };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(frames[frameNumber].mainCommandBuffer, 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(frames[frameNumber].mainCommandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
-        vkCmdBindDescriptorSets(frames[frameNumber].mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frames[imageIndex].descriptorSet, 0, nullptr);
+        if (occlusionCullingEnabled)
+            drawObjects(frames[frameNumber], frames[frameNumber].drawCount, false);
 
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 1);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 2);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 3);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 4);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 5);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 6);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 7);
-        vkCmdDrawIndexed(frames[frameNumber].mainCommandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 8);
+        // Blended over the objects of both phases and tested against their depth
+        if (particlesEnabled)
+            drawParticles(frames[frameNumber]);
 
         // Record dear imgui primitives into command buffer
-        ImGui_ImplVulkan_RenderDrawData(draw_data, frames[frameNumber].mainCommandBuffer);
+        // The backend only reads the draw data, it just predates const correctness
+        ImGui_ImplVulkan_RenderDrawData(const_cast<ImDrawData*>(&framePacket.drawData), frames[frameNumber].mainCommandBuffer);
+
+        g_pipelineVariantCount = pipelineVariants.getVariantCount();
+        g_pendingPipelineVariantCount = pipelineVariants.getPendingCount();
+        g_stateBindCount = frames[frameNumber].boundGraphicsState.bindCount;
+        g_skippedStateBindCount = frames[frameNumber].boundGraphicsState.skippedBindCount;
 
         // Submit command buffer
         vkCmdEndRenderPass(frames[frameNumber].mainCommandBuffer);
 
+        if (drawObjectsEnabled)
+            copyDrawCommandsToHost(frames[frameNumber]);
+
+        if (frames[frameNumber].timestampQueryPool != VK_NULL_HANDLE)
+        {
+            vkCmdWriteTimestamp(frames[frameNumber].mainCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[frameNumber].timestampQueryPool, 1);
+            frames[frameNumber].timestampsWritten = true;
+        }
+
         VkPipelineStageFlags waitStageMask[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
         VkSubmitInfo submitInfo =
         {
@@ -2052,6 +5128,9 @@ namespace VulkanPrototype::Renderer
 
         vkQueueSubmit(queue, 1, &submitInfo, frames[frameNumber].fenceCommandBufferDone);
 
+        g_cpuFrameTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStartTime).count();
+        g_renderedFrameCount++;
+
         VkPresentInfoKHR presentInfo =
         {
             .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -2073,4 +5152,22 @@ namespace VulkanPrototype::Renderer
 
         frameNumber = (frameNumber + 1) % imageCount;
     }
+
+    void StreamMesh(StreamedMesh&& mesh)
+    {
+        if (mesh.slot >= maxStreamedMeshCount)
+            throw std::runtime_error("Es gibt nur " + std::to_string(maxStreamedMeshCount) + " Streaming Slots!");
+
+        std::lock_guard<std::mutex> lock(streamedMeshMutex);
+
+        // Only the newest mesh of a slot is uploaded, it keeps the place of the queued one
+        auto queuedMesh = std::find_if(streamedMeshQueue.begin(), streamedMeshQueue.end(), [&mesh](const StreamedMesh& queued) { return queued.slot == mesh.slot; });
+
+        if (queuedMesh != streamedMeshQueue.end())
+            *queuedMesh = std::move(mesh);
+        else
+            streamedMeshQueue.push_back(std::move(mesh));
+
+        g_pendingStreamedMeshCount = static_cast<uint32_t>(streamedMeshQueue.size());
+    }
 }
\ No newline at end of file
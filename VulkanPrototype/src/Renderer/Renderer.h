@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -22,13 +23,159 @@
 
 namespace VulkanPrototype::Renderer
 {
+    /*
+    * Helper Structs for the Renderer
+    */
+
+    /// <summary>
+    /// Ein zu zeichnendes Objekt, geschrieben von der Render Extraction der Szene.
+    /// </summary>
+    struct RenderObject
+    {
+        glm::mat4 worldMatrix;
+
+        // Position before the last fixed simulation step, RenderFrame interpolates the translation of worldMatrix from there
+        glm::vec3 previousPosition;
+
+        uint32_t meshIndex;
+        uint32_t materialIndex;
+
+        // Stays the same over the frames, the occlusion culling remembers which objects were visible by it
+        uint32_t objectId;
+
+        // Slot in the transform buffer that the transform ranges of the frame packets keep up to date, or noTransformIndex
+        // for objects whose transform is only in this packet
+        uint32_t transformIndex;
+    };
+
+    static const uint32_t noTransformIndex = UINT32_MAX;
+
+    /// <summary>
+    /// Punktlicht in Weltkoordinaten, das Licht faellt bis zum Radius auf null ab.
+    /// </summary>
+    struct RenderLight
+    {
+        glm::vec3 position;
+        float radius;
+        glm::vec3 color;
+    };
+
+    /// <summary>
+    /// Quelle der GPU Partikel. Pro Sekunde werden rate Partikel auf einer Scheibe mit dem Radius um position ausgestossen
+    /// und fliegen mit etwa speed nach oben, bis sie nach hoechstens lifetime Sekunden sterben.
+    /// </summary>
+    struct ParticleEmitter
+    {
+        glm::vec3 position;
+        float radius;
+        float rate;
+        float lifetime;
+        float speed;
+        float size;
+    };
+
+    // Slots for meshes that are replaced at runtime, like the chunks of the voxel world
+    static const uint32_t maxStreamedMeshCount = 4096;
+
+    // The occlusion culling stores one bit per object id, objects with larger ids are always drawn
+    static const uint32_t maxVisibilityObjectCount = 1 << 21;
+
+    /// <summary>
+    /// Mesh fuer einen Streaming Slot, die Positionen sind mit quantization quantisiert. Ein Mesh ohne Vertices leert den Slot.
+    /// </summary>
+    struct StreamedMesh
+    {
+        uint32_t slot;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        VertexQuantization quantization;
+    };
+
+    /// <summary>
+    /// Alles, was RenderFrame von der Simulation braucht. Der Hauptthread fuellt das Paket und veraendert es danach nicht mehr,
+    /// so kann RenderFrame auf einem eigenen Thread laufen, waehrend schon der naechste Frame simuliert wird.
+    /// </summary>
+    struct FramePacket
+    {
+        UBOValues uboValues;
+        VkPolygonMode polygonMode;
+        float lodPixelError;
+        bool occlusionCulling;
+        bool depthPrepass;
+        bool pushConstantDraws;
+
+        // Shader features, each combination is its own pipeline variant
+        bool texturing;
+        uint32_t debugVisualization;
+
+        // Queried on the main thread, GLFW must not be called from the render thread
+        VkExtent2D framebufferSize;
+
+        std::vector<RenderObject> objects;
+
+        // Slots of the transform buffer changed since the last packet and their new transforms, one after another in the
+        // order of the ranges. The slots from transformCount on are free for the transforms of this packet.
+        std::vector<TransformRange> transformRanges;
+        std::vector<ObjectTransform> transforms;
+        uint32_t transformCount;
+
+        // Few objects that change every frame. With pushConstantDraws they are drawn one by one with their data in the
+        // push constants, without culling and without a write to the object buffer.
+        std::vector<RenderObject> dynamicObjects;
+        std::vector<RenderLight> lights;
+
+        // Emission, simulation and the draw of the particles run on the GPU, the CPU only knows the emitter
+        bool particles;
+        ParticleEmitter particleEmitter;
+
+        // State before the last fixed simulation step, RenderFrame interpolates towards the current state by this factor
+        glm::vec3 previousEye;
+        float interpolationFactor;
+
+        // Copies of the ImGui draw lists, ImGui overwrites its own in the next NewFrame
+        ImDrawData drawData;
+        std::vector<ImDrawList*> drawLists;
+
+        FramePacket() = default;
+        FramePacket(const FramePacket&) = delete;
+        FramePacket& operator=(const FramePacket&) = delete;
+
+        ~FramePacket()
+        {
+            for (ImDrawList* drawList : drawLists)
+                IM_DELETE(drawList);
+        }
+    };
+
     /*
      * Global Functions
      */
 
     void Cleanup();
     int  Initialize();
-    void RenderFrame(ImDrawData* draw_data);
+
+    /// <summary>
+    /// Kopiert die Draw Lists von ImGui::Render() in das Paket, die vorherigen Kopien des Pakets werden freigegeben.
+    /// </summary>
+    void CopyDrawData(const ImDrawData* drawData, FramePacket& framePacket);
+
+    /// <summary>
+    /// Projektion * View * Model wie in shader.vert, fuer Culling und Picking auf dem Hauptthread.
+    /// </summary>
+    glm::mat4 GetViewProjectionMatrix(const UBOValues& uboValues, const glm::vec3& eye, float aspectRatio);
+
+    /// <summary>
+    /// Mesh Index, mit dem RenderObjects den Streaming Slot zeichnen. Leere oder noch nicht hochgeladene Slots werden nicht gezeichnet.
+    /// </summary>
+    uint32_t GetStreamedMeshIndex(uint32_t slot);
+
+    void RenderFrame(const FramePacket& framePacket);
+
+    /// <summary>
+    /// Reiht das Mesh fuer den Upload ein, RenderFrame kopiert pro Frame so viele, wie in seinen Staging Buffer passen.
+    /// Ein noch wartendes Mesh fuer denselben Slot wird ersetzt. Darf von jedem Thread aufgerufen werden.
+    /// </summary>
+    void StreamMesh(StreamedMesh&& mesh);
 
     /*
      * Global Variables
@@ -37,6 +184,48 @@ namespace VulkanPrototype::Renderer
     extern VkExtent2D g_windowSize;
     extern UBOValues g_uboValues;
     extern VkPolygonMode g_polygonMode;
+
+    // Screen space error in pixels up to which coarser LODs are used
+    extern float g_lodPixelError;
+
+    // Objects hidden behind the depth of the objects that were visible in the last frame are not drawn
+    extern bool g_occlusionCulling;
+
+    // Written by RenderFrame, which may run on the render thread. Known once the GPU has culled the frame, so a few frames late.
+    extern std::atomic<uint32_t> g_drawnTriangleCount;
+
+    // Pipeline, index buffer and descriptor set binds of the objects in the last recorded frame, and the redundant ones that were skipped
+    extern std::atomic<uint32_t> g_stateBindCount;
+    extern std::atomic<uint32_t> g_skippedStateBindCount;
+
+    // Depth only pass over the filled objects before the color pass, which then shades only fragments with equal depth
+    extern bool g_depthPrepass;
+
+    // Time between the first and the last command of a frame on the GPU in milliseconds, 0 without timestamp support
+    extern std::atomic<float> g_gpuFrameTime;
+
+    // Draws the dynamic objects of the frame packets with push constants instead of through the object buffer
+    extern bool g_pushConstantDraws;
+
+    // Time of RenderFrame for filling the buffers and recording the command buffer in milliseconds
+    extern std::atomic<float> g_cpuFrameTime;
+
+    // Frames RenderFrame has submitted so far, with the render thread the main loop can run more often than this
+    extern std::atomic<uint64_t> g_renderedFrameCount;
+
+    // Shader features of the next frame packets, texturing and one of the DebugVisualization views
+    extern bool g_texturing;
+    extern uint32_t g_debugVisualization;
+
+    // Pipeline variants created so far, identical variants are counted once, and those still waiting for the compile threads
+    extern std::atomic<uint32_t> g_pipelineVariantCount;
+    extern std::atomic<uint32_t> g_pendingPipelineVariantCount;
+
+    // Particles drawn in the last frames, read back from the GPU a few frames late
+    extern std::atomic<uint32_t> g_particleCount;
+
+    // Meshes waiting in the queue of StreamMesh
+    extern std::atomic<uint32_t> g_pendingStreamedMeshCount;
 }
 
 #endif // RENDERER_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define RENDERERUTILS_H
 
 #include <array>
+#include <cstddef>
 #include <fstream>
 #include <optional>
 #include <vector>
@@ -9,8 +10,14 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
 #include <glm/glm.hpp>
+#include <glm/gtc/type_aligned.hpp>
 #include <vulkan/vulkan.h>
 
+#include "DescriptorAllocator.h"
+#include "GeometryAllocator.h"
+#include "MeshFormat.h"
+#include "VertexLayout.h"
+
 namespace VulkanPrototype::Renderer
 {
     /*
@@ -23,6 +30,101 @@ namespace VulkanPrototype::Renderer
         VkDeviceMemory bufferMemory;
     };
 
+    // Persistent per transform slot, only the slots that changed since the last frame are copied into the transform buffer
+    struct ObjectTransform
+    {
+        // Rows of the world matrix, its last row is always (0, 0, 0, 1)
+        glm::vec4 worldMatrixRows[3];
+
+        // Translation before the last fixed simulation step, the shaders interpolate towards the one in the rows
+        glm::vec4 previousPosition;
+    };
+
+    // Has to match the std430 layout of TransformBuffer in shader.vert, depthPrepass.vert and occlusionCulling.comp
+    static_assert(sizeof(ObjectTransform) == 64 && offsetof(ObjectTransform, previousPosition) == 48);
+
+    // Consecutive slots of the transform buffer
+    struct TransformRange
+    {
+        uint32_t firstTransform;
+        uint32_t transformCount;
+    };
+
+    // Written every frame in the order of the draw keys
+    struct GameObjectData
+    {
+        uint32_t transformIndex;
+        uint32_t materialIndex;
+        uint32_t meshIndex;
+
+        // Draw command of the mesh and LOD, and the stable id the occlusion culling remembers the visibility by
+        uint32_t drawIndex;
+        uint32_t objectId;
+    };
+
+    // Has to match the std430 layout of GameObjectBuffer in shader.vert and occlusionCulling.comp
+    static_assert(sizeof(GameObjectData) == 20 && offsetof(GameObjectData, materialIndex) == 4 && offsetof(GameObjectData, meshIndex) == 8 && offsetof(GameObjectData, objectId) == 16);
+
+    // Per draw data of the direct draws in the push constants of pipelineLayout, 64 of the 128 bytes every device supports
+    struct DrawPushConstants
+    {
+        // Rows of the world matrix like in ObjectTransform, already interpolated
+        glm::vec4 worldMatrixRows[3];
+
+        // Stable id of the object, the instanced draws read everything from the object buffer instead
+        uint32_t objectIndex;
+        uint32_t materialIndex;
+        uint32_t meshIndex;
+        uint32_t lod;
+    };
+
+    // Has to match DrawParameters in shader.vert and depthPrepass.vert
+    static_assert(sizeof(DrawPushConstants) == 64 && offsetof(DrawPushConstants, objectIndex) == 48);
+
+    // Small dynamic objects are drawn one by one with their data in the push constants, nothing is written to a buffer for them
+    struct DirectDraw
+    {
+        DrawPushConstants pushConstants;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+    };
+
+    struct LightData
+    {
+        // View space position and radius, the light falls off to zero at the radius
+        glm::vec4 positionRadius;
+        glm::vec4 color;
+    };
+
+    // Has to match the std430 layout of LightBuffer in lightCulling.comp and shader.frag
+    static_assert(sizeof(LightData) == 32);
+
+    // Has to match ParticleCounterBuffer in the particle shaders. Only written on the GPU, particleArguments.comp turns the
+    // counts into the arguments of the indirect dispatches and the indirect draw.
+    struct ParticleCounters
+    {
+        VkDispatchIndirectCommand emitDispatch;
+        uint32_t emitCount;
+        VkDispatchIndirectCommand simulateDispatch;
+        uint32_t deadCount;
+        VkDrawIndirectCommand draw;
+        uint32_t aliveCounts[2];
+    };
+
+    static_assert(sizeof(ParticleCounters) == 56);
+
+    // Graphics state bound in the command buffer of a frame, binding the same state again is skipped
+    struct BoundGraphicsState
+    {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        bool frameDescriptors = false;
+
+        uint32_t bindCount = 0;
+        uint32_t skippedBindCount = 0;
+    };
+
     struct FrameData
     {
         VkSemaphore     semaphoreImageAvailable;
@@ -35,12 +137,199 @@ namespace VulkanPrototype::Renderer
         AllocatedBuffer uniformBuffer;
         AllocatedBuffer objectBuffer;
 
-        VkDescriptorSet descriptorSet;
+        // Transforms of the hierarchy in its slot order, followed by the transforms that only live in the current frame packet
+        AllocatedBuffer transformBuffer;
+
+        // Slots changed by the frame packets since this frame last wrote its transform buffer
+        std::vector<TransformRange> pendingTransformRanges;
+
+        // Host side of the draw commands: the commands of both culling phases as written by the CPU, followed by a copy of
+        // the culled commands of the last submission of this frame
+        AllocatedBuffer indirectBuffer;
+
+        // Device side of the draw commands, occlusionCulling.comp counts the instances and writes their objects into visibleInstanceBuffer
+        AllocatedBuffer drawCommandBuffer;
+        AllocatedBuffer visibleInstanceBuffer;
+        uint32_t drawCount = 0;
+        uint32_t objectCount = 0;
+
+        // Clustered lighting: the lights of the frame, offset and count per cluster and the light index lists of all clusters.
+        // The last two are written by lightCulling.comp, which starts every frame with an empty list.
+        AllocatedBuffer lightBuffer;
+        AllocatedBuffer clusterBuffer;
+        AllocatedBuffer lightIndexBuffer;
+
+        // Persistently mapped, these buffers are host coherent
+        GameObjectData* mappedObjects = nullptr;
+        ObjectTransform* mappedTransforms = nullptr;
+        VkDrawIndexedIndirectCommand* mappedDrawCommands = nullptr;
+        LightData* mappedLights = nullptr;
+
+        // Transient descriptor sets, reset once the frame's fence was waited on
+        DescriptorAllocator descriptorAllocator;
+
+        // Reset when the command buffer is recorded again
+        BoundGraphicsState boundGraphicsState;
+
+        // Two timestamps around the command buffer, read back once the fence was waited on
+        VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+        bool timestampsWritten = false;
+
+        // Copy of the particle counters at the end of the frame, persistently mapped like the indirect buffer
+        AllocatedBuffer particleCounterReadbackBuffer;
+        ParticleCounters* mappedParticleCounters = nullptr;
+        bool particleCountersWritten = false;
+
+        // Staging memory of the streamed meshes, persistently mapped. The geometry of replaced meshes is freed once the fence
+        // of this frame was waited on, the frames in flight before it may still draw them.
+        AllocatedBuffer streamingBuffer;
+        uint8_t* mappedStreamingBuffer = nullptr;
+        std::vector<GeometryAllocation> retiredGeometry;
+
+        // Loaded assets copied by this frame's command buffer. They are published and their staging buffers freed once the
+        // fence of this frame was waited on, until then the objects draw without them.
+        std::vector<MeshUpload> meshUploads;
+        std::vector<TextureUpload> textureUploads;
     };
 
-    struct GameObjectData
+    // Source data for the frame descriptor update templates, one entry per binding of set 0. The light culling set uses a part of them.
+    struct FrameDescriptors
     {
-        glm::vec3 globalPosition;
+        VkDescriptorBufferInfo uniformBuffer;
+        VkDescriptorBufferInfo objectBuffer;
+        VkDescriptorBufferInfo lightBuffer;
+        VkDescriptorBufferInfo clusterBuffer;
+        VkDescriptorBufferInfo lightIndexBuffer;
+        VkDescriptorBufferInfo visibleInstanceBuffer;
+        VkDescriptorBufferInfo transformBuffer;
+    };
+
+    // Source data for the occlusion culling update template, in the order of the bindings
+    struct CullingDescriptors
+    {
+        VkDescriptorBufferInfo uniformBuffer;
+        VkDescriptorBufferInfo objectBuffer;
+        VkDescriptorBufferInfo meshBuffer;
+        VkDescriptorBufferInfo drawCommandBuffer;
+        VkDescriptorBufferInfo visibleInstanceBuffer;
+        VkDescriptorBufferInfo visibilityBuffer;
+        VkDescriptorImageInfo depthPyramid;
+        VkDescriptorBufferInfo transformBuffer;
+    };
+
+    // Has to match CullingParameters in occlusionCulling.comp
+    struct CullingParameters
+    {
+        uint32_t objectCount;
+        uint32_t drawCount;
+        uint32_t phase;
+        uint32_t occlusionCulling;
+    };
+
+    // One level of the depth pyramid is reduced from the level above it, or from the depth image for level 0
+    struct DepthPyramidDescriptors
+    {
+        VkDescriptorImageInfo source;
+        VkDescriptorImageInfo destination;
+    };
+
+    // Has to match PyramidParameters in depthPyramid.comp
+    struct DepthPyramidParameters
+    {
+        uint32_t sourceSize[2];
+        uint32_t destinationSize[2];
+    };
+
+    // Source data for the particle update templates, in the order of the bindings. The particles are stored as a structure of
+    // arrays, the emission takes free indices from the dead list and the simulation compacts the alive ones into the other list.
+    struct ParticleDescriptors
+    {
+        VkDescriptorBufferInfo uniformBuffer;
+        VkDescriptorBufferInfo positionBuffer;
+        VkDescriptorBufferInfo velocityBuffer;
+        VkDescriptorBufferInfo colorBuffer;
+        VkDescriptorBufferInfo deadListBuffer;
+        VkDescriptorBufferInfo aliveListBuffer;
+        VkDescriptorBufferInfo counterBuffer;
+    };
+
+    // Has to match ParticleParameters in the particle shaders, the push constants of all particle passes
+    struct ParticleParameters
+    {
+        glm::vec4 emitterPositionRadius;
+        glm::vec4 gravityTimeStep;
+        uint32_t emitCount;
+        uint32_t maxParticleCount;
+
+        // The alive list that is read, the simulation writes the other one
+        uint32_t aliveList;
+
+        // Only for particleArguments.comp: 0 before the emission, 1 before the simulation, 2 before the draw
+        uint32_t stage;
+
+        uint32_t seed;
+        float lifetime;
+        float speed;
+        float size;
+    };
+
+    static_assert(sizeof(ParticleParameters) == 64);
+
+    struct MaterialData
+    {
+        glm::vec4 baseColor;
+        uint32_t textureIndex;
+        uint32_t padding[3];
+    };
+
+    // Has to match the std430 layout of MaterialBuffer in shader.frag
+    static_assert(sizeof(MaterialData) == 32);
+
+    struct MeshLod
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;                // Object space, projected onto the screen to select the LOD
+    };
+
+    struct Mesh
+    {
+        // Ranges of the geometry buffer, freed together with the mesh
+        GeometryAllocation vertexAllocation;
+        GeometryAllocation indexAllocation;
+
+        // Position of the ranges in vertices and indices, as expected by the draw commands
+        int32_t vertexOffset;
+        uint32_t firstIndex;
+
+        std::vector<MeshLod> lods;
+        glm::vec4 boundingSphere;
+    };
+
+    // Dequantization of QuantizedVertex positions, has to match the std430 layout of MeshBuffer in shader.vert
+    struct MeshData
+    {
+        glm::vec4 positionScale;
+        glm::vec4 positionOffset;
+    };
+
+    static_assert(sizeof(MeshData) == 32);
+
+    struct MeshUpload
+    {
+        // Vertices at offset 0, indices directly behind them and the positions of the depth prepass at the end.
+        // Indices are always 32 bit in the geometry buffer.
+        AllocatedBuffer stagingBuffer;
+        uint64_t vertexSize;
+        uint64_t indexSize;
+        uint64_t positionSize;
+        uint32_t indexCount;
+        VertexQuantization quantization;
+        std::vector<MeshLod> lods;
+
+        // Filled when the copies are recorded, the mesh is moved to meshIndex once they are done
+        uint32_t meshIndex;
+        Mesh mesh;
     };
 
     struct QueueFamily
@@ -56,22 +345,81 @@ namespace VulkanPrototype::Renderer
         std::vector<VkPresentModeKHR> presentModes;
     };
 
+    struct Texture
+    {
+        VkImage image;
+        VkImageView imageView;
+        VkDeviceMemory imageMemory;
+    };
+
+    struct TextureUpload
+    {
+        AllocatedBuffer stagingBuffer;
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        std::vector<VkBufferImageCopy> regions;
+
+        // The slot shows the placeholder until the copies into texture are done
+        uint32_t textureIndex;
+        Texture texture;
+    };
+
     struct UniformBufferObject
     {
         alignas(16) glm::mat4 model;
         alignas(16) glm::mat4 view;
         alignas(16) glm::mat4 proj;
+
+        // Framebuffer width and height, near and far plane. The light clusters are built from these and proj.
+        alignas(16) glm::vec4 clusterParameters;
+        uint32_t lightCount;
+
+        // Between the last two fixed simulation steps, for the translations in the transform buffer
+        float interpolationFactor;
     };
 
-    struct Vertex
+    using Vertex = QuantizedVertex;
+
+    /*
+    * Vertex Input Descriptions, generated from the VertexLayout at compile time
+    *
+    * The mesh pipeline pulls its vertices in shader.vert, these are for pipelines with fixed function vertex input.
+    */
+
+    static_assert(float2::format == VK_FORMAT_R32G32_SFLOAT && float3::format == VK_FORMAT_R32G32B32_SFLOAT);
+    static_assert(half2::format == VK_FORMAT_R16G16_SFLOAT && snorm16x4::format == VK_FORMAT_R16G16B16A16_SNORM && unorm8x4::format == VK_FORMAT_R8G8B8A8_UNORM);
+
+    template<typename Layout>
+    constexpr std::array<VkVertexInputAttributeDescription, Layout::attributeCount> getAttributeDescriptions(uint32_t binding = 0)
     {
-        glm::vec3 pos;
-        glm::vec3 color;
-        glm::vec2 textureCoordinate;
+        std::array<VkVertexInputAttributeDescription, Layout::attributeCount> attributeDescriptions = {};
 
-        static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
-        static VkVertexInputBindingDescription getBindingDescription();
-    };
+        // The shader locations follow the order of the attributes
+        for (uint32_t i = 0; i < Layout::attributeCount; i++)
+        {
+            attributeDescriptions[i] =
+            {
+                .location = i,
+                .binding = binding,
+                .format = static_cast<VkFormat>(Layout::formats[i]),
+                .offset = Layout::offsets[i]
+            };
+        }
+
+        return attributeDescriptions;
+    }
+
+    template<typename Layout>
+    constexpr VkVertexInputBindingDescription getBindingDescription(uint32_t binding = 0)
+    {
+        return
+        {
+            .binding = binding,
+            .stride = Layout::stride,
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+        };
+    }
 
     struct UBOValues
     {
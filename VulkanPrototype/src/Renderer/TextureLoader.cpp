@@ -0,0 +1,741 @@
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * File Format Definitions
+    */
+
+    static const uint8_t ktx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    // A 32 bit extent never has more than 32 mip levels, anything above that is a corrupt header
+    static const uint32_t maxLevelCount = 32;
+
+    struct Ktx2Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct Ktx2LevelIndex
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    struct DdsPixelFormat
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t rBitMask;
+        uint32_t gBitMask;
+        uint32_t bBitMask;
+        uint32_t aBitMask;
+    };
+
+    struct DdsHeader
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DdsPixelFormat pixelFormat;
+        uint32_t caps;
+        uint32_t caps2;
+        uint32_t caps3;
+        uint32_t caps4;
+        uint32_t reserved2;
+    };
+
+    struct DdsHeaderDx10
+    {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must be tightly packed");
+    static_assert(sizeof(DdsHeader) == 124, "DDS header must be tightly packed");
+
+    /*
+    * BC7 Tables
+    */
+
+    struct Bc7Mode
+    {
+        uint32_t subsetCount;
+        uint32_t partitionBits;
+        uint32_t rotationBits;
+        uint32_t indexSelectionBits;
+        uint32_t colorBits;
+        uint32_t alphaBits;
+        uint32_t endpointPBits;
+        uint32_t sharedPBits;
+        uint32_t indexBits;
+        uint32_t secondaryIndexBits;
+    };
+
+    static const Bc7Mode bc7Modes[8] =
+    {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+    };
+
+    // Bit i is the subset of texel i
+    static const uint16_t bc7Partitions2[64] =
+    {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+    };
+
+    // Bits 2i and 2i + 1 are the subset of texel i
+    static const uint32_t bc7Partitions3[64] =
+    {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+    };
+
+    // The anchor texel of subset 0 is always texel 0
+    static const uint8_t bc7Anchors2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+    };
+
+    static const uint8_t bc7Anchors3Subset1[64] =
+    {
+         3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+         3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+         8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+         3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+    };
+
+    static const uint8_t bc7Anchors3Subset2[64] =
+    {
+        15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+        15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+        15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+        15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+    };
+
+    static const uint32_t bc7Weights2[4] = { 0, 21, 43, 64 };
+    static const uint32_t bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    static const uint32_t bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    static constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    /*
+     * Private Utility Functions
+     */
+
+    static uint32_t getBlockSize(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    static VkFormat getFormatFromDxgi(uint32_t dxgiFormat)
+    {
+        switch (dxgiFormat)
+        {
+        case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK; // DXGI_FORMAT_BC1_UNORM
+        case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;  // DXGI_FORMAT_BC1_UNORM_SRGB
+        case 77: return VK_FORMAT_BC3_UNORM_BLOCK;      // DXGI_FORMAT_BC3_UNORM
+        case 78: return VK_FORMAT_BC3_SRGB_BLOCK;       // DXGI_FORMAT_BC3_UNORM_SRGB
+        case 98: return VK_FORMAT_BC7_UNORM_BLOCK;      // DXGI_FORMAT_BC7_UNORM
+        case 99: return VK_FORMAT_BC7_SRGB_BLOCK;       // DXGI_FORMAT_BC7_UNORM_SRGB
+        default: return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    static void decodeColor565(uint16_t color, uint8_t* rgba)
+    {
+        uint8_t r = (color >> 11) & 0x1F;
+        uint8_t g = (color >> 5) & 0x3F;
+        uint8_t b = color & 0x1F;
+
+        rgba[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        rgba[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        rgba[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        rgba[3] = 255;
+    }
+
+    // Decodes the 8 byte color part of a BC1/BC3 block into 16 RGBA texels. Only BC1 knows the 3 color mode.
+    static void decodeColorBlock(const uint8_t* block, uint8_t* texels, bool isBC1, bool hasAlpha)
+    {
+        uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+        uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+        uint8_t palette[4][4];
+        decodeColor565(color0, palette[0]);
+        decodeColor565(color1, palette[1]);
+
+        if (color0 > color1 || !isBC1)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 255;
+        }
+        else
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = hasAlpha ? 0 : 255;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            memcpy(&texels[i * 4], palette[(indices >> (i * 2)) & 0x3], 4);
+        }
+    }
+
+    // Decodes the 8 byte alpha part of a BC3 block into the alpha channel of 16 RGBA texels.
+    static void decodeAlphaBlock(const uint8_t* block, uint8_t* texels)
+    {
+        uint8_t alpha[8];
+        alpha[0] = block[0];
+        alpha[1] = block[1];
+
+        if (alpha[0] > alpha[1])
+        {
+            for (int i = 1; i < 7; i++)
+                alpha[i + 1] = static_cast<uint8_t>(((7 - i) * alpha[0] + i * alpha[1]) / 7);
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+                alpha[i + 1] = static_cast<uint8_t>(((5 - i) * alpha[0] + i * alpha[1]) / 5);
+            alpha[6] = 0;
+            alpha[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++)
+            indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+
+        for (int i = 0; i < 16; i++)
+        {
+            texels[i * 4 + 3] = alpha[(indices >> (i * 3)) & 0x7];
+        }
+    }
+
+    // Reads the bits of a BC7 block LSB first
+    struct Bc7BitReader
+    {
+        const uint8_t* block;
+        uint32_t position;
+
+        uint32_t read(uint32_t count)
+        {
+            uint32_t value = 0;
+
+            for (uint32_t i = 0; i < count; i++, position++)
+                value |= static_cast<uint32_t>((block[position >> 3] >> (position & 7)) & 1) << i;
+
+            return value;
+        }
+    };
+
+    static uint8_t interpolateBc7(uint32_t endpoint0, uint32_t endpoint1, uint32_t index, uint32_t indexBits)
+    {
+        const uint32_t* weights = indexBits == 2 ? bc7Weights2 : indexBits == 3 ? bc7Weights3 : bc7Weights4;
+        uint32_t weight = weights[index];
+
+        return static_cast<uint8_t>(((64 - weight) * endpoint0 + weight * endpoint1 + 32) >> 6);
+    }
+
+    // Decodes a 16 byte BC7 block into 16 RGBA texels.
+    static void decodeBc7Block(const uint8_t* block, uint8_t* texels)
+    {
+        uint32_t modeIndex = 0;
+        while (modeIndex < 8 && (block[0] & (1 << modeIndex)) == 0)
+            modeIndex++;
+
+        // Blocks without a mode bit are reserved and decode to transparent black
+        if (modeIndex == 8)
+        {
+            memset(texels, 0, 16 * 4);
+            return;
+        }
+
+        const Bc7Mode& mode = bc7Modes[modeIndex];
+        Bc7BitReader reader = { block, modeIndex + 1 };
+
+        uint32_t partition = reader.read(mode.partitionBits);
+        uint32_t rotation = reader.read(mode.rotationBits);
+        uint32_t indexSelection = reader.read(mode.indexSelectionBits);
+
+        uint32_t endpointCount = mode.subsetCount * 2;
+        uint32_t endpoints[6][4] = {};
+
+        // Endpoints are stored channel by channel, all red values first
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            for (uint32_t e = 0; e < endpointCount; e++)
+                endpoints[e][c] = reader.read(mode.colorBits);
+        }
+
+        for (uint32_t e = 0; e < endpointCount && mode.alphaBits > 0; e++)
+            endpoints[e][3] = reader.read(mode.alphaBits);
+
+        uint32_t channelCount = mode.alphaBits > 0 ? 4 : 3;
+
+        if (mode.endpointPBits)
+        {
+            for (uint32_t e = 0; e < endpointCount; e++)
+            {
+                uint32_t pBit = reader.read(1);
+                for (uint32_t c = 0; c < channelCount; c++)
+                    endpoints[e][c] = (endpoints[e][c] << 1) | pBit;
+            }
+        }
+
+        if (mode.sharedPBits)
+        {
+            for (uint32_t s = 0; s < mode.subsetCount; s++)
+            {
+                uint32_t pBit = reader.read(1);
+                for (uint32_t c = 0; c < channelCount; c++)
+                {
+                    endpoints[s * 2][c] = (endpoints[s * 2][c] << 1) | pBit;
+                    endpoints[s * 2 + 1][c] = (endpoints[s * 2 + 1][c] << 1) | pBit;
+                }
+            }
+        }
+
+        // Expand to 8 bit by replicating the high bits into the low bits
+        uint32_t pBits = mode.endpointPBits + mode.sharedPBits;
+        for (uint32_t e = 0; e < endpointCount; e++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                uint32_t precision = (c < 3 ? mode.colorBits : mode.alphaBits) + pBits;
+
+                if (c == 3 && mode.alphaBits == 0)
+                {
+                    endpoints[e][c] = 255;
+                    continue;
+                }
+
+                endpoints[e][c] <<= 8 - precision;
+                endpoints[e][c] |= endpoints[e][c] >> precision;
+            }
+        }
+
+        uint32_t subsets[16];
+        uint32_t anchors[3] = { 0, 0, 0 };
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (mode.subsetCount == 2)
+                subsets[i] = (bc7Partitions2[partition] >> i) & 1;
+            else if (mode.subsetCount == 3)
+                subsets[i] = (bc7Partitions3[partition] >> (i * 2)) & 3;
+            else
+                subsets[i] = 0;
+        }
+
+        if (mode.subsetCount == 2)
+        {
+            anchors[1] = bc7Anchors2[partition];
+        }
+        else if (mode.subsetCount == 3)
+        {
+            anchors[1] = bc7Anchors3Subset1[partition];
+            anchors[2] = bc7Anchors3Subset2[partition];
+        }
+
+        // The anchor texel of each subset stores its index with one bit less, the high bit is implicitly zero
+        uint32_t indices[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            bool isAnchor = i == anchors[subsets[i]];
+            indices[i] = reader.read(isAnchor ? mode.indexBits - 1 : mode.indexBits);
+        }
+
+        uint32_t secondaryIndices[16] = {};
+        for (uint32_t i = 0; i < 16 && mode.secondaryIndexBits > 0; i++)
+            secondaryIndices[i] = reader.read(i == 0 ? mode.secondaryIndexBits - 1 : mode.secondaryIndexBits);
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t* endpoint0 = endpoints[subsets[i] * 2];
+            const uint32_t* endpoint1 = endpoints[subsets[i] * 2 + 1];
+            uint8_t* texel = &texels[i * 4];
+
+            uint32_t colorIndex = indices[i];
+            uint32_t colorIndexBits = mode.indexBits;
+            uint32_t alphaIndex = indices[i];
+            uint32_t alphaIndexBits = mode.indexBits;
+
+            // Modes 4 and 5 have separate indices for color and alpha, mode 4 can swap their roles
+            if (mode.secondaryIndexBits > 0)
+            {
+                if (indexSelection == 0)
+                {
+                    alphaIndex = secondaryIndices[i];
+                    alphaIndexBits = mode.secondaryIndexBits;
+                }
+                else
+                {
+                    colorIndex = secondaryIndices[i];
+                    colorIndexBits = mode.secondaryIndexBits;
+                }
+            }
+
+            for (uint32_t c = 0; c < 3; c++)
+                texel[c] = interpolateBc7(endpoint0[c], endpoint1[c], colorIndex, colorIndexBits);
+            texel[3] = interpolateBc7(endpoint0[3], endpoint1[3], alphaIndex, alphaIndexBits);
+
+            if (rotation > 0)
+                std::swap(texel[3], texel[rotation - 1]);
+        }
+    }
+
+    static bool readKtx2Header(std::ifstream& file, TextureFile& textureFile)
+    {
+        Ktx2Header header;
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (!file || header.supercompressionScheme != 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+            return false;
+
+        textureFile.format = static_cast<VkFormat>(header.vkFormat);
+        textureFile.width = header.pixelWidth;
+        textureFile.height = header.pixelHeight;
+
+        uint32_t levelCount = std::max(header.levelCount, 1u);
+
+        if (levelCount > maxLevelCount)
+            return false;
+
+        std::vector<Ktx2LevelIndex> levelIndex(levelCount);
+        file.read(reinterpret_cast<char*>(levelIndex.data()), sizeof(Ktx2LevelIndex) * levelCount);
+
+        if (!file)
+            return false;
+
+        textureFile.levels.resize(levelCount);
+        for (uint32_t i = 0; i < levelCount; i++)
+        {
+            textureFile.levels[i] =
+            {
+                .fileOffset = levelIndex[i].byteOffset,
+                .size = levelIndex[i].byteLength,
+                .width = std::max(header.pixelWidth >> i, 1u),
+                .height = std::max(header.pixelHeight >> i, 1u)
+            };
+        }
+
+        return true;
+    }
+
+    static bool readDdsHeader(std::ifstream& file, TextureFile& textureFile)
+    {
+        DdsHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (!file || header.size != sizeof(DdsHeader))
+            return false;
+
+        uint64_t dataOffset = sizeof(uint32_t) + sizeof(DdsHeader);
+
+        switch (header.pixelFormat.fourCC)
+        {
+        case makeFourCC('D', 'X', 'T', '1'):
+            textureFile.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+            break;
+        case makeFourCC('D', 'X', 'T', '5'):
+            textureFile.format = VK_FORMAT_BC3_UNORM_BLOCK;
+            break;
+        case makeFourCC('D', 'X', '1', '0'):
+        {
+            DdsHeaderDx10 headerDx10;
+            file.read(reinterpret_cast<char*>(&headerDx10), sizeof(headerDx10));
+
+            if (!file || headerDx10.arraySize > 1)
+                return false;
+
+            textureFile.format = getFormatFromDxgi(headerDx10.dxgiFormat);
+            dataOffset += sizeof(DdsHeaderDx10);
+            break;
+        }
+        default:
+            return false;
+        }
+
+        textureFile.width = header.width;
+        textureFile.height = header.height;
+
+        uint32_t levelCount = std::max(header.mipMapCount, 1u);
+
+        if (levelCount > maxLevelCount)
+            return false;
+
+        textureFile.levels.resize(levelCount);
+
+        for (uint32_t i = 0; i < levelCount; i++)
+        {
+            uint32_t width = std::max(header.width >> i, 1u);
+            uint32_t height = std::max(header.height >> i, 1u);
+            uint64_t size = getTextureLevelSize(textureFile.format, width, height);
+
+            textureFile.levels[i] =
+            {
+                .fileOffset = dataOffset,
+                .size = size,
+                .width = width,
+                .height = height
+            };
+
+            dataOffset += size;
+        }
+
+        return true;
+    }
+
+    // Every level has to have exactly the size of its blocks and has to lie completely inside of the file,
+    // otherwise readTextureFileLevels would overrun the staging buffer or read past the end of the file.
+    static bool validateTextureLevels(std::ifstream& file, const TextureFile& textureFile)
+    {
+        file.clear();
+        file.seekg(0, std::ios::end);
+        std::streamoff end = file.tellg();
+
+        if (end < 0)
+            return false;
+
+        uint64_t fileSize = static_cast<uint64_t>(end);
+
+        for (const TextureLevel& level : textureFile.levels)
+        {
+            if (level.size != getTextureLevelSize(textureFile.format, level.width, level.height))
+                return false;
+
+            if (level.fileOffset > fileSize || level.size > fileSize - level.fileOffset)
+                return false;
+        }
+
+        return true;
+    }
+
+    /*
+     * Global Functions
+     */
+
+    bool readTextureFileHeader(const std::string& filename, TextureFile& textureFile)
+    {
+        std::ifstream file(filename, std::ios::binary);
+
+        if (!file.is_open())
+            return false;
+
+        textureFile = {};
+        textureFile.filename = filename;
+
+        uint8_t identifier[12];
+        file.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+
+        if (!file)
+            return false;
+
+        bool result = false;
+
+        if (memcmp(identifier, ktx2Identifier, sizeof(ktx2Identifier)) == 0)
+        {
+            result = readKtx2Header(file, textureFile);
+        }
+        else if (memcmp(identifier, "DDS ", 4) == 0)
+        {
+            file.seekg(4);
+            result = readDdsHeader(file, textureFile);
+        }
+
+        if (!result || getBlockSize(textureFile.format) == 0 || textureFile.width == 0 || textureFile.height == 0)
+            return false;
+
+        return validateTextureLevels(file, textureFile);
+    }
+
+    void readTextureFileLevels(const TextureFile& textureFile, uint8_t* destination)
+    {
+        std::ifstream file(textureFile.filename, std::ios::binary);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Datei \"" + textureFile.filename + "\" konnte nicht geoeffnet werden!");
+        }
+
+        for (const TextureLevel& level : textureFile.levels)
+        {
+            file.seekg(static_cast<std::streamoff>(level.fileOffset));
+            file.read(reinterpret_cast<char*>(destination), static_cast<std::streamsize>(level.size));
+
+            if (!file)
+            {
+                throw std::runtime_error("Datei \"" + textureFile.filename + "\" ist unvollstaendig!");
+            }
+
+            destination += level.size;
+        }
+    }
+
+    void decompressBlocks(VkFormat format, const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination)
+    {
+        uint32_t blockSize = getBlockSize(format);
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        bool hasAlphaBlock = format == VK_FORMAT_BC3_UNORM_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+        bool hasBC1Alpha = format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        bool isBC7 = format == VK_FORMAT_BC7_UNORM_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+
+        uint8_t texels[16 * 4];
+
+        for (uint32_t by = 0; by < blocksY; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                const uint8_t* block = source + (static_cast<uint64_t>(by) * blocksX + bx) * blockSize;
+
+                if (isBC7)
+                {
+                    decodeBc7Block(block, texels);
+                }
+                else if (hasAlphaBlock)
+                {
+                    decodeColorBlock(block + 8, texels, false, true);
+                    decodeAlphaBlock(block, texels);
+                }
+                else
+                {
+                    decodeColorBlock(block, texels, true, hasBC1Alpha);
+                }
+
+                // Blocks on the right and bottom edge can be partially outside of the image
+                for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+                {
+                    uint32_t columns = std::min(4u, width - bx * 4);
+                    uint8_t* row = destination + ((static_cast<uint64_t>(by) * 4 + y) * width + bx * 4) * 4;
+                    memcpy(row, &texels[y * 16], columns * 4);
+                }
+            }
+        }
+    }
+
+    bool canDecompressFormat(VkFormat format)
+    {
+        return getDecompressedFormat(format) != VK_FORMAT_UNDEFINED;
+    }
+
+    VkFormat getDecompressedFormat(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        default:
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    uint64_t getTextureLevelSize(VkFormat format, uint32_t width, uint32_t height)
+    {
+        if (format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB)
+            return static_cast<uint64_t>(width) * height * 4;
+
+        uint64_t blocksX = (width + 3) / 4;
+        uint64_t blocksY = (height + 3) / 4;
+
+        return blocksX * blocksY * getBlockSize(format);
+    }
+
+    uint64_t getTextureSize(const TextureFile& textureFile, VkFormat format)
+    {
+        uint64_t size = 0;
+
+        for (const TextureLevel& level : textureFile.levels)
+            size += getTextureLevelSize(format, level.width, level.height);
+
+        return size;
+    }
+}
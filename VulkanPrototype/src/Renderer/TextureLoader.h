@@ -0,0 +1,57 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Helper Structs for precompressed Textures (KTX2 / DDS)
+    */
+
+    struct TextureLevel
+    {
+        uint64_t fileOffset;
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    struct TextureFile
+    {
+        std::string filename;
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        std::vector<TextureLevel> levels;
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Liest den Header einer KTX2 oder DDS Datei. Es werden nur BC1, BC3 und BC7 ohne Supercompression unterstuetzt.
+    /// </summary>
+    /// <returns>False, wenn die Datei nicht existiert, das Format nicht unterstuetzt wird oder ein Level nicht
+    /// die erwartete Groesse hat bzw. ueber das Dateiende hinausgeht.</returns>
+    bool readTextureFileHeader(const std::string& filename, TextureFile& textureFile);
+
+    /// <summary>
+    /// Streamt alle Mip Level hintereinander (Level 0 zuerst) nach destination. Bloecke, die die GPU nicht lesen kann,
+    /// dekodiert decompressBlocks Level fuer Level direkt aus der Datei an den fileOffsets.
+    /// </summary>
+    void readTextureFileLevels(const TextureFile& textureFile, uint8_t* destination);
+
+    void     decompressBlocks(VkFormat format, const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination);
+    bool     canDecompressFormat(VkFormat format);
+    VkFormat getDecompressedFormat(VkFormat format);
+    uint64_t getTextureLevelSize(VkFormat format, uint32_t width, uint32_t height);
+    uint64_t getTextureSize(const TextureFile& textureFile, VkFormat format);
+}
+
+#endif // TEXTURELOADER_H
@@ -0,0 +1,229 @@
+#ifndef VERTEXLAYOUT_H
+#define VERTEXLAYOUT_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+
+// Shared with tools/MeshImporter, so this header must not depend on Vulkan or GLM.
+namespace VulkanPrototype::Renderer
+{
+    /*
+    * Vertex Attribute Types
+    *
+    * Every type stores its packed components and the VkFormat the vertex fetch unit uses to unpack them.
+    * The formats are plain values of VkFormat, RendererUtils.h checks them against the Vulkan headers.
+    */
+
+    struct float2
+    {
+        float value[2];
+
+        static constexpr uint32_t format = 103; // VK_FORMAT_R32G32_SFLOAT
+    };
+
+    struct float3
+    {
+        float value[3];
+
+        static constexpr uint32_t format = 106; // VK_FORMAT_R32G32B32_SFLOAT
+    };
+
+    struct half2
+    {
+        uint16_t value[2];
+
+        static constexpr uint32_t format = 83;  // VK_FORMAT_R16G16_SFLOAT
+
+        static uint16_t packHalf(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            uint32_t sign = (bits >> 16) & 0x8000;
+            uint32_t exponent = (bits >> 23) & 0xFF;
+            uint32_t mantissa = bits & 0x7FFFFF;
+
+            // NaN stays NaN, everything above the half range becomes infinity
+            if (exponent == 0xFF)
+                return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+            int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+
+            if (halfExponent >= 31)
+                return static_cast<uint16_t>(sign | 0x7C00);
+
+            if (halfExponent <= 0)
+            {
+                // Subnormal half, values below half of the smallest subnormal round to zero
+                if (halfExponent < -10)
+                    return static_cast<uint16_t>(sign);
+
+                mantissa |= 0x800000;
+                uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+                uint32_t halfMantissa = mantissa >> shift;
+                uint32_t remainder = mantissa & ((1u << shift) - 1);
+                uint32_t halfway = 1u << (shift - 1);
+
+                if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+                    halfMantissa++;
+
+                return static_cast<uint16_t>(sign | halfMantissa);
+            }
+
+            uint32_t half = sign | (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+            uint32_t remainder = mantissa & 0x1FFF;
+
+            // Round to nearest even, a carry into the exponent is the correct result
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+                half++;
+
+            return static_cast<uint16_t>(half);
+        }
+
+        static half2 pack(float x, float y)
+        {
+            return { { packHalf(x), packHalf(y) } };
+        }
+    };
+
+    struct snorm16x4
+    {
+        int16_t value[4];
+
+        static constexpr uint32_t format = 92;  // VK_FORMAT_R16G16B16A16_SNORM
+
+        static int16_t packSnorm16(float value)
+        {
+            return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        static snorm16x4 pack(float x, float y, float z, float w)
+        {
+            return { { packSnorm16(x), packSnorm16(y), packSnorm16(z), packSnorm16(w) } };
+        }
+    };
+
+    struct unorm8x4
+    {
+        uint8_t value[4];
+
+        static constexpr uint32_t format = 37;  // VK_FORMAT_R8G8B8A8_UNORM
+
+        static uint8_t packUnorm8(float value)
+        {
+            return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+        }
+
+        static unorm8x4 pack(float x, float y, float z, float w)
+        {
+            return { { packUnorm8(x), packUnorm8(y), packUnorm8(z), packUnorm8(w) } };
+        }
+    };
+
+    /*
+    * Vertex Layout
+    */
+
+    /// <summary>
+    /// Vertex aus den angegebenen Attributtypen, dicht gepackt in Reihenfolge der Template Parameter.
+    /// Stride, Offsets und Formate stehen zur Compilezeit fest, daraus erzeugt RendererUtils.h die Vulkan Beschreibungen.
+    /// </summary>
+    template<typename... Attributes>
+    struct VertexLayout
+    {
+        static constexpr uint32_t attributeCount = sizeof...(Attributes);
+        static constexpr uint32_t stride = (0 + ... + static_cast<uint32_t>(sizeof(Attributes)));
+
+        static constexpr std::array<uint32_t, attributeCount> formats = { Attributes::format... };
+
+        static constexpr std::array<uint32_t, attributeCount> offsets = []()
+        {
+            std::array<uint32_t, attributeCount> result = {};
+            uint32_t sizes[] = { static_cast<uint32_t>(sizeof(Attributes))... };
+
+            for (uint32_t i = 1; i < attributeCount; i++)
+                result[i] = result[i - 1] + sizes[i - 1];
+
+            return result;
+        }();
+
+        template<uint32_t Index>
+        using Attribute = std::tuple_element_t<Index, std::tuple<Attributes...>>;
+
+        // Byte storage keeps the vertex free of padding, the attributes are copied in and out
+        uint8_t data[stride];
+
+        template<uint32_t Index>
+        Attribute<Index> get() const
+        {
+            Attribute<Index> attribute;
+            memcpy(&attribute, data + offsets[Index], sizeof(attribute));
+            return attribute;
+        }
+
+        template<uint32_t Index>
+        void set(const Attribute<Index>& attribute)
+        {
+            memcpy(data + offsets[Index], &attribute, sizeof(attribute));
+        }
+    };
+
+    /*
+    * Quantized Vertex
+    *
+    * Position relative to the mesh bounds, dequantized in shader.vert with the scale and offset of the mesh.
+    */
+
+    enum QuantizedVertexAttribute : uint32_t
+    {
+        VERTEX_ATTRIBUTE_POSITION = 0,
+        VERTEX_ATTRIBUTE_COLOR = 1,
+        VERTEX_ATTRIBUTE_TEXTURE_COORDINATE = 2
+    };
+
+    using QuantizedVertex = VertexLayout<snorm16x4, unorm8x4, half2>;
+
+    static_assert(sizeof(QuantizedVertex) == 16 && QuantizedVertex::stride == 16);
+
+    struct VertexQuantization
+    {
+        float scale[3];
+        float offset[3];
+    };
+
+    /// <summary>
+    /// Bildet die Bounding Box auf [-1, 1] ab. Flache Achsen bekommen die Skalierung 0, ihre Position steckt komplett im Offset.
+    /// </summary>
+    inline VertexQuantization getVertexQuantization(const float boundsMin[3], const float boundsMax[3])
+    {
+        VertexQuantization quantization;
+
+        for (int i = 0; i < 3; i++)
+        {
+            quantization.offset[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+            quantization.scale[i] = (boundsMax[i] - boundsMin[i]) * 0.5f;
+        }
+
+        return quantization;
+    }
+
+    inline QuantizedVertex quantizeVertex(const VertexQuantization& quantization, const float position[3], const float color[3], const float textureCoordinate[2])
+    {
+        float normalized[3];
+        for (int i = 0; i < 3; i++)
+            normalized[i] = quantization.scale[i] > 0.0f ? (position[i] - quantization.offset[i]) / quantization.scale[i] : 0.0f;
+
+        QuantizedVertex vertex;
+        vertex.set<VERTEX_ATTRIBUTE_POSITION>(snorm16x4::pack(normalized[0], normalized[1], normalized[2], 1.0f));
+        vertex.set<VERTEX_ATTRIBUTE_COLOR>(unorm8x4::pack(color[0], color[1], color[2], 1.0f));
+        vertex.set<VERTEX_ATTRIBUTE_TEXTURE_COORDINATE>(half2::pack(textureCoordinate[0], textureCoordinate[1]));
+
+        return vertex;
+    }
+}
+
+#endif // VERTEXLAYOUT_H
@@ -0,0 +1,539 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Module Global Variables
+    */
+
+    // Bins along the longest centroid axis, evaluated by the surface area heuristic during build
+    static const uint32_t sahBinCount = 16;
+
+    /*
+     * Member Functions
+     */
+
+    Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+    {
+        glm::vec4 rows[4];
+
+        for (uint32_t i = 0; i < 4; i++)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+        return
+        {
+            {
+                rows[3] + rows[0],
+                rows[3] - rows[0],
+                rows[3] + rows[1],
+                rows[3] - rows[1],
+                rows[2],
+                rows[3] - rows[2]
+            }
+        };
+    }
+
+    void Bvh::build(const Aabb* bounds, const uint32_t* objects, uint32_t count, uint32_t* leaves)
+    {
+        clear();
+
+        if (count == 0)
+            return;
+
+        // Built depth first, the first child of every inner node directly follows it in memory
+        nodes.reserve(2 * static_cast<size_t>(count) - 1);
+
+        std::vector<uint32_t> indices(count);
+
+        for (uint32_t i = 0; i < count; i++)
+            indices[i] = i;
+
+        root = buildNode(bounds, objects, leaves, indices.data(), count, noBvhNode);
+        leafCount = count;
+    }
+
+    void Bvh::clear()
+    {
+        nodes.clear();
+        freeNodes.clear();
+        root = noBvhNode;
+        leafCount = 0;
+    }
+
+    uint32_t Bvh::insert(const Aabb& bounds, uint32_t object)
+    {
+        uint32_t leaf = allocateNode();
+
+        nodes[leaf] = { enlarge(bounds), noBvhNode, { noBvhNode, noBvhNode }, object };
+        insertLeaf(leaf);
+        leafCount++;
+
+        return leaf;
+    }
+
+    void Bvh::remove(uint32_t leaf)
+    {
+        removeLeaf(leaf);
+        freeNode(leaf);
+        leafCount--;
+    }
+
+    bool Bvh::update(uint32_t leaf, const Aabb& bounds)
+    {
+        if (nodes[leaf].bounds.contains(bounds))
+            return false;
+
+        // The leaf keeps its place, only its ancestors grow or shrink and get rotated
+        nodes[leaf].bounds = enlarge(bounds);
+
+        if (nodes[leaf].parent != noBvhNode)
+            refit(nodes[leaf].parent);
+
+        return true;
+    }
+
+    uint32_t Bvh::getObject(uint32_t leaf) const
+    {
+        return nodes[leaf].object;
+    }
+
+    uint32_t Bvh::getLeafCount() const
+    {
+        return leafCount;
+    }
+
+    uint32_t Bvh::getHeight() const
+    {
+        if (root == noBvhNode)
+            return 0;
+
+        std::vector<std::pair<uint32_t, uint32_t>> stack = { { root, 1 } };
+        uint32_t height = 0;
+
+        while (!stack.empty())
+        {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+
+            height = std::max(height, depth);
+
+            if (!nodes[node].isLeaf())
+            {
+                stack.push_back({ nodes[node].children[0], depth + 1 });
+                stack.push_back({ nodes[node].children[1], depth + 1 });
+            }
+        }
+
+        return height;
+    }
+
+    float Bvh::getSurfaceAreaCost() const
+    {
+        if (root == noBvhNode || nodes[root].isLeaf())
+            return 0.0f;
+
+        std::vector<uint32_t> stack = { root };
+        float surfaceArea = 0.0f;
+
+        while (!stack.empty())
+        {
+            const BvhNode& node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (node.isLeaf())
+                continue;
+
+            surfaceArea += node.bounds.getSurfaceArea();
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+
+        return surfaceArea / nodes[root].bounds.getSurfaceArea();
+    }
+
+    bool Bvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& object, float& distance) const
+    {
+        if (root == noBvhNode)
+            return false;
+
+        glm::vec3 inverseDirection = 1.0f / direction;
+        float closestDistance = maxDistance;
+        bool hit = false;
+
+        // Distance at which the ray enters the box, or infinity if it misses it before the closest hit so far
+        auto intersect = [&](const Aabb& bounds)
+        {
+            glm::vec3 t1 = (bounds.min - origin) * inverseDirection;
+            glm::vec3 t2 = (bounds.max - origin) * inverseDirection;
+            glm::vec3 tMin = glm::min(t1, t2);
+            glm::vec3 tMax = glm::max(t1, t2);
+
+            float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+            float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, closestDistance));
+
+            return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+        };
+
+        uint32_t stack[maxStackSize];
+        uint32_t stackSize = 0;
+
+        stack[stackSize++] = root;
+
+        while (stackSize > 0)
+        {
+            const BvhNode& node = nodes[stack[--stackSize]];
+
+            // Tested again, the closest hit may have moved closer since the node was pushed
+            float enter = intersect(node.bounds);
+
+            if (enter == std::numeric_limits<float>::infinity())
+                continue;
+
+            if (node.isLeaf())
+            {
+                closestDistance = enter;
+                object = node.object;
+                hit = true;
+                continue;
+            }
+
+            // The closer child is popped first, so it can shrink closestDistance for the other one
+            uint32_t first = node.children[0];
+            uint32_t second = node.children[1];
+            float firstEnter = intersect(nodes[first].bounds);
+            float secondEnter = intersect(nodes[second].bounds);
+
+            if (firstEnter > secondEnter)
+            {
+                std::swap(first, second);
+                std::swap(firstEnter, secondEnter);
+            }
+
+            checkStack(stackSize);
+
+            if (secondEnter != std::numeric_limits<float>::infinity())
+                stack[stackSize++] = second;
+
+            if (firstEnter != std::numeric_limits<float>::infinity())
+                stack[stackSize++] = first;
+        }
+
+        distance = closestDistance;
+        return hit;
+    }
+
+    uint32_t Bvh::allocateNode()
+    {
+        if (!freeNodes.empty())
+        {
+            uint32_t node = freeNodes.back();
+            freeNodes.pop_back();
+            return node;
+        }
+
+        nodes.push_back({});
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void Bvh::freeNode(uint32_t node)
+    {
+        freeNodes.push_back(node);
+    }
+
+    uint32_t Bvh::buildNode(const Aabb* bounds, const uint32_t* objects, uint32_t* leaves, uint32_t* indices, uint32_t count, uint32_t parent)
+    {
+        uint32_t node = allocateNode();
+
+        if (count == 1)
+        {
+            nodes[node] = { enlarge(bounds[indices[0]]), parent, { noBvhNode, noBvhNode }, objects[indices[0]] };
+            leaves[indices[0]] = node;
+            return node;
+        }
+
+        auto getCenter = [bounds](uint32_t index)
+        {
+            return (bounds[index].min + bounds[index].max) * 0.5f;
+        };
+
+        Aabb centerBounds = { getCenter(indices[0]), getCenter(indices[0]) };
+
+        for (uint32_t i = 1; i < count; i++)
+        {
+            glm::vec3 center = getCenter(indices[i]);
+            centerBounds = { glm::min(centerBounds.min, center), glm::max(centerBounds.max, center) };
+        }
+
+        glm::vec3 extent = centerBounds.max - centerBounds.min;
+        uint32_t axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        uint32_t splitIndex = count / 2;
+
+        if (extent[axis] > 0.0f)
+        {
+            auto getBin = [&](uint32_t index)
+            {
+                float position = (getCenter(index)[axis] - centerBounds.min[axis]) / extent[axis];
+                return std::min(static_cast<uint32_t>(position * sahBinCount), sahBinCount - 1);
+            };
+
+            uint32_t binCounts[sahBinCount] = {};
+            Aabb binBounds[sahBinCount];
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t bin = getBin(indices[i]);
+                const Aabb& objectBounds = bounds[indices[i]];
+
+                binBounds[bin] = binCounts[bin] == 0 ? objectBounds : Aabb::merge(binBounds[bin], objectBounds);
+                binCounts[bin]++;
+            }
+
+            // Cost of the objects right of every split plane, swept from the right
+            float rightCosts[sahBinCount] = {};
+            Aabb rightBounds;
+            uint32_t rightCount = 0;
+
+            for (uint32_t bin = sahBinCount - 1; bin > 0; bin--)
+            {
+                if (binCounts[bin] > 0)
+                {
+                    rightBounds = rightCount == 0 ? binBounds[bin] : Aabb::merge(rightBounds, binBounds[bin]);
+                    rightCount += binCounts[bin];
+                }
+
+                rightCosts[bin] = rightCount == 0 ? 0.0f : rightBounds.getSurfaceArea() * rightCount;
+            }
+
+            Aabb leftBounds;
+            uint32_t leftCount = 0;
+            float bestCost = std::numeric_limits<float>::infinity();
+            uint32_t bestSplit = sahBinCount;
+
+            // A split after bin puts the bins 0 to bin on the left side
+            for (uint32_t bin = 0; bin < sahBinCount - 1; bin++)
+            {
+                if (binCounts[bin] > 0)
+                {
+                    leftBounds = leftCount == 0 ? binBounds[bin] : Aabb::merge(leftBounds, binBounds[bin]);
+                    leftCount += binCounts[bin];
+                }
+
+                if (leftCount == 0 || leftCount == count)
+                    continue;
+
+                float cost = leftBounds.getSurfaceArea() * leftCount + rightCosts[bin + 1];
+
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestSplit = bin;
+                }
+            }
+
+            if (bestSplit < sahBinCount)
+            {
+                uint32_t* middle = std::partition(indices, indices + count, [&](uint32_t index) { return getBin(index) <= bestSplit; });
+                splitIndex = static_cast<uint32_t>(middle - indices);
+            }
+        }
+
+        // All centers in one bin or at one point, the median keeps the tree balanced
+        if (splitIndex == 0 || splitIndex == count || extent[axis] <= 0.0f)
+        {
+            splitIndex = count / 2;
+            std::nth_element(indices, indices + splitIndex, indices + count, [&](uint32_t first, uint32_t second)
+            {
+                return getCenter(first)[axis] < getCenter(second)[axis];
+            });
+        }
+
+        uint32_t firstChild = buildNode(bounds, objects, leaves, indices, splitIndex, node);
+        uint32_t secondChild = buildNode(bounds, objects, leaves, indices + splitIndex, count - splitIndex, node);
+
+        nodes[node] = { Aabb::merge(nodes[firstChild].bounds, nodes[secondChild].bounds), parent, { firstChild, secondChild }, noBvhNode };
+
+        return node;
+    }
+
+    void Bvh::insertLeaf(uint32_t leaf)
+    {
+        if (root == noBvhNode)
+        {
+            root = leaf;
+            nodes[leaf].parent = noBvhNode;
+            return;
+        }
+
+        // Descend towards the sibling with the smallest increase in surface area, stop when a new parent here is cheaper
+        const Aabb leafBounds = nodes[leaf].bounds;
+        uint32_t sibling = root;
+
+        while (!nodes[sibling].isLeaf())
+        {
+            const BvhNode& node = nodes[sibling];
+
+            float area = node.bounds.getSurfaceArea();
+            float combinedArea = Aabb::merge(node.bounds, leafBounds).getSurfaceArea();
+
+            // Creating a new parent for this node and the leaf
+            float cost = 2.0f * combinedArea;
+
+            // Pushing the leaf further down enlarges this node in any case
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            float childCosts[2];
+
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                const BvhNode& child = nodes[node.children[i]];
+                float childArea = Aabb::merge(child.bounds, leafBounds).getSurfaceArea();
+
+                childCosts[i] = (child.isLeaf() ? childArea : childArea - child.bounds.getSurfaceArea()) + inheritanceCost;
+            }
+
+            if (cost < childCosts[0] && cost < childCosts[1])
+                break;
+
+            sibling = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+        }
+
+        uint32_t oldParent = nodes[sibling].parent;
+        uint32_t newParent = allocateNode();
+
+        nodes[newParent] = { Aabb::merge(leafBounds, nodes[sibling].bounds), oldParent, { sibling, leaf }, noBvhNode };
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent == noBvhNode)
+        {
+            root = newParent;
+        }
+        else
+        {
+            BvhNode& parent = nodes[oldParent];
+            parent.children[parent.children[0] == sibling ? 0 : 1] = newParent;
+
+            refit(oldParent);
+        }
+    }
+
+    void Bvh::removeLeaf(uint32_t leaf)
+    {
+        if (leaf == root)
+        {
+            root = noBvhNode;
+            return;
+        }
+
+        // The parent goes away, the sibling takes its place
+        uint32_t parent = nodes[leaf].parent;
+        uint32_t grandParent = nodes[parent].parent;
+        uint32_t sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        if (grandParent == noBvhNode)
+        {
+            root = sibling;
+            return;
+        }
+
+        BvhNode& node = nodes[grandParent];
+        node.children[node.children[0] == parent ? 0 : 1] = sibling;
+
+        refit(grandParent);
+    }
+
+    void Bvh::refit(uint32_t node)
+    {
+        // Every ancestor is recomputed up to the root, a rotation below may have changed the bounds of any of them
+        while (node != noBvhNode)
+        {
+            BvhNode& current = nodes[node];
+            current.bounds = Aabb::merge(nodes[current.children[0]].bounds, nodes[current.children[1]].bounds);
+
+            rotate(node);
+
+            node = current.parent;
+        }
+    }
+
+    void Bvh::rotate(uint32_t node)
+    {
+        // Swaps one child with a grandchild on the other side, if that shrinks the surface area of the other child.
+        // The bounds of the node itself stay the same, it still contains the same leaves.
+        uint32_t bestChild = 0;
+        uint32_t bestGrandChild = 0;
+        float bestGain = 0.0f;
+
+        for (uint32_t child = 0; child < 2; child++)
+        {
+            const BvhNode& other = nodes[nodes[node].children[1 - child]];
+
+            if (other.isLeaf())
+                continue;
+
+            const Aabb& childBounds = nodes[nodes[node].children[child]].bounds;
+
+            for (uint32_t grandChild = 0; grandChild < 2; grandChild++)
+            {
+                // The child takes the place of the grandchild, the other grandchild stays
+                Aabb rotatedBounds = Aabb::merge(childBounds, nodes[other.children[1 - grandChild]].bounds);
+                float gain = other.bounds.getSurfaceArea() - rotatedBounds.getSurfaceArea();
+
+                if (gain > bestGain)
+                {
+                    bestGain = gain;
+                    bestChild = child;
+                    bestGrandChild = grandChild;
+                }
+            }
+        }
+
+        if (bestGain <= 0.0f)
+            return;
+
+        uint32_t child = nodes[node].children[bestChild];
+        uint32_t other = nodes[node].children[1 - bestChild];
+        uint32_t grandChild = nodes[other].children[bestGrandChild];
+
+        nodes[node].children[bestChild] = grandChild;
+        nodes[grandChild].parent = node;
+
+        nodes[other].children[bestGrandChild] = child;
+        nodes[child].parent = other;
+
+        nodes[other].bounds = Aabb::merge(nodes[nodes[other].children[0]].bounds, nodes[nodes[other].children[1]].bounds);
+    }
+
+    Aabb Bvh::enlarge(const Aabb& bounds) const
+    {
+        return { bounds.min - glm::vec3(margin), bounds.max + glm::vec3(margin) };
+    }
+
+    Bvh::Containment Bvh::classify(const Frustum& frustum, const Aabb& bounds)
+    {
+        Containment containment = Containment::Inside;
+
+        for (const glm::vec4& plane : frustum.planes)
+        {
+            glm::vec3 normal(plane);
+
+            // The corners furthest along and against the plane normal
+            glm::vec3 positiveCorner = glm::mix(bounds.min, bounds.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+            glm::vec3 negativeCorner = glm::mix(bounds.max, bounds.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+
+            if (glm::dot(normal, positiveCorner) + plane.w < 0.0f)
+                return Containment::Outside;
+
+            if (glm::dot(normal, negativeCorner) + plane.w < 0.0f)
+                containment = Containment::Intersecting;
+        }
+
+        return containment;
+    }
+}
@@ -0,0 +1,229 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "GlmConfig.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Bounding Volume Hierarchy
+    */
+
+    static const uint32_t noBvhNode = UINT32_MAX;
+
+    struct Aabb
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+
+        float getSurfaceArea() const
+        {
+            glm::vec3 extent = max - min;
+            return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+        }
+
+        bool contains(const Aabb& other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+        }
+
+        bool overlaps(const Aabb& other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+        }
+
+        static Aabb merge(const Aabb& first, const Aabb& second)
+        {
+            return { glm::min(first.min, second.min), glm::max(first.max, second.max) };
+        }
+    };
+
+    /// <summary>
+    /// Sechs Ebenen mit nach innen zeigender Normale, ein Punkt p liegt im Frustum, wenn dot(plane, vec4(p, 1)) >= 0 fuer alle gilt.
+    /// </summary>
+    struct Frustum
+    {
+        glm::vec4 planes[6];
+
+        /// <summary>
+        /// Ebenen aus Projektion * View (* Model), fuer den Clip Space von Vulkan mit 0 <= z <= w.
+        /// </summary>
+        static Frustum fromMatrix(const glm::mat4& viewProjection);
+    };
+
+    struct BvhNode
+    {
+        // Leaves store their bounds enlarged by the margin of the tree
+        Aabb bounds;
+        uint32_t parent;
+
+        // noBvhNode for leaves
+        uint32_t children[2];
+
+        // Only used by leaves
+        uint32_t object;
+
+        bool isLeaf() const
+        {
+            return children[0] == noBvhNode;
+        }
+    };
+
+    /// <summary>
+    /// Dynamische Bounding Volume Hierarchy ueber Objekt-AABBs, alle Knoten liegen in einem flachen Array.
+    /// build() baut den Baum komplett mit der Surface Area Heuristic auf, insert(), remove() und update() aendern ihn inkrementell.
+    /// update() passt die Eltern eines bewegten Blatts an und verbessert sie dabei mit Rotationen, statt neu einzufuegen.
+    /// </summary>
+    class Bvh
+    {
+    public:
+        // Leaves are enlarged by this much on every side, objects moving inside the margin need no update
+        float margin = 0.1f;
+
+        /// <summary>
+        /// Ersetzt den Baum. leaves bekommt fuer jedes Objekt den Index seines Blatts, er bleibt bis zum remove() gueltig.
+        /// </summary>
+        void build(const Aabb* bounds, const uint32_t* objects, uint32_t count, uint32_t* leaves);
+        void clear();
+
+        uint32_t insert(const Aabb& bounds, uint32_t object);
+        void remove(uint32_t leaf);
+
+        /// <summary>
+        /// Gibt true zurueck, wenn das Blatt seine vergroesserten Grenzen verlassen hat und der Baum angepasst wurde.
+        /// </summary>
+        bool update(uint32_t leaf, const Aabb& bounds);
+
+        uint32_t getObject(uint32_t leaf) const;
+        uint32_t getLeafCount() const;
+        uint32_t getHeight() const;
+
+        // Sum of the inner node surface areas relative to the root, lower is better for the queries
+        float getSurfaceAreaCost() const;
+
+        /// <summary>
+        /// Ruft callback(object) fuer jedes Blatt, das bounds ueberlappt.
+        /// </summary>
+        template<typename F>
+        void queryAabb(const Aabb& bounds, F&& callback) const
+        {
+            if (root == noBvhNode)
+                return;
+
+            uint32_t stack[maxStackSize];
+            uint32_t stackSize = 0;
+
+            stack[stackSize++] = root;
+
+            while (stackSize > 0)
+            {
+                const BvhNode& node = nodes[stack[--stackSize]];
+
+                if (!node.bounds.overlaps(bounds))
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    callback(node.object);
+                    continue;
+                }
+
+                checkStack(stackSize);
+                stack[stackSize++] = node.children[0];
+                stack[stackSize++] = node.children[1];
+            }
+        }
+
+        /// <summary>
+        /// Ruft callback(object) fuer jedes Blatt, das das Frustum schneidet. Vollstaendig enthaltene Teilbaeume werden ohne weitere Tests gemeldet.
+        /// </summary>
+        template<typename F>
+        void queryFrustum(const Frustum& frustum, F&& callback) const
+        {
+            if (root == noBvhNode)
+                return;
+
+            // The top bit marks nodes that are known to be completely inside
+            const uint32_t insideBit = 0x80000000;
+
+            uint32_t stack[maxStackSize];
+            uint32_t stackSize = 0;
+
+            stack[stackSize++] = root;
+
+            while (stackSize > 0)
+            {
+                uint32_t entry = stack[--stackSize];
+                const BvhNode& node = nodes[entry & ~insideBit];
+                uint32_t inside = entry & insideBit;
+
+                if (!inside)
+                {
+                    Containment containment = classify(frustum, node.bounds);
+
+                    if (containment == Containment::Outside)
+                        continue;
+
+                    if (containment == Containment::Inside)
+                        inside = insideBit;
+                }
+
+                if (node.isLeaf())
+                {
+                    callback(node.object);
+                    continue;
+                }
+
+                checkStack(stackSize);
+                stack[stackSize++] = node.children[0] | inside;
+                stack[stackSize++] = node.children[1] | inside;
+            }
+        }
+
+        /// <summary>
+        /// Naechstes Blatt entlang des Strahls bis maxDistance, direction muss nicht normalisiert sein.
+        /// distance ist in Vielfachen von direction angegeben. Gibt false zurueck, wenn nichts getroffen wurde.
+        /// </summary>
+        bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& object, float& distance) const;
+
+    private:
+        enum class Containment
+        {
+            Outside,
+            Intersecting,
+            Inside
+        };
+
+        // Heights stay far below this, the rotations keep the tree balanced
+        static constexpr uint32_t maxStackSize = 256;
+
+        std::vector<BvhNode> nodes;
+        std::vector<uint32_t> freeNodes;
+        uint32_t root = noBvhNode;
+        uint32_t leafCount = 0;
+
+        uint32_t allocateNode();
+        void freeNode(uint32_t node);
+
+        uint32_t buildNode(const Aabb* bounds, const uint32_t* objects, uint32_t* leaves, uint32_t* indices, uint32_t count, uint32_t parent);
+        void insertLeaf(uint32_t leaf);
+        void removeLeaf(uint32_t leaf);
+        void refit(uint32_t node);
+        void rotate(uint32_t node);
+
+        Aabb enlarge(const Aabb& bounds) const;
+        static Containment classify(const Frustum& frustum, const Aabb& bounds);
+
+        static void checkStack(uint32_t stackSize)
+        {
+            if (stackSize + 2 > maxStackSize)
+                throw std::runtime_error("Die BVH ist zu tief fuer den Traversierungsstapel.");
+        }
+    };
+}
+
+#endif // BVH_H
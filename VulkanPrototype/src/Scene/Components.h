@@ -0,0 +1,41 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <cstdint>
+
+#include "GlmConfig.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Components of the Scene Objects
+    */
+
+    // Node in the TransformHierarchy, which holds the local and world transform
+    struct Transform
+    {
+        uint32_t node;
+    };
+
+    struct MeshRenderer
+    {
+        uint32_t meshIndex;
+        uint32_t materialIndex;
+    };
+
+    // Placed at the world position of the Transform, falls off to zero at the radius
+    struct PointLight
+    {
+        glm::vec3 color;
+        float radius;
+    };
+
+    // Rasterized by the CPU occlusion culling, the box in the space of the Transform replaces the mesh
+    struct Occluder
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+}
+
+#endif // COMPONENTS_H
@@ -0,0 +1,10 @@
+#ifndef GLMCONFIG_H
+#define GLMCONFIG_H
+
+// Same configuration as RendererUtils.h, otherwise glm types would differ in size between the translation units.
+// Every header of the scene includes glm through this one.
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#endif // GLMCONFIG_H
@@ -0,0 +1,341 @@
+#include "OcclusionRasterizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "../Jobs/JobSystem.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Module Global Variables
+    */
+
+    // Two triangles per face, the corners are numbered by their bits: x is bit 0, y bit 1 and z bit 2.
+    // The face diagonal runs from the first to the last vertex of the first triangle and to the second vertex of the other one.
+    static const uint8_t boxTriangles[12][3] =
+    {
+        { 0, 2, 6 }, { 0, 6, 4 },
+        { 1, 5, 7 }, { 1, 7, 3 },
+        { 0, 4, 5 }, { 0, 5, 1 },
+        { 2, 3, 7 }, { 2, 7, 6 },
+        { 0, 1, 3 }, { 0, 3, 2 },
+        { 4, 6, 7 }, { 4, 7, 5 }
+    };
+
+    // Tiles per job, a job should not be much cheaper than scheduling it
+    static const uint32_t tileBatchSize = 2;
+
+    /*
+     * Private Functions
+     */
+
+    static glm::vec2 toPixel(const glm::vec4& clipPosition)
+    {
+        // The viewport maps ndc -1 to the first row and column like on the GPU
+        glm::vec2 ndc = glm::vec2(clipPosition) / clipPosition.w;
+        return (ndc * 0.5f + 0.5f) * glm::vec2(OcclusionRasterizer::width, OcclusionRasterizer::height);
+    }
+
+    /*
+     * Member Functions
+     */
+
+    void OcclusionRasterizer::begin(const glm::mat4& viewProjection)
+    {
+        this->viewProjection = viewProjection;
+
+        depths.resize(width * height);
+        tileMinDepths.resize(tilesX * tilesY);
+        tileMaxDepths.resize(tilesX * tilesY);
+        tileTriangles.resize(tilesX * tilesY);
+
+        triangles.clear();
+
+        for (std::vector<uint32_t>& tile : tileTriangles)
+            tile.clear();
+    }
+
+    void OcclusionRasterizer::addOccluderBox(const glm::mat4& worldMatrix, const Aabb& localBounds)
+    {
+        glm::mat4 transform = viewProjection * worldMatrix;
+        glm::vec4 corners[8];
+
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            glm::vec3 corner((i & 1) ? localBounds.max.x : localBounds.min.x, (i & 2) ? localBounds.max.y : localBounds.min.y, (i & 4) ? localBounds.max.z : localBounds.min.z);
+            corners[i] = transform * glm::vec4(corner, 1.0f);
+        }
+
+        for (uint32_t t = 0; t < 12; t++)
+        {
+            const uint8_t* indices = boxTriangles[t];
+            OccluderTriangle triangle;
+            triangle.faceDiagonal = t % 2 == 0 ? 1 : 2;
+            bool clipped = false;
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const glm::vec4& clipPosition = corners[indices[i]];
+
+                // Without clipping a triangle reaching in front of the near plane cannot be projected, leaving it out only hides less
+                if (clipPosition.z < 0.0f || clipPosition.w <= 0.0f)
+                {
+                    clipped = true;
+                    break;
+                }
+
+                triangle.vertices[i] = glm::vec3(toPixel(clipPosition), clipPosition.z / clipPosition.w);
+            }
+
+            if (!clipped)
+                triangles.push_back(triangle);
+        }
+    }
+
+    void OcclusionRasterizer::rasterize()
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        // Binning, every triangle goes to the tiles its screen rectangle overlaps
+        for (uint32_t index = 0; index < triangles.size(); index++)
+        {
+            const glm::vec3* vertices = triangles[index].vertices;
+
+            glm::vec2 minPixel = glm::min(glm::vec2(vertices[0]), glm::min(glm::vec2(vertices[1]), glm::vec2(vertices[2])));
+            glm::vec2 maxPixel = glm::max(glm::vec2(vertices[0]), glm::max(glm::vec2(vertices[1]), glm::vec2(vertices[2])));
+
+            if (maxPixel.x < 0.0f || maxPixel.y < 0.0f || minPixel.x >= width || minPixel.y >= height)
+                continue;
+
+            uint32_t firstTileX = static_cast<uint32_t>(std::max(minPixel.x, 0.0f)) / tileSize;
+            uint32_t firstTileY = static_cast<uint32_t>(std::max(minPixel.y, 0.0f)) / tileSize;
+            uint32_t lastTileX = std::min(static_cast<uint32_t>(maxPixel.x) / tileSize, tilesX - 1);
+            uint32_t lastTileY = std::min(static_cast<uint32_t>(maxPixel.y) / tileSize, tilesY - 1);
+
+            for (uint32_t tileY = firstTileY; tileY <= lastTileY; tileY++)
+                for (uint32_t tileX = firstTileX; tileX <= lastTileX; tileX++)
+                    tileTriangles[tileY * tilesX + tileX].push_back(index);
+        }
+
+        // Every tile owns its part of the buffer, so they are rasterized without synchronization
+        Jobs::Counter counter;
+        Jobs::ParallelFor(tilesX * tilesY, tileBatchSize, [this](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t tile = begin; tile < end; tile++)
+                rasterizeTile(tile);
+        }, counter);
+        Jobs::Wait(counter);
+
+        rasterTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    bool OcclusionRasterizer::isVisible(const Aabb& worldBounds) const
+    {
+        if (triangles.empty())
+            return true;
+
+        glm::vec2 minPixel(std::numeric_limits<float>::max());
+        glm::vec2 maxPixel(std::numeric_limits<float>::lowest());
+        float nearestDepth = std::numeric_limits<float>::max();
+
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            glm::vec3 corner((i & 1) ? worldBounds.max.x : worldBounds.min.x, (i & 2) ? worldBounds.max.y : worldBounds.min.y, (i & 4) ? worldBounds.max.z : worldBounds.min.z);
+            glm::vec4 clipPosition = viewProjection * glm::vec4(corner, 1.0f);
+
+            // Boxes reaching in front of the near plane cannot be projected, they are always drawn
+            if (clipPosition.z < 0.0f || clipPosition.w <= 0.0f)
+                return true;
+
+            glm::vec2 pixel = toPixel(clipPosition);
+            minPixel = glm::min(minPixel, pixel);
+            maxPixel = glm::max(maxPixel, pixel);
+            nearestDepth = std::min(nearestDepth, clipPosition.z / clipPosition.w);
+        }
+
+        if (maxPixel.x < 0.0f || maxPixel.y < 0.0f || minPixel.x >= width || minPixel.y >= height)
+            return false;
+
+        // Every pixel touched by the screen rectangle of the box
+        uint32_t firstX = static_cast<uint32_t>(std::max(minPixel.x, 0.0f));
+        uint32_t firstY = static_cast<uint32_t>(std::max(minPixel.y, 0.0f));
+        uint32_t lastX = std::min(static_cast<uint32_t>(maxPixel.x), width - 1);
+        uint32_t lastY = std::min(static_cast<uint32_t>(maxPixel.y), height - 1);
+
+        for (uint32_t tileY = firstY / tileSize; tileY <= lastY / tileSize; tileY++)
+        {
+            for (uint32_t tileX = firstX / tileSize; tileX <= lastX / tileSize; tileX++)
+            {
+                uint32_t tile = tileY * tilesX + tileX;
+
+                // Everything in the tile is in front of the box
+                if (tileMaxDepths[tile] < nearestDepth)
+                    continue;
+
+                // Nothing in the tile is in front of the box
+                if (tileMinDepths[tile] >= nearestDepth)
+                    return true;
+
+                const float* tileDepths = depths.data() + tile * tileSize * tileSize;
+
+                uint32_t beginX = std::max(firstX, tileX * tileSize) - tileX * tileSize;
+                uint32_t beginY = std::max(firstY, tileY * tileSize) - tileY * tileSize;
+                uint32_t endX = std::min(lastX, tileX * tileSize + tileSize - 1) - tileX * tileSize;
+                uint32_t endY = std::min(lastY, tileY * tileSize + tileSize - 1) - tileY * tileSize;
+
+                for (uint32_t y = beginY; y <= endY; y++)
+                {
+                    const float* row = tileDepths + y * tileSize;
+
+#if defined(__SSE__) || defined(_M_X64)
+                    __m128 boxDepth = _mm_set1_ps(nearestDepth);
+                    __m128 columnBegin = _mm_set1_ps(static_cast<float>(beginX));
+                    __m128 columnEnd = _mm_set1_ps(static_cast<float>(endX));
+
+                    for (uint32_t x = beginX & ~3u; x <= endX; x += 4)
+                    {
+                        __m128 columns = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+                        __m128 inside = _mm_and_ps(_mm_cmpge_ps(columns, columnBegin), _mm_cmple_ps(columns, columnEnd));
+
+                        if (_mm_movemask_ps(_mm_and_ps(inside, _mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth))) != 0)
+                            return true;
+                    }
+#else
+                    for (uint32_t x = beginX; x <= endX; x++)
+                    {
+                        if (row[x] >= nearestDepth)
+                            return true;
+                    }
+#endif
+                }
+            }
+        }
+
+        return false;
+    }
+
+    uint32_t OcclusionRasterizer::getOccluderTriangleCount() const
+    {
+        return static_cast<uint32_t>(triangles.size());
+    }
+
+    float OcclusionRasterizer::getRasterTime() const
+    {
+        return rasterTime;
+    }
+
+    void OcclusionRasterizer::rasterizeTile(uint32_t tile)
+    {
+        float* tileDepths = depths.data() + tile * tileSize * tileSize;
+        std::fill(tileDepths, tileDepths + tileSize * tileSize, 1.0f);
+
+        uint32_t tileX = (tile % tilesX) * tileSize;
+        uint32_t tileY = (tile / tilesX) * tileSize;
+
+        for (uint32_t index : tileTriangles[tile])
+        {
+            const glm::vec3& v0 = triangles[index].vertices[0];
+            const glm::vec3& v1 = triangles[index].vertices[1];
+            const glm::vec3& v2 = triangles[index].vertices[2];
+
+            float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+            if (std::abs(area) < 1e-6f)
+                continue;
+
+            // Edge functions a * x + b * y + c, the one of edge i is zero on the edge opposite to vertex i.
+            // Both windings are rasterized, the signs are flipped so the inside is positive.
+            float sign = area > 0.0f ? 1.0f : -1.0f;
+            float edgeA[3] = { (v1.y - v2.y) * sign, (v2.y - v0.y) * sign, (v0.y - v1.y) * sign };
+            float edgeB[3] = { (v2.x - v1.x) * sign, (v0.x - v2.x) * sign, (v1.x - v0.x) * sign };
+            float edgeC[3] = { (v1.x * v2.y - v1.y * v2.x) * sign, (v2.x * v0.y - v2.y * v0.x) * sign, (v0.x * v1.y - v0.y * v1.x) * sign };
+            area *= sign;
+
+            // The depth is affine in screen space, so it is a plane over the pixels like the edge functions
+            float depthA = (edgeA[1] * (v1.z - v0.z) + edgeA[2] * (v2.z - v0.z)) / area;
+            float depthB = (edgeB[1] * (v1.z - v0.z) + edgeB[2] * (v2.z - v0.z)) / area;
+            float depthC = v0.z + (edgeC[1] * (v1.z - v0.z) + edgeC[2] * (v2.z - v0.z)) / area;
+
+            // Occluders have to be conservative: a pixel is only written if the box face covers it completely,
+            // so every outer edge has to be positive at the pixel corner closest to it, and it gets the farthest depth inside the pixel.
+            // The diagonal stays, a pixel on it is covered by both halves of the face together.
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                if (i != triangles[index].faceDiagonal)
+                    edgeC[i] -= 0.5f * (std::abs(edgeA[i]) + std::abs(edgeB[i]));
+            }
+
+            depthC += 0.5f * (std::abs(depthA) + std::abs(depthB));
+
+            // Pixel centers lie at + 0.5, the columns start at a multiple of four inside the tile
+            float minX = std::min(v0.x, std::min(v1.x, v2.x));
+            float minY = std::min(v0.y, std::min(v1.y, v2.y));
+            float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+            float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+
+            uint32_t firstX = std::max(static_cast<uint32_t>(std::max(minX, 0.0f)), tileX) & ~3u;
+            uint32_t firstY = std::max(static_cast<uint32_t>(std::max(minY, 0.0f)), tileY);
+            uint32_t lastX = std::min(static_cast<uint32_t>(std::max(maxX, 0.0f)), tileX + tileSize - 1);
+            uint32_t lastY = std::min(static_cast<uint32_t>(std::max(maxY, 0.0f)), tileY + tileSize - 1);
+
+            for (uint32_t y = firstY; y <= lastY; y++)
+            {
+                float* row = tileDepths + (y - tileY) * tileSize;
+                float centerY = static_cast<float>(y) + 0.5f;
+
+#if defined(__SSE__) || defined(_M_X64)
+                __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(firstX) + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+                __m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), centerX), _mm_set1_ps(edgeB[0] * centerY + edgeC[0]));
+                __m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), centerX), _mm_set1_ps(edgeB[1] * centerY + edgeC[1]));
+                __m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), centerX), _mm_set1_ps(edgeB[2] * centerY + edgeC[2]));
+                __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), centerX), _mm_set1_ps(depthB * centerY + depthC));
+
+                __m128 edgeStep0 = _mm_set1_ps(edgeA[0] * 4.0f);
+                __m128 edgeStep1 = _mm_set1_ps(edgeA[1] * 4.0f);
+                __m128 edgeStep2 = _mm_set1_ps(edgeA[2] * 4.0f);
+                __m128 depthStep = _mm_set1_ps(depthA * 4.0f);
+                __m128 zero = _mm_setzero_ps();
+
+                for (uint32_t x = firstX; x <= lastX; x += 4)
+                {
+                    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+
+                    if (_mm_movemask_ps(inside) != 0)
+                    {
+                        __m128 previous = _mm_loadu_ps(row + (x - tileX));
+                        __m128 nearest = _mm_min_ps(previous, depth);
+                        _mm_storeu_ps(row + (x - tileX), _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+                    }
+
+                    edge0 = _mm_add_ps(edge0, edgeStep0);
+                    edge1 = _mm_add_ps(edge1, edgeStep1);
+                    edge2 = _mm_add_ps(edge2, edgeStep2);
+                    depth = _mm_add_ps(depth, depthStep);
+                }
+#else
+                for (uint32_t x = firstX; x <= lastX; x++)
+                {
+                    float centerX = static_cast<float>(x) + 0.5f;
+
+                    if (edgeA[0] * centerX + edgeB[0] * centerY + edgeC[0] < 0.0f || edgeA[1] * centerX + edgeB[1] * centerY + edgeC[1] < 0.0f ||
+                        edgeA[2] * centerX + edgeB[2] * centerY + edgeC[2] < 0.0f)
+                        continue;
+
+                    row[x - tileX] = std::min(row[x - tileX], depthA * centerX + depthB * centerY + depthC);
+                }
+#endif
+            }
+        }
+
+        auto [minDepth, maxDepth] = std::minmax_element(tileDepths, tileDepths + tileSize * tileSize);
+        tileMinDepths[tile] = *minDepth;
+        tileMaxDepths[tile] = *maxDepth;
+    }
+}
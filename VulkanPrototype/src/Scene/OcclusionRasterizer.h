@@ -0,0 +1,83 @@
+#ifndef OCCLUSIONRASTERIZER_H
+#define OCCLUSIONRASTERIZER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Bvh.h"
+#include "GlmConfig.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Occlusion Rasterizer
+    */
+
+    // Vertices in pixels of the depth buffer, z is the depth of Vulkan between 0 and 1
+    struct OccluderTriangle
+    {
+        glm::vec3 vertices[3];
+
+        // Edge (opposite to this vertex) the triangle shares with the other half of its box face
+        uint32_t faceDiagonal;
+    };
+
+    /// <summary>
+    /// Software Occlusion Culling auf der CPU: Verdecker werden mit niedriger Aufloesung in einen Tiefenpuffer gerastert,
+    /// danach werden die AABBs der Objekte dagegen getestet, ohne auf die GPU zu warten.
+    /// Der Puffer liegt Kachel fuer Kachel im Speicher, die Kacheln werden parallel auf den Workern des Job Systems gerastert,
+    /// jeweils vier Pixel einer Zeile auf einmal.
+    /// </summary>
+    class OcclusionRasterizer
+    {
+    public:
+        static constexpr uint32_t width = 320;
+        static constexpr uint32_t height = 192;
+        static constexpr uint32_t tileSize = 32;
+        static constexpr uint32_t tilesX = width / tileSize;
+        static constexpr uint32_t tilesY = height / tileSize;
+
+        /// <summary>
+        /// Leert den Tiefenpuffer und die Verdecker. viewProjection ist Projektion * View (* Model) wie beim Frustum Culling.
+        /// </summary>
+        void begin(const glm::mat4& viewProjection);
+
+        /// <summary>
+        /// Fuegt die zwoelf Dreiecke der Box als Verdecker hinzu. Dreiecke, die die Near Plane schneiden, werden verworfen.
+        /// </summary>
+        void addOccluderBox(const glm::mat4& worldMatrix, const Aabb& localBounds);
+
+        void rasterize();
+
+        /// <summary>
+        /// Gibt false zurueck, wenn die Box vollstaendig hinter den Verdeckern liegt. Thread-sicher nach rasterize().
+        /// </summary>
+        bool isVisible(const Aabb& worldBounds) const;
+
+        uint32_t getOccluderTriangleCount() const;
+
+        // Binning and rasterization of the last rasterize() call
+        float getRasterTime() const;
+
+    private:
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+
+        // tileSize * tileSize depths per tile, the rows of a tile lie one after another
+        std::vector<float> depths;
+
+        // Nearest and farthest depth of every tile, for early outs of the visibility test
+        std::vector<float> tileMinDepths;
+        std::vector<float> tileMaxDepths;
+
+        std::vector<OccluderTriangle> triangles;
+
+        // Indices of the triangles overlapping each tile
+        std::vector<std::vector<uint32_t>> tileTriangles;
+
+        float rasterTime = 0.0f;
+
+        void rasterizeTile(uint32_t tile);
+    };
+}
+
+#endif // OCCLUSIONRASTERIZER_H
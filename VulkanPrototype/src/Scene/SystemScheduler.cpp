@@ -0,0 +1,63 @@
+#include "SystemScheduler.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+     * Private Functions
+     */
+
+    static bool conflicts(const System& first, const System& second)
+    {
+        return (first.writes & (second.reads | second.writes)) != 0 || (second.writes & first.reads) != 0;
+    }
+
+    /*
+     * Member Functions
+     */
+
+    void SystemScheduler::addSystem(const std::string& name, ComponentMask reads, ComponentMask writes, std::function<void(World&)> update)
+    {
+        systems.push_back({ name, reads, writes, std::move(update) });
+
+        // The new system runs one stage after the last system it conflicts with
+        uint32_t systemIndex = static_cast<uint32_t>(systems.size() - 1);
+        uint32_t stage = 0;
+
+        for (uint32_t i = 0; i < stages.size(); i++)
+        {
+            for (uint32_t otherIndex : stages[i])
+            {
+                if (conflicts(systems[otherIndex], systems[systemIndex]))
+                    stage = i + 1;
+            }
+        }
+
+        if (stage == stages.size())
+            stages.emplace_back();
+
+        stages[stage].push_back(systemIndex);
+    }
+
+    void SystemScheduler::run(World& world)
+    {
+        for (const std::vector<uint32_t>& stage : stages)
+        {
+            // A single system saves the round trip through the queues
+            if (stage.size() == 1)
+            {
+                systems[stage[0]].update(world);
+                continue;
+            }
+
+            Jobs::Counter counter;
+
+            for (uint32_t systemIndex : stage)
+            {
+                const System& system = systems[systemIndex];
+                Jobs::Run([&system, &world]() { system.update(world); }, &counter);
+            }
+
+            Jobs::Wait(counter);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "World.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the System Scheduler
+    */
+
+    struct System
+    {
+        std::string name;
+
+        // Components the system reads and writes, two systems conflict if one of them writes what the other one uses
+        ComponentMask reads;
+        ComponentMask writes;
+
+        std::function<void(World&)> update;
+    };
+
+    /// <summary>
+    /// Fuehrt Systeme in der Reihenfolge aus, in der sie hinzugefuegt wurden. Systeme ohne Konflikt in ihren Komponenten
+    /// landen in derselben Stufe und laufen parallel als Jobs, eine Stufe beginnt erst, wenn die vorherige fertig ist.
+    /// Systeme duerfen die Struktur der World nicht veraendern, sondern nur Komponenten lesen und schreiben.
+    /// </summary>
+    class SystemScheduler
+    {
+    public:
+        void addSystem(const std::string& name, ComponentMask reads, ComponentMask writes, std::function<void(World&)> update);
+        void run(World& world);
+
+    private:
+        std::vector<System> systems;
+
+        // Indices into systems, rebuilt when a system is added
+        std::vector<std::vector<uint32_t>> stages;
+    };
+}
+
+#endif // SYSTEMSCHEDULER_H
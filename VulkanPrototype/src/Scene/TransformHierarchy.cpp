@@ -0,0 +1,389 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+namespace VulkanPrototype::Scene
+{
+    /*
+     * Private Functions
+     */
+
+    static void composeWorldMatrices(const uint32_t* slots, uint32_t count, const uint32_t* parentSlots, const LocalTransform* localTransforms, glm::mat4* worldMatrices)
+    {
+        // The slots have to be ordered so every parent comes before its children, which the breadth first order guarantees
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t slot = slots[i];
+            const LocalTransform& localTransform = localTransforms[slot];
+
+            // Columns of rotation * scale, the local matrix is affine
+            glm::mat3 rotation = glm::mat3_cast(localTransform.rotation);
+            glm::vec3 axisX = rotation[0] * localTransform.scale.x;
+            glm::vec3 axisY = rotation[1] * localTransform.scale.y;
+            glm::vec3 axisZ = rotation[2] * localTransform.scale.z;
+            const glm::vec3& translation = localTransform.translation;
+
+            glm::mat4& worldMatrix = worldMatrices[slot];
+
+            if (parentSlots[slot] == TransformHierarchy::noParent)
+            {
+                worldMatrix = glm::mat4(glm::vec4(axisX, 0.0f), glm::vec4(axisY, 0.0f), glm::vec4(axisZ, 0.0f), glm::vec4(translation, 1.0f));
+                continue;
+            }
+
+            const glm::mat4& parentMatrix = worldMatrices[parentSlots[slot]];
+
+#if defined(__SSE__) || defined(_M_X64)
+            // parent * local, one column of the result per local column. The last row of the local matrix is (0, 0, 0, 1).
+            __m128 parentColumn0 = _mm_loadu_ps(&parentMatrix[0][0]);
+            __m128 parentColumn1 = _mm_loadu_ps(&parentMatrix[1][0]);
+            __m128 parentColumn2 = _mm_loadu_ps(&parentMatrix[2][0]);
+            __m128 parentColumn3 = _mm_loadu_ps(&parentMatrix[3][0]);
+
+            const glm::vec3* localColumns[] = { &axisX, &axisY, &axisZ, &translation };
+
+            for (uint32_t column = 0; column < 4; column++)
+            {
+                const glm::vec3& localColumn = *localColumns[column];
+
+                __m128 result = _mm_mul_ps(parentColumn0, _mm_set1_ps(localColumn.x));
+                result = _mm_add_ps(result, _mm_mul_ps(parentColumn1, _mm_set1_ps(localColumn.y)));
+                result = _mm_add_ps(result, _mm_mul_ps(parentColumn2, _mm_set1_ps(localColumn.z)));
+
+                if (column == 3)
+                    result = _mm_add_ps(result, parentColumn3);
+
+                _mm_storeu_ps(&worldMatrix[column][0], result);
+            }
+#else
+            worldMatrix = parentMatrix * glm::mat4(glm::vec4(axisX, 0.0f), glm::vec4(axisY, 0.0f), glm::vec4(axisZ, 0.0f), glm::vec4(translation, 1.0f));
+#endif
+        }
+    }
+
+    /*
+     * Member Functions
+     */
+
+    uint32_t TransformHierarchy::createNode(uint32_t parent, const LocalTransform& localTransform)
+    {
+        uint32_t node;
+
+        if (freeNodes.empty())
+        {
+            node = static_cast<uint32_t>(slotOfNode.size());
+            slotOfNode.push_back(0);
+            parentOfNode.push_back(noParent);
+        }
+        else
+        {
+            node = freeNodes.back();
+            freeNodes.pop_back();
+        }
+
+        // Appended for now, the rebuild in the next update moves it behind its parent
+        uint32_t slot = static_cast<uint32_t>(nodeOfSlot.size());
+
+        slotOfNode[node] = slot;
+        parentOfNode[node] = parent;
+
+        nodeOfSlot.push_back(node);
+        parentSlots.push_back(noParent);
+        firstChildSlots.push_back(0);
+        childCounts.push_back(0);
+        depths.push_back(0);
+        localTransforms.push_back(localTransform);
+        worldMatrices.push_back(glm::mat4(1.0f));
+        previousWorldPositions.push_back(localTransform.translation);
+        dirtyFlags.push_back(0);
+
+        structureChanged = true;
+
+        return node;
+    }
+
+    void TransformHierarchy::setParent(uint32_t node, uint32_t parent)
+    {
+        for (uint32_t ancestor = parent; ancestor != noParent; ancestor = parentOfNode[ancestor])
+        {
+            if (ancestor == node)
+                throw std::runtime_error("Ein Knoten kann nicht in seinen eigenen Teilbaum gehaengt werden.");
+        }
+
+        parentOfNode[node] = parent;
+        structureChanged = true;
+    }
+
+    void TransformHierarchy::destroyNode(uint32_t node)
+    {
+        for (uint32_t& parent : parentOfNode)
+        {
+            if (parent == node)
+                parent = parentOfNode[node];
+        }
+
+        // The slot stays until the rebuild, marked as unused
+        nodeOfSlot[slotOfNode[node]] = noParent;
+        slotOfNode[node] = noParent;
+        parentOfNode[node] = noParent;
+        freeNodes.push_back(node);
+
+        structureChanged = true;
+    }
+
+    void TransformHierarchy::setLocalTransform(uint32_t node, const LocalTransform& localTransform)
+    {
+        uint32_t slot = slotOfNode[node];
+
+        localTransforms[slot] = localTransform;
+
+        if (dirtyFlags[slot] == 0)
+        {
+            dirtyFlags[slot] = 1;
+            dirtySlots.push_back(slot);
+        }
+    }
+
+    const LocalTransform& TransformHierarchy::getLocalTransform(uint32_t node) const
+    {
+        return localTransforms[slotOfNode[node]];
+    }
+
+    const glm::mat4& TransformHierarchy::getWorldMatrix(uint32_t node) const
+    {
+        return worldMatrices[slotOfNode[node]];
+    }
+
+    glm::vec3 TransformHierarchy::getPreviousWorldPosition(uint32_t node) const
+    {
+        return previousWorldPositions[slotOfNode[node]];
+    }
+
+    void TransformHierarchy::update()
+    {
+        updatedNodes.clear();
+        changedSlots.clear();
+        changedSlotRanges.clear();
+
+        if (structureChanged)
+        {
+            rebuild();
+            return;
+        }
+
+        // Nodes that moved in the last step and not in this one are at rest again
+        for (uint32_t slot : movedSlots)
+            previousWorldPositions[slot] = glm::vec3(worldMatrices[slot][3]);
+
+        changedSlots.swap(movedSlots);
+
+        if (dirtySlots.empty())
+        {
+            mergeChangedSlots();
+            return;
+        }
+
+        for (uint32_t slot : dirtySlots)
+        {
+            levelSlots[depths[slot]].push_back(slot);
+            dirtyFlags[slot] = 0;
+        }
+
+        dirtySlots.clear();
+
+        // Level by level, every recomputed node adds its children to the next level
+        for (uint32_t depth = 0; depth < levelSlots.size(); depth++)
+        {
+            std::vector<uint32_t>& slots = levelSlots[depth];
+
+            if (slots.empty())
+                continue;
+
+            // A dirty node below a dirty parent is in the list twice, sorting also keeps the accesses sequential
+            std::sort(slots.begin(), slots.end());
+            slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+            for (uint32_t slot : slots)
+                previousWorldPositions[slot] = glm::vec3(worldMatrices[slot][3]);
+
+            composeWorldMatrices(slots.data(), static_cast<uint32_t>(slots.size()), parentSlots.data(), localTransforms.data(), worldMatrices.data());
+
+            for (uint32_t slot : slots)
+            {
+                movedSlots.push_back(slot);
+                changedSlots.push_back(slot);
+                updatedNodes.push_back(nodeOfSlot[slot]);
+
+                for (uint32_t child = firstChildSlots[slot]; child < firstChildSlots[slot] + childCounts[slot]; child++)
+                    levelSlots[depth + 1].push_back(child);
+            }
+
+            slots.clear();
+        }
+
+        mergeChangedSlots();
+    }
+
+    uint32_t TransformHierarchy::getNodeCount() const
+    {
+        return static_cast<uint32_t>(slotOfNode.size() - freeNodes.size());
+    }
+
+    uint32_t TransformHierarchy::getNodeHandleCount() const
+    {
+        return static_cast<uint32_t>(slotOfNode.size());
+    }
+
+    uint32_t TransformHierarchy::getUpdatedNodeCount() const
+    {
+        return static_cast<uint32_t>(updatedNodes.size());
+    }
+
+    const std::vector<uint32_t>& TransformHierarchy::getUpdatedNodes() const
+    {
+        return updatedNodes;
+    }
+
+    uint32_t TransformHierarchy::getSlot(uint32_t node) const
+    {
+        return slotOfNode[node];
+    }
+
+    uint32_t TransformHierarchy::getSlotCount() const
+    {
+        return static_cast<uint32_t>(nodeOfSlot.size());
+    }
+
+    const glm::mat4& TransformHierarchy::getSlotWorldMatrix(uint32_t slot) const
+    {
+        return worldMatrices[slot];
+    }
+
+    glm::vec3 TransformHierarchy::getSlotPreviousWorldPosition(uint32_t slot) const
+    {
+        return previousWorldPositions[slot];
+    }
+
+    const std::vector<SlotRange>& TransformHierarchy::getChangedSlotRanges() const
+    {
+        return changedSlotRanges;
+    }
+
+    void TransformHierarchy::rebuild()
+    {
+        uint32_t nodeCount = getNodeCount();
+
+        // Children of every node, grouped by a counting sort over the parents
+        std::vector<uint32_t> childOffsets(slotOfNode.size() + 1, 0);
+        std::vector<uint32_t> children(nodeCount);
+
+        for (uint32_t node = 0; node < slotOfNode.size(); node++)
+        {
+            if (slotOfNode[node] != noParent && parentOfNode[node] != noParent)
+                childOffsets[parentOfNode[node] + 1]++;
+        }
+
+        for (uint32_t node = 0; node < slotOfNode.size(); node++)
+            childOffsets[node + 1] += childOffsets[node];
+
+        std::vector<uint32_t> childPositions(childOffsets.begin(), childOffsets.end() - 1);
+
+        for (uint32_t node = 0; node < slotOfNode.size(); node++)
+        {
+            if (slotOfNode[node] != noParent && parentOfNode[node] != noParent)
+                children[childPositions[parentOfNode[node]]++] = node;
+        }
+
+        // Breadth first from the roots, in their old order
+        std::vector<uint32_t> newNodeOfSlot;
+        newNodeOfSlot.reserve(nodeCount);
+
+        for (uint32_t node : nodeOfSlot)
+        {
+            if (node != noParent && parentOfNode[node] == noParent)
+                newNodeOfSlot.push_back(node);
+        }
+
+        std::vector<uint32_t> newParentSlots(nodeCount);
+        std::vector<uint32_t> newFirstChildSlots(nodeCount);
+        std::vector<uint32_t> newChildCounts(nodeCount);
+        std::vector<uint32_t> newDepths(nodeCount);
+        std::vector<LocalTransform> newLocalTransforms(nodeCount);
+        std::vector<uint32_t> newSlotOfNode(slotOfNode.size(), noParent);
+
+        for (uint32_t slot = 0; slot < newNodeOfSlot.size(); slot++)
+        {
+            uint32_t node = newNodeOfSlot[slot];
+            uint32_t parent = parentOfNode[node];
+
+            newSlotOfNode[node] = slot;
+            newParentSlots[slot] = parent == noParent ? noParent : newSlotOfNode[parent];
+            newDepths[slot] = parent == noParent ? 0 : newDepths[newParentSlots[slot]] + 1;
+            newLocalTransforms[slot] = localTransforms[slotOfNode[node]];
+
+            newFirstChildSlots[slot] = static_cast<uint32_t>(newNodeOfSlot.size());
+            newChildCounts[slot] = childOffsets[node + 1] - childOffsets[node];
+
+            newNodeOfSlot.insert(newNodeOfSlot.end(), children.begin() + childOffsets[node], children.begin() + childOffsets[node + 1]);
+        }
+
+        slotOfNode = std::move(newSlotOfNode);
+        nodeOfSlot = std::move(newNodeOfSlot);
+        parentSlots = std::move(newParentSlots);
+        firstChildSlots = std::move(newFirstChildSlots);
+        childCounts = std::move(newChildCounts);
+        depths = std::move(newDepths);
+        localTransforms = std::move(newLocalTransforms);
+
+        // Every world matrix is recomputed, in slot order the parents come first
+        std::vector<uint32_t> allSlots(nodeCount);
+
+        for (uint32_t slot = 0; slot < nodeCount; slot++)
+            allSlots[slot] = slot;
+
+        worldMatrices.resize(nodeCount);
+        composeWorldMatrices(allSlots.data(), nodeCount, parentSlots.data(), localTransforms.data(), worldMatrices.data());
+
+        // Interpolation starts over, a moving node stands still for one step
+        previousWorldPositions.resize(nodeCount);
+
+        for (uint32_t slot = 0; slot < nodeCount; slot++)
+            previousWorldPositions[slot] = glm::vec3(worldMatrices[slot][3]);
+
+        dirtyFlags.assign(nodeCount, 0);
+        dirtySlots.clear();
+        movedSlots.clear();
+
+        levelSlots.clear();
+        levelSlots.resize(nodeCount > 0 ? depths.back() + 2 : 1);
+
+        structureChanged = false;
+        updatedNodes = nodeOfSlot;
+
+        if (nodeCount > 0)
+            changedSlotRanges.push_back({ 0, nodeCount });
+    }
+
+    void TransformHierarchy::mergeChangedSlots()
+    {
+        // A node that moved in the last step and again in this one is in the list twice
+        std::sort(changedSlots.begin(), changedSlots.end());
+
+        for (uint32_t slot : changedSlots)
+        {
+            if (!changedSlotRanges.empty() && slot <= changedSlotRanges.back().firstSlot + changedSlotRanges.back().slotCount)
+            {
+                SlotRange& range = changedSlotRanges.back();
+                range.slotCount = std::max(range.slotCount, slot + 1 - range.firstSlot);
+                continue;
+            }
+
+            changedSlotRanges.push_back({ slot, 1 });
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef TRANSFORMHIERARCHY_H
+#define TRANSFORMHIERARCHY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "GlmConfig.h"
+#include <glm/gtc/quaternion.hpp>
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Transform Hierarchy
+    */
+
+    struct LocalTransform
+    {
+        glm::vec3 translation = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+    };
+
+    // Consecutive slots in breadth first order
+    struct SlotRange
+    {
+        uint32_t firstSlot;
+        uint32_t slotCount;
+    };
+
+    /// <summary>
+    /// Eltern-Kind-Hierarchie von Transformationen. Die Knoten liegen in Breitensuche-Reihenfolge: nach Tiefe sortiert und
+    /// die Kinder eines Knotens direkt hintereinander, so sind Eltern immer vor ihren Kindern fertig.
+    /// update() berechnet nur die Weltmatrizen geaenderter Knoten und ihrer Teilbaeume neu, ohne Aenderungen kostet es fast nichts.
+    /// </summary>
+    class TransformHierarchy
+    {
+    public:
+        static constexpr uint32_t noParent = UINT32_MAX;
+
+        /// <summary>
+        /// Neue Knoten und neue Eltern sortieren die Hierarchie beim naechsten update() einmal komplett um.
+        /// </summary>
+        uint32_t createNode(uint32_t parent = noParent, const LocalTransform& localTransform = {});
+        void setParent(uint32_t node, uint32_t parent);
+
+        /// <summary>
+        /// Die Kinder des Knotens werden an seinen Elternknoten gehaengt.
+        /// </summary>
+        void destroyNode(uint32_t node);
+
+        void setLocalTransform(uint32_t node, const LocalTransform& localTransform);
+        const LocalTransform& getLocalTransform(uint32_t node) const;
+
+        const glm::mat4& getWorldMatrix(uint32_t node) const;
+
+        /// <summary>
+        /// Weltposition vor dem letzten update(), fuer die Interpolation zwischen zwei Simulationsschritten.
+        /// </summary>
+        glm::vec3 getPreviousWorldPosition(uint32_t node) const;
+
+        void update();
+
+        uint32_t getNodeCount() const;
+
+        // All handles are smaller than this, createNode reuses the handles of destroyed nodes
+        uint32_t getNodeHandleCount() const;
+
+        // Nodes whose world matrix was recomputed by the last update, all of them after a rebuild
+        uint32_t getUpdatedNodeCount() const;
+        const std::vector<uint32_t>& getUpdatedNodes() const;
+
+        /// <summary>
+        /// Slot des Knotens in Breitensuche-Reihenfolge. Gilt bis zum naechsten Umsortieren, danach sind alle Slots geaendert.
+        /// </summary>
+        uint32_t getSlot(uint32_t node) const;
+
+        // All slots are smaller than this, including the ones of destroyed nodes until the next rebuild
+        uint32_t getSlotCount() const;
+
+        const glm::mat4& getSlotWorldMatrix(uint32_t slot) const;
+        glm::vec3 getSlotPreviousWorldPosition(uint32_t slot) const;
+
+        /// <summary>
+        /// Slots, deren Weltmatrix oder vorherige Position sich im letzten update() geaendert hat, zu Bereichen zusammengefasst.
+        /// Ein geaenderter Teilbaum liegt pro Tiefe am Stueck, so sind es wenige Bereiche. Nach dem Umsortieren ein Bereich ueber alle Slots.
+        /// </summary>
+        const std::vector<SlotRange>& getChangedSlotRanges() const;
+
+    private:
+        // Stable handles, the source of the structure when the slots are rebuilt
+        std::vector<uint32_t> slotOfNode;
+        std::vector<uint32_t> parentOfNode;
+        std::vector<uint32_t> freeNodes;
+
+        // Per slot in breadth first order, new nodes are appended until the next rebuild
+        std::vector<uint32_t> nodeOfSlot;
+        std::vector<uint32_t> parentSlots;
+        std::vector<uint32_t> firstChildSlots;
+        std::vector<uint32_t> childCounts;
+        std::vector<uint32_t> depths;
+        std::vector<LocalTransform> localTransforms;
+        std::vector<glm::mat4> worldMatrices;
+        std::vector<glm::vec3> previousWorldPositions;
+
+        std::vector<uint8_t> dirtyFlags;
+        std::vector<uint32_t> dirtySlots;
+
+        // Their previous position has to catch up with the current one in the next update
+        std::vector<uint32_t> movedSlots;
+
+        // Slots to recompute, one list per depth
+        std::vector<std::vector<uint32_t>> levelSlots;
+
+        std::vector<uint32_t> updatedNodes;
+        std::vector<uint32_t> changedSlots;
+        std::vector<SlotRange> changedSlotRanges;
+
+        bool structureChanged = false;
+
+        void rebuild();
+        void mergeChangedSlots();
+    };
+}
+
+#endif // TRANSFORMHIERARCHY_H
@@ -0,0 +1,221 @@
+#include "VoxelChunk.h"
+
+#include <algorithm>
+
+namespace VulkanPrototype::Scene
+{
+    /*
+     * Private Functions
+     */
+
+    static uint32_t getBitsForPaletteSize(uint32_t paletteSize)
+    {
+        uint32_t bits = 0;
+
+        while ((1u << bits) < paletteSize)
+            bits = bits == 0 ? 1 : bits * 2;
+
+        return bits;
+    }
+
+    /*
+     * Member Functions
+     */
+
+    VoxelChunk::VoxelChunk(Block block)
+    {
+        palette.push_back(block);
+        paletteCounts.push_back(chunkBlockCount);
+    }
+
+    Block VoxelChunk::getBlock(uint32_t x, uint32_t y, uint32_t z) const
+    {
+        return palette[getIndex(getChunkBlockIndex(x, y, z))];
+    }
+
+    bool VoxelChunk::setBlock(uint32_t x, uint32_t y, uint32_t z, Block block)
+    {
+        uint32_t blockIndex = getChunkBlockIndex(x, y, z);
+        uint32_t oldIndex = getIndex(blockIndex);
+
+        if (palette[oldIndex] == block)
+            return false;
+
+        paletteCounts[oldIndex]--;
+
+        // The type may already be in the palette, otherwise an entry that no block uses anymore takes it
+        uint32_t paletteSize = static_cast<uint32_t>(palette.size());
+        uint32_t newIndex = paletteSize;
+        uint32_t freeIndex = paletteSize;
+
+        for (uint32_t i = 0; i < paletteSize; i++)
+        {
+            if (palette[i] == block)
+            {
+                newIndex = i;
+                break;
+            }
+
+            if (paletteCounts[i] == 0 && freeIndex == paletteSize)
+                freeIndex = i;
+        }
+
+        if (newIndex == paletteSize && freeIndex < paletteSize)
+        {
+            newIndex = freeIndex;
+            palette[newIndex] = block;
+        }
+        else if (newIndex == paletteSize)
+        {
+            palette.push_back(block);
+            paletteCounts.push_back(0);
+
+            if (palette.size() > (1ull << bitsPerBlock))
+                resize(getBitsForPaletteSize(static_cast<uint32_t>(palette.size())));
+        }
+
+        paletteCounts[newIndex]++;
+        setIndex(blockIndex, newIndex);
+
+        return true;
+    }
+
+    void VoxelChunk::setBlocks(const Block* blocks)
+    {
+        palette.clear();
+        paletteCounts.clear();
+
+        // Neighbouring blocks mostly have the same type, the last entry found is tried first
+        auto findEntry = [this](Block block, uint32_t& lastIndex)
+        {
+            if (lastIndex < palette.size() && palette[lastIndex] == block)
+                return lastIndex;
+
+            auto entry = std::find(palette.begin(), palette.end(), block);
+            lastIndex = static_cast<uint32_t>(entry - palette.begin());
+
+            return lastIndex;
+        };
+
+        uint32_t lastIndex = 0;
+
+        for (uint32_t i = 0; i < chunkBlockCount; i++)
+        {
+            uint32_t index = findEntry(blocks[i], lastIndex);
+
+            if (index == palette.size())
+            {
+                palette.push_back(blocks[i]);
+                paletteCounts.push_back(0);
+            }
+
+            paletteCounts[index]++;
+        }
+
+        bitsPerBlock = getBitsForPaletteSize(static_cast<uint32_t>(palette.size()));
+        indices.assign(chunkBlockCount * bitsPerBlock / 64, 0);
+
+        if (bitsPerBlock == 0)
+            return;
+
+        for (uint32_t i = 0; i < chunkBlockCount; i++)
+            setIndex(i, findEntry(blocks[i], lastIndex));
+    }
+
+    void VoxelChunk::getBlocks(Block* blocks) const
+    {
+        if (bitsPerBlock == 0)
+        {
+            std::fill(blocks, blocks + chunkBlockCount, palette[0]);
+            return;
+        }
+
+        // Word by word, every word holds the indices of the same number of blocks
+        uint32_t blocksPerWord = 64 / bitsPerBlock;
+        uint64_t mask = (1ull << bitsPerBlock) - 1;
+
+        for (uint32_t word = 0; word < indices.size(); word++)
+        {
+            uint64_t bits = indices[word];
+            Block* destination = blocks + word * blocksPerWord;
+
+            for (uint32_t i = 0; i < blocksPerWord; i++, bits >>= bitsPerBlock)
+                destination[i] = palette[bits & mask];
+        }
+    }
+
+    bool VoxelChunk::isEmpty() const
+    {
+        return getSolidBlockCount() == 0;
+    }
+
+    uint32_t VoxelChunk::getSolidBlockCount() const
+    {
+        uint32_t solidBlockCount = 0;
+
+        for (uint32_t i = 0; i < palette.size(); i++)
+        {
+            if (palette[i] != airBlock)
+                solidBlockCount += paletteCounts[i];
+        }
+
+        return solidBlockCount;
+    }
+
+    uint32_t VoxelChunk::getPaletteSize() const
+    {
+        return static_cast<uint32_t>(palette.size());
+    }
+
+    uint32_t VoxelChunk::getBitsPerBlock() const
+    {
+        return bitsPerBlock;
+    }
+
+    uint64_t VoxelChunk::getMemorySize() const
+    {
+        return palette.size() * sizeof(Block) + paletteCounts.size() * sizeof(uint32_t) + indices.size() * sizeof(uint64_t);
+    }
+
+    uint32_t VoxelChunk::getIndex(uint32_t blockIndex) const
+    {
+        if (bitsPerBlock == 0)
+            return 0;
+
+        uint32_t bit = blockIndex * bitsPerBlock;
+
+        return static_cast<uint32_t>((indices[bit / 64] >> (bit % 64)) & ((1ull << bitsPerBlock) - 1));
+    }
+
+    void VoxelChunk::setIndex(uint32_t blockIndex, uint32_t index)
+    {
+        if (bitsPerBlock == 0)
+            return;
+
+        uint32_t bit = blockIndex * bitsPerBlock;
+        uint64_t mask = ((1ull << bitsPerBlock) - 1) << (bit % 64);
+
+        indices[bit / 64] = (indices[bit / 64] & ~mask) | (static_cast<uint64_t>(index) << (bit % 64));
+    }
+
+    void VoxelChunk::resize(uint32_t newBitsPerBlock)
+    {
+        std::vector<uint64_t> oldIndices(chunkBlockCount * newBitsPerBlock / 64, 0);
+        oldIndices.swap(indices);
+
+        uint32_t oldBitsPerBlock = bitsPerBlock;
+        bitsPerBlock = newBitsPerBlock;
+
+        // Without indices every block used entry 0
+        if (oldBitsPerBlock == 0)
+            return;
+
+        uint64_t oldMask = (1ull << oldBitsPerBlock) - 1;
+
+        for (uint32_t i = 0; i < chunkBlockCount; i++)
+        {
+            uint32_t bit = i * oldBitsPerBlock;
+            setIndex(i, static_cast<uint32_t>((oldIndices[bit / 64] >> (bit % 64)) & oldMask));
+        }
+    }
+}
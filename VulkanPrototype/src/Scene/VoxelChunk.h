@@ -0,0 +1,80 @@
+#ifndef VOXELCHUNK_H
+#define VOXELCHUNK_H
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Voxel Chunks
+    */
+
+    // Block type, 0 is air and the only type that is not solid
+    using Block = uint16_t;
+
+    static const Block airBlock = 0;
+
+    static constexpr uint32_t voxelChunkSize = 32;
+    static constexpr uint32_t chunkBlockCount = voxelChunkSize * voxelChunkSize * voxelChunkSize;
+
+    // Index of a block inside its chunk, x varies fastest
+    inline uint32_t getChunkBlockIndex(uint32_t x, uint32_t y, uint32_t z)
+    {
+        return x + voxelChunkSize * (y + voxelChunkSize * z);
+    }
+
+    /// <summary>
+    /// 32x32x32 Bloecke, palettenkomprimiert: jeder Block speichert nur den Index seines Typs in der Palette des Chunks,
+    /// mit so wenigen Bits wie die Palette braucht (0, 1, 2, 4, 8 oder 16). Ein Chunk aus einem Typ belegt nur seine Palette.
+    /// Eintraege, die kein Block mehr benutzt, werden fuer neue Typen wiederverwendet, bevor die Indices breiter werden.
+    /// </summary>
+    class VoxelChunk
+    {
+    public:
+        VoxelChunk(Block block = airBlock);
+
+        Block getBlock(uint32_t x, uint32_t y, uint32_t z) const;
+
+        /// <summary>
+        /// Gibt true zurueck, wenn sich der Block geaendert hat.
+        /// </summary>
+        bool setBlock(uint32_t x, uint32_t y, uint32_t z, Block block);
+
+        /// <summary>
+        /// Ersetzt alle Bloecke, blocks hat chunkBlockCount Eintraege in der Reihenfolge von getChunkBlockIndex.
+        /// Die Palette wird in einem Durchgang neu aufgebaut, schneller als chunkBlockCount mal setBlock.
+        /// </summary>
+        void setBlocks(const Block* blocks);
+
+        /// <summary>
+        /// Entpackt alle Bloecke in der Reihenfolge von getChunkBlockIndex, fuer das Meshing.
+        /// </summary>
+        void getBlocks(Block* blocks) const;
+
+        // Only air, such a chunk has no mesh
+        bool isEmpty() const;
+
+        uint32_t getSolidBlockCount() const;
+        uint32_t getPaletteSize() const;
+        uint32_t getBitsPerBlock() const;
+
+        // Bytes of the palette and the packed indices, the uncompressed chunk would need sizeof(Block) * chunkBlockCount
+        uint64_t getMemorySize() const;
+
+    private:
+        // Indices never straddle two words, because the widths are powers of two
+        std::vector<Block> palette;
+        std::vector<uint32_t> paletteCounts;
+        std::vector<uint64_t> indices;
+        uint32_t bitsPerBlock = 0;
+
+        uint32_t getIndex(uint32_t blockIndex) const;
+        void setIndex(uint32_t blockIndex, uint32_t index);
+
+        // Repacks the indices with the new width
+        void resize(uint32_t newBitsPerBlock);
+    };
+}
+
+#endif // VOXELCHUNK_H
@@ -0,0 +1,224 @@
+#include "VoxelMesher.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Voxel Mesher
+    */
+
+    // Rectangle of equal faces in the plane at position[axis], spanning width blocks along the next axis and height along the one after
+    struct VoxelQuad
+    {
+        int32_t position[3];
+        uint32_t axis;
+        uint32_t width;
+        uint32_t height;
+        Block block;
+        bool positive;
+    };
+
+    /*
+    * Module Global Variables
+    */
+
+    // Stone, dirt, grass and sand, unknown types are shown in magenta
+    static const float blockColors[][3] =
+    {
+        { 0.0f, 0.0f, 0.0f },
+        { 0.52f, 0.52f, 0.55f },
+        { 0.48f, 0.33f, 0.2f },
+        { 0.33f, 0.62f, 0.22f },
+        { 0.86f, 0.78f, 0.52f }
+    };
+
+    // The mesh has no normals, so the directions are told apart by their brightness. Index axis * 2 + positive, up is -y.
+    static const float faceShades[6] = { 0.8f, 0.8f, 1.0f, 0.5f, 0.65f, 0.65f };
+
+    /*
+     * Global Functions
+     */
+
+    void GetBlockColor(Block block, float color[3])
+    {
+        if (block >= sizeof(blockColors) / sizeof(blockColors[0]))
+        {
+            color[0] = 1.0f;
+            color[1] = 0.0f;
+            color[2] = 1.0f;
+            return;
+        }
+
+        for (int i = 0; i < 3; i++)
+            color[i] = blockColors[block][i];
+    }
+
+    void MeshChunk(const Block* blocks, VoxelMesh& mesh)
+    {
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.faceCount = 0;
+        mesh.quadCount = 0;
+
+        std::vector<VoxelQuad> quads;
+
+        // Positive values are faces towards +axis, negative ones towards -axis, 0 is no face
+        int32_t mask[voxelChunkSize * voxelChunkSize];
+
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            uint32_t u = (axis + 1) % 3;
+            uint32_t v = (axis + 2) % 3;
+
+            // Plane s lies between the blocks s - 1 and s along the axis, the planes 0 and voxelChunkSize are shared with the neighbours
+            for (int32_t s = 0; s <= static_cast<int32_t>(voxelChunkSize); s++)
+            {
+                for (int32_t j = 0; j < static_cast<int32_t>(voxelChunkSize); j++)
+                {
+                    for (int32_t i = 0; i < static_cast<int32_t>(voxelChunkSize); i++)
+                    {
+                        int32_t position[3];
+                        position[axis] = s - 1;
+                        position[u] = i;
+                        position[v] = j;
+
+                        Block front = blocks[getPaddedBlockIndex(position[0], position[1], position[2])];
+                        position[axis] = s;
+                        Block back = blocks[getPaddedBlockIndex(position[0], position[1], position[2])];
+
+                        // Each face belongs to the chunk of its solid block
+                        int32_t value = 0;
+
+                        if (front != airBlock && back == airBlock && s > 0)
+                            value = front;
+                        else if (back != airBlock && front == airBlock && s < static_cast<int32_t>(voxelChunkSize))
+                            value = -static_cast<int32_t>(back);
+
+                        mask[i + j * voxelChunkSize] = value;
+                        mesh.faceCount += value != 0;
+                    }
+                }
+
+                // Grows every face first along u and then row by row along v, as long as all faces match
+                for (uint32_t j = 0; j < voxelChunkSize; j++)
+                {
+                    for (uint32_t i = 0; i < voxelChunkSize; )
+                    {
+                        int32_t value = mask[i + j * voxelChunkSize];
+
+                        if (value == 0)
+                        {
+                            i++;
+                            continue;
+                        }
+
+                        uint32_t width = 1;
+
+                        while (i + width < voxelChunkSize && mask[i + width + j * voxelChunkSize] == value)
+                            width++;
+
+                        uint32_t height = 1;
+
+                        while (j + height < voxelChunkSize)
+                        {
+                            const int32_t* row = mask + (j + height) * voxelChunkSize + i;
+
+                            if (std::any_of(row, row + width, [value](int32_t face) { return face != value; }))
+                                break;
+
+                            height++;
+                        }
+
+                        for (uint32_t y = j; y < j + height; y++)
+                            std::fill(mask + y * voxelChunkSize + i, mask + y * voxelChunkSize + i + width, 0);
+
+                        VoxelQuad& quad = quads.emplace_back();
+                        quad.position[axis] = s;
+                        quad.position[u] = static_cast<int32_t>(i);
+                        quad.position[v] = static_cast<int32_t>(j);
+                        quad.axis = axis;
+                        quad.width = width;
+                        quad.height = height;
+                        quad.block = static_cast<Block>(std::abs(value));
+                        quad.positive = value > 0;
+
+                        i += width;
+                    }
+                }
+            }
+        }
+
+        mesh.quadCount = static_cast<uint32_t>(quads.size());
+
+        if (quads.empty())
+            return;
+
+        for (int i = 0; i < 3; i++)
+        {
+            mesh.boundsMin[i] = static_cast<float>(voxelChunkSize);
+            mesh.boundsMax[i] = 0.0f;
+        }
+
+        for (const VoxelQuad& quad : quads)
+        {
+            uint32_t u = (quad.axis + 1) % 3;
+            uint32_t v = (quad.axis + 2) % 3;
+
+            for (int i = 0; i < 3; i++)
+                mesh.boundsMin[i] = std::min(mesh.boundsMin[i], static_cast<float>(quad.position[i]));
+
+            float end[3] = { static_cast<float>(quad.position[0]), static_cast<float>(quad.position[1]), static_cast<float>(quad.position[2]) };
+            end[u] += static_cast<float>(quad.width);
+            end[v] += static_cast<float>(quad.height);
+
+            for (int i = 0; i < 3; i++)
+                mesh.boundsMax[i] = std::max(mesh.boundsMax[i], end[i]);
+        }
+
+        // Corners on the chunk border lie on the bounds, which are reproduced exactly, so neighbouring chunks meet without gaps
+        mesh.quantization = Renderer::getVertexQuantization(mesh.boundsMin, mesh.boundsMax);
+
+        mesh.vertices.reserve(quads.size() * 4);
+        mesh.indices.reserve(quads.size() * 6);
+
+        for (const VoxelQuad& quad : quads)
+        {
+            uint32_t u = (quad.axis + 1) % 3;
+            uint32_t v = (quad.axis + 2) % 3;
+
+            float color[3];
+            GetBlockColor(quad.block, color);
+
+            float shade = faceShades[quad.axis * 2 + (quad.positive ? 1 : 0)];
+
+            for (int i = 0; i < 3; i++)
+                color[i] *= shade;
+
+            // The texture repeats once per block
+            float width = static_cast<float>(quad.width);
+            float height = static_cast<float>(quad.height);
+            const float corners[4][2] = { { 0.0f, 0.0f }, { width, 0.0f }, { width, height }, { 0.0f, height } };
+
+            uint32_t firstVertex = static_cast<uint32_t>(mesh.vertices.size());
+
+            for (const float* corner : corners)
+            {
+                float position[3] = { static_cast<float>(quad.position[0]), static_cast<float>(quad.position[1]), static_cast<float>(quad.position[2]) };
+                position[u] += corner[0];
+                position[v] += corner[1];
+
+                mesh.vertices.push_back(Renderer::quantizeVertex(mesh.quantization, position, color, corner));
+            }
+
+            // u cross v points along +axis, the winding matches the faces of cube.obj
+            const uint32_t positiveIndices[6] = { 0, 1, 2, 0, 2, 3 };
+            const uint32_t negativeIndices[6] = { 0, 2, 1, 0, 3, 2 };
+            const uint32_t* quadIndices = quad.positive ? positiveIndices : negativeIndices;
+
+            for (uint32_t i = 0; i < 6; i++)
+                mesh.indices.push_back(firstVertex + quadIndices[i]);
+        }
+    }
+}
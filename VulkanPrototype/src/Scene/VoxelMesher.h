@@ -0,0 +1,59 @@
+#ifndef VOXELMESHER_H
+#define VOXELMESHER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../Renderer/VertexLayout.h"
+#include "VoxelChunk.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Voxel Mesher
+    */
+
+    // A chunk with one layer of blocks of its six neighbours around it, so the faces on the chunk border are culled as well
+    static constexpr uint32_t paddedChunkSize = voxelChunkSize + 2;
+    static constexpr uint32_t paddedChunkBlockCount = paddedChunkSize * paddedChunkSize * paddedChunkSize;
+
+    // Block (-1, -1, -1) of the chunk is entry 0, x varies fastest like in the chunk
+    inline uint32_t getPaddedBlockIndex(int32_t x, int32_t y, int32_t z)
+    {
+        return static_cast<uint32_t>((x + 1) + static_cast<int32_t>(paddedChunkSize) * ((y + 1) + static_cast<int32_t>(paddedChunkSize) * (z + 1)));
+    }
+
+    /// <summary>
+    /// Mesh eines Chunks in Blockeinheiten relativ zu seiner Ecke, die Quantisierung bildet die Grenzen der Vertices ab.
+    /// </summary>
+    struct VoxelMesh
+    {
+        std::vector<Renderer::QuantizedVertex> vertices;
+        std::vector<uint32_t> indices;
+        Renderer::VertexQuantization quantization;
+        float boundsMin[3];
+        float boundsMax[3];
+
+        // Visible block faces before and after merging them, each quad has four vertices
+        uint32_t faceCount;
+        uint32_t quadCount;
+    };
+
+    /*
+     * Global Functions
+     */
+
+    /// <summary>
+    /// Greedy Meshing: die sichtbaren Flaechen jeder Schicht werden zu moeglichst grossen Rechtecken gleichen Typs zusammengefasst.
+    /// blocks hat paddedChunkBlockCount Eintraege, siehe getPaddedBlockIndex. Flaechen zum Rand der Polsterung gehoeren dem Nachbarn
+    /// und werden nicht erzeugt. Ohne sichtbare Flaeche bleibt mesh leer. Thread-sicher, mesh wird ueberschrieben.
+    /// </summary>
+    void MeshChunk(const Block* blocks, VoxelMesh& mesh);
+
+    /// <summary>
+    /// Grundfarbe des Blocktyps, Flaechen werden je nach Richtung zusaetzlich abgedunkelt.
+    /// </summary>
+    void GetBlockColor(Block block, float color[3]);
+}
+
+#endif // VOXELMESHER_H
@@ -0,0 +1,483 @@
+#include "VoxelWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "../Jobs/JobSystem.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Module Global Variables
+    */
+
+    // Wavelength of the coarsest octave of the height field in blocks, every further octave halves it
+    static const float terrainWavelength = 96.0f;
+    static const uint32_t terrainOctaveCount = 4;
+
+    // Dirt below the grass, and the lowest fifth of the surface range is sand
+    static const int32_t dirtDepth = 3;
+    static const float sandHeight = 0.2f;
+
+    /*
+     * Private Functions
+     */
+
+    static float hashLatticePoint(int32_t x, int32_t z, uint32_t seed)
+    {
+        // PCG hash of the point, the upper 24 bits become a value in [0, 1)
+        uint32_t state = static_cast<uint32_t>(x) * 747796405u + static_cast<uint32_t>(z) * 2891336453u + seed * 277803737u;
+        uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        word = (word >> 22u) ^ word;
+
+        return static_cast<float>(word >> 8) / static_cast<float>(1 << 24);
+    }
+
+    static float sampleValueNoise(float x, float z, uint32_t seed)
+    {
+        float cellX = std::floor(x);
+        float cellZ = std::floor(z);
+        int32_t x0 = static_cast<int32_t>(cellX);
+        int32_t z0 = static_cast<int32_t>(cellZ);
+
+        // Smoothstep between the lattice points, so the slopes have no kinks at the cell borders
+        float tx = x - cellX;
+        float tz = z - cellZ;
+        tx = tx * tx * (3.0f - 2.0f * tx);
+        tz = tz * tz * (3.0f - 2.0f * tz);
+
+        float top = glm::mix(hashLatticePoint(x0, z0, seed), hashLatticePoint(x0 + 1, z0, seed), tx);
+        float bottom = glm::mix(hashLatticePoint(x0, z0 + 1, seed), hashLatticePoint(x0 + 1, z0 + 1, seed), tx);
+
+        return glm::mix(top, bottom, tz);
+    }
+
+    static float sampleTerrainHeight(int32_t x, int32_t z, uint32_t seed)
+    {
+        float height = 0.0f;
+        float amplitude = 0.5f;
+        float frequency = 1.0f / terrainWavelength;
+        float amplitudeSum = 0.0f;
+
+        for (uint32_t octave = 0; octave < terrainOctaveCount; octave++)
+        {
+            height += amplitude * sampleValueNoise(static_cast<float>(x) * frequency, static_cast<float>(z) * frequency, seed + octave);
+            amplitudeSum += amplitude;
+            amplitude *= 0.5f;
+            frequency *= 2.0f;
+        }
+
+        return height / amplitudeSum;
+    }
+
+    /*
+     * Member Functions
+     */
+
+    void VoxelWorld::create(const glm::ivec3& origin, const glm::ivec3& chunkCounts)
+    {
+        this->origin = origin;
+        this->chunkCounts = chunkCounts;
+
+        uint32_t chunkCount = static_cast<uint32_t>(chunkCounts.x * chunkCounts.y * chunkCounts.z);
+
+        chunks.assign(chunkCount, VoxelChunk());
+        chunkStates.assign(chunkCount, ChunkState());
+        dirtyChunks.clear();
+        chunkBvh.clear();
+
+        vertexCount = 0;
+        faceCount = 0;
+    }
+
+    void VoxelWorld::generateTerrain(uint32_t seed, int32_t surfaceTop, int32_t surfaceBottom)
+    {
+        uint32_t chunkCount = getChunkCount();
+        int32_t sandLevel = surfaceBottom - static_cast<int32_t>(static_cast<float>(surfaceBottom - surfaceTop) * sandHeight);
+
+        Jobs::Counter counter;
+        Jobs::ParallelFor(chunkCount, 4, [this, seed, surfaceTop, surfaceBottom, sandLevel](uint32_t begin, uint32_t end)
+        {
+            std::vector<Block> blocks(chunkBlockCount);
+            int32_t surface[voxelChunkSize * voxelChunkSize];
+
+            for (uint32_t chunk = begin; chunk < end; chunk++)
+            {
+                glm::ivec3 chunkOrigin = glm::ivec3(getChunkOrigin(chunk));
+
+                // Higher noise values are higher hills, which have smaller y
+                for (uint32_t z = 0; z < voxelChunkSize; z++)
+                {
+                    for (uint32_t x = 0; x < voxelChunkSize; x++)
+                    {
+                        float height = sampleTerrainHeight(chunkOrigin.x + static_cast<int32_t>(x), chunkOrigin.z + static_cast<int32_t>(z), seed);
+                        surface[x + z * voxelChunkSize] = surfaceBottom - static_cast<int32_t>(height * static_cast<float>(surfaceBottom - surfaceTop));
+                    }
+                }
+
+                for (uint32_t z = 0; z < voxelChunkSize; z++)
+                {
+                    for (uint32_t y = 0; y < voxelChunkSize; y++)
+                    {
+                        int32_t worldY = chunkOrigin.y + static_cast<int32_t>(y);
+
+                        for (uint32_t x = 0; x < voxelChunkSize; x++)
+                        {
+                            int32_t depth = worldY - surface[x + z * voxelChunkSize];
+                            bool sand = surface[x + z * voxelChunkSize] >= sandLevel;
+                            Block block = airBlock;
+
+                            if (depth == 0)
+                                block = sand ? VOXEL_BLOCK_SAND : VOXEL_BLOCK_GRASS;
+                            else if (depth > 0 && depth <= dirtDepth)
+                                block = sand ? VOXEL_BLOCK_SAND : VOXEL_BLOCK_DIRT;
+                            else if (depth > dirtDepth)
+                                block = VOXEL_BLOCK_STONE;
+
+                            blocks[getChunkBlockIndex(x, y, z)] = block;
+                        }
+                    }
+                }
+
+                chunks[chunk].setBlocks(blocks.data());
+            }
+        }, counter);
+        Jobs::Wait(counter);
+
+        for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+            markDirty(chunk);
+    }
+
+    Block VoxelWorld::getBlock(const glm::ivec3& position) const
+    {
+        uint32_t chunk;
+        glm::ivec3 localPosition;
+
+        if (!findChunk(position, chunk, localPosition))
+            return airBlock;
+
+        return chunks[chunk].getBlock(localPosition.x, localPosition.y, localPosition.z);
+    }
+
+    bool VoxelWorld::setBlock(const glm::ivec3& position, Block block)
+    {
+        uint32_t chunk;
+        glm::ivec3 localPosition;
+
+        if (!findChunk(position, chunk, localPosition) || !chunks[chunk].setBlock(localPosition.x, localPosition.y, localPosition.z, block))
+            return false;
+
+        markDirty(chunk);
+
+        // Only the faces towards the six direct neighbours can change, the diagonal chunks never see this block
+        glm::ivec3 chunkPosition = (position - origin) / static_cast<int32_t>(voxelChunkSize);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            glm::ivec3 offset(0);
+            offset[axis] = 1;
+
+            if (localPosition[axis] == 0)
+                markDirty(chunkPosition - offset);
+            else if (localPosition[axis] == static_cast<int32_t>(voxelChunkSize) - 1)
+                markDirty(chunkPosition + offset);
+        }
+
+        return true;
+    }
+
+    uint32_t VoxelWorld::fillSphere(const glm::vec3& center, float radius, Block block)
+    {
+        glm::ivec3 first = glm::ivec3(glm::floor(center - radius));
+        glm::ivec3 last = glm::ivec3(glm::ceil(center + radius));
+        uint32_t changedCount = 0;
+
+        for (int32_t z = first.z; z <= last.z; z++)
+        {
+            for (int32_t y = first.y; y <= last.y; y++)
+            {
+                for (int32_t x = first.x; x <= last.x; x++)
+                {
+                    glm::vec3 offset = glm::vec3(x, y, z) + 0.5f - center;
+
+                    if (glm::dot(offset, offset) <= radius * radius && setBlock(glm::ivec3(x, y, z), block))
+                        changedCount++;
+                }
+            }
+        }
+
+        return changedCount;
+    }
+
+    bool VoxelWorld::raycast(const glm::vec3& start, const glm::vec3& direction, float maxDistance, glm::ivec3& block) const
+    {
+        // Steps from block to block, always over the closest of the three next block borders
+        glm::ivec3 position = glm::ivec3(glm::floor(start));
+        glm::ivec3 step(0);
+        glm::vec3 nextBorder(std::numeric_limits<float>::infinity());
+        glm::vec3 borderDistance(std::numeric_limits<float>::infinity());
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (direction[axis] > 0.0f)
+            {
+                step[axis] = 1;
+                nextBorder[axis] = (std::floor(start[axis]) + 1.0f - start[axis]) / direction[axis];
+                borderDistance[axis] = 1.0f / direction[axis];
+            }
+            else if (direction[axis] < 0.0f)
+            {
+                step[axis] = -1;
+                nextBorder[axis] = (start[axis] - std::floor(start[axis])) / -direction[axis];
+                borderDistance[axis] = -1.0f / direction[axis];
+            }
+        }
+
+        float distance = 0.0f;
+
+        while (distance <= maxDistance)
+        {
+            if (getBlock(position) != airBlock)
+            {
+                block = position;
+                return true;
+            }
+
+            int axis = nextBorder.x < nextBorder.y ? (nextBorder.x < nextBorder.z ? 0 : 2) : (nextBorder.y < nextBorder.z ? 1 : 2);
+
+            distance = nextBorder[axis];
+            position[axis] += step[axis];
+            nextBorder[axis] += borderDistance[axis];
+        }
+
+        return false;
+    }
+
+    glm::vec3 VoxelWorld::getChunkOrigin(uint32_t chunk) const
+    {
+        uint32_t countX = static_cast<uint32_t>(chunkCounts.x);
+        uint32_t countY = static_cast<uint32_t>(chunkCounts.y);
+
+        glm::ivec3 chunkPosition(chunk % countX, (chunk / countX) % countY, chunk / (countX * countY));
+
+        return glm::vec3(origin + chunkPosition * static_cast<int32_t>(voxelChunkSize));
+    }
+
+    uint32_t VoxelWorld::getChunkCount() const
+    {
+        return static_cast<uint32_t>(chunks.size());
+    }
+
+    uint32_t VoxelWorld::getDirtyChunkCount() const
+    {
+        return static_cast<uint32_t>(dirtyChunks.size());
+    }
+
+    uint32_t VoxelWorld::getMeshedChunkCount() const
+    {
+        return chunkBvh.getLeafCount();
+    }
+
+    uint64_t VoxelWorld::getVertexCount() const
+    {
+        return vertexCount;
+    }
+
+    uint64_t VoxelWorld::getFaceCount() const
+    {
+        return faceCount;
+    }
+
+    uint64_t VoxelWorld::getSolidBlockCount() const
+    {
+        uint64_t solidBlockCount = 0;
+
+        for (const VoxelChunk& chunk : chunks)
+            solidBlockCount += chunk.getSolidBlockCount();
+
+        return solidBlockCount;
+    }
+
+    uint64_t VoxelWorld::getMemorySize() const
+    {
+        uint64_t memorySize = 0;
+
+        for (const VoxelChunk& chunk : chunks)
+            memorySize += chunk.getMemorySize();
+
+        return memorySize;
+    }
+
+    float VoxelWorld::getMeshTime() const
+    {
+        return meshTime;
+    }
+
+    bool VoxelWorld::findChunk(const glm::ivec3& position, uint32_t& chunk, glm::ivec3& localPosition) const
+    {
+        glm::ivec3 worldPosition = position - origin;
+
+        if (glm::any(glm::lessThan(worldPosition, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(worldPosition, chunkCounts * static_cast<int32_t>(voxelChunkSize))))
+            return false;
+
+        glm::ivec3 chunkPosition = worldPosition / static_cast<int32_t>(voxelChunkSize);
+
+        chunk = static_cast<uint32_t>(chunkPosition.x + chunkCounts.x * (chunkPosition.y + chunkCounts.y * chunkPosition.z));
+        localPosition = worldPosition - chunkPosition * static_cast<int32_t>(voxelChunkSize);
+
+        return true;
+    }
+
+    void VoxelWorld::markDirty(uint32_t chunk)
+    {
+        if (chunkStates[chunk].dirty)
+            return;
+
+        chunkStates[chunk].dirty = true;
+        dirtyChunks.push_back(chunk);
+    }
+
+    void VoxelWorld::markDirty(const glm::ivec3& chunkPosition)
+    {
+        if (glm::any(glm::lessThan(chunkPosition, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(chunkPosition, chunkCounts)))
+            return;
+
+        markDirty(static_cast<uint32_t>(chunkPosition.x + chunkCounts.x * (chunkPosition.y + chunkCounts.y * chunkPosition.z)));
+    }
+
+    void VoxelWorld::copyPaddedBlocks(uint32_t chunk, Block* chunkBlocks, Block* blocks) const
+    {
+        chunks[chunk].getBlocks(chunkBlocks);
+
+        // The edges and corners of the padding are never read by the mesher, missing neighbours are air
+        std::fill(blocks, blocks + paddedChunkBlockCount, airBlock);
+
+        for (uint32_t z = 0; z < voxelChunkSize; z++)
+        {
+            for (uint32_t y = 0; y < voxelChunkSize; y++)
+            {
+                const Block* source = chunkBlocks + getChunkBlockIndex(0, y, z);
+                std::copy(source, source + voxelChunkSize, blocks + getPaddedBlockIndex(0, static_cast<int32_t>(y), static_cast<int32_t>(z)));
+            }
+        }
+
+        glm::ivec3 chunkOrigin = glm::ivec3(getChunkOrigin(chunk));
+        const int32_t size = static_cast<int32_t>(voxelChunkSize);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+
+            // The layer in front of the chunk and the one behind it, read block by block from the neighbours
+            for (int32_t layer : { -1, size })
+            {
+                for (int32_t j = 0; j < size; j++)
+                {
+                    for (int32_t i = 0; i < size; i++)
+                    {
+                        glm::ivec3 localPosition;
+                        localPosition[axis] = layer;
+                        localPosition[u] = i;
+                        localPosition[v] = j;
+
+                        blocks[getPaddedBlockIndex(localPosition.x, localPosition.y, localPosition.z)] = getBlock(chunkOrigin + localPosition);
+                    }
+                }
+            }
+        }
+    }
+
+    uint32_t VoxelWorld::meshDirtyChunks(uint32_t maxChunkCount, const glm::vec3& eye)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        uint32_t count = std::min(maxChunkCount, static_cast<uint32_t>(dirtyChunks.size()));
+
+        if (count == 0)
+        {
+            meshTime = 0.0f;
+            return 0;
+        }
+
+        // The closest chunks first, the others stay marked for the next calls
+        auto getDistance = [this, &eye](uint32_t chunk)
+        {
+            glm::vec3 offset = getChunkOrigin(chunk) + 0.5f * static_cast<float>(voxelChunkSize) - eye;
+            return glm::dot(offset, offset);
+        };
+
+        std::partial_sort(dirtyChunks.begin(), dirtyChunks.begin() + count, dirtyChunks.end(), [&getDistance](uint32_t first, uint32_t second)
+        {
+            return getDistance(first) < getDistance(second);
+        });
+
+        meshedChunks.assign(dirtyChunks.begin(), dirtyChunks.begin() + count);
+        dirtyChunks.erase(dirtyChunks.begin(), dirtyChunks.begin() + count);
+
+        for (uint32_t chunk : meshedChunks)
+            chunkStates[chunk].dirty = false;
+
+        if (chunkMeshes.size() < count)
+            chunkMeshes.resize(count);
+
+        // The chunks are only read, nothing edits the world before Wait returns
+        Jobs::Counter counter;
+        Jobs::ParallelFor(count, 1, [this](uint32_t begin, uint32_t end)
+        {
+            // The padded block array followed by the unpacked chunk. Per thread instead of per thread index,
+            // so it does not matter which threads run the jobs or whether they are registered at the job system.
+            static thread_local std::vector<Block> paddedBlocks;
+            paddedBlocks.resize(paddedChunkBlockCount + chunkBlockCount);
+
+            Block* blocks = paddedBlocks.data();
+
+            for (uint32_t i = begin; i < end; i++)
+            {
+                copyPaddedBlocks(meshedChunks[i], blocks + paddedChunkBlockCount, blocks);
+                MeshChunk(blocks, chunkMeshes[i]);
+            }
+        }, counter);
+        Jobs::Wait(counter);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const VoxelMesh& mesh = chunkMeshes[i];
+            ChunkState& state = chunkStates[meshedChunks[i]];
+
+            // Separately, the difference of two unsigned counts would wrap around when the chunk lost faces
+            vertexCount -= state.vertexCount;
+            vertexCount += mesh.vertices.size();
+            faceCount -= state.faceCount;
+            faceCount += mesh.faceCount;
+            state.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            state.faceCount = mesh.faceCount;
+
+            if (mesh.vertices.empty())
+            {
+                if (state.leaf != noBvhNode)
+                    chunkBvh.remove(state.leaf);
+
+                state.leaf = noBvhNode;
+                continue;
+            }
+
+            glm::vec3 chunkOrigin = getChunkOrigin(meshedChunks[i]);
+            Aabb bounds =
+            {
+                chunkOrigin + glm::vec3(mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]),
+                chunkOrigin + glm::vec3(mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2])
+            };
+
+            if (state.leaf == noBvhNode)
+                state.leaf = chunkBvh.insert(bounds, meshedChunks[i]);
+            else
+                chunkBvh.update(state.leaf, bounds);
+        }
+
+        meshTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        return count;
+    }
+}
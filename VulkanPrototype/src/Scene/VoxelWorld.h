@@ -0,0 +1,145 @@
+#ifndef VOXELWORLD_H
+#define VOXELWORLD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Bvh.h"
+#include "GlmConfig.h"
+#include "VoxelChunk.h"
+#include "VoxelMesher.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Voxel World
+    */
+
+    // Stone, dirt, grass and sand of the generated terrain, see GetBlockColor
+    enum VoxelBlockType : Block
+    {
+        VOXEL_BLOCK_STONE = 1,
+        VOXEL_BLOCK_DIRT = 2,
+        VOXEL_BLOCK_GRASS = 3,
+        VOXEL_BLOCK_SAND = 4
+    };
+
+    /// <summary>
+    /// Blockwelt aus einem festen Gitter von Chunks, Block (x, y, z) fuellt den Wuerfel von (x, y, z) bis (x + 1, y + 1, z + 1).
+    /// Geaenderte Chunks und ihre Nachbarn, deren Randflaechen sich mit aendern, werden markiert und von remeshDirtyChunks()
+    /// auf dem Job System neu vernetzt. Nicht leere Meshes liegen mit ihren Grenzen in einer BVH fuer das Frustum Culling.
+    /// </summary>
+    class VoxelWorld
+    {
+    public:
+        /// <summary>
+        /// Ersetzt die Welt durch chunkCounts leere Chunks, der erste beginnt bei Block origin.
+        /// </summary>
+        void create(const glm::ivec3& origin, const glm::ivec3& chunkCounts);
+
+        /// <summary>
+        /// Fuellt alle Chunks mit einem Gelaende aus einem Hoehenfeld, die Chunks werden parallel auf dem Job System erzeugt.
+        /// Die Oberflaeche liegt zwischen surfaceTop und surfaceBottom, y zeigt nach unten wie die Kamera.
+        /// </summary>
+        void generateTerrain(uint32_t seed, int32_t surfaceTop, int32_t surfaceBottom);
+
+        // Air outside of the world
+        Block getBlock(const glm::ivec3& position) const;
+
+        /// <summary>
+        /// Gibt false zurueck, wenn die Position ausserhalb liegt oder der Block schon diesen Typ hat.
+        /// </summary>
+        bool setBlock(const glm::ivec3& position, Block block);
+
+        /// <summary>
+        /// Setzt alle Bloecke, deren Mittelpunkt in der Kugel liegt. Gibt die Anzahl der geaenderten Bloecke zurueck.
+        /// </summary>
+        uint32_t fillSphere(const glm::vec3& center, float radius, Block block);
+
+        /// <summary>
+        /// Erster fester Block entlang des Strahls bis maxDistance (in Vielfachen von direction), Block fuer Block gelaufen.
+        /// </summary>
+        bool raycast(const glm::vec3& start, const glm::vec3& direction, float maxDistance, glm::ivec3& block) const;
+
+        /// <summary>
+        /// Vernetzt bis zu maxChunkCount markierte Chunks, die naechsten zu eye zuerst, parallel auf dem Job System und ruft danach
+        /// callback(chunk, mesh) auf dem aufrufenden Thread fuer jeden. Leere Meshes bedeuten, dass der Chunk nichts mehr zeichnet.
+        /// Gibt die Anzahl der vernetzten Chunks zurueck.
+        /// </summary>
+        template<typename F>
+        uint32_t remeshDirtyChunks(uint32_t maxChunkCount, const glm::vec3& eye, F&& callback)
+        {
+            uint32_t count = meshDirtyChunks(maxChunkCount, eye);
+
+            for (uint32_t i = 0; i < count; i++)
+                callback(meshedChunks[i], chunkMeshes[i]);
+
+            return count;
+        }
+
+        /// <summary>
+        /// Ruft callback(chunk) fuer jeden Chunk mit Mesh, dessen Grenzen das Frustum schneiden.
+        /// </summary>
+        template<typename F>
+        void queryFrustum(const Frustum& frustum, F&& callback) const
+        {
+            chunkBvh.queryFrustum(frustum, callback);
+        }
+
+        // Position of the first block of the chunk, the chunk meshes are relative to it
+        glm::vec3 getChunkOrigin(uint32_t chunk) const;
+
+        uint32_t getChunkCount() const;
+        uint32_t getDirtyChunkCount() const;
+
+        // Chunks with a mesh, vertices and visible block faces over all of them
+        uint32_t getMeshedChunkCount() const;
+        uint64_t getVertexCount() const;
+        uint64_t getFaceCount() const;
+        uint64_t getSolidBlockCount() const;
+
+        // Palette compressed size of all chunks in bytes
+        uint64_t getMemorySize() const;
+
+        // Time of the last remeshDirtyChunks() call in milliseconds
+        float getMeshTime() const;
+
+    private:
+        struct ChunkState
+        {
+            uint32_t leaf = noBvhNode;
+            uint32_t vertexCount = 0;
+            uint32_t faceCount = 0;
+            bool dirty = false;
+        };
+
+        glm::ivec3 origin = glm::ivec3(0);
+        glm::ivec3 chunkCounts = glm::ivec3(0);
+        std::vector<VoxelChunk> chunks;
+        std::vector<ChunkState> chunkStates;
+        std::vector<uint32_t> dirtyChunks;
+
+        Bvh chunkBvh;
+
+        // Results of the last meshDirtyChunks() call, the callback may move the vectors out of the meshes
+        std::vector<uint32_t> meshedChunks;
+        std::vector<VoxelMesh> chunkMeshes;
+
+        uint64_t vertexCount = 0;
+        uint64_t faceCount = 0;
+        float meshTime = 0.0f;
+
+        // False outside of the world, otherwise the chunk and the position inside of it
+        bool findChunk(const glm::ivec3& position, uint32_t& chunk, glm::ivec3& localPosition) const;
+
+        void markDirty(uint32_t chunk);
+        void markDirty(const glm::ivec3& chunkPosition);
+
+        // Blocks of the chunk and the bordering layers of its neighbours, see getPaddedBlockIndex. chunkBlocks takes the unpacked chunk first.
+        void copyPaddedBlocks(uint32_t chunk, Block* chunkBlocks, Block* blocks) const;
+
+        uint32_t meshDirtyChunks(uint32_t maxChunkCount, const glm::vec3& eye);
+    };
+}
+
+#endif // VOXELWORLD_H
@@ -0,0 +1,280 @@
+#include "World.h"
+
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Entity Component System
+    */
+
+    struct ComponentInfo
+    {
+        uint32_t size;
+        uint32_t alignment;
+    };
+
+    /*
+    * Module Global Variables
+    */
+
+    // Component types register themselves on first use, possibly from different threads
+    static std::mutex componentInfoMutex;
+    static ComponentInfo componentInfos[maxComponentTypes];
+    static uint32_t componentTypeCount = 0;
+
+    // Chunks start on a cache line, so no component array shares its first line with the entities
+    static const std::align_val_t chunkAlignment = std::align_val_t(64);
+
+    /*
+     * Private Functions
+     */
+
+    static uint32_t alignOffset(uint32_t offset, uint32_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static uint32_t computeLayout(Archetype& archetype, uint32_t capacity)
+    {
+        uint32_t offset = sizeof(Entity) * capacity;
+
+        for (uint32_t componentType : archetype.componentTypes)
+        {
+            const ComponentInfo& info = componentInfos[componentType];
+
+            offset = alignOffset(offset, info.alignment);
+            archetype.componentOffsets[componentType] = offset;
+            offset += info.size * capacity;
+        }
+
+        return offset;
+    }
+
+    static void copyRow(const Archetype& archetype, const Chunk& source, uint32_t sourceRow, const Archetype& destinationArchetype, Chunk& destination, uint32_t destinationRow)
+    {
+        // Components the destination does not have are dropped, new ones stay zeroed
+        for (uint32_t componentType : archetype.componentTypes)
+        {
+            if ((destinationArchetype.mask & (ComponentMask(1) << componentType)) == 0)
+                continue;
+
+            uint32_t size = componentInfos[componentType].size;
+
+            std::memcpy(destination.data + destinationArchetype.componentOffsets[componentType] + size * destinationRow,
+                source.data + archetype.componentOffsets[componentType] + size * sourceRow, size);
+        }
+    }
+
+    /*
+     * Member Functions
+     */
+
+    World::~World()
+    {
+        for (Archetype& archetype : archetypes)
+        {
+            for (Chunk& chunk : archetype.chunks)
+                ::operator delete(chunk.data, chunkAlignment);
+        }
+    }
+
+    Entity World::createEntity(ComponentMask mask)
+    {
+        uint32_t index;
+
+        if (freeEntityIndices.empty())
+        {
+            index = static_cast<uint32_t>(entityRecords.size());
+            entityRecords.push_back({});
+        }
+        else
+        {
+            index = freeEntityIndices.back();
+            freeEntityIndices.pop_back();
+        }
+
+        EntityRecord& record = entityRecords[index];
+        Entity entity = { index, record.generation };
+
+        record.archetype = getArchetype(mask);
+        record.row = appendRow(record.archetype, record.chunk);
+
+        Archetype& archetype = archetypes[record.archetype];
+        Chunk& chunk = archetype.chunks[record.chunk];
+
+        getEntities(chunk)[record.row] = entity;
+
+        for (uint32_t componentType : archetype.componentTypes)
+        {
+            uint32_t size = componentInfos[componentType].size;
+            std::memset(chunk.data + archetype.componentOffsets[componentType] + size * record.row, 0, size);
+        }
+
+        entityCount++;
+        return entity;
+    }
+
+    void World::destroyEntity(Entity entity)
+    {
+        if (!isAlive(entity))
+            return;
+
+        EntityRecord& record = entityRecords[entity.index];
+
+        removeRow(record.archetype, record.chunk, record.row);
+
+        record.generation++;
+        freeEntityIndices.push_back(entity.index);
+        entityCount--;
+    }
+
+    bool World::isAlive(Entity entity) const
+    {
+        return entity.index < entityRecords.size() && entityRecords[entity.index].generation == entity.generation;
+    }
+
+    uint32_t World::getEntityCount() const
+    {
+        return entityCount;
+    }
+
+    uint32_t World::getArchetype(ComponentMask mask)
+    {
+        auto existing = archetypeLookup.find(mask);
+
+        if (existing != archetypeLookup.end())
+            return existing->second;
+
+        Archetype archetype = { .mask = mask };
+        uint32_t rowSize = sizeof(Entity);
+
+        for (uint32_t componentType = 0; componentType < maxComponentTypes; componentType++)
+        {
+            if ((mask & (ComponentMask(1) << componentType)) == 0)
+                continue;
+
+            archetype.componentTypes.push_back(componentType);
+            rowSize += componentInfos[componentType].size;
+        }
+
+        // The estimate ignores the padding between the arrays, so it may have to shrink a bit
+        archetype.capacity = chunkSize / rowSize;
+
+        while (archetype.capacity > 0 && computeLayout(archetype, archetype.capacity) > chunkSize)
+            archetype.capacity--;
+
+        if (archetype.capacity == 0)
+            throw std::runtime_error("Die Komponenten eines Archetyps passen nicht in einen Chunk.");
+
+        uint32_t archetypeIndex = static_cast<uint32_t>(archetypes.size());
+
+        archetypes.push_back(std::move(archetype));
+        archetypeLookup[mask] = archetypeIndex;
+
+        return archetypeIndex;
+    }
+
+    void World::changeArchetype(Entity entity, ComponentMask mask)
+    {
+        if (!isAlive(entity))
+            return;
+
+        EntityRecord& record = entityRecords[entity.index];
+        uint32_t newArchetypeIndex = getArchetype(mask);
+
+        if (newArchetypeIndex == record.archetype)
+            return;
+
+        uint32_t newChunkIndex;
+        uint32_t newRow = appendRow(newArchetypeIndex, newChunkIndex);
+
+        Archetype& oldArchetype = archetypes[record.archetype];
+        Archetype& newArchetype = archetypes[newArchetypeIndex];
+        Chunk& newChunk = newArchetype.chunks[newChunkIndex];
+
+        for (uint32_t componentType : newArchetype.componentTypes)
+        {
+            uint32_t size = componentInfos[componentType].size;
+            std::memset(newChunk.data + newArchetype.componentOffsets[componentType] + size * newRow, 0, size);
+        }
+
+        copyRow(oldArchetype, oldArchetype.chunks[record.chunk], record.row, newArchetype, newChunk, newRow);
+        getEntities(newChunk)[newRow] = entity;
+
+        removeRow(record.archetype, record.chunk, record.row);
+
+        record.archetype = newArchetypeIndex;
+        record.chunk = newChunkIndex;
+        record.row = newRow;
+    }
+
+    uint32_t World::appendRow(uint32_t archetypeIndex, uint32_t& chunkIndex)
+    {
+        Archetype& archetype = archetypes[archetypeIndex];
+
+        if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity)
+            archetype.chunks.push_back({ static_cast<uint8_t*>(::operator new(chunkSize, chunkAlignment)), 0 });
+
+        chunkIndex = static_cast<uint32_t>(archetype.chunks.size() - 1);
+        return archetype.chunks.back().count++;
+    }
+
+    void World::removeRow(uint32_t archetypeIndex, uint32_t chunkIndex, uint32_t row)
+    {
+        Archetype& archetype = archetypes[archetypeIndex];
+        Chunk& lastChunk = archetype.chunks.back();
+        uint32_t lastRow = lastChunk.count - 1;
+
+        // The last entity of the archetype fills the hole, so only the last chunk is ever partially filled
+        if (&archetype.chunks[chunkIndex] != &lastChunk || row != lastRow)
+        {
+            Chunk& chunk = archetype.chunks[chunkIndex];
+            Entity movedEntity = getEntities(lastChunk)[lastRow];
+
+            copyRow(archetype, lastChunk, lastRow, archetype, chunk, row);
+            getEntities(chunk)[row] = movedEntity;
+
+            entityRecords[movedEntity.index].chunk = chunkIndex;
+            entityRecords[movedEntity.index].row = row;
+        }
+
+        if (--lastChunk.count == 0)
+        {
+            ::operator delete(lastChunk.data, chunkAlignment);
+            archetype.chunks.pop_back();
+        }
+    }
+
+    void* World::getComponentPointer(Entity entity, uint32_t componentType)
+    {
+        if (!isAlive(entity))
+            return nullptr;
+
+        const EntityRecord& record = entityRecords[entity.index];
+        const Archetype& archetype = archetypes[record.archetype];
+
+        if ((archetype.mask & (ComponentMask(1) << componentType)) == 0)
+            return nullptr;
+
+        return archetype.chunks[record.chunk].data + archetype.componentOffsets[componentType] + componentInfos[componentType].size * record.row;
+    }
+
+    /*
+     * Global Functions
+     */
+
+    uint32_t RegisterComponentType(uint32_t size, uint32_t alignment)
+    {
+        std::lock_guard<std::mutex> lock(componentInfoMutex);
+
+        if (componentTypeCount == maxComponentTypes)
+            throw std::runtime_error("Zu viele Komponententypen.");
+
+        componentInfos[componentTypeCount] = { size, alignment };
+        return componentTypeCount++;
+    }
+}
@@ -0,0 +1,294 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../Jobs/JobSystem.h"
+
+namespace VulkanPrototype::Scene
+{
+    /*
+    * Helper Structs for the Entity Component System
+    */
+
+    // One bit per component type, an archetype holds every entity with exactly this set of components
+    using ComponentMask = uint64_t;
+
+    static const uint32_t maxComponentTypes = 64;
+    static const uint32_t chunkSize = 16 * 1024;
+
+    struct Entity
+    {
+        uint32_t index = UINT32_MAX;
+
+        // Incremented when the index is reused, so handles to destroyed entities can be detected
+        uint32_t generation = 0;
+
+        bool operator==(const Entity& other) const = default;
+    };
+
+    struct Chunk
+    {
+        // Entities at offset 0, followed by one array per component type (SoA)
+        uint8_t* data = nullptr;
+        uint32_t count = 0;
+    };
+
+    struct Archetype
+    {
+        ComponentMask mask = 0;
+        std::vector<uint32_t> componentTypes;
+
+        // Offset of the component array in every chunk, indexed by the component type
+        uint32_t componentOffsets[maxComponentTypes] = {};
+        uint32_t capacity = 0;
+
+        // All chunks are full except the last one
+        std::vector<Chunk> chunks;
+    };
+
+    /*
+     * Global Functions
+     */
+
+    uint32_t RegisterComponentType(uint32_t size, uint32_t alignment);
+
+    /// <summary>
+    /// Fortlaufende Nummer des Komponententyps. Komponenten werden mit memcpy verschoben, sie muessen trivial kopierbar sein.
+    /// </summary>
+    template<typename T>
+    uint32_t GetComponentType()
+    {
+        // const T shares the number of T, queries use it for components they only read
+        if constexpr (!std::is_same_v<T, std::remove_cvref_t<T>>)
+        {
+            return GetComponentType<std::remove_cvref_t<T>>();
+        }
+        else
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Komponenten muessen trivial kopierbar sein");
+
+            static const uint32_t componentType = RegisterComponentType(sizeof(T), alignof(T));
+            return componentType;
+        }
+    }
+
+    template<typename... Components>
+    ComponentMask GetComponentMask()
+    {
+        return (ComponentMask(0) | ... | (ComponentMask(1) << GetComponentType<Components>()));
+    }
+
+    /// <summary>
+    /// Speichert Entities nach Archetyp in Chunks fester Groesse, jede Komponente als eigenes Array im Chunk.
+    /// Abfragen laufen ueber alle Archetypen, die die angefragten Komponenten enthalten, und liefern pro Chunk dichte Arrays.
+    /// Waehrend einer Abfrage duerfen keine Entities erzeugt, entfernt oder um Komponenten veraendert werden.
+    /// </summary>
+    class World
+    {
+    public:
+        World() = default;
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+        ~World();
+
+        Entity createEntity(ComponentMask mask = 0);
+
+        template<typename... Components>
+        Entity createEntity(const Components&... components)
+        {
+            Entity entity = createEntity(GetComponentMask<Components...>());
+            (setComponent(entity, components), ...);
+
+            return entity;
+        }
+
+        void destroyEntity(Entity entity);
+        bool isAlive(Entity entity) const;
+        uint32_t getEntityCount() const;
+
+        template<typename T>
+        void addComponent(Entity entity, const T& component)
+        {
+            if (!isAlive(entity))
+                return;
+
+            changeArchetype(entity, getEntityMask(entity) | GetComponentMask<T>());
+            setComponent(entity, component);
+        }
+
+        template<typename T>
+        void removeComponent(Entity entity)
+        {
+            if (!isAlive(entity))
+                return;
+
+            changeArchetype(entity, getEntityMask(entity) & ~GetComponentMask<T>());
+        }
+
+        template<typename T>
+        bool hasComponent(Entity entity) const
+        {
+            if (!isAlive(entity))
+                return false;
+
+            return (getEntityMask(entity) & GetComponentMask<T>()) != 0;
+        }
+
+        /// <summary>
+        /// Zeiger auf die Komponente im Chunk, gueltig bis zur naechsten strukturellen Aenderung. nullptr, wenn sie fehlt.
+        /// </summary>
+        template<typename T>
+        T* getComponent(Entity entity)
+        {
+            return static_cast<T*>(getComponentPointer(entity, GetComponentType<T>()));
+        }
+
+        template<typename T>
+        void setComponent(Entity entity, const T& component)
+        {
+            T* destination = getComponent<T>(entity);
+
+            if (destination == nullptr)
+                throw std::runtime_error("Die Entity ist nicht mehr gueltig oder hat diese Komponente nicht.");
+
+            *destination = component;
+        }
+
+        template<typename... Components>
+        uint32_t countEntities() const
+        {
+            ComponentMask mask = GetComponentMask<Components...>();
+            uint32_t count = 0;
+
+            for (const Archetype& archetype : archetypes)
+            {
+                if ((archetype.mask & mask) != mask)
+                    continue;
+
+                for (const Chunk& chunk : archetype.chunks)
+                    count += chunk.count;
+            }
+
+            return count;
+        }
+
+        /// <summary>
+        /// Ruft function(count, entities, components...) einmal pro Chunk mit den dichten Arrays der angefragten Komponenten.
+        /// </summary>
+        template<typename... Components, typename F>
+        void forEachChunk(F&& function)
+        {
+            ComponentMask mask = GetComponentMask<Components...>();
+
+            for (Archetype& archetype : archetypes)
+            {
+                if ((archetype.mask & mask) != mask)
+                    continue;
+
+                for (Chunk& chunk : archetype.chunks)
+                    function(chunk.count, getEntities(chunk), getComponentArray<Components>(archetype, chunk)...);
+            }
+        }
+
+        template<typename... Components, typename F>
+        void forEach(F&& function)
+        {
+            forEachChunk<Components...>([&function](uint32_t count, const Entity*, Components*... components)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    function(components[i]...);
+            });
+        }
+
+        /// <summary>
+        /// Wie forEachChunk, aber die Chunks werden auf die Worker des Job Systems verteilt. function bekommt zusaetzlich
+        /// den Index des ersten Entities des Chunks innerhalb der Abfrage, damit lassen sich Ergebnisse ohne Locks in ein Array schreiben.
+        /// </summary>
+        template<typename... Components, typename F>
+        void parallelForEachChunk(F function, Jobs::Counter& counter)
+        {
+            ComponentMask mask = GetComponentMask<Components...>();
+
+            // Shared, every job of ParallelFor holds a copy of the function
+            std::shared_ptr<std::vector<QueryChunk>> chunks = std::make_shared<std::vector<QueryChunk>>();
+            uint32_t firstEntity = 0;
+
+            for (Archetype& archetype : archetypes)
+            {
+                if ((archetype.mask & mask) != mask)
+                    continue;
+
+                for (Chunk& chunk : archetype.chunks)
+                {
+                    chunks->push_back({ &archetype, &chunk, firstEntity });
+                    firstEntity += chunk.count;
+                }
+            }
+
+            // The caller has to keep the world unchanged until the counter is done
+            Jobs::ParallelFor(static_cast<uint32_t>(chunks->size()), chunksPerJob, [chunks, function](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    const QueryChunk& queryChunk = (*chunks)[i];
+                    function(queryChunk.firstEntity, queryChunk.chunk->count, getEntities(*queryChunk.chunk), getComponentArray<Components>(*queryChunk.archetype, *queryChunk.chunk)...);
+                }
+            }, counter);
+        }
+
+    private:
+        struct EntityRecord
+        {
+            uint32_t archetype;
+            uint32_t chunk;
+            uint32_t row;
+            uint32_t generation;
+        };
+
+        struct QueryChunk
+        {
+            Archetype* archetype;
+            Chunk* chunk;
+            uint32_t firstEntity;
+        };
+
+        static constexpr uint32_t chunksPerJob = 4;
+
+        std::vector<Archetype> archetypes;
+        std::unordered_map<ComponentMask, uint32_t> archetypeLookup;
+
+        std::vector<EntityRecord> entityRecords;
+        std::vector<uint32_t> freeEntityIndices;
+        uint32_t entityCount = 0;
+
+        uint32_t getArchetype(ComponentMask mask);
+        void changeArchetype(Entity entity, ComponentMask mask);
+        uint32_t appendRow(uint32_t archetypeIndex, uint32_t& chunkIndex);
+        void removeRow(uint32_t archetypeIndex, uint32_t chunkIndex, uint32_t row);
+        void* getComponentPointer(Entity entity, uint32_t componentType);
+
+        ComponentMask getEntityMask(Entity entity) const
+        {
+            return archetypes[entityRecords[entity.index].archetype].mask;
+        }
+
+        static Entity* getEntities(const Chunk& chunk)
+        {
+            return reinterpret_cast<Entity*>(chunk.data);
+        }
+
+        template<typename T>
+        static T* getComponentArray(const Archetype& archetype, const Chunk& chunk)
+        {
+            return reinterpret_cast<T*>(chunk.data + archetype.componentOffsets[GetComponentType<T>()]);
+        }
+    };
+}
+
+#endif // WORLD_H
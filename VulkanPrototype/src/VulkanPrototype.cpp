@@ -1,43 +1,550 @@
 #include "VulkanPrototype.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <random>
+#include <thread>
 
+#include "Assets/AssetLoader.h"
 #include "Backend/Backend.h"
+#include "Jobs/JobSystem.h"
+#include "Jobs/TripleBuffer.h"
 #include "Renderer/Renderer.h"
+#include "Scene/Bvh.h"
+#include "Scene/Components.h"
+#include "Scene/OcclusionRasterizer.h"
+#include "Scene/SystemScheduler.h"
+#include "Scene/TransformHierarchy.h"
+#include "Scene/VoxelWorld.h"
+#include "Scene/World.h"
 
 namespace VulkanPrototype
 {
-    void handleInputs(GLFWwindow* window)
+    /*
+    * Helper Structs
+    */
+
+    // Runs two paths for frameCount rendered frames each and averages the frame times of both. The first frames of a path are
+    // not measured, the packets in flight still use the previous path and the GPU time arrives a few frames late.
+    struct FrameBenchmark
     {
-        static auto lastTime = std::chrono::high_resolution_clock::now();
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        auto deltaTime = currentTime - lastTime;
+        uint32_t frameCount;
+        uint32_t warmupFrameCount;
 
-        lastTime = currentTime;
+        bool running = false;
+        uint64_t startFrame = 0;
+        uint32_t sampledFrame = 0;
+        uint32_t sampleCounts[2] = {};
+        float cpuTimes[2] = {};
+        float gpuTimes[2] = {};
+        float values[2] = {};
+
+        void start()
+        {
+            running = true;
+            startFrame = Renderer::g_renderedFrameCount;
+            sampledFrame = 0;
+
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                sampleCounts[i] = 0;
+                cpuTimes[i] = 0.0f;
+                gpuTimes[i] = 0.0f;
+                values[i] = 0.0f;
+            }
+        }
+
+        uint32_t getFrame() const
+        {
+            return static_cast<uint32_t>(std::min<uint64_t>(Renderer::g_renderedFrameCount - startFrame, 2 * frameCount));
+        }
+
+        // Samples the last rendered frame together with value and returns the path of the next frame packet, 2 once it is done
+        uint32_t update(float value)
+        {
+            uint32_t frame = getFrame();
+
+            // The main loop can run more often than frames are rendered, every frame is measured once
+            if (frame > sampledFrame)
+            {
+                uint32_t path = (frame - 1) / frameCount;
+
+                if ((frame - 1) % frameCount >= warmupFrameCount)
+                {
+                    sampleCounts[path]++;
+                    cpuTimes[path] += Renderer::g_cpuFrameTime.load();
+                    gpuTimes[path] += Renderer::g_gpuFrameTime.load();
+                    values[path] += value;
+                }
+
+                sampledFrame = frame;
+            }
+
+            uint32_t path = frame / frameCount;
+
+            if (path == 2)
+            {
+                for (uint32_t i = 0; i < 2; i++)
+                {
+                    float count = static_cast<float>(std::max(sampleCounts[i], 1u));
+                    cpuTimes[i] /= count;
+                    gpuTimes[i] /= count;
+                    values[i] /= count;
+                }
+
+                running = false;
+            }
+
+            return path;
+        }
+    };
+
+    /*
+    * Module Global Variables
+    */
+
+    static const glm::vec3 objectPositions[] =
+    {
+        glm::vec3(-1, 1, -1),
+        glm::vec3(0, 1, 0),
+        glm::vec3(1, 1, 1),
+        glm::vec3(-1, 0, -1),
+        glm::vec3(0, 0, 0),
+        glm::vec3(1, 0, 1),
+        glm::vec3(-1, -1, -1),
+        glm::vec3(0, -1, 0),
+        glm::vec3(1, -1, 1)
+    };
+
+    static Scene::World world;
+    static Scene::TransformHierarchy transforms;
+
+    // Slots changed by the simulation steps since the last frame packet, the renderer only copies these into its transform buffer
+    static std::vector<Scene::SlotRange> changedTransformRanges;
+
+    // Parent of the start objects, rotated from the ImGui window
+    static uint32_t sceneRootNode;
+    static float sceneRootAngle = 0.0f;
+
+    // Lights of the start scene, children of the scene root so they turn with it
+    static const Scene::PointLight startLights[] =
+    {
+        { glm::vec3(1.0f, 0.7f, 0.4f), 5.0f },
+        { glm::vec3(0.4f, 0.6f, 1.0f), 5.0f },
+        { glm::vec3(0.5f, 1.0f, 0.5f), 5.0f },
+        { glm::vec3(1.0f, 0.4f, 0.8f), 5.0f }
+    };
+
+    // Spawned objects lie in a grid of this width below the start scene, spawned lights above it
+    static const uint32_t spawnGridWidth = 1000;
+    static uint32_t spawnedObjectCount = 0;
+    static std::mt19937 spawnRandom;
+
+    // Run once per fixed simulation step
+    static Scene::SystemScheduler simulationSystems;
+
+    // World bounds of every rendered object for culling and picking, the objects of the leaves are transform nodes
+    static Scene::Bvh bvh;
+    static std::vector<uint32_t> nodeLeaves;
+    static std::vector<Scene::Entity> nodeEntities;
+
+    // Local bounds of the cube mesh, the meshes are loaded on the worker threads and the scene does not know theirs
+    static const Scene::Aabb objectBounds = { glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.5f, 0.5f, 1.0f) };
+
+    static bool frustumCullingEnabled = true;
+    static std::vector<uint32_t> visibleNodes;
+
+    // Removes occluded nodes from the frustum culling result before they are extracted, without waiting for the GPU
+    static Scene::OcclusionRasterizer occlusionRasterizer;
+    static bool cpuOcclusionCullingEnabled = false;
+    static std::vector<uint8_t> visibleNodeFlags;
+    static uint32_t occlusionTestedCount = 0;
+    static uint32_t occlusionCulledCount = 0;
+
+    // Cubes circling above the start scene, recomputed every frame instead of being entities. The ids lie above every node and
+    // beyond the visibility buffer of the occlusion culling, which does not track them.
+    static uint32_t dynamicObjectCount = 0;
+    static const uint32_t maxDynamicObjectCount = 256;
+    static const uint32_t dynamicObjectIdOffset = 0x80000000;
+
+    // Draws the dynamic objects with push constants and then through the object buffer for the same number of frames
+    static FrameBenchmark drawDataBenchmark = { 300, 30 };
+    static bool drawDataBenchmarkPushConstantDraws = true;
+
+    // Fountain of GPU particles in the middle of the ring of dynamic objects, the renderer only gets the emitter
+    static bool particlesEnabled = false;
+    static Renderer::ParticleEmitter particleEmitter = { glm::vec3(0.0f, -3.0f, 0.0f), 0.3f, 20000.0f, 3.0f, 7.0f, 0.03f };
+
+    // Measures the GPU time without particles and then with an emission rate that keeps all 2^21 slots alive. A particle lives
+    // 0.5 to 1 times the lifetime, 2.25 s on average with 3 s, so the rate asks for about 2.7 million particles and the free slots
+    // limit the emission. The warmup of the second path is longer than a lifetime, so the count has settled before it is measured.
+    static FrameBenchmark particleBenchmark = { 600, 300 };
+    static const float particleBenchmarkRate = 1200000.0f;
+    static const float particleBenchmarkLifetime = 3.0f;
+    static bool particleBenchmarkParticlesEnabled = false;
+    static Renderer::ParticleEmitter particleBenchmarkEmitter;
+
+    // Block terrain below the start scene, generated when it is first enabled. Every chunk is drawn from its own streaming slot
+    // of the renderer, 16 * 4 * 16 chunks fit the slots. The object ids of the chunks are the last ones of the visibility buffer,
+    // the transform nodes whose handles are the ids of the other objects are never spawned into this range.
+    static Scene::VoxelWorld voxelWorld;
+    static bool voxelWorldEnabled = false;
+    static bool voxelWorldGenerated = false;
+    static const glm::ivec3 voxelWorldOrigin = glm::ivec3(-256, 0, -256);
+    static const glm::ivec3 voxelWorldChunkCounts = glm::ivec3(16, 4, 16);
+    static const uint32_t voxelChunkIdOffset = Renderer::maxVisibilityObjectCount - Renderer::maxStreamedMeshCount;
+
+    // Chunks meshed per frame, the others stay dirty for the next frames. Right clicks dig a sphere of this radius.
+    static const uint32_t voxelRemeshBudget = 64;
+    static uint32_t voxelRemeshedChunkCount = 0;
+    static float voxelDigRadius = 4.0f;
+    static std::vector<uint32_t> visibleChunks;
+
+    // Last cursor position in window coordinates, clicking with a visible cursor picks the object below it
+    static double cursorX = 0.0, cursorY = 0.0;
+    static Scene::Entity pickedEntity;
+
+    // The main thread publishes one packet per simulated frame, the render thread always takes the newest one
+    static Jobs::TripleBuffer<Renderer::FramePacket> framePackets;
+    static std::atomic<uint64_t> publishedFramePackets = 0;
+
+    // Count of published packets the render thread has taken, the main thread never runs more than one packet ahead
+    static std::atomic<uint64_t> takenFramePackets = 0;
+
+    static std::thread renderThread;
+    static std::atomic<bool> renderThreadStopping = false;
+    static bool renderThreadEnabled = true;
+
+    // The simulation advances in fixed steps, rendering interpolates between the last two of them
+    static const double fixedTimeStep = 1.0 / 60.0;
+    static const uint32_t maxFixedSteps = 5;
+    static double simulationTimeAccumulator = 0.0;
+    static uint64_t simulationStepCount = 0;
+
+    static glm::vec3 previousEye;
+
+    static const float cameraSpeed = 3.0f;
+
+    Scene::Aabb calculateWorldBounds(const glm::mat4& worldMatrix)
+    {
+        // The transformed center plus the half extent projected onto the world axes
+        glm::vec3 center = (objectBounds.min + objectBounds.max) * 0.5f;
+        glm::vec3 halfExtent = (objectBounds.max - objectBounds.min) * 0.5f;
+
+        glm::vec3 worldCenter = glm::vec3(worldMatrix * glm::vec4(center, 1.0f));
+        glm::vec3 worldHalfExtent = glm::abs(glm::vec3(worldMatrix[0])) * halfExtent.x + glm::abs(glm::vec3(worldMatrix[1])) * halfExtent.y + glm::abs(glm::vec3(worldMatrix[2])) * halfExtent.z;
+
+        return { worldCenter - worldHalfExtent, worldCenter + worldHalfExtent };
+    }
+
+    void updateBounds()
+    {
+        const std::vector<uint32_t>& updatedNodes = transforms.getUpdatedNodes();
+
+        // After a rebuild of the hierarchy every node moved, a new SAH build is cheaper and better than updating every leaf
+        if (!updatedNodes.empty() && updatedNodes.size() == transforms.getNodeCount())
+        {
+            std::vector<Scene::Aabb> bounds;
+            std::vector<uint32_t> nodes;
+
+            world.forEachChunk<const Scene::Transform, const Scene::MeshRenderer>([&bounds, &nodes](uint32_t count, const Scene::Entity* entities,
+                const Scene::Transform* entityTransforms, const Scene::MeshRenderer*)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    uint32_t node = entityTransforms[i].node;
+
+                    if (node >= nodeEntities.size())
+                        nodeEntities.resize(node + 1);
+
+                    nodeEntities[node] = entities[i];
+                    bounds.push_back(calculateWorldBounds(transforms.getWorldMatrix(node)));
+                    nodes.push_back(node);
+                }
+            });
+
+            std::vector<uint32_t> leaves(nodes.size());
+            bvh.build(bounds.data(), nodes.data(), static_cast<uint32_t>(nodes.size()), leaves.data());
+
+            nodeLeaves.assign(nodeEntities.size(), Scene::noBvhNode);
+
+            for (uint32_t i = 0; i < nodes.size(); i++)
+                nodeLeaves[nodes[i]] = leaves[i];
+
+            return;
+        }
+
+        for (uint32_t node : updatedNodes)
+        {
+            // Nodes without a mesh, like the root of the start scene, have no leaf
+            if (node < nodeLeaves.size() && nodeLeaves[node] != Scene::noBvhNode)
+                bvh.update(nodeLeaves[node], calculateWorldBounds(transforms.getWorldMatrix(node)));
+        }
+    }
+
+    void createScene()
+    {
+        sceneRootNode = transforms.createNode();
+
+        // The materials are created by Renderer::Initialize, mesh 0 is the first mesh that finishes loading
+        for (uint32_t i = 0; i < IM_ARRAYSIZE(objectPositions); i++)
+        {
+            uint32_t node = transforms.createNode(sceneRootNode, { .translation = objectPositions[i] });
+            world.createEntity(Scene::Transform{ node }, Scene::MeshRenderer{ 0, i % 3 }, Scene::Occluder{ objectBounds.min, objectBounds.max });
+        }
+
+        for (uint32_t i = 0; i < IM_ARRAYSIZE(startLights); i++)
+        {
+            // Around the objects, the up vector of the camera is -y
+            float angle = glm::radians(90.0f * i + 45.0f);
+            uint32_t node = transforms.createNode(sceneRootNode, { .translation = glm::vec3(2.5f * std::cos(angle), -1.5f, 2.5f * std::sin(angle)) });
+
+            world.createEntity(Scene::Transform{ node }, startLights[i]);
+        }
+
+        // Only nodes changed since the last step and their subtrees are recomputed. It writes the world matrices behind the Transform components.
+        simulationSystems.addSystem("UpdateTransforms", 0, Scene::GetComponentMask<Scene::Transform>(), [](Scene::World&)
+        {
+            transforms.update();
+
+            const std::vector<Scene::SlotRange>& ranges = transforms.getChangedSlotRanges();
+            changedTransformRanges.insert(changedTransformRanges.end(), ranges.begin(), ranges.end());
+        });
+
+        // Reads the world matrices, so it runs in the stage after UpdateTransforms
+        simulationSystems.addSystem("UpdateBounds", Scene::GetComponentMask<Scene::Transform, Scene::MeshRenderer>(), 0, [](Scene::World&)
+        {
+            updateBounds();
+        });
+    }
+
+    void cullOccludedNodes(const glm::mat4& viewProjection)
+    {
+        occlusionRasterizer.begin(viewProjection);
+
+        world.forEach<const Scene::Transform, const Scene::Occluder>([](const Scene::Transform& transform, const Scene::Occluder& occluder)
+        {
+            occlusionRasterizer.addOccluderBox(transforms.getWorldMatrix(transform.node), { occluder.boundsMin, occluder.boundsMax });
+        });
+
+        occlusionRasterizer.rasterize();
+
+        visibleNodeFlags.resize(visibleNodes.size());
+
+        Jobs::Counter counter;
+        Jobs::ParallelFor(static_cast<uint32_t>(visibleNodes.size()), 4096, [](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+                visibleNodeFlags[i] = occlusionRasterizer.isVisible(calculateWorldBounds(transforms.getWorldMatrix(visibleNodes[i])));
+        }, counter);
+        Jobs::Wait(counter);
+
+        uint32_t visibleCount = 0;
+
+        for (uint32_t i = 0; i < visibleNodes.size(); i++)
+        {
+            if (visibleNodeFlags[i])
+                visibleNodes[visibleCount++] = visibleNodes[i];
+        }
+
+        occlusionTestedCount = static_cast<uint32_t>(visibleNodes.size());
+        occlusionCulledCount = occlusionTestedCount - visibleCount;
+        visibleNodes.resize(visibleCount);
+    }
+
+    void extractDynamicObjects(Renderer::FramePacket& framePacket)
+    {
+        framePacket.dynamicObjects.resize(dynamicObjectCount);
+
+        for (uint32_t i = 0; i < dynamicObjectCount; i++)
+        {
+            // Positions of the last two simulation steps, the renderer interpolates between them like for the entities
+            float angle = glm::radians(360.0f) * static_cast<float>(i) / static_cast<float>(dynamicObjectCount) + 0.01f * static_cast<float>(simulationStepCount);
+            float previousAngle = angle - 0.01f;
+
+            glm::mat4 worldMatrix(1.0f);
+            worldMatrix[3] = glm::vec4(3.0f * std::cos(angle), -3.0f, 3.0f * std::sin(angle), 1.0f);
+
+            framePacket.dynamicObjects[i] = { worldMatrix, glm::vec3(3.0f * std::cos(previousAngle), -3.0f, 3.0f * std::sin(previousAngle)), 0, i % 3, dynamicObjectIdOffset + i,
+                Renderer::noTransformIndex };
+        }
+    }
+
+    void extractRenderObjects(Renderer::FramePacket& framePacket)
+    {
+        // The lights are culled per cluster on the GPU
+        framePacket.lights.clear();
+        world.forEach<const Scene::Transform, const Scene::PointLight>([&framePacket](const Scene::Transform& transform, const Scene::PointLight& light)
+        {
+            framePacket.lights.push_back({ glm::vec3(transforms.getWorldMatrix(transform.node)[3]), light.radius, light.color });
+        });
+
+        Jobs::Counter counter;
+
+        if (frustumCullingEnabled)
+        {
+            // Culled against the camera of the current simulation step, the margin of the leaves covers the interpolation towards it
+            float aspectRatio = static_cast<float>(framePacket.framebufferSize.width) / static_cast<float>(framePacket.framebufferSize.height);
+            glm::mat4 viewProjection = Renderer::GetViewProjectionMatrix(framePacket.uboValues, framePacket.uboValues.eye, aspectRatio);
+            Scene::Frustum frustum = Scene::Frustum::fromMatrix(viewProjection);
+
+            visibleNodes.clear();
+            bvh.queryFrustum(frustum, [](uint32_t node)
+            {
+                visibleNodes.push_back(node);
+            });
+
+            // Tests the objects inside the frustum, so it only runs together with the frustum culling
+            if (cpuOcclusionCullingEnabled)
+                cullOccludedNodes(viewProjection);
+
+            framePacket.objects.resize(visibleNodes.size());
+
+            Jobs::ParallelFor(static_cast<uint32_t>(visibleNodes.size()), 4096, [&framePacket](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    uint32_t node = visibleNodes[i];
+                    const Scene::MeshRenderer* meshRenderer = world.getComponent<Scene::MeshRenderer>(nodeEntities[node]);
+
+                    framePacket.objects[i] = { transforms.getWorldMatrix(node), transforms.getPreviousWorldPosition(node), meshRenderer->meshIndex, meshRenderer->materialIndex, node,
+                        transforms.getSlot(node) };
+                }
+            }, counter);
+            Jobs::Wait(counter);
+
+            return;
+        }
+
+        // Every chunk writes its own range of the packet, so the chunks are extracted in parallel
+        framePacket.objects.resize(world.countEntities<Scene::Transform, Scene::MeshRenderer>());
+
+        world.parallelForEachChunk<const Scene::Transform, const Scene::MeshRenderer>([&framePacket](uint32_t firstEntity, uint32_t count, const Scene::Entity*,
+            const Scene::Transform* entityTransforms, const Scene::MeshRenderer* meshRenderers)
+        {
+            Renderer::RenderObject* objects = framePacket.objects.data() + firstEntity;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t node = entityTransforms[i].node;
+                objects[i] = { transforms.getWorldMatrix(node), transforms.getPreviousWorldPosition(node), meshRenderers[i].meshIndex, meshRenderers[i].materialIndex, node,
+                    transforms.getSlot(node) };
+            }
+        }, counter);
+        Jobs::Wait(counter);
+    }
+
+    void extractTransforms(Renderer::FramePacket& framePacket)
+    {
+        framePacket.transformRanges.clear();
+        framePacket.transforms.clear();
+        framePacket.transformCount = transforms.getSlotCount();
+
+        // The ranges of several simulation steps overlap, every slot is sent once
+        std::sort(changedTransformRanges.begin(), changedTransformRanges.end(), [](const Scene::SlotRange& a, const Scene::SlotRange& b)
+        {
+            return a.firstSlot < b.firstSlot;
+        });
+
+        for (const Scene::SlotRange& range : changedTransformRanges)
+        {
+            uint32_t firstSlot = range.firstSlot;
+            uint32_t endSlot = std::min(range.firstSlot + range.slotCount, framePacket.transformCount);
+
+            if (!framePacket.transformRanges.empty())
+                firstSlot = std::max(firstSlot, framePacket.transformRanges.back().firstTransform + framePacket.transformRanges.back().transformCount);
+
+            if (firstSlot >= endSlot)
+                continue;
+
+            if (!framePacket.transformRanges.empty() && firstSlot == framePacket.transformRanges.back().firstTransform + framePacket.transformRanges.back().transformCount)
+                framePacket.transformRanges.back().transformCount += endSlot - firstSlot;
+            else
+                framePacket.transformRanges.push_back({ firstSlot, endSlot - firstSlot });
+
+            for (uint32_t slot = firstSlot; slot < endSlot; slot++)
+            {
+                glm::mat4 worldMatrix = glm::transpose(transforms.getSlotWorldMatrix(slot));
+                framePacket.transforms.push_back({ { worldMatrix[0], worldMatrix[1], worldMatrix[2] }, glm::vec4(transforms.getSlotPreviousWorldPosition(slot), 1.0f) });
+            }
+        }
+
+        changedTransformRanges.clear();
+    }
+
+    void extractVoxelChunks(Renderer::FramePacket& framePacket)
+    {
+        if (!voxelWorldGenerated || !voxelWorldEnabled)
+            return;
+
+        visibleChunks.clear();
+
+        if (frustumCullingEnabled)
+        {
+            float aspectRatio = static_cast<float>(framePacket.framebufferSize.width) / static_cast<float>(framePacket.framebufferSize.height);
+            glm::mat4 viewProjection = Renderer::GetViewProjectionMatrix(framePacket.uboValues, framePacket.uboValues.eye, aspectRatio);
+
+            voxelWorld.queryFrustum(Scene::Frustum::fromMatrix(viewProjection), [](uint32_t chunk)
+            {
+                visibleChunks.push_back(chunk);
+            });
+        }
+        else
+        {
+            // Chunks without a mesh have an empty slot, which the renderer skips
+            for (uint32_t chunk = 0; chunk < voxelWorld.getChunkCount(); chunk++)
+                visibleChunks.push_back(chunk);
+        }
+
+        // The chunks never move, so the previous position is the current one
+        for (uint32_t chunk : visibleChunks)
+        {
+            glm::vec3 chunkOrigin = voxelWorld.getChunkOrigin(chunk);
+
+            glm::mat4 worldMatrix(1.0f);
+            worldMatrix[3] = glm::vec4(chunkOrigin, 1.0f);
+
+            framePacket.objects.push_back({ worldMatrix, chunkOrigin, Renderer::GetStreamedMeshIndex(chunk), 0, voxelChunkIdOffset + chunk, Renderer::noTransformIndex });
+        }
+    }
+
+    // New transform nodes that still get handles below the object ids of the voxel chunks
+    uint32_t getFreeObjectIdCount()
+    {
+        return voxelChunkIdOffset - std::min(transforms.getNodeHandleCount(), voxelChunkIdOffset);
+    }
+
+    void handleInputs(GLFWwindow* window, float deltaTime)
+    {
+        float distance = cameraSpeed * deltaTime;
+
+        glm::vec3 right = glm::normalize(glm::cross(Renderer::g_uboValues.center, Renderer::g_uboValues.up));
+        glm::vec3 down = glm::normalize(glm::cross(Renderer::g_uboValues.center, glm::cross(Renderer::g_uboValues.center, Renderer::g_uboValues.up)));
 
         if (glfwGetKey(window, GLFW_KEY_W))
         {
-            Renderer::g_uboValues.eye += deltaTime.count() * 0.00000001f * Renderer::g_uboValues.center;
+            Renderer::g_uboValues.eye += distance * Renderer::g_uboValues.center;
         }
         if (glfwGetKey(window, GLFW_KEY_A))
         {
-            Renderer::g_uboValues.eye -= deltaTime.count() * 0.00000001f * (glm::normalize(glm::cross( Renderer::g_uboValues.center, Renderer::g_uboValues.up)));
+            Renderer::g_uboValues.eye -= distance * right;
         }
         if (glfwGetKey(window, GLFW_KEY_S))
         {
-            Renderer::g_uboValues.eye -= deltaTime.count() * 0.00000001f * Renderer::g_uboValues.center;
+            Renderer::g_uboValues.eye -= distance * Renderer::g_uboValues.center;
         }
         if (glfwGetKey(window, GLFW_KEY_D))
         {
-            Renderer::g_uboValues.eye += deltaTime.count() * 0.00000001f * (glm::normalize(glm::cross(Renderer::g_uboValues.center, Renderer::g_uboValues.up)));
+            Renderer::g_uboValues.eye += distance * right;
         }
         if (glfwGetKey(window, GLFW_KEY_SPACE))
         {
-            Renderer::g_uboValues.eye -= deltaTime.count() * 0.00000001f * (glm::normalize(glm::cross(Renderer::g_uboValues.center, glm::cross(Renderer::g_uboValues.center, Renderer::g_uboValues.up))));
+            Renderer::g_uboValues.eye -= distance * down;
         }
         if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL))
         {
-            Renderer::g_uboValues.eye += deltaTime.count() * 0.00000001f * (glm::normalize(glm::cross(Renderer::g_uboValues.center, glm::cross(Renderer::g_uboValues.center, Renderer::g_uboValues.up))));
+            Renderer::g_uboValues.eye += distance * down;
         }
     }
 
@@ -55,12 +562,60 @@ namespace VulkanPrototype
         }
     }
 
+    void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+    {
+        if ((button != GLFW_MOUSE_BUTTON_LEFT && button != GLFW_MOUSE_BUTTON_RIGHT) || action != GLFW_PRESS)
+            return;
+
+        // With a disabled cursor the mouse turns the camera, clicks on the ImGui window belong to ImGui
+        if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED || ImGui::GetIO().WantCaptureMouse)
+            return;
+
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+
+        if (width == 0 || height == 0)
+            return;
+
+        // The cursor in normalized device coordinates, y points down in Vulkan like in window coordinates
+        float x = static_cast<float>(cursorX) / static_cast<float>(width) * 2.0f - 1.0f;
+        float y = static_cast<float>(cursorY) / static_cast<float>(height) * 2.0f - 1.0f;
+
+        glm::mat4 inverseViewProjection = glm::inverse(Renderer::GetViewProjectionMatrix(Renderer::g_uboValues, Renderer::g_uboValues.eye, static_cast<float>(width) / static_cast<float>(height)));
+
+        // Vulkan clips the depth to [0, 1], so the ray runs from the near to the far plane
+        glm::vec4 nearPoint = inverseViewProjection * glm::vec4(x, y, 0.0f, 1.0f);
+        glm::vec4 farPoint = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+
+        glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+        glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+        // The right button digs into the voxel world, the chunks around the hole are remeshed in the next frames
+        if (button == GLFW_MOUSE_BUTTON_RIGHT)
+        {
+            glm::ivec3 block;
+
+            if (voxelWorldEnabled && voxelWorld.raycast(origin, direction, 1.0f, block))
+                voxelWorld.fillSphere(glm::vec3(block) + 0.5f, voxelDigRadius, Scene::airBlock);
+
+            return;
+        }
+
+        uint32_t node;
+        float distance;
+
+        pickedEntity = bvh.raycast(origin, direction, 1.0f, node, distance) ? nodeEntities[node] : Scene::Entity();
+    }
+
     void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     {
         static const float sensititvity = 0.1f;
         static float old_xpos = 0, old_ypos = 0;
         static float yaw = 0, pitch = 0;
 
+        cursorX = xpos;
+        cursorY = ypos;
+
         float delta_x = (old_xpos - static_cast<float>(xpos)) * sensititvity;
         float delta_y = (old_ypos - static_cast<float>(ypos)) * sensititvity;
 
@@ -87,15 +642,219 @@ namespace VulkanPrototype
         Renderer::g_uboValues.center = glm::normalize(direction);
     }
 
+    void renderLoop()
+    {
+        // RenderFrame runs and waits for jobs, with its own queue it does not take the jobs of the main thread
+        Jobs::RegisterThread();
+
+        uint64_t consumedFramePackets = 0;
+
+        while (true)
+        {
+            publishedFramePackets.wait(consumedFramePackets);
+            consumedFramePackets = publishedFramePackets;
+
+            if (renderThreadStopping)
+                break;
+
+            //Finish Assets that were loaded on the worker threads, RenderFrame records their uploads on this thread
+            Assets::Update();
+
+            bool consumed = framePackets.consume();
+
+            // The main thread may build the next packet while this one is rendered
+            takenFramePackets = consumedFramePackets;
+            takenFramePackets.notify_one();
+
+            if (consumed)
+                Renderer::RenderFrame(framePackets.getReadBuffer());
+        }
+
+        Jobs::UnregisterThread();
+    }
+
+    void spawnLights(uint32_t count)
+    {
+        count = std::min(count, getFreeObjectIdCount());
+
+        // Randomly over the rows of the grid that are filled so far, slightly above the objects
+        float gridDepth = static_cast<float>(std::max((spawnedObjectCount + spawnGridWidth - 1) / spawnGridWidth, 1u)) * 2.0f;
+
+        std::uniform_real_distribution<float> x(-static_cast<float>(spawnGridWidth), static_cast<float>(spawnGridWidth));
+        std::uniform_real_distribution<float> z(0.0f, gridDepth);
+        std::uniform_real_distribution<float> hue(0.0f, 1.0f);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t node = transforms.createNode(Scene::TransformHierarchy::noParent, { .translation = glm::vec3(x(spawnRandom), -4.5f, z(spawnRandom)) });
+
+            // Saturated colors, one channel is always at full strength
+            float h = hue(spawnRandom) * 6.0f;
+            glm::vec3 color = glm::clamp(glm::vec3(std::abs(h - 3.0f) - 1.0f, 2.0f - std::abs(h - 2.0f), 2.0f - std::abs(h - 4.0f)), 0.0f, 1.0f);
+
+            world.createEntity(Scene::Transform{ node }, Scene::PointLight{ color, 6.0f });
+        }
+    }
+
+    void spawnObjects(uint32_t count)
+    {
+        // One node more for the grid
+        uint32_t freeObjectIdCount = getFreeObjectIdCount();
+        if (freeObjectIdCount <= 1)
+            return;
+
+        count = std::min(count, freeObjectIdCount - 1);
+
+        // A grid on the ground below the start scene, each new batch one row further away
+        uint32_t gridNode = transforms.createNode(Scene::TransformHierarchy::noParent, { .translation = glm::vec3(-static_cast<float>(spawnGridWidth), -3.0f, 0.0f) });
+
+        for (uint32_t i = 0; i < count; i++, spawnedObjectCount++)
+        {
+            glm::vec3 position(static_cast<float>(spawnedObjectCount % spawnGridWidth) * 2.0f, 0.0f, static_cast<float>(spawnedObjectCount / spawnGridWidth) * 2.0f);
+            uint32_t node = transforms.createNode(gridNode, { .translation = position });
+
+            world.createEntity(Scene::Transform{ node }, Scene::MeshRenderer{ 0, spawnedObjectCount % 3 });
+        }
+    }
+
+    void startRenderThread()
+    {
+        renderThreadStopping = false;
+        renderThread = std::thread(renderLoop);
+    }
+
+    void stopRenderThread()
+    {
+        renderThreadStopping = true;
+        publishedFramePackets++;
+        publishedFramePackets.notify_one();
+
+        renderThread.join();
+    }
+
+    void updateDrawDataBenchmark()
+    {
+        if (!drawDataBenchmark.running)
+            return;
+
+        // Path 0 uses push constants, path 1 the object buffer
+        uint32_t path = drawDataBenchmark.update(0.0f);
+
+        if (path == 2)
+        {
+            Renderer::g_pushConstantDraws = drawDataBenchmarkPushConstantDraws;
+            return;
+        }
+
+        Renderer::g_pushConstantDraws = path == 0;
+    }
+
+    void updateParticleBenchmark()
+    {
+        if (!particleBenchmark.running)
+            return;
+
+        // Path 0 runs without particles, path 1 with the full emission
+        uint32_t path = particleBenchmark.update(static_cast<float>(Renderer::g_particleCount.load()));
+
+        if (path == 2)
+        {
+            particlesEnabled = particleBenchmarkParticlesEnabled;
+            particleEmitter = particleBenchmarkEmitter;
+            return;
+        }
+
+        particlesEnabled = path == 1;
+        particleEmitter.rate = particleBenchmarkRate;
+        particleEmitter.lifetime = particleBenchmarkLifetime;
+    }
+
+    void updateVoxelWorld()
+    {
+        if (!voxelWorldEnabled)
+            return;
+
+        if (!voxelWorldGenerated)
+        {
+            voxelWorld.create(voxelWorldOrigin, voxelWorldChunkCounts);
+            voxelWorld.generateTerrain(1337, 4, 52);
+            voxelWorldGenerated = true;
+        }
+
+        // The vertices and indices are moved into the upload queue, the renderer copies them with the next frames
+        voxelRemeshedChunkCount = voxelWorld.remeshDirtyChunks(voxelRemeshBudget, Renderer::g_uboValues.eye, [](uint32_t chunk, Scene::VoxelMesh& mesh)
+        {
+            Renderer::StreamMesh({ chunk, std::move(mesh.vertices), std::move(mesh.indices), mesh.quantization });
+        });
+    }
+
+    void updateSimulation(GLFWwindow* window)
+    {
+        static auto lastTime = std::chrono::steady_clock::now();
+        auto currentTime = std::chrono::steady_clock::now();
+        double frameTime = std::chrono::duration<double>(currentTime - lastTime).count();
+
+        lastTime = currentTime;
+
+        // A spike (window drag, breakpoint, long upload) is dropped instead of being caught up over the next frames
+        simulationTimeAccumulator += std::min(frameTime, maxFixedSteps * fixedTimeStep);
+
+        while (simulationTimeAccumulator >= fixedTimeStep)
+        {
+            previousEye = Renderer::g_uboValues.eye;
+            simulationSystems.run(world);
+            simulationStepCount++;
+
+            handleInputs(window, static_cast<float>(fixedTimeStep));
+
+            simulationTimeAccumulator -= fixedTimeStep;
+        }
+    }
+
     int mainLoop()
     {
         glfwSetInputMode(Backend::g_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
+        previousEye = Renderer::g_uboValues.eye;
+
+        if (renderThreadEnabled)
+            startRenderThread();
+
         while (!glfwWindowShouldClose(Backend::g_window))
         {
+            // Without this the main thread would simulate frames the render thread never shows,
+            // waiting here keeps the loop at the rate the render thread presents with
+            if (renderThread.joinable())
+            {
+                uint64_t taken = takenFramePackets;
+                while (taken < publishedFramePackets)
+                {
+                    takenFramePackets.wait(taken);
+                    taken = takenFramePackets;
+                }
+            }
+
             //GlfwEvents
             glfwPollEvents();
-            handleInputs(Backend::g_window);
+
+            int width, height;
+            glfwGetFramebufferSize(Backend::g_window, &width, &height);
+
+            //Nothing is rendered while the window is minimized
+            if (width == 0 || height == 0)
+            {
+                glfwWaitEvents();
+                continue;
+            }
+
+            updateSimulation(Backend::g_window);
+
+            //Finish Assets that were loaded on the worker threads, the render thread does this if it is running
+            if (!renderThread.joinable())
+                Assets::Update();
+
+            // After the events, so the chunks around a hole dug by a click are remeshed in the same frame
+            updateVoxelWorld();
 
             //Setup ImGui
             ImGui_ImplVulkan_NewFrame();
@@ -113,6 +872,11 @@ namespace VulkanPrototype
             ImGui::SliderFloat("Axis y", &Renderer::g_uboValues.axis.y, -1.0f, 1.0f);
             ImGui::SliderFloat("Axis z", &Renderer::g_uboValues.axis.z, -1.0f, 1.0f);
 
+            if (ImGui::SliderFloat("Scene Angle", &sceneRootAngle, -180.0f, 180.0f))
+            {
+                transforms.setLocalTransform(sceneRootNode, { .rotation = glm::angleAxis(glm::radians(sceneRootAngle), glm::vec3(0.0f, 1.0f, 0.0f)) });
+            }
+
             ImGui::Text("View:");
             ImGui::SliderFloat("Eye x", &Renderer::g_uboValues.eye.x, -1.0f, 1.0f);
             ImGui::SliderFloat("Eye y", &Renderer::g_uboValues.eye.y, -1.0f, 1.0f);
@@ -126,23 +890,168 @@ namespace VulkanPrototype
             ImGui::SliderFloat("Near", &Renderer::g_uboValues.near, 0.0f, 20.0f);
             ImGui::SliderFloat("Far", &Renderer::g_uboValues.far, 0.0f, 20.0f);
 
+            ImGui::Text("LOD:");
+            ImGui::SliderFloat("Pixel Error", &Renderer::g_lodPixelError, 0.1f, 16.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+            ImGui::Text("Triangles: %u", Renderer::g_drawnTriangleCount.load());
+            ImGui::Text("State binds: %u (%u skipped)", Renderer::g_stateBindCount.load(), Renderer::g_skippedStateBindCount.load());
+            ImGui::Checkbox("Depth Prepass", &Renderer::g_depthPrepass);
+            ImGui::Checkbox("Texturing", &Renderer::g_texturing);
+            const char* debugVisualizations[] = { "None", "Normals", "Light Count", "Material" };
+            int debugVisualization = static_cast<int>(Renderer::g_debugVisualization);
+            if (ImGui::Combo("Debug View", &debugVisualization, debugVisualizations, IM_ARRAYSIZE(debugVisualizations)))
+            {
+                Renderer::g_debugVisualization = static_cast<uint32_t>(debugVisualization);
+            }
+            ImGui::Text("Pipeline variants: %u (%u compiling)", Renderer::g_pipelineVariantCount.load(), Renderer::g_pendingPipelineVariantCount.load());
+            ImGui::Text("CPU: %.2f ms, GPU: %.2f ms", Renderer::g_cpuFrameTime.load(), Renderer::g_gpuFrameTime.load());
+
+            ImGui::Text("Draw Data:");
+            uint32_t minDynamicObjectCount = 0;
+            ImGui::SliderScalar("Dynamic Objects", ImGuiDataType_U32, &dynamicObjectCount, &minDynamicObjectCount, &maxDynamicObjectCount);
+            ImGui::Checkbox("Push Constant Draws", &Renderer::g_pushConstantDraws);
+            if (!drawDataBenchmark.running && ImGui::Button("Run Draw Data Benchmark"))
+            {
+                drawDataBenchmark.start();
+                drawDataBenchmarkPushConstantDraws = Renderer::g_pushConstantDraws;
+            }
+            if (drawDataBenchmark.running)
+            {
+                ImGui::Text("Benchmark: frame %u / %u", drawDataBenchmark.getFrame(), 2 * drawDataBenchmark.frameCount);
+            }
+            else if (drawDataBenchmark.cpuTimes[0] > 0.0f)
+            {
+                ImGui::Text("Push constants: CPU %.3f ms, GPU %.3f ms", drawDataBenchmark.cpuTimes[0], drawDataBenchmark.gpuTimes[0]);
+                ImGui::Text("Object buffer:  CPU %.3f ms, GPU %.3f ms", drawDataBenchmark.cpuTimes[1], drawDataBenchmark.gpuTimes[1]);
+            }
+
+            ImGui::Text("Particles:");
+            ImGui::Checkbox("GPU Particles", &particlesEnabled);
+            ImGui::SliderFloat("Emission Rate", &particleEmitter.rate, 0.0f, 1000000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Particle Lifetime", &particleEmitter.lifetime, 0.1f, 10.0f, "%.1f");
+            ImGui::Text("Alive particles: %u", Renderer::g_particleCount.load());
+            if (!particleBenchmark.running && ImGui::Button("Run Particle Benchmark"))
+            {
+                particleBenchmark.start();
+                particleBenchmarkParticlesEnabled = particlesEnabled;
+                particleBenchmarkEmitter = particleEmitter;
+            }
+            if (particleBenchmark.running)
+            {
+                ImGui::Text("Benchmark: frame %u / %u", particleBenchmark.getFrame(), 2 * particleBenchmark.frameCount);
+            }
+            else if (particleBenchmark.gpuTimes[0] > 0.0f)
+            {
+                ImGui::Text("Without particles: GPU %.3f ms", particleBenchmark.gpuTimes[0]);
+                ImGui::Text("%.0f particles: GPU %.3f ms", particleBenchmark.values[1], particleBenchmark.gpuTimes[1]);
+            }
+
+            ImGui::Text("Entities: %u", world.getEntityCount());
+            ImGui::Text("Transforms updated: %u / %u", transforms.getUpdatedNodeCount(), transforms.getNodeCount());
+            if (ImGui::Button("Spawn 100000 Objects"))
+            {
+                spawnObjects(100000);
+            }
+
+            ImGui::Text("Lights: %u", world.countEntities<Scene::Transform, Scene::PointLight>());
+            if (ImGui::Button("Spawn 1000 Lights"))
+            {
+                spawnLights(1000);
+            }
+
+            ImGui::Text("Voxel World:");
+            ImGui::Checkbox("Voxel Terrain", &voxelWorldEnabled);
+            if (voxelWorldGenerated)
+            {
+                uint64_t solidBlockCount = voxelWorld.getSolidBlockCount();
+                uint64_t vertexCount = voxelWorld.getVertexCount();
+                float rawSize = static_cast<float>(voxelWorld.getChunkCount() * Scene::chunkBlockCount * sizeof(Scene::Block));
+
+                ImGui::Text("Chunks: %u (%u meshed, %u dirty, %u uploads pending)", voxelWorld.getChunkCount(), voxelWorld.getMeshedChunkCount(),
+                    voxelWorld.getDirtyChunkCount(), Renderer::g_pendingStreamedMeshCount.load());
+                ImGui::Text("Blocks: %llu, palettes %.2f MB instead of %.2f MB", static_cast<unsigned long long>(solidBlockCount),
+                    static_cast<float>(voxelWorld.getMemorySize()) / (1024.0f * 1024.0f), rawSize / (1024.0f * 1024.0f));
+                ImGui::Text("Vertices: %llu, one cube per block: %llu", static_cast<unsigned long long>(vertexCount), static_cast<unsigned long long>(solidBlockCount * 24));
+                ImGui::Text("Greedy meshing: %llu faces in %llu quads", static_cast<unsigned long long>(voxelWorld.getFaceCount()), static_cast<unsigned long long>(vertexCount / 4));
+                ImGui::Text("Meshing: %u chunks in %.2f ms", voxelRemeshedChunkCount, voxelWorld.getMeshTime());
+                ImGui::SliderFloat("Dig Radius", &voxelDigRadius, 1.0f, 16.0f, "%.1f");
+            }
+
+            ImGui::Checkbox("Frustum Culling", &frustumCullingEnabled);
+            ImGui::Checkbox("Occlusion Culling", &Renderer::g_occlusionCulling);
+            ImGui::Checkbox("CPU Occlusion Culling", &cpuOcclusionCullingEnabled);
+            if (cpuOcclusionCullingEnabled && frustumCullingEnabled)
+            {
+                ImGui::Text("Occluder raster: %.3f ms (%u triangles)", occlusionRasterizer.getRasterTime(), occlusionRasterizer.getOccluderTriangleCount());
+                ImGui::Text("CPU culled: %u / %u (%.1f%%)", occlusionCulledCount, occlusionTestedCount,
+                    occlusionTestedCount > 0 ? 100.0f * static_cast<float>(occlusionCulledCount) / static_cast<float>(occlusionTestedCount) : 0.0f);
+            }
+            ImGui::Text("Visible: %u / %u", static_cast<uint32_t>(frustumCullingEnabled ? visibleNodes.size() : bvh.getLeafCount()), bvh.getLeafCount());
+
+            if (world.isAlive(pickedEntity))
+                ImGui::Text("Picked: Entity %u", pickedEntity.index);
+            else
+                ImGui::Text("Picked: -");
+
             static bool check = false;
             if (ImGui::Checkbox("Enable Polygon Mode Line", &check))
             {
                 Renderer::g_polygonMode = check ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
             }
 
+            ImGui::Checkbox("Render Thread", &renderThreadEnabled);
+
             ImGui::End();
 
             //ImGui::ShowDemoWindow(nullptr);
 
             //Render Data and record Command Buffers
             ImGui::Render();
-            ImDrawData* draw_data = ImGui::GetDrawData();
 
-            Renderer::RenderFrame(draw_data);
+            // Chooses the path of the dynamic objects and the particles before the packet takes them over
+            updateDrawDataBenchmark();
+            updateParticleBenchmark();
+
+            Renderer::FramePacket& framePacket = framePackets.getWriteBuffer();
+            framePacket.uboValues = Renderer::g_uboValues;
+            framePacket.polygonMode = Renderer::g_polygonMode;
+            framePacket.lodPixelError = Renderer::g_lodPixelError;
+            framePacket.occlusionCulling = Renderer::g_occlusionCulling;
+            framePacket.depthPrepass = Renderer::g_depthPrepass;
+            framePacket.pushConstantDraws = Renderer::g_pushConstantDraws;
+            framePacket.texturing = Renderer::g_texturing;
+            framePacket.debugVisualization = Renderer::g_debugVisualization;
+            framePacket.particles = particlesEnabled;
+            framePacket.particleEmitter = particleEmitter;
+            framePacket.framebufferSize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+            framePacket.previousEye = previousEye;
+            framePacket.interpolationFactor = static_cast<float>(simulationTimeAccumulator / fixedTimeStep);
+            extractTransforms(framePacket);
+            extractRenderObjects(framePacket);
+            extractVoxelChunks(framePacket);
+            extractDynamicObjects(framePacket);
+            Renderer::CopyDrawData(ImGui::GetDrawData(), framePacket);
+
+            if (renderThread.joinable())
+            {
+                framePackets.publish();
+                publishedFramePackets++;
+                publishedFramePackets.notify_one();
+            }
+            else
+            {
+                Renderer::RenderFrame(framePacket);
+            }
+
+            //Switch the mode between two frames, so no packet is in flight
+            if (renderThreadEnabled && !renderThread.joinable())
+                startRenderThread();
+            else if (!renderThreadEnabled && renderThread.joinable())
+                stopRenderThread();
         }
 
+        if (renderThread.joinable())
+            stopRenderThread();
+
         //vkDeviceWaitIdle(device);
 
         return 0;
@@ -153,16 +1062,27 @@ namespace VulkanPrototype
         if (Backend::Initialize(Renderer::g_windowSize.width, Renderer::g_windowSize.height))
             return 0;
 
+        Jobs::Initialize();
+        Assets::Initialize();
+
         //TODO: Put Callbacks in specific function
         //Needs to be before ImguiInit !!!
         glfwSetKeyCallback(Backend::g_window, key_callback);
         glfwSetCursorPosCallback(Backend::g_window, mouse_callback);
+        glfwSetMouseButtonCallback(Backend::g_window, mouse_button_callback);
 
         if (Renderer::Initialize())
+        {
+            Assets::Cleanup();
+            Jobs::Cleanup();
             return 0;
+        }
 
+        createScene();
         mainLoop();
 
+        Assets::Cleanup();
+        Jobs::Cleanup();
         Renderer::Cleanup();
         Backend::Cleanup();
 
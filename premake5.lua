@@ -10,6 +10,9 @@ VULKAN_INCLUDE = "%{VULKAN_SDK}/Include"
 VULKAN_LIB = "%{VULKAN_SDK}/Lib/vulkan-1.lib"
 
 include "VulkanPrototype"
+include "tools/BvhBenchmark"
+include "tools/MeshImporter"
+include "tools/TextureConverter"
 include "vendor/premake5_imgui.lua"
 
 if os.host() == "windows" then
@@ -0,0 +1,27 @@
+project "BvhBenchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    warnings "Extra"
+    targetdir ("../../out/bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("../../out/obj/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "src/**.h",
+        "src/**.cpp",
+        "../../VulkanPrototype/src/Scene/Bvh.h",
+        "../../VulkanPrototype/src/Scene/Bvh.cpp"
+    }
+
+    includedirs {
+        "../../VulkanPrototype/src/Scene",
+        "../../vendor/glm"
+    }
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
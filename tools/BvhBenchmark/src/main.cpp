@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Bvh.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using VulkanPrototype::Scene::Aabb;
+using VulkanPrototype::Scene::Bvh;
+using VulkanPrototype::Scene::Frustum;
+
+/*
+ * Measures build, refit and query rates of the scene BVH for growing object counts.
+ * Usage: BvhBenchmark [objectCount...]
+ */
+
+namespace BvhBenchmark
+{
+    struct Scene
+    {
+        std::vector<Aabb> bounds;
+        std::vector<uint32_t> objects;
+        float size;
+    };
+
+    static double getSeconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static Scene createScene(uint32_t objectCount, std::mt19937& random)
+    {
+        // The density stays the same, so the queries return about the same number of objects at every size
+        Scene scene;
+        scene.size = 4.0f * std::cbrt(static_cast<float>(objectCount));
+        std::uniform_real_distribution<float> position(-scene.size * 0.5f, scene.size * 0.5f);
+        std::uniform_real_distribution<float> extent(0.25f, 1.0f);
+
+        scene.bounds.resize(objectCount);
+        scene.objects.resize(objectCount);
+
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            glm::vec3 center(position(random), position(random), position(random));
+            glm::vec3 halfSize(extent(random), extent(random), extent(random));
+
+            scene.bounds[i] = { center - halfSize, center + halfSize };
+            scene.objects[i] = i;
+        }
+
+        return scene;
+    }
+
+    static void printTree(const char* name, const Bvh& bvh, double seconds)
+    {
+        std::printf("  %-16s %9.2f ms  height %3u  SAH cost %8.1f\n", name, seconds * 1000.0, bvh.getHeight(), bvh.getSurfaceAreaCost());
+    }
+
+    static void printTree(const char* name, const Bvh& bvh)
+    {
+        std::printf("  %-16s %12s  height %3u  SAH cost %8.1f\n", name, "", bvh.getHeight(), bvh.getSurfaceAreaCost());
+    }
+
+    static void printRate(const char* name, uint32_t count, double seconds, uint64_t results)
+    {
+        std::printf("  %-16s %9.2f M/s  %8.1f results per query\n", name, count / seconds / 1e6, static_cast<double>(results) / count);
+    }
+
+    static void run(uint32_t objectCount)
+    {
+        std::mt19937 random(objectCount);
+        Scene scene = createScene(objectCount, random);
+        std::vector<uint32_t> leaves(objectCount);
+
+        std::printf("%u objects\n", objectCount);
+
+        Bvh bvh;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < objectCount; i++)
+            leaves[i] = bvh.insert(scene.bounds[i], scene.objects[i]);
+        printTree("insert", bvh, getSeconds(start));
+
+        start = std::chrono::steady_clock::now();
+        bvh.build(scene.bounds.data(), scene.objects.data(), objectCount, leaves.data());
+        printTree("SAH build", bvh, getSeconds(start));
+
+        // Every frame a tenth of the objects moves a bit, most of them stay inside their margin
+        const uint32_t frameCount = 10;
+        uint32_t movedCount = std::max(objectCount / 10, 1u);
+        uint32_t reinsertedCount = 0;
+        std::uniform_int_distribution<uint32_t> objectIndex(0, objectCount - 1);
+        std::uniform_real_distribution<float> step(-0.15f, 0.15f);
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            for (uint32_t i = 0; i < movedCount; i++)
+            {
+                uint32_t object = objectIndex(random);
+                glm::vec3 offset(step(random), step(random), step(random));
+
+                scene.bounds[object] = { scene.bounds[object].min + offset, scene.bounds[object].max + offset };
+                reinsertedCount += bvh.update(leaves[object], scene.bounds[object]);
+            }
+        }
+        double refitSeconds = getSeconds(start);
+        std::printf("  %-16s %9.2f M/s  %8.1f %% left their margin\n", "refit", movedCount * frameCount / refitSeconds / 1e6, 100.0 * reinsertedCount / (movedCount * frameCount));
+        printTree("after refit", bvh);
+
+        std::uniform_real_distribution<float> position(-scene.size * 0.5f, scene.size * 0.5f);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+        uint64_t results = 0;
+
+        const uint32_t aabbQueryCount = 100000;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < aabbQueryCount; i++)
+        {
+            glm::vec3 center(position(random), position(random), position(random));
+            bvh.queryAabb({ center - glm::vec3(2.0f), center + glm::vec3(2.0f) }, [&results](uint32_t) { results++; });
+        }
+        printRate("AABB query", aabbQueryCount, getSeconds(start), results);
+
+        // A camera in the middle looking into random directions with a far plane at a tenth of the scene size
+        const uint32_t frustumQueryCount = 100;
+        glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, scene.size * 0.1f);
+        results = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < frustumQueryCount; i++)
+        {
+            glm::vec3 target(direction(random), direction(random), direction(random));
+            Frustum frustum = Frustum::fromMatrix(projection * glm::lookAt(glm::vec3(0.0f), target, glm::vec3(0.0f, 1.0f, 0.0f)));
+            bvh.queryFrustum(frustum, [&results](uint32_t) { results++; });
+        }
+        double frustumSeconds = getSeconds(start);
+        std::printf("  %-16s %9.3f ms  %8.1f results per query\n", "frustum query", frustumSeconds * 1000.0 / frustumQueryCount, static_cast<double>(results) / frustumQueryCount);
+
+        const uint32_t rayCount = 100000;
+        results = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < rayCount; i++)
+        {
+            glm::vec3 origin(position(random), position(random), position(random));
+            glm::vec3 rayDirection(direction(random), direction(random), direction(random));
+            uint32_t object;
+            float distance;
+
+            results += bvh.raycast(origin, rayDirection, scene.size, object, distance);
+        }
+        printRate("raycast", rayCount, getSeconds(start), results);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<uint32_t> objectCounts = { 10000, 100000, 1000000 };
+
+    if (argc > 1)
+    {
+        objectCounts.clear();
+
+        for (int i = 1; i < argc; i++)
+            objectCounts.push_back(static_cast<uint32_t>(std::stoul(argv[i])));
+    }
+
+    for (uint32_t objectCount : objectCounts)
+        BvhBenchmark::run(objectCount);
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+project "MeshImporter"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    warnings "Extra"
+    targetdir ("../../out/bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("../../out/obj/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "src/**.h",
+        "src/**.cpp"
+    }
+
+    includedirs {
+        "../../VulkanPrototype/src/Renderer"
+    }
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
@@ -0,0 +1,434 @@
+#include "MeshImporter.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "Json.h"
+
+namespace MeshImporter
+{
+    // Column major like glTF itself
+    using Matrix = std::array<float, 16>;
+
+    struct GltfFile
+    {
+        JsonValue json;
+        std::vector<std::vector<uint8_t>> buffers;
+    };
+
+    static const Matrix identityMatrix = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+    static bool readBinaryFile(const std::string& filename, std::vector<uint8_t>& data)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+        return file.good();
+    }
+
+    static std::vector<uint8_t> decodeBase64(const std::string& text, size_t begin)
+    {
+        std::vector<uint8_t> data;
+        uint32_t accumulator = 0;
+        int bits = 0;
+
+        for (size_t i = begin; i < text.size() && text[i] != '='; i++)
+        {
+            char c = text[i];
+            int value;
+
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '+') value = 62;
+            else if (c == '/') value = 63;
+            else continue;
+
+            accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+
+            if (bits >= 8)
+            {
+                bits -= 8;
+                data.push_back(static_cast<uint8_t>(accumulator >> bits));
+            }
+        }
+
+        return data;
+    }
+
+    static uint32_t readUint32(const uint8_t* data)
+    {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    static bool loadGltfFile(const std::string& filename, GltfFile& gltf)
+    {
+        std::vector<uint8_t> data;
+        if (!readBinaryFile(filename, data))
+        {
+            std::cerr << "Datei \"" << filename << "\" konnte nicht geoeffnet werden!\n";
+            return false;
+        }
+
+        std::string jsonText;
+        std::vector<uint8_t> binaryChunk;
+
+        // Binary glTF: 12 byte header, JSON chunk, optional BIN chunk
+        if (data.size() >= 12 && readUint32(data.data()) == 0x46546C67)
+        {
+            size_t offset = 12;
+            while (offset + 8 <= data.size())
+            {
+                uint32_t chunkLength = readUint32(&data[offset]);
+                uint32_t chunkType = readUint32(&data[offset + 4]);
+                offset += 8;
+
+                if (offset + chunkLength > data.size())
+                    break;
+
+                if (chunkType == 0x4E4F534A)
+                    jsonText.assign(reinterpret_cast<const char*>(&data[offset]), chunkLength);
+                else if (chunkType == 0x004E4942)
+                    binaryChunk.assign(data.begin() + offset, data.begin() + offset + chunkLength);
+
+                offset += chunkLength;
+            }
+        }
+        else
+        {
+            jsonText.assign(reinterpret_cast<const char*>(data.data()), data.size());
+        }
+
+        if (!parseJson(jsonText, gltf.json))
+        {
+            std::cerr << "Datei \"" << filename << "\" enthaelt kein gueltiges glTF!\n";
+            return false;
+        }
+
+        std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+
+        if (const JsonValue* buffers = gltf.json.find("buffers"))
+        {
+            for (const JsonValue& buffer : buffers->array)
+            {
+                std::string uri = buffer.getString("uri", "");
+                gltf.buffers.emplace_back();
+
+                if (uri.empty())
+                {
+                    gltf.buffers.back() = binaryChunk;
+                }
+                else if (uri.rfind("data:", 0) == 0)
+                {
+                    size_t comma = uri.find(',');
+                    gltf.buffers.back() = decodeBase64(uri, comma == std::string::npos ? uri.size() : comma + 1);
+                }
+                else if (!readBinaryFile(directory + uri, gltf.buffers.back()))
+                {
+                    std::cerr << "Datei \"" << directory + uri << "\" konnte nicht geoeffnet werden!\n";
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static uint32_t getComponentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0;
+    }
+
+    static uint32_t getComponentSize(uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case 5120: case 5121: return 1;
+        case 5122: case 5123: return 2;
+        case 5125: case 5126: return 4;
+        default: return 0;
+        }
+    }
+
+    static float readComponent(const uint8_t* source, uint32_t componentType, bool normalized)
+    {
+        switch (componentType)
+        {
+        case 5120: { int8_t v; memcpy(&v, source, 1); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+        case 5121: { uint8_t v = *source; return normalized ? v / 255.0f : v; }
+        case 5122: { int16_t v; memcpy(&v, source, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+        case 5123: { uint16_t v; memcpy(&v, source, 2); return normalized ? v / 65535.0f : v; }
+        case 5125: { uint32_t v; memcpy(&v, source, 4); return static_cast<float>(v); }
+        default: { float v; memcpy(&v, source, 4); return v; }
+        }
+    }
+
+    /// <summary>
+    /// Liest einen Accessor als float, fehlende Komponenten werden mit defaultValue aufgefuellt.
+    /// </summary>
+    static bool readAccessor(const GltfFile& gltf, uint32_t accessorIndex, uint32_t components, float defaultValue, std::vector<float>& values)
+    {
+        const JsonValue* accessors = gltf.json.find("accessors");
+        const JsonValue* bufferViews = gltf.json.find("bufferViews");
+
+        if (accessors == nullptr || bufferViews == nullptr || accessorIndex >= accessors->array.size())
+            return false;
+
+        const JsonValue& accessor = accessors->array[accessorIndex];
+
+        if (accessor.find("sparse") != nullptr)
+        {
+            std::cerr << "Sparse Accessors werden nicht unterstuetzt!\n";
+            return false;
+        }
+
+        uint32_t count = static_cast<uint32_t>(accessor.getNumber("count", 0));
+        uint32_t componentType = static_cast<uint32_t>(accessor.getNumber("componentType", 0));
+        uint32_t componentCount = getComponentCount(accessor.getString("type", ""));
+        uint32_t componentSize = getComponentSize(componentType);
+        const JsonValue* normalizedValue = accessor.find("normalized");
+        bool normalized = normalizedValue != nullptr && normalizedValue->boolean;
+
+        uint32_t bufferViewIndex = static_cast<uint32_t>(accessor.getNumber("bufferView", -1));
+        if (componentCount == 0 || componentSize == 0 || bufferViewIndex >= bufferViews->array.size())
+            return false;
+
+        const JsonValue& bufferView = bufferViews->array[bufferViewIndex];
+        uint32_t bufferIndex = static_cast<uint32_t>(bufferView.getNumber("buffer", 0));
+        if (bufferIndex >= gltf.buffers.size())
+            return false;
+
+        const std::vector<uint8_t>& buffer = gltf.buffers[bufferIndex];
+        uint64_t offset = static_cast<uint64_t>(bufferView.getNumber("byteOffset", 0) + accessor.getNumber("byteOffset", 0));
+        uint64_t stride = static_cast<uint64_t>(bufferView.getNumber("byteStride", componentCount * componentSize));
+
+        if (count > 0 && offset + stride * (count - 1) + componentCount * componentSize > buffer.size())
+            return false;
+
+        values.assign(static_cast<size_t>(count) * components, defaultValue);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint8_t* element = &buffer[offset + stride * i];
+
+            for (uint32_t c = 0; c < std::min(components, componentCount); c++)
+                values[static_cast<size_t>(i) * components + c] = readComponent(element + c * componentSize, componentType, normalized);
+        }
+
+        return true;
+    }
+
+    static Matrix multiply(const Matrix& a, const Matrix& b)
+    {
+        Matrix result = {};
+
+        for (int column = 0; column < 4; column++)
+            for (int row = 0; row < 4; row++)
+                for (int k = 0; k < 4; k++)
+                    result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+
+        return result;
+    }
+
+    static Matrix getLocalMatrix(const JsonValue& node)
+    {
+        if (const JsonValue* matrix = node.find("matrix"); matrix != nullptr && matrix->array.size() == 16)
+        {
+            Matrix result;
+            for (int i = 0; i < 16; i++)
+                result[i] = static_cast<float>(matrix->array[i].number);
+            return result;
+        }
+
+        float t[3] = { 0, 0, 0 }, r[4] = { 0, 0, 0, 1 }, s[3] = { 1, 1, 1 };
+
+        if (const JsonValue* translation = node.find("translation"); translation != nullptr && translation->array.size() == 3)
+            for (int i = 0; i < 3; i++) t[i] = static_cast<float>(translation->array[i].number);
+
+        if (const JsonValue* rotation = node.find("rotation"); rotation != nullptr && rotation->array.size() == 4)
+            for (int i = 0; i < 4; i++) r[i] = static_cast<float>(rotation->array[i].number);
+
+        if (const JsonValue* scale = node.find("scale"); scale != nullptr && scale->array.size() == 3)
+            for (int i = 0; i < 3; i++) s[i] = static_cast<float>(scale->array[i].number);
+
+        // T * R * S with R from the unit quaternion (x, y, z, w)
+        float x = r[0], y = r[1], z = r[2], w = r[3];
+
+        return
+        {
+            (1 - 2 * (y * y + z * z)) * s[0], (2 * (x * y + z * w)) * s[0], (2 * (x * z - y * w)) * s[0], 0,
+            (2 * (x * y - z * w)) * s[1], (1 - 2 * (x * x + z * z)) * s[1], (2 * (y * z + x * w)) * s[1], 0,
+            (2 * (x * z + y * w)) * s[2], (2 * (y * z - x * w)) * s[2], (1 - 2 * (x * x + y * y)) * s[2], 0,
+            t[0], t[1], t[2], 1
+        };
+    }
+
+    static bool appendPrimitive(const GltfFile& gltf, const JsonValue& primitive, const Matrix& transform, ImportedMesh& mesh)
+    {
+        if (primitive.getNumber("mode", 4) != 4)
+        {
+            std::cerr << "Primitive ohne Triangle List wird uebersprungen\n";
+            return true;
+        }
+
+        const JsonValue* attributes = primitive.find("attributes");
+        if (attributes == nullptr || attributes->find("POSITION") == nullptr)
+            return false;
+
+        std::vector<float> positions, colors, textureCoordinates, indices;
+
+        if (!readAccessor(gltf, static_cast<uint32_t>(attributes->getNumber("POSITION", -1)), 3, 0.0f, positions))
+            return false;
+
+        uint32_t vertexCount = static_cast<uint32_t>(positions.size() / 3);
+
+        if (attributes->find("COLOR_0") == nullptr || !readAccessor(gltf, static_cast<uint32_t>(attributes->getNumber("COLOR_0", -1)), 3, 1.0f, colors))
+            colors.assign(static_cast<size_t>(vertexCount) * 3, 1.0f);
+
+        if (attributes->find("TEXCOORD_0") == nullptr || !readAccessor(gltf, static_cast<uint32_t>(attributes->getNumber("TEXCOORD_0", -1)), 2, 0.0f, textureCoordinates))
+            textureCoordinates.assign(static_cast<size_t>(vertexCount) * 2, 0.0f);
+
+        if (colors.size() != static_cast<size_t>(vertexCount) * 3 || textureCoordinates.size() != static_cast<size_t>(vertexCount) * 2)
+            return false;
+
+        uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            const float* p = &positions[static_cast<size_t>(i) * 3];
+
+            MeshVertex vertex;
+            for (int row = 0; row < 3; row++)
+            {
+                vertex.position[row] = transform[row] * p[0] + transform[4 + row] * p[1] + transform[8 + row] * p[2] + transform[12 + row];
+                vertex.color[row] = colors[static_cast<size_t>(i) * 3 + row];
+            }
+
+            vertex.textureCoordinate[0] = textureCoordinates[static_cast<size_t>(i) * 2];
+            vertex.textureCoordinate[1] = textureCoordinates[static_cast<size_t>(i) * 2 + 1];
+
+            mesh.vertices.push_back(vertex);
+        }
+
+        if (primitive.find("indices") != nullptr)
+        {
+            if (!readAccessor(gltf, static_cast<uint32_t>(primitive.getNumber("indices", -1)), 1, 0.0f, indices))
+                return false;
+
+            for (float index : indices)
+            {
+                if (index >= vertexCount)
+                    return false;
+
+                mesh.indices.push_back(baseVertex + static_cast<uint32_t>(index));
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < vertexCount; i++)
+                mesh.indices.push_back(baseVertex + i);
+        }
+
+        // A negative determinant mirrors the mesh, so the winding has to be flipped back
+        float determinant =
+            transform[0] * (transform[5] * transform[10] - transform[9] * transform[6]) -
+            transform[4] * (transform[1] * transform[10] - transform[9] * transform[2]) +
+            transform[8] * (transform[1] * transform[6] - transform[5] * transform[2]);
+
+        if (determinant < 0.0f)
+        {
+            size_t firstIndex = mesh.indices.size() - (indices.empty() ? vertexCount : indices.size());
+            for (size_t i = firstIndex; i + 2 < mesh.indices.size(); i += 3)
+                std::swap(mesh.indices[i + 1], mesh.indices[i + 2]);
+        }
+
+        return true;
+    }
+
+    static bool appendNode(const GltfFile& gltf, uint32_t nodeIndex, const Matrix& parentTransform, uint32_t depth, ImportedMesh& mesh)
+    {
+        const JsonValue* nodes = gltf.json.find("nodes");
+        const JsonValue* meshes = gltf.json.find("meshes");
+
+        // The depth limit guards against cyclic node references in broken files
+        if (nodes == nullptr || nodeIndex >= nodes->array.size() || depth > 64)
+            return false;
+
+        const JsonValue& node = nodes->array[nodeIndex];
+        Matrix transform = multiply(parentTransform, getLocalMatrix(node));
+
+        if (const JsonValue* meshIndex = node.find("mesh"); meshIndex != nullptr && meshes != nullptr && meshIndex->number < meshes->array.size())
+        {
+            if (const JsonValue* primitives = meshes->array[static_cast<size_t>(meshIndex->number)].find("primitives"))
+            {
+                for (const JsonValue& primitive : primitives->array)
+                {
+                    if (!appendPrimitive(gltf, primitive, transform, mesh))
+                        return false;
+                }
+            }
+        }
+
+        if (const JsonValue* children = node.find("children"))
+        {
+            for (const JsonValue& child : children->array)
+            {
+                if (!appendNode(gltf, static_cast<uint32_t>(child.number), transform, depth + 1, mesh))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool importGltf(const std::string& filename, ImportedMesh& mesh)
+    {
+        GltfFile gltf;
+        if (!loadGltfFile(filename, gltf))
+            return false;
+
+        bool success = true;
+
+        const JsonValue* scenes = gltf.json.find("scenes");
+        uint32_t sceneIndex = static_cast<uint32_t>(gltf.json.getNumber("scene", 0));
+
+        if (scenes != nullptr && sceneIndex < scenes->array.size())
+        {
+            // Nodes of the scene with their transforms baked into the vertices
+            if (const JsonValue* rootNodes = scenes->array[sceneIndex].find("nodes"))
+            {
+                for (const JsonValue& rootNode : rootNodes->array)
+                    success = success && appendNode(gltf, static_cast<uint32_t>(rootNode.number), identityMatrix, 0, mesh);
+            }
+        }
+        else if (const JsonValue* meshes = gltf.json.find("meshes"))
+        {
+            // Files without a scene only contain meshes in their local space
+            for (const JsonValue& gltfMesh : meshes->array)
+            {
+                if (const JsonValue* primitives = gltfMesh.find("primitives"))
+                {
+                    for (const JsonValue& primitive : primitives->array)
+                        success = success && appendPrimitive(gltf, primitive, identityMatrix, mesh);
+                }
+            }
+        }
+
+        if (!success)
+            std::cerr << "Datei \"" << filename << "\" enthaelt ungueltige Mesh Daten!\n";
+
+        return success;
+    }
+}
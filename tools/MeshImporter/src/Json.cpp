@@ -0,0 +1,225 @@
+#include "Json.h"
+
+#include <cstdlib>
+
+namespace MeshImporter
+{
+    /*
+     * Parser
+     */
+
+    struct JsonParser
+    {
+        const std::string& text;
+        size_t position = 0;
+
+        void skipWhitespace()
+        {
+            while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r'))
+                position++;
+        }
+
+        bool consume(char c)
+        {
+            skipWhitespace();
+
+            if (position >= text.size() || text[position] != c)
+                return false;
+
+            position++;
+            return true;
+        }
+
+        bool consumeLiteral(const char* literal)
+        {
+            size_t length = std::char_traits<char>::length(literal);
+
+            if (text.compare(position, length, literal) != 0)
+                return false;
+
+            position += length;
+            return true;
+        }
+
+        static void appendUtf8(std::string& string, uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                string += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                string += static_cast<char>(0xC0 | (codePoint >> 6));
+                string += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                string += static_cast<char>(0xE0 | (codePoint >> 12));
+                string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                string += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        bool parseString(std::string& string)
+        {
+            if (!consume('"'))
+                return false;
+
+            while (position < text.size() && text[position] != '"')
+            {
+                char c = text[position++];
+
+                if (c != '\\')
+                {
+                    string += c;
+                    continue;
+                }
+
+                if (position >= text.size())
+                    return false;
+
+                char escape = text[position++];
+                switch (escape)
+                {
+                case 'b': string += '\b'; break;
+                case 'f': string += '\f'; break;
+                case 'n': string += '\n'; break;
+                case 'r': string += '\r'; break;
+                case 't': string += '\t'; break;
+                case 'u':
+                    if (position + 4 > text.size())
+                        return false;
+                    appendUtf8(string, static_cast<uint32_t>(std::strtoul(text.substr(position, 4).c_str(), nullptr, 16)));
+                    position += 4;
+                    break;
+                default: string += escape; break;
+                }
+            }
+
+            return consume('"');
+        }
+
+        bool parseValue(JsonValue& value)
+        {
+            skipWhitespace();
+
+            if (position >= text.size())
+                return false;
+
+            char c = text[position];
+
+            if (c == '{')
+            {
+                value.type = JsonValue::JSON_OBJECT;
+                position++;
+
+                if (consume('}'))
+                    return true;
+
+                do
+                {
+                    std::pair<std::string, JsonValue> member;
+                    if (!parseString(member.first) || !consume(':') || !parseValue(member.second))
+                        return false;
+
+                    value.object.push_back(std::move(member));
+                } while (consume(','));
+
+                return consume('}');
+            }
+
+            if (c == '[')
+            {
+                value.type = JsonValue::JSON_ARRAY;
+                position++;
+
+                if (consume(']'))
+                    return true;
+
+                do
+                {
+                    value.array.emplace_back();
+                    if (!parseValue(value.array.back()))
+                        return false;
+                } while (consume(','));
+
+                return consume(']');
+            }
+
+            if (c == '"')
+            {
+                value.type = JsonValue::JSON_STRING;
+                return parseString(value.string);
+            }
+
+            if (consumeLiteral("true"))
+            {
+                value.type = JsonValue::JSON_BOOL;
+                value.boolean = true;
+                return true;
+            }
+
+            if (consumeLiteral("false"))
+            {
+                value.type = JsonValue::JSON_BOOL;
+                return true;
+            }
+
+            if (consumeLiteral("null"))
+                return true;
+
+            const char* begin = text.c_str() + position;
+            char* end = nullptr;
+            value.type = JsonValue::JSON_NUMBER;
+            value.number = std::strtod(begin, &end);
+
+            if (end == begin)
+                return false;
+
+            position += static_cast<size_t>(end - begin);
+            return true;
+        }
+    };
+
+    /*
+     * Member Functions
+     */
+
+    const JsonValue* JsonValue::find(const std::string& key) const
+    {
+        for (const std::pair<std::string, JsonValue>& member : object)
+        {
+            if (member.first == key)
+                return &member.second;
+        }
+
+        return nullptr;
+    }
+
+    double JsonValue::getNumber(const std::string& key, double defaultValue) const
+    {
+        const JsonValue* value = find(key);
+        return value != nullptr && value->type == JSON_NUMBER ? value->number : defaultValue;
+    }
+
+    std::string JsonValue::getString(const std::string& key, const std::string& defaultValue) const
+    {
+        const JsonValue* value = find(key);
+        return value != nullptr && value->type == JSON_STRING ? value->string : defaultValue;
+    }
+
+    /*
+     * Global Functions
+     */
+
+    bool parseJson(const std::string& text, JsonValue& value)
+    {
+        JsonParser parser = { text };
+
+        if (!parser.parseValue(value))
+            return false;
+
+        parser.skipWhitespace();
+        return parser.position == text.size();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace MeshImporter
+{
+    /// <summary>
+    /// Minimaler JSON Baum, gerade genug um glTF Dateien zu lesen.
+    /// </summary>
+    struct JsonValue
+    {
+        enum Type
+        {
+            JSON_NULL,
+            JSON_BOOL,
+            JSON_NUMBER,
+            JSON_STRING,
+            JSON_ARRAY,
+            JSON_OBJECT
+        };
+
+        Type type = JSON_NULL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        const JsonValue* find(const std::string& key) const;
+
+        double getNumber(const std::string& key, double defaultValue) const;
+        std::string getString(const std::string& key, const std::string& defaultValue) const;
+    };
+
+    bool parseJson(const std::string& text, JsonValue& value);
+}
+
+#endif // JSON_H
@@ -0,0 +1,81 @@
+#ifndef MESHIMPORTER_H
+#define MESHIMPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <MeshFormat.h>
+
+namespace MeshImporter
+{
+    using VulkanPrototype::Renderer::MeshVertex;
+    using VulkanPrototype::Renderer::QuantizedVertex;
+
+    struct ImportedLod
+    {
+        std::vector<uint32_t> indices;
+        float error;
+    };
+
+    struct ImportedMesh
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices;
+
+        // Simplified levels after the full mesh in indices, they reference the same vertices
+        std::vector<ImportedLod> lods;
+    };
+
+    /*
+     * Importers, all primitives of a file are merged into one indexed triangle list
+     */
+
+    bool importObj(const std::string& filename, ImportedMesh& mesh);
+    bool importGltf(const std::string& filename, ImportedMesh& mesh);
+
+    /*
+     * Optimization, run in this order: vertex cache, overdraw, LOD generation, vertex fetch
+     */
+
+    struct VertexCacheStatistics
+    {
+        float acmr;     // Cache misses per triangle, 0.5 is the optimum for large regular meshes
+        float atvr;     // Cache misses per vertex, 1.0 means every vertex is transformed exactly once
+    };
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    /// <summary>
+    /// Sortiert Cluster des cache optimierten Index Buffers so, dass aussen liegende Flaechen zuerst gezeichnet werden.
+    /// threshold begrenzt wie stark die ACMR eines Clusters ueber der des ganzen Meshes liegen darf.
+    /// </summary>
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold);
+
+    /// <summary>
+    /// Vereinfacht das Mesh durch Kanten Kollapse nach Quadric Error, bis targetIndexCount erreicht ist oder jeder weitere Kollapse
+    /// mehr als maxError von der Oberflaeche abweichen wuerde. Es werden nur Indices erzeugt, die Vertices bleiben unveraendert.
+    /// </summary>
+    bool simplifyMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, std::vector<uint32_t>& result, float& resultError);
+
+    /// <summary>
+    /// Erzeugt bis zu lodCount - 1 vereinfachte Stufen mit jeweils der halben Dreiecksanzahl.
+    /// Die letzte Stufe darf hoechstens errorLimit mal die Diagonale der Bounding Box abweichen, jede davor die Haelfte ihrer Nachfolgerin.
+    /// </summary>
+    void generateLods(ImportedMesh& mesh, uint32_t lodCount, float errorLimit);
+
+    void optimizeVertexFetch(ImportedMesh& mesh);
+
+    /*
+     * Writer
+     */
+
+    /// <summary>
+    /// Schreibt die Vertices standardmaessig als QuantizedVertex, mit quantize = false als float MeshVertex.
+    /// </summary>
+    bool writeMeshFile(const std::string& filename, const ImportedMesh& mesh, bool quantize);
+}
+
+#endif // MESHIMPORTER_H
@@ -0,0 +1,349 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace MeshImporter
+{
+    /*
+    * Vertex cache simulation
+    */
+
+    struct FifoCache
+    {
+        std::vector<uint32_t> timestamps;
+        uint32_t cacheSize;
+        uint32_t time;
+
+        FifoCache(uint32_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), cacheSize(cacheSize), time(cacheSize + 1)
+        {
+        }
+
+        // Returns true on a miss, a vertex is in the cache while fewer than cacheSize misses happened since it was loaded
+        bool access(uint32_t vertex)
+        {
+            if (time - timestamps[vertex] > cacheSize)
+            {
+                timestamps[vertex] = time++;
+                return true;
+            }
+
+            return false;
+        }
+
+        void flush()
+        {
+            time += cacheSize + 1;
+        }
+    };
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        FifoCache cache(static_cast<uint32_t>(vertexCount), cacheSize);
+        uint32_t misses = 0;
+
+        for (uint32_t index : indices)
+            misses += cache.access(index) ? 1 : 0;
+
+        VertexCacheStatistics statistics;
+        statistics.acmr = indices.empty() ? 0.0f : static_cast<float>(misses) / (indices.size() / 3);
+        statistics.atvr = vertexCount == 0 ? 0.0f : static_cast<float>(misses) / vertexCount;
+
+        return statistics;
+    }
+
+    /*
+    * Vertex cache optimization, Tom Forsyth "Linear-Speed Vertex Cache Optimisation"
+    */
+
+    static const uint32_t forsythCacheSize = 32;
+
+    static float getVertexScore(int32_t cachePosition, uint32_t remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+
+        if (cachePosition >= 0)
+        {
+            // The last triangle's vertices get a fixed score so its neighbours are not preferred over strips
+            if (cachePosition < 3)
+                score = 0.75f;
+            else
+                score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (forsythCacheSize - 3), 1.5f);
+        }
+
+        // Vertices with few remaining triangles are finished first, so they do not have to be loaded again later
+        return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        if (triangleCount == 0)
+            return;
+
+        // Triangles per vertex as one flat adjacency array
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (uint32_t index : indices)
+            adjacencyOffsets[index + 1]++;
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                adjacency[adjacencyOffsets[vertex] + remainingTriangles[vertex]++] = triangle;
+            }
+        }
+
+        std::vector<float> vertexScores(vertexCount);
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+            vertexScores[vertex] = getVertexScore(-1, remainingTriangles[vertex]);
+
+        std::vector<bool> emitted(triangleCount, false);
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        // Cache plus room for the three vertices pushed by the next triangle
+        std::vector<uint32_t> cache, nextCache;
+        cache.reserve(forsythCacheSize + 3);
+        nextCache.reserve(forsythCacheSize + 3);
+
+        uint32_t bestTriangle = UINT32_MAX;
+        uint32_t scanPosition = 0;
+
+        for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            // Nothing in the cache is adjacent to a remaining triangle, continue with the next one in input order
+            if (bestTriangle == UINT32_MAX)
+            {
+                while (emitted[scanPosition])
+                    scanPosition++;
+
+                bestTriangle = scanPosition;
+            }
+
+            emitted[bestTriangle] = true;
+            nextCache.clear();
+
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[bestTriangle * 3 + corner];
+                result.push_back(vertex);
+                nextCache.push_back(vertex);
+
+                // Remove the triangle from the vertex's adjacency, order does not matter
+                uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+                uint32_t* last = triangles + remainingTriangles[vertex] - 1;
+                *std::find(triangles, last + 1, bestTriangle) = *last;
+                remainingTriangles[vertex]--;
+            }
+
+            for (uint32_t vertex : cache)
+            {
+                if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+                    nextCache.push_back(vertex);
+            }
+
+            // Vertices pushed out of the cache lose their position score
+            for (size_t i = forsythCacheSize; i < nextCache.size(); i++)
+            {
+                vertexScores[nextCache[i]] = getVertexScore(-1, remainingTriangles[nextCache[i]]);
+            }
+
+            nextCache.resize(std::min<size_t>(nextCache.size(), forsythCacheSize));
+            std::swap(cache, nextCache);
+
+            for (size_t i = 0; i < cache.size(); i++)
+            {
+                vertexScores[cache[i]] = getVertexScore(static_cast<int32_t>(i), remainingTriangles[cache[i]]);
+            }
+
+            // Only triangles around cached vertices changed their score
+            bestTriangle = UINT32_MAX;
+            float bestScore = -1.0f;
+
+            for (uint32_t vertex : cache)
+            {
+                for (uint32_t i = 0; i < remainingTriangles[vertex]; i++)
+                {
+                    uint32_t triangle = adjacency[adjacencyOffsets[vertex] + i];
+                    float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTriangle = triangle;
+                    }
+                }
+            }
+        }
+
+        indices = std::move(result);
+    }
+
+    /*
+    * Overdraw optimization, Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+    */
+
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold)
+    {
+        uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        if (triangleCount < 2)
+            return;
+
+        const uint32_t cacheSize = 16;
+        float meshAcmr = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr;
+
+        // Clusters start where the cache optimized order jumps, a triangle with three misses shares nothing with its predecessors
+        std::vector<uint32_t> hardBoundaries;
+        FifoCache cache(static_cast<uint32_t>(vertices.size()), cacheSize);
+
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            uint32_t misses = 0;
+            for (uint32_t corner = 0; corner < 3; corner++)
+                misses += cache.access(indices[triangle * 3 + corner]) ? 1 : 0;
+
+            if (triangle == 0 || misses == 3)
+                hardBoundaries.push_back(triangle);
+        }
+
+        hardBoundaries.push_back(triangleCount);
+
+        // Clusters get drawn in any order, so they are simulated with an empty cache. A cluster is split as soon as its
+        // ACMR dropped to threshold * mesh ACMR, smaller clusters sort better but pay for the cold cache more often.
+        std::vector<uint32_t> clusterStarts;
+
+        for (size_t hardCluster = 0; hardCluster + 1 < hardBoundaries.size(); hardCluster++)
+        {
+            uint32_t clusterMisses = 0, clusterTriangles = 0;
+
+            for (uint32_t triangle = hardBoundaries[hardCluster]; triangle < hardBoundaries[hardCluster + 1]; triangle++)
+            {
+                if (clusterTriangles == 0)
+                {
+                    clusterStarts.push_back(triangle);
+                    cache.flush();
+                }
+
+                for (uint32_t corner = 0; corner < 3; corner++)
+                    clusterMisses += cache.access(indices[triangle * 3 + corner]) ? 1 : 0;
+
+                clusterTriangles++;
+
+                if (static_cast<float>(clusterMisses) / clusterTriangles <= threshold * meshAcmr)
+                {
+                    clusterMisses = 0;
+                    clusterTriangles = 0;
+                }
+            }
+        }
+
+        clusterStarts.push_back(triangleCount);
+        uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+
+        float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+        for (const MeshVertex& vertex : vertices)
+        {
+            for (int i = 0; i < 3; i++)
+                meshCentroid[i] += vertex.position[i] / vertices.size();
+        }
+
+        // Clusters far out and facing away from the center are likely occluders and drawn first
+        std::vector<float> clusterSortKeys(clusterCount);
+
+        for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+        {
+            float centroid[3] = { 0.0f, 0.0f, 0.0f }, normal[3] = { 0.0f, 0.0f, 0.0f };
+            float area = 0.0f;
+
+            for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+            {
+                const float* a = vertices[indices[triangle * 3]].position;
+                const float* b = vertices[indices[triangle * 3 + 1]].position;
+                const float* c = vertices[indices[triangle * 3 + 2]].position;
+
+                float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                float cross[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+                float triangleArea = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+                // Area weighted, the length of the cross product already is twice the area
+                for (int i = 0; i < 3; i++)
+                {
+                    centroid[i] += (a[i] + b[i] + c[i]) / 3.0f * triangleArea;
+                    normal[i] += cross[i];
+                }
+
+                area += triangleArea;
+            }
+
+            float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            float key = 0.0f;
+
+            if (area > 0.0f && normalLength > 0.0f)
+            {
+                for (int i = 0; i < 3; i++)
+                    key += (centroid[i] / area - meshCentroid[i]) * normal[i] / normalLength;
+            }
+
+            clusterSortKeys[cluster] = key;
+        }
+
+        std::vector<uint32_t> clusterOrder(clusterCount);
+        std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) { return clusterSortKeys[a] > clusterSortKeys[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        for (uint32_t cluster : clusterOrder)
+            result.insert(result.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+
+        indices = std::move(result);
+    }
+
+    /*
+    * Vertex fetch optimization
+    */
+
+    void optimizeVertexFetch(ImportedMesh& mesh)
+    {
+        // Vertices in the order of their first use, unused vertices are dropped
+        std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+        std::vector<MeshVertex> vertices;
+        vertices.reserve(mesh.vertices.size());
+
+        auto remapIndices = [&](std::vector<uint32_t>& indices)
+        {
+            for (uint32_t& index : indices)
+            {
+                if (remap[index] == UINT32_MAX)
+                {
+                    remap[index] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(mesh.vertices[index]);
+                }
+
+                index = remap[index];
+            }
+        };
+
+        // LOD 0 decides the order, simplified LODs only reference vertices that LOD 0 uses as well
+        remapIndices(mesh.indices);
+        for (ImportedLod& lod : mesh.lods)
+            remapIndices(lod.indices);
+
+        mesh.vertices = std::move(vertices);
+    }
+}
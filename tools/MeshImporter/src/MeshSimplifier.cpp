@@ -0,0 +1,340 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace MeshImporter
+{
+    /*
+    * Quadric error metric, Garland and Heckbert "Surface Simplification Using Quadric Error Metrics"
+    */
+
+    struct Quadric
+    {
+        // Symmetric 4x4 matrix of the summed plane equations
+        double a00, a01, a02, a03;
+        double a11, a12, a13;
+        double a22, a23;
+        double a33;
+        double weight;
+
+        void addPlane(const double plane[4], double planeWeight)
+        {
+            a00 += plane[0] * plane[0] * planeWeight;
+            a01 += plane[0] * plane[1] * planeWeight;
+            a02 += plane[0] * plane[2] * planeWeight;
+            a03 += plane[0] * plane[3] * planeWeight;
+            a11 += plane[1] * plane[1] * planeWeight;
+            a12 += plane[1] * plane[2] * planeWeight;
+            a13 += plane[1] * plane[3] * planeWeight;
+            a22 += plane[2] * plane[2] * planeWeight;
+            a23 += plane[2] * plane[3] * planeWeight;
+            a33 += plane[3] * plane[3] * planeWeight;
+            weight += planeWeight;
+        }
+
+        void add(const Quadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+            a11 += other.a11; a12 += other.a12; a13 += other.a13;
+            a22 += other.a22; a23 += other.a23;
+            a33 += other.a33;
+            weight += other.weight;
+        }
+
+        // Weighted mean of the squared distances to all planes
+        double evaluate(const float position[3]) const
+        {
+            double x = position[0], y = position[1], z = position[2];
+
+            double error =
+                a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                a22 * z * z + 2 * a23 * z +
+                a33;
+
+            return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t source;
+        uint32_t target;
+        double error;
+    };
+
+    static void getTriangleNormal(const float* a, const float* b, const float* c, double normal[3])
+    {
+        double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+        normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+        normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+        normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+    }
+
+    // Vertices with the same position but different attributes share one id, so texture seams do not open up as holes
+    static std::vector<uint32_t> getPositionIds(const std::vector<MeshVertex>& vertices)
+    {
+        struct PositionHash
+        {
+            size_t operator()(const std::array<float, 3>& position) const
+            {
+                uint32_t bits[3];
+                memcpy(bits, position.data(), sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+
+        std::unordered_map<std::array<float, 3>, uint32_t, PositionHash> positionLookup;
+        std::vector<uint32_t> positionIds(vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            std::array<float, 3> position = { vertices[i].position[0], vertices[i].position[1], vertices[i].position[2] };
+            positionIds[i] = positionLookup.try_emplace(position, static_cast<uint32_t>(i)).first->second;
+        }
+
+        return positionIds;
+    }
+
+    bool simplifyMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, std::vector<uint32_t>& result, float& resultError)
+    {
+        size_t vertexCount = vertices.size();
+        std::vector<uint32_t> positionIds = getPositionIds(vertices);
+
+        // Seam vertices and vertices on open borders are never moved, only collapsed onto
+        std::vector<uint32_t> attributeVertexCount(vertexCount, 0);
+        for (size_t i = 0; i < vertexCount; i++)
+            attributeVertexCount[positionIds[i]]++;
+
+        std::unordered_map<uint64_t, uint32_t> edgeCounts;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t a = positionIds[indices[i + corner]], b = positionIds[indices[i + (corner + 1) % 3]];
+                edgeCounts[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+            }
+        }
+
+        std::vector<bool> locked(vertexCount, false);
+        for (size_t i = 0; i < vertexCount; i++)
+            locked[i] = attributeVertexCount[positionIds[i]] > 1;
+
+        for (const auto& [edge, count] : edgeCounts)
+        {
+            if (count != 2)
+            {
+                // Position ids are vertex indices, marking them locks every vertex at that position
+                locked[static_cast<uint32_t>(edge >> 32)] = true;
+                locked[static_cast<uint32_t>(edge)] = true;
+            }
+        }
+
+        for (size_t i = 0; i < vertexCount; i++)
+            locked[i] = locked[i] || locked[positionIds[i]];
+
+        // Area weighted plane quadrics, accumulated per position
+        std::vector<Quadric> quadrics(vertexCount, Quadric{});
+
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const float* a = vertices[indices[i]].position;
+            const float* b = vertices[indices[i + 1]].position;
+            const float* c = vertices[indices[i + 2]].position;
+
+            double normal[3];
+            getTriangleNormal(a, b, c, normal);
+
+            double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length <= 0.0)
+                continue;
+
+            double plane[4] = { normal[0] / length, normal[1] / length, normal[2] / length, 0.0 };
+            plane[3] = -(plane[0] * a[0] + plane[1] * a[1] + plane[2] * a[2]);
+
+            for (uint32_t corner = 0; corner < 3; corner++)
+                quadrics[positionIds[indices[i + corner]]].addPlane(plane, length * 0.5);
+        }
+
+        result = indices;
+        resultError = 0.0f;
+
+        double maxErrorSquared = static_cast<double>(maxError) * maxError;
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> collapseTargets(vertexCount);
+        std::vector<bool> touched(vertexCount);
+
+        // Every pass collapses a batch of independent edges in the order of their error
+        while (result.size() > targetIndexCount)
+        {
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (uint32_t index : result)
+                adjacencyOffsets[index + 1]++;
+            for (size_t i = 1; i <= vertexCount; i++)
+                adjacencyOffsets[i] += adjacencyOffsets[i - 1];
+
+            adjacency.resize(result.size());
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+                adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t source = result[i + corner], target = result[i + (corner + 1) % 3];
+
+                    for (int direction = 0; direction < 2; direction++, std::swap(source, target))
+                    {
+                        if (locked[source])
+                            continue;
+
+                        double error = quadrics[positionIds[source]].evaluate(vertices[target].position);
+                        if (error <= maxErrorSquared)
+                            collapses.push_back({ source, target, error });
+                    }
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            // Each collapse removes about two triangles, more than needed would overshoot the target
+            size_t collapseLimit = std::max<size_t>((result.size() - targetIndexCount) / 6, 1);
+            size_t collapseCount = 0;
+
+            for (size_t i = 0; i < vertexCount; i++)
+                collapseTargets[i] = static_cast<uint32_t>(i);
+            std::fill(touched.begin(), touched.end(), false);
+
+            for (const Collapse& collapse : collapses)
+            {
+                if (collapseCount >= collapseLimit)
+                    break;
+
+                if (touched[collapse.source] || touched[collapse.target])
+                    continue;
+
+                // Reject collapses that flip a remaining triangle around the source vertex
+                bool flipped = false;
+
+                for (uint32_t i = adjacencyOffsets[collapse.source]; i < adjacencyOffsets[collapse.source + 1] && !flipped; i++)
+                {
+                    const uint32_t* triangle = &result[adjacency[i] * 3];
+
+                    if (triangle[0] == collapse.target || triangle[1] == collapse.target || triangle[2] == collapse.target)
+                        continue;
+
+                    const float* positions[3];
+                    const float* moved[3];
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                    {
+                        positions[corner] = vertices[triangle[corner]].position;
+                        moved[corner] = triangle[corner] == collapse.source ? vertices[collapse.target].position : positions[corner];
+                    }
+
+                    double before[3], after[3];
+                    getTriangleNormal(positions[0], positions[1], positions[2], before);
+                    getTriangleNormal(moved[0], moved[1], moved[2], after);
+
+                    flipped = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0;
+                }
+
+                if (flipped)
+                    continue;
+
+                // Neighbours of the source keep their triangles for this pass, so the flip test above stays valid
+                for (uint32_t i = adjacencyOffsets[collapse.source]; i < adjacencyOffsets[collapse.source + 1]; i++)
+                {
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                        touched[result[adjacency[i] * 3 + corner]] = true;
+                }
+
+                collapseTargets[collapse.source] = collapse.target;
+                quadrics[positionIds[collapse.target]].add(quadrics[positionIds[collapse.source]]);
+                resultError = std::max(resultError, static_cast<float>(std::sqrt(collapse.error)));
+                collapseCount++;
+            }
+
+            if (collapseCount == 0)
+                break;
+
+            size_t writePosition = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                uint32_t a = collapseTargets[result[i]], b = collapseTargets[result[i + 1]], c = collapseTargets[result[i + 2]];
+
+                if (a == b || b == c || a == c)
+                    continue;
+
+                result[writePosition++] = a;
+                result[writePosition++] = b;
+                result[writePosition++] = c;
+            }
+
+            result.resize(writePosition);
+        }
+
+        return result.size() < indices.size();
+    }
+
+    /*
+    * LOD generation
+    */
+
+    void generateLods(ImportedMesh& mesh, uint32_t lodCount, float errorLimit)
+    {
+        mesh.lods.clear();
+
+        float boundsMin[3] = { 0.0f, 0.0f, 0.0f }, boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                boundsMin[axis] = i == 0 ? mesh.vertices[i].position[axis] : std::min(boundsMin[axis], mesh.vertices[i].position[axis]);
+                boundsMax[axis] = i == 0 ? mesh.vertices[i].position[axis] : std::max(boundsMax[axis], mesh.vertices[i].position[axis]);
+            }
+        }
+
+        float extent = std::sqrt(
+            (boundsMax[0] - boundsMin[0]) * (boundsMax[0] - boundsMin[0]) +
+            (boundsMax[1] - boundsMin[1]) * (boundsMax[1] - boundsMin[1]) +
+            (boundsMax[2] - boundsMin[2]) * (boundsMax[2] - boundsMin[2]));
+
+        size_t previousIndexCount = mesh.indices.size();
+        float previousError = 0.0f;
+
+        // Every level halves the triangles, its error may double up to errorLimit times the mesh size at the last level
+        for (uint32_t level = 1; level < lodCount; level++)
+        {
+            size_t targetIndexCount = previousIndexCount / 6 * 3;
+            float maxError = errorLimit * extent / static_cast<float>(1u << (lodCount - 1 - level));
+
+            // Always simplified from LOD 0, so the quadrics measure the error against the original surface
+            ImportedLod lod;
+            if (!simplifyMesh(mesh.vertices, mesh.indices, targetIndexCount, maxError, lod.indices, lod.error))
+                break;
+
+            // A level that barely removes triangles only costs memory
+            if (lod.indices.size() > previousIndexCount * 9 / 10)
+                break;
+
+            optimizeVertexCache(lod.indices, mesh.vertices.size());
+
+            lod.error = std::max(lod.error, previousError);
+            previousIndexCount = lod.indices.size();
+            previousError = lod.error;
+
+            mesh.lods.push_back(std::move(lod));
+        }
+    }
+}
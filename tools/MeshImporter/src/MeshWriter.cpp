@@ -0,0 +1,114 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+
+namespace MeshImporter
+{
+    using namespace VulkanPrototype::Renderer;
+
+    static uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + meshFileAlignment - 1) & ~static_cast<uint64_t>(meshFileAlignment - 1);
+    }
+
+    static void writePadding(std::ofstream& file, uint64_t offset)
+    {
+        static const char zeros[meshFileAlignment] = {};
+        file.write(zeros, static_cast<std::streamsize>(alignOffset(offset) - offset));
+    }
+
+    bool writeMeshFile(const std::string& filename, const ImportedMesh& mesh, bool quantize)
+    {
+        MeshFileHeader header = {};
+        header.magic = meshFileMagic;
+        header.version = meshFileVersion;
+        header.vertexFormat = quantize ? MESH_VERTEX_FORMAT_QUANTIZED : MESH_VERTEX_FORMAT_FLOAT;
+        header.streamCount = 1;
+        header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        header.lodCount = static_cast<uint32_t>(std::min<size_t>(mesh.lods.size() + 1, meshMaxLodCount));
+
+        // All LODs one after another in a single index block
+        std::vector<uint32_t> indices = mesh.indices;
+        std::vector<MeshFileLod> lods = { { 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f, 0 } };
+
+        for (uint32_t i = 1; i < header.lodCount; i++)
+        {
+            const ImportedLod& lod = mesh.lods[i - 1];
+
+            lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.indices.size()), lod.error, 0 });
+            indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+        }
+
+        header.indexCount = static_cast<uint32_t>(indices.size());
+
+        // 16 bit indices halve the index bandwidth for every mesh that fits into them
+        header.indexSize = header.vertexCount <= 0xFFFF ? 2 : 4;
+
+        for (int i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = mesh.vertices.empty() ? 0.0f : FLT_MAX;
+            header.boundsMax[i] = mesh.vertices.empty() ? 0.0f : -FLT_MAX;
+        }
+
+        for (const MeshVertex& vertex : mesh.vertices)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                header.boundsMin[i] = std::min(header.boundsMin[i], vertex.position[i]);
+                header.boundsMax[i] = std::max(header.boundsMax[i], vertex.position[i]);
+            }
+        }
+
+        MeshFileStream stream = {};
+        stream.stride = quantize ? sizeof(QuantizedVertex) : sizeof(MeshVertex);
+        uint64_t tableSize = sizeof(MeshFileHeader) + sizeof(MeshFileStream) + sizeof(MeshFileLod) * lods.size();
+        stream.offset = alignOffset(tableSize);
+
+        uint64_t vertexSize = static_cast<uint64_t>(mesh.vertices.size()) * stream.stride;
+        header.indexOffset = alignOffset(stream.offset + vertexSize);
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&stream), sizeof(stream));
+        file.write(reinterpret_cast<const char*>(lods.data()), static_cast<std::streamsize>(sizeof(MeshFileLod) * lods.size()));
+        writePadding(file, tableSize);
+
+        if (quantize)
+        {
+            VertexQuantization quantization = getVertexQuantization(header.boundsMin, header.boundsMax);
+
+            std::vector<QuantizedVertex> vertices;
+            vertices.reserve(mesh.vertices.size());
+
+            for (const MeshVertex& vertex : mesh.vertices)
+                vertices.push_back(quantizeVertex(quantization, vertex.position, vertex.color, vertex.textureCoordinate));
+
+            file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertexSize));
+        }
+        else
+        {
+            file.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(vertexSize));
+        }
+
+        writePadding(file, stream.offset + vertexSize);
+
+        if (header.indexSize == 2)
+        {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            file.write(reinterpret_cast<const char*>(shortIndices.data()), static_cast<std::streamsize>(shortIndices.size() * sizeof(uint16_t)));
+        }
+        else
+        {
+            file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+        }
+
+        writePadding(file, header.indexOffset + static_cast<uint64_t>(header.indexCount) * header.indexSize);
+
+        return file.good();
+    }
+}
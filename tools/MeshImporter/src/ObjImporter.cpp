@@ -0,0 +1,149 @@
+#include "MeshImporter.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace MeshImporter
+{
+    struct ObjPosition
+    {
+        float position[3];
+        float color[3];
+    };
+
+    struct ObjTextureCoordinate
+    {
+        float u;
+        float v;
+    };
+
+    // Resolves 1-based and negative (relative) OBJ indices, returns -1 for missing or invalid references
+    static int64_t resolveIndex(const std::string& token, size_t count)
+    {
+        if (token.empty())
+            return -1;
+
+        int64_t index = std::strtoll(token.c_str(), nullptr, 10);
+        index = index < 0 ? static_cast<int64_t>(count) + index : index - 1;
+
+        return index >= 0 && index < static_cast<int64_t>(count) ? index : -1;
+    }
+
+    bool importObj(const std::string& filename, ImportedMesh& mesh)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            std::cerr << "Datei \"" << filename << "\" konnte nicht geoeffnet werden!\n";
+            return false;
+        }
+
+        std::vector<ObjPosition> positions;
+        std::vector<ObjTextureCoordinate> textureCoordinates;
+
+        // One output vertex per distinct position/texture coordinate pair
+        std::unordered_map<uint64_t, uint32_t> vertexLookup;
+
+        std::string line;
+        std::vector<uint32_t> polygon;
+        size_t lineNumber = 0;
+
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+
+            std::istringstream stream(line);
+            std::string keyword;
+            stream >> keyword;
+
+            if (keyword == "v")
+            {
+                // "v x y z r g b" is a common extension for vertex colors
+                ObjPosition position = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+                stream >> position.position[0] >> position.position[1] >> position.position[2];
+
+                float r, g, b;
+                if (stream >> r >> g >> b)
+                {
+                    position.color[0] = r;
+                    position.color[1] = g;
+                    position.color[2] = b;
+                }
+
+                positions.push_back(position);
+            }
+            else if (keyword == "vt")
+            {
+                ObjTextureCoordinate textureCoordinate = { 0.0f, 0.0f };
+                stream >> textureCoordinate.u >> textureCoordinate.v;
+                textureCoordinates.push_back(textureCoordinate);
+            }
+            else if (keyword == "f")
+            {
+                polygon.clear();
+
+                std::string corner;
+                while (stream >> corner)
+                {
+                    size_t firstSlash = corner.find('/');
+                    std::string positionToken = corner.substr(0, firstSlash);
+                    std::string textureCoordinateToken;
+
+                    if (firstSlash != std::string::npos)
+                    {
+                        size_t secondSlash = corner.find('/', firstSlash + 1);
+                        textureCoordinateToken = corner.substr(firstSlash + 1, secondSlash == std::string::npos ? std::string::npos : secondSlash - firstSlash - 1);
+                    }
+
+                    int64_t positionIndex = resolveIndex(positionToken, positions.size());
+                    int64_t textureCoordinateIndex = resolveIndex(textureCoordinateToken, textureCoordinates.size());
+
+                    if (positionIndex < 0)
+                    {
+                        std::cerr << filename << ":" << lineNumber << ": Ungueltiger Vertex Index\n";
+                        return false;
+                    }
+
+                    uint64_t key = (static_cast<uint64_t>(positionIndex) << 32) | static_cast<uint32_t>(textureCoordinateIndex);
+                    auto [entry, inserted] = vertexLookup.try_emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+
+                    if (inserted)
+                    {
+                        const ObjPosition& position = positions[positionIndex];
+
+                        MeshVertex vertex = {};
+                        for (int i = 0; i < 3; i++)
+                        {
+                            vertex.position[i] = position.position[i];
+                            vertex.color[i] = position.color[i];
+                        }
+
+                        // OBJ has its texture origin at the bottom left, Vulkan at the top left
+                        if (textureCoordinateIndex >= 0)
+                        {
+                            vertex.textureCoordinate[0] = textureCoordinates[textureCoordinateIndex].u;
+                            vertex.textureCoordinate[1] = 1.0f - textureCoordinates[textureCoordinateIndex].v;
+                        }
+
+                        mesh.vertices.push_back(vertex);
+                    }
+
+                    polygon.push_back(entry->second);
+                }
+
+                // Polygons are triangulated as a fan
+                for (size_t i = 2; i < polygon.size(); i++)
+                {
+                    mesh.indices.push_back(polygon[0]);
+                    mesh.indices.push_back(polygon[i - 1]);
+                    mesh.indices.push_back(polygon[i]);
+                }
+            }
+        }
+
+        return true;
+    }
+}
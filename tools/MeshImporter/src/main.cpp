@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MeshImporter.h"
+
+using VulkanPrototype::Renderer::meshMaxLodCount;
+
+/*
+ * Offline importer from OBJ/glTF to the binary .vpmesh format of the renderer.
+ * Usage: MeshImporter <input.obj|.gltf|.glb> <output.vpmesh> [--float] [--no-optimize]
+ */
+
+namespace MeshImporter
+{
+    struct Options
+    {
+        std::string input;
+        std::string output;
+        bool unquantized = false;
+        bool unoptimized = false;
+    };
+
+    static std::string getExtension(const std::string& filename)
+    {
+        size_t dot = filename.find_last_of('.');
+        std::string extension = dot == std::string::npos ? "" : filename.substr(dot + 1);
+
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+
+    static bool parseOptions(int argc, char* argv[], Options& options)
+    {
+        std::vector<std::string> positional;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+
+            if (argument == "--float")
+                options.unquantized = true;
+            else if (argument == "--no-optimize")
+                options.unoptimized = true;
+            else
+                positional.push_back(argument);
+        }
+
+        if (positional.size() != 2)
+            return false;
+
+        options.input = positional[0];
+        options.output = positional[1];
+
+        return true;
+    }
+
+    int Run(int argc, char* argv[])
+    {
+        Options options;
+
+        if (!parseOptions(argc, argv, options))
+        {
+            std::cerr << "Usage: MeshImporter <input.obj|.gltf|.glb> <output.vpmesh> [--float] [--no-optimize]\n";
+            return 1;
+        }
+
+        const std::string& input = options.input;
+        const std::string& output = options.output;
+        std::string extension = getExtension(input);
+
+        ImportedMesh mesh;
+        bool success;
+
+        if (extension == "obj")
+            success = importObj(input, mesh);
+        else if (extension == "gltf" || extension == "glb")
+            success = importGltf(input, mesh);
+        else
+        {
+            std::cerr << "Dateiformat \"" << extension << "\" wird nicht unterstuetzt!\n";
+            return 1;
+        }
+
+        if (!success)
+            return 1;
+
+        if (mesh.indices.empty())
+        {
+            std::cerr << "Datei \"" << input << "\" enthaelt keine Dreiecke!\n";
+            return 1;
+        }
+
+        if (!options.unoptimized)
+        {
+            // 16 entries is a conservative size for the post-transform cache of current GPUs
+            VertexCacheStatistics before = analyzeVertexCache(mesh.indices, mesh.vertices.size(), 16);
+
+            optimizeVertexCache(mesh.indices, mesh.vertices.size());
+            optimizeOverdraw(mesh.indices, mesh.vertices, 1.05f);
+            generateLods(mesh, meshMaxLodCount, 0.05f);
+            optimizeVertexFetch(mesh);
+
+            VertexCacheStatistics after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), 16);
+
+            std::cout << "ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << "\n";
+
+            for (size_t i = 0; i < mesh.lods.size(); i++)
+                std::cout << "LOD " << i + 1 << ": " << mesh.lods[i].indices.size() / 3 << " triangles, error " << mesh.lods[i].error << "\n";
+        }
+
+        if (!writeMeshFile(output, mesh, !options.unquantized))
+        {
+            std::cerr << "Datei \"" << output << "\" konnte nicht geschrieben werden!\n";
+            return 1;
+        }
+
+        std::cout << input << " -> " << output << ": " << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, "
+            << (mesh.vertices.size() <= 0xFFFF ? 16 : 32) << " bit indices, " << (options.unquantized ? sizeof(MeshVertex) : sizeof(QuantizedVertex)) << " bytes per vertex\n";
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    return MeshImporter::Run(argc, argv);
+}
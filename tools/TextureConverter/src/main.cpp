@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+/*
+ * Offline converter from jpeg/png to a BC1/BC3 KTX2 file with a full mip chain.
+ * Usage: TextureConverter <input> <output.ktx2> [--bc1|--bc3] [--linear]
+ */
+
+namespace TextureConverter
+{
+    // Values of VkFormat, the tool does not depend on the Vulkan SDK
+    enum Format : uint32_t
+    {
+        FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+        FORMAT_BC1_RGB_SRGB_BLOCK = 132,
+        FORMAT_BC3_UNORM_BLOCK = 137,
+        FORMAT_BC3_SRGB_BLOCK = 138
+    };
+
+    struct Image
+    {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    struct Options
+    {
+        std::string input;
+        std::string output;
+        bool forceBC1 = false;
+        bool forceBC3 = false;
+        bool linear = false;
+    };
+
+    static float srgbToLinear(uint8_t value)
+    {
+        float c = value / 255.0f;
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static uint8_t linearToSrgb(float value)
+    {
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+    }
+
+    // 2x2 box filter, color channels are averaged in linear space for sRGB textures
+    static Image downsample(const Image& source, bool linear)
+    {
+        static float srgbTable[256];
+        static bool srgbTableInitialized = false;
+
+        if (!srgbTableInitialized)
+        {
+            for (int i = 0; i < 256; i++)
+                srgbTable[i] = srgbToLinear(static_cast<uint8_t>(i));
+            srgbTableInitialized = true;
+        }
+
+        Image result;
+        result.width = std::max(source.width / 2, 1u);
+        result.height = std::max(source.height / 2, 1u);
+        result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+        for (uint32_t y = 0; y < result.height; y++)
+        {
+            for (uint32_t x = 0; x < result.width; x++)
+            {
+                uint32_t x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                uint32_t y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+
+                const uint8_t* samples[4] =
+                {
+                    &source.pixels[(static_cast<size_t>(y0) * source.width + x0) * 4],
+                    &source.pixels[(static_cast<size_t>(y0) * source.width + x1) * 4],
+                    &source.pixels[(static_cast<size_t>(y1) * source.width + x0) * 4],
+                    &source.pixels[(static_cast<size_t>(y1) * source.width + x1) * 4]
+                };
+
+                uint8_t* destination = &result.pixels[(static_cast<size_t>(y) * result.width + x) * 4];
+
+                for (int c = 0; c < 4; c++)
+                {
+                    if (linear || c == 3)
+                    {
+                        int sum = samples[0][c] + samples[1][c] + samples[2][c] + samples[3][c];
+                        destination[c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                    else
+                    {
+                        float sum = srgbTable[samples[0][c]] + srgbTable[samples[1][c]] + srgbTable[samples[2][c]] + srgbTable[samples[3][c]];
+                        destination[c] = linearToSrgb(sum * 0.25f);
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static std::vector<uint8_t> compress(const Image& image, bool alpha)
+    {
+        uint32_t blocksX = (image.width + 3) / 4;
+        uint32_t blocksY = (image.height + 3) / 4;
+        uint32_t blockSize = alpha ? 16 : 8;
+
+        std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockSize);
+        uint8_t texels[16 * 4];
+
+        for (uint32_t by = 0; by < blocksY; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                // Edge blocks repeat the last row/column of the image
+                for (uint32_t y = 0; y < 4; y++)
+                {
+                    for (uint32_t x = 0; x < 4; x++)
+                    {
+                        uint32_t sx = std::min(bx * 4 + x, image.width - 1);
+                        uint32_t sy = std::min(by * 4 + y, image.height - 1);
+                        memcpy(&texels[(y * 4 + x) * 4], &image.pixels[(static_cast<size_t>(sy) * image.width + sx) * 4], 4);
+                    }
+                }
+
+                stb_compress_dxt_block(&blocks[(static_cast<size_t>(by) * blocksX + bx) * blockSize], texels, alpha ? 1 : 0, STB_DXT_HIGHQUAL);
+            }
+        }
+
+        return blocks;
+    }
+
+    static void writeUint32(std::vector<uint8_t>& buffer, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            buffer.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    static void writeUint64(std::vector<uint8_t>& buffer, uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+            buffer.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    // Khronos Basic Data Format Descriptor for BC1 (one color sample) or BC3 (alpha + color sample)
+    static std::vector<uint8_t> createDataFormatDescriptor(bool alpha, bool linear)
+    {
+        const uint32_t sampleCount = alpha ? 2 : 1;
+        const uint32_t blockSize = 24 + 16 * sampleCount;
+        const uint32_t colorModel = alpha ? 130 : 128;  // KHR_DF_MODEL_BC3 : KHR_DF_MODEL_BC1A
+        const uint32_t transferFunction = linear ? 1 : 2;  // KHR_DF_TRANSFER_LINEAR : KHR_DF_TRANSFER_SRGB
+        const uint32_t linearQualifier = 0x80;
+
+        std::vector<uint8_t> dfd;
+        writeUint32(dfd, 4 + blockSize);
+        writeUint32(dfd, 0);  // vendorId, descriptorType
+        writeUint32(dfd, 2 | (blockSize << 16));  // versionNumber, descriptorBlockSize
+        writeUint32(dfd, colorModel | (1 << 8) | (transferFunction << 16));  // colorPrimaries BT709, flags 0
+        writeUint32(dfd, 3 | (3 << 8));  // texelBlockDimension 4x4
+        writeUint32(dfd, alpha ? 16 : 8);  // bytesPlane0
+        writeUint32(dfd, 0);
+
+        if (alpha)
+        {
+            writeUint32(dfd, 0 | (63 << 16) | ((15 | (linear ? 0 : linearQualifier)) << 24));  // KHR_DF_CHANNEL_BC3_ALPHA
+            writeUint32(dfd, 0);
+            writeUint32(dfd, 0);
+            writeUint32(dfd, 0xFFFFFFFF);
+        }
+
+        writeUint32(dfd, (alpha ? 64 : 0) | (63 << 16));  // KHR_DF_CHANNEL_BC1A_COLOR / KHR_DF_CHANNEL_BC3_COLOR
+        writeUint32(dfd, 0);
+        writeUint32(dfd, 0);
+        writeUint32(dfd, 0xFFFFFFFF);
+
+        return dfd;
+    }
+
+    static bool writeKtx2(const std::string& filename, uint32_t format, const std::vector<Image>& levels, const std::vector<std::vector<uint8_t>>& levelData, bool alpha, bool linear)
+    {
+        static const uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+        const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+        const uint64_t alignment = alpha ? 16 : 8;
+
+        std::vector<uint8_t> dfd = createDataFormatDescriptor(alpha, linear);
+
+        const uint32_t levelIndexOffset = 80;
+        const uint32_t dfdOffset = levelIndexOffset + 24 * levelCount;
+
+        // Mip levels are stored smallest first so a streaming reader gets the mip tail first
+        std::vector<uint64_t> offsets(levelCount);
+        uint64_t offset = dfdOffset + dfd.size();
+        for (uint32_t i = levelCount; i-- > 0;)
+        {
+            offset = (offset + alignment - 1) / alignment * alignment;
+            offsets[i] = offset;
+            offset += levelData[i].size();
+        }
+
+        std::vector<uint8_t> header(identifier, identifier + sizeof(identifier));
+        writeUint32(header, format);
+        writeUint32(header, 1);  // typeSize
+        writeUint32(header, levels[0].width);
+        writeUint32(header, levels[0].height);
+        writeUint32(header, 0);  // pixelDepth
+        writeUint32(header, 0);  // layerCount
+        writeUint32(header, 1);  // faceCount
+        writeUint32(header, levelCount);
+        writeUint32(header, 0);  // supercompressionScheme
+
+        writeUint32(header, dfdOffset);
+        writeUint32(header, static_cast<uint32_t>(dfd.size()));
+        writeUint32(header, 0);  // kvdByteOffset
+        writeUint32(header, 0);  // kvdByteLength
+        writeUint64(header, 0);  // sgdByteOffset
+        writeUint64(header, 0);  // sgdByteLength
+
+        for (uint32_t i = 0; i < levelCount; i++)
+        {
+            writeUint64(header, offsets[i]);
+            writeUint64(header, levelData[i].size());
+            writeUint64(header, levelData[i].size());
+        }
+
+        header.insert(header.end(), dfd.begin(), dfd.end());
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        uint64_t position = header.size();
+        for (uint32_t i = levelCount; i-- > 0;)
+        {
+            static const char padding[16] = {};
+            file.write(padding, static_cast<std::streamsize>(offsets[i] - position));
+            file.write(reinterpret_cast<const char*>(levelData[i].data()), levelData[i].size());
+            position = offsets[i] + levelData[i].size();
+        }
+
+        return file.good();
+    }
+
+    static bool parseOptions(int argc, char* argv[], Options& options)
+    {
+        std::vector<std::string> positional;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+
+            if (argument == "--bc1")
+                options.forceBC1 = true;
+            else if (argument == "--bc3")
+                options.forceBC3 = true;
+            else if (argument == "--linear")
+                options.linear = true;
+            else
+                positional.push_back(argument);
+        }
+
+        if (positional.size() != 2 || (options.forceBC1 && options.forceBC3))
+            return false;
+
+        options.input = positional[0];
+        options.output = positional[1];
+
+        return true;
+    }
+
+    int Run(int argc, char* argv[])
+    {
+        Options options;
+
+        if (!parseOptions(argc, argv, options))
+        {
+            std::cerr << "Usage: TextureConverter <input> <output.ktx2> [--bc1|--bc3] [--linear]\n";
+            return 1;
+        }
+
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(options.input.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+        if (!pixels)
+        {
+            std::cerr << "Datei \"" << options.input << "\" konnte nicht geoeffnet werden!\n";
+            return 1;
+        }
+
+        std::vector<Image> levels(1);
+        levels[0].width = static_cast<uint32_t>(width);
+        levels[0].height = static_cast<uint32_t>(height);
+        levels[0].pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(pixels);
+
+        bool hasAlpha = false;
+        for (size_t i = 3; i < levels[0].pixels.size(); i += 4)
+        {
+            if (levels[0].pixels[i] != 255)
+            {
+                hasAlpha = true;
+                break;
+            }
+        }
+
+        bool alpha = options.forceBC3 || (hasAlpha && !options.forceBC1);
+
+        while (levels.back().width > 1 || levels.back().height > 1)
+            levels.push_back(downsample(levels.back(), options.linear));
+
+        std::vector<std::vector<uint8_t>> levelData;
+        uint64_t compressedSize = 0, uncompressedSize = 0;
+
+        for (const Image& level : levels)
+        {
+            levelData.push_back(compress(level, alpha));
+            compressedSize += levelData.back().size();
+            uncompressedSize += level.pixels.size();
+        }
+
+        uint32_t format;
+        if (alpha)
+            format = options.linear ? FORMAT_BC3_UNORM_BLOCK : FORMAT_BC3_SRGB_BLOCK;
+        else
+            format = options.linear ? FORMAT_BC1_RGB_UNORM_BLOCK : FORMAT_BC1_RGB_SRGB_BLOCK;
+
+        if (!writeKtx2(options.output, format, levels, levelData, alpha, options.linear))
+        {
+            std::cerr << "Datei \"" << options.output << "\" konnte nicht geschrieben werden!\n";
+            return 1;
+        }
+
+        std::cout << options.input << " -> " << options.output << ": " << (alpha ? "BC3" : "BC1") << ", " << levels.size() << " mip levels, "
+            << compressedSize << " bytes (RGBA8 " << uncompressedSize << " bytes)\n";
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    return TextureConverter::Run(argc, argv);
+}